@@ -0,0 +1,173 @@
+#
+# @file      EmbedFeatures.cmake
+# @copyright 2022 Andrew MacIsaac
+#
+# @remark
+#     SPDX-License-Identifier: MPL-2.0
+#
+# @brief     Script embedding target description documents into the stub library.
+#
+# Run as a script with "cmake -P", with the following variables defined:
+#
+#   OUTPUT          C source file to generate, defining the table declared in protocol/features.h.
+#   INPUTS          Target description XML files, separated by '|'.  Each is served to GDB under
+#                   its file name, and one of them should be "target.xml".  May be empty.
+#   RLE             Boolean selecting run-length compressed storage.
+#   BLOCK_LENGTH    Uncompressed length of each indexed block of compressed data.  Defaults to 64.
+#
+# Documents are minified before they are embedded: comments and the whitespace between elements
+# are removed, and other whitespace within tags is collapsed.  Compressed data is made up of
+# literal bytes and runs, where a run is a byte with the top bit set, holding the run length less
+# three, followed by the repeated byte.  Runs never cross a block boundary, so that decoding can
+# start at the beginning of any block.
+#
+cmake_minimum_required(VERSION 3.16)
+
+if(NOT DEFINED BLOCK_LENGTH)
+    set(BLOCK_LENGTH 64)
+endif()
+set(RUN_MIN 3)
+set(RUN_MAX 130)
+
+# Remove comments and insignificant whitespace from an XML document.
+function(minify text result)
+    string(FIND "${text}" "<!--" start)
+    while(start GREATER_EQUAL 0)
+        string(SUBSTRING "${text}" ${start} -1 rest)
+        string(FIND "${rest}" "-->" end)
+        if(end LESS 0)
+            message(FATAL_ERROR "Unterminated comment in target description")
+        endif()
+        math(EXPR end "${end} + 3")
+        string(SUBSTRING "${text}" 0 ${start} head)
+        string(SUBSTRING "${rest}" ${end} -1 rest)
+        set(text "${head}${rest}")
+        string(FIND "${text}" "<!--" start)
+    endwhile()
+    string(REGEX REPLACE ">[ \t\r\n]+" ">" text "${text}")
+    string(REGEX REPLACE "[ \t\r\n]+<" "<" text "${text}")
+    string(REGEX REPLACE "[ \t\r\n]+" " " text "${text}")
+    string(REPLACE " />" "/>" text "${text}")
+    string(REPLACE " >" ">" text "${text}")
+    string(STRIP "${text}" text)
+    set(${result} "${text}" PARENT_SCOPE)
+endfunction()
+
+# Append a run of a byte to the compressed data.
+macro(flush_run)
+    if(run_length GREATER_EQUAL RUN_MIN)
+        math(EXPR marker "128 + ${run_length} - ${RUN_MIN}" OUTPUT_FORMAT HEXADECIMAL)
+        list(APPEND encoded ${marker} 0x${run_byte})
+    elseif(run_length GREATER 0)
+        foreach(i RANGE 1 ${run_length})
+            list(APPEND encoded 0x${run_byte})
+        endforeach()
+    endif()
+    set(run_length 0)
+endmacro()
+
+# Format a list of values as the body of a C array initializer, sixteen values to a line.
+function(format_array values result)
+    set(text "")
+    set(column 0)
+    foreach(value IN LISTS values)
+        if(column EQUAL 0)
+            string(APPEND text "\n   ")
+        endif()
+        string(APPEND text " ${value},")
+        math(EXPR column "(${column} + 1) % 16")
+    endforeach()
+    set(${result} "${text}\n" PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "|" ";" inputs "${INPUTS}")
+set(arrays "")
+set(entries "")
+set(count 0)
+set(have_target OFF)
+
+foreach(input IN LISTS inputs)
+    get_filename_component(name "${input}" NAME)
+    if(name STREQUAL "target.xml")
+        set(have_target ON)
+    endif()
+
+    file(READ "${input}" text)
+    minify("${text}" text)
+    file(WRITE "${OUTPUT}.xml" "${text}")
+    file(READ "${OUTPUT}.xml" hex HEX)
+    file(REMOVE "${OUTPUT}.xml")
+    string(REGEX MATCHALL ".." bytes "${hex}")
+    list(LENGTH bytes length)
+    if(length EQUAL 0)
+        message(FATAL_ERROR "Empty target description: ${input}")
+    endif()
+
+    if(RLE)
+        set(encoded "")
+        set(index "")
+        set(position 0)
+        set(run_length 0)
+        foreach(byte IN LISTS bytes)
+            if(byte MATCHES "^[89a-f]")
+                message(FATAL_ERROR "Target description is not plain ASCII: ${input}")
+            endif()
+            math(EXPR offset "${position} % ${BLOCK_LENGTH}")
+            if(offset EQUAL 0)
+                flush_run()
+                list(LENGTH encoded used)
+                list(APPEND index ${used})
+            endif()
+            if(run_length GREATER 0 AND byte STREQUAL run_byte AND run_length LESS RUN_MAX)
+                math(EXPR run_length "${run_length} + 1")
+            else()
+                flush_run()
+                set(run_byte ${byte})
+                set(run_length 1)
+            endif()
+            math(EXPR position "${position} + 1")
+        endforeach()
+        flush_run()
+        list(LENGTH encoded used)
+        if(used GREATER 65535)
+            message(FATAL_ERROR "Compressed target description is too long: ${input}")
+        endif()
+
+        format_array("${encoded}" data)
+        format_array("${index}" blocks)
+        string(APPEND arrays
+            "/// Compressed ${name}, ${length} bytes expanded.\n"
+            "static const unsigned char data_${count}[] =\n{${data}};\n\n"
+            "/// Offsets of the blocks of ${name} within its compressed data.\n"
+            "static const unsigned short index_${count}[] =\n{${blocks}};\n\n")
+        string(APPEND entries
+            "    { \"${name}\", data_${count}, index_${count}, ${length}, ${BLOCK_LENGTH} },\n")
+    else()
+        list(TRANSFORM bytes PREPEND "0x")
+        format_array("${bytes}" data)
+        string(APPEND arrays
+            "/// Minified ${name}.\n"
+            "static const unsigned char data_${count}[] =\n{${data}};\n\n")
+        string(APPEND entries "    { \"${name}\", data_${count}, 0, ${length}, 0 },\n")
+    endif()
+    math(EXPR count "${count} + 1")
+endforeach()
+
+if(count GREATER 0 AND NOT have_target)
+    message(WARNING "No target.xml among the target descriptions, so GDB will not read them")
+endif()
+if(count EQUAL 0)
+    set(entries "    { 0, 0, 0, 0, 0 },\n")
+endif()
+
+file(WRITE "${OUTPUT}.tmp"
+    "/*\n"
+    " * Generated by EmbedFeatures.cmake.  Do not edit.\n"
+    " */\n"
+    "#include \"protocol/features.h\"\n\n"
+    "${arrays}"
+    "const struct features_file features_files[] =\n{\n${entries}};\n\n"
+    "const unsigned int features_file_count = ${count};\n")
+# Only touch the output when it changes, to avoid rebuilding the library needlessly.
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -24,6 +24,232 @@
 #   define GDBS_PACKET_BUFFER_DECL
 #endif
 
+/// Unsigned integer type able to represent any target address or memory region length.  The default
+/// relies on <stdint.h>; define GDBS_ADDRESS_TYPE explicitly on platforms which do not provide it.
+#ifndef GDBS_ADDRESS_TYPE
+#   include <stdint.h>
+#   define GDBS_ADDRESS_TYPE uintptr_t
+#endif
+
+/// Target address type used throughout the stub interfaces.
+typedef GDBS_ADDRESS_TYPE gdbs_address_t;
+
+/// Set to 0 in order to provide custom gdbs_memory_read() and gdbs_memory_write() implementations
+/// instead of the generic ones supplied with the stub library.
+#ifndef GDBS_GENERIC_MEMORY_ACCESS
+#   define GDBS_GENERIC_MEMORY_ACCESS 1
+#endif
+
+/// Number of separate ranges of memory written by GDB which are held back until the target
+/// resumes, or until GDB reads them.  Adjacent writes are combined into one range, so that runs of
+/// small writes reach target memory as a single access.
+#ifndef GDBS_WRITE_COMBINE_COUNT
+#   define GDBS_WRITE_COMBINE_COUNT 4
+#endif
+#if GDBS_WRITE_COMBINE_COUNT < 1
+#   error "GDBS_WRITE_COMBINE_COUNT must be >= 1"
+#endif
+
+/// Number of bytes of memory written by GDB which can be held back.  Longer writes are made
+/// straight away.
+#ifndef GDBS_WRITE_COMBINE_LENGTH
+#   define GDBS_WRITE_COMBINE_LENGTH 256
+#endif
+
+/// Set to 0 in order to calculate the CRCs requested with 'qCRC' four bits at a time, using a
+/// 64 byte table, instead of four bytes at a time, using 4 KiB of tables.
+#ifndef GDBS_CRC_SLICING
+#   define GDBS_CRC_SLICING 1
+#endif
+
+/// Widest access type used by the generic memory hooks.  Naturally aligned runs of memory are
+/// transferred using this type, and only an unaligned head or tail is accessed byte by byte.
+#ifndef GDBS_MEMORY_WORD_TYPE
+#   define GDBS_MEMORY_WORD_TYPE unsigned long
+#endif
+
+/// One greater than the highest GDB register number that can be accessed individually with the 'p'
+/// and 'P' commands.  Registers beyond this limit remain accessible through 'g' and 'G'.  Each unit
+/// costs one entry in the register lookup table.
+#ifndef GDBS_REGISTER_NUMBER_LIMIT
+#   define GDBS_REGISTER_NUMBER_LIMIT 128
+#endif
+
+/// Set to 0 in order to provide custom thread hooks, such as gdbs_get_threads(), which describe the
+/// tasks of an RTOS.  The generic hooks supplied with the stub library present the whole target as
+/// a single thread.
+#ifndef GDBS_GENERIC_THREADS
+#   define GDBS_GENERIC_THREADS 1
+#endif
+
+/// Set to 0 in order to provide flash hooks, such as gdbs_get_memory_map(), which allow GDB to load
+/// programs into flash.  The generic hooks supplied with the stub library report no memory map, so
+/// GDB treats all memory as RAM.
+#ifndef GDBS_GENERIC_FLASH
+#   define GDBS_GENERIC_FLASH 1
+#endif
+
+/// Set to 0 in order to provide gdbs_get_monitor_commands(), which adds the target's own commands
+/// to those run by GDB's "monitor" command.  The generic hook supplied with the stub library adds
+/// none, leaving only the built-in commands of the stub.
+#ifndef GDBS_GENERIC_MONITOR
+#   define GDBS_GENERIC_MONITOR 1
+#endif
+
+/// Longest command line accepted by GDB's "monitor" command.  The command line is decoded on the
+/// stack of the stub.
+#ifndef GDBS_MONITOR_LINE_LENGTH
+#   define GDBS_MONITOR_LINE_LENGTH 128
+#endif
+
+/// Size of the unit in which flash is programmed.  Writes from GDB are collected into whole pages,
+/// so that each page is programmed once.  Two page buffers are reserved, so that one page can be
+/// programmed while the next is received.  Must be a power of two.
+#ifndef GDBS_FLASH_PAGE_LENGTH
+#   define GDBS_FLASH_PAGE_LENGTH 256
+#endif
+#if GDBS_FLASH_PAGE_LENGTH < 1 || (GDBS_FLASH_PAGE_LENGTH & (GDBS_FLASH_PAGE_LENGTH - 1)) != 0
+#   error "GDBS_FLASH_PAGE_LENGTH must be a power of two"
+#endif
+
+/// Size of the buffer which holds the registers of a thread selected by GDB, other than the one
+/// which was running on entry to the stub.  Must cover every register in the register table.
+#ifndef GDBS_REGISTER_FRAME_LENGTH
+#   define GDBS_REGISTER_FRAME_LENGTH 256
+#endif
+
+/// Number of thread register contexts cached while the stub is active, each holding a buffer of
+/// GDBS_REGISTER_FRAME_LENGTH bytes.
+#ifndef GDBS_THREAD_CONTEXT_COUNT
+#   define GDBS_THREAD_CONTEXT_COUNT 4
+#endif
+
+/// Maximum number of software breakpoints which can be set at once.
+#ifndef GDBS_BREAKPOINT_COUNT
+#   define GDBS_BREAKPOINT_COUNT 32
+#endif
+
+/// Length in bytes of the longest breakpoint instruction for the target.
+#ifndef GDBS_BREAKPOINT_LENGTH_MAX
+#   define GDBS_BREAKPOINT_LENGTH_MAX 4
+#endif
+
+/// Maximum number of hardware comparator units of each kind (breakpoint or watchpoint) which the
+/// stub can track.  The number actually available is reported by gdbs_get_comparator_count().
+#ifndef GDBS_COMPARATOR_COUNT
+#   define GDBS_COMPARATOR_COUNT 8
+#endif
+
+/// Unsigned integer type for agent expression values.  GDB compiles agent expressions for 64-bit
+/// arithmetic; a narrower type is faster on small targets but truncates wider values.
+#ifndef GDBS_AGENT_VALUE_TYPE
+#   define GDBS_AGENT_VALUE_TYPE unsigned long long
+#endif
+
+/// Maximum depth of the agent expression evaluation stack.  The stack is allocated on the stack of
+/// the stub, with one value per entry.  Expressions which need more are abandoned with an error.
+#ifndef GDBS_AGENT_STACK_DEPTH
+#   define GDBS_AGENT_STACK_DEPTH 32
+#endif
+
+/// Number of bytes reserved for storing agent expressions attached to breakpoints.  Each expression
+/// costs its bytecode length plus three bytes.
+#ifndef GDBS_AGENT_BYTECODE_LENGTH
+#   define GDBS_AGENT_BYTECODE_LENGTH 512
+#endif
+
+/// Maximum number of tracepoints which can be defined at once.
+#ifndef GDBS_TRACEPOINT_COUNT
+#   define GDBS_TRACEPOINT_COUNT 8
+#endif
+
+/// Number of bytes reserved for storing tracepoint conditions and collection actions.  Each action
+/// costs its encoded length plus three bytes.
+#ifndef GDBS_TRACE_ACTION_LENGTH
+#   define GDBS_TRACE_ACTION_LENGTH 512
+#endif
+
+/// Size of the buffer which holds the trace frames collected at tracepoints.
+#ifndef GDBS_TRACE_BUFFER_LENGTH
+#   define GDBS_TRACE_BUFFER_LENGTH 4096
+#endif
+
+/// Extra declaration for the trace buffer, which is statically allocated.  Set to a section
+/// attribute in order to place the buffer in a dedicated memory region.
+#ifndef GDBS_TRACE_BUFFER_DECL
+#   define GDBS_TRACE_BUFFER_DECL
+#endif
+
+/// Longest record of arguments written by an enabled static tracepoint marker.  The record is built
+/// on the stack of the code which reaches the marker.  Arguments beyond it are left out.
+#ifndef GDBS_TRACE_MARKER_RECORD_LENGTH
+#   define GDBS_TRACE_MARKER_RECORD_LENGTH 64
+#endif
+
+/// Size of the ring buffer which collects console output produced on the target, such as dynamic
+/// printf output and gdbs_console_write() calls, before it is sent to GDB in 'O' packets.  Must be
+/// a power of two.
+#ifndef GDBS_CONSOLE_BUFFER_LENGTH
+#   define GDBS_CONSOLE_BUFFER_LENGTH 256
+#endif
+#if GDBS_CONSOLE_BUFFER_LENGTH < 2 || \
+    (GDBS_CONSOLE_BUFFER_LENGTH & (GDBS_CONSOLE_BUFFER_LENGTH - 1)) != 0
+#   error "GDBS_CONSOLE_BUFFER_LENGTH must be a power of two >= 2"
+#endif
+
+/// Amount of buffered console output which is sent to GDB straight away, even though the target
+/// continues running.  Smaller amounts wait until the buffer fills up or the target stops.  Set to
+/// 1 to send output as soon as it is produced.
+#ifndef GDBS_CONSOLE_FLUSH_THRESHOLD
+#   define GDBS_CONSOLE_FLUSH_THRESHOLD (GDBS_CONSOLE_BUFFER_LENGTH / 2)
+#endif
+
+/// Number of stop events which can wait to be reported to GDB in non-stop mode.  Must be a power of
+/// two.
+#ifndef GDBS_STOP_QUEUE_LENGTH
+#   define GDBS_STOP_QUEUE_LENGTH 8
+#endif
+#if GDBS_STOP_QUEUE_LENGTH < 2 || (GDBS_STOP_QUEUE_LENGTH & (GDBS_STOP_QUEUE_LENGTH - 1)) != 0
+#   error "GDBS_STOP_QUEUE_LENGTH must be a power of two >= 2"
+#endif
+
+/// Set to 1 in order to collect the statistics of struct gdbs_stats, which are read with
+/// gdbs_get_stats() and reported by "monitor stats".  When 0, the counting compiles to nothing.
+#ifndef GDBS_STATS
+#   define GDBS_STATS 0
+#endif
+
+/// Set to 1, along with GDBS_STATS, in order to also account the time spent receiving, dispatching,
+/// and transmitting packets.  Time is measured with the gdbs_timestamp() hook, which must then be
+/// provided.
+#ifndef GDBS_STATS_TIMING
+#   define GDBS_STATS_TIMING 0
+#endif
+#if GDBS_STATS_TIMING && !GDBS_STATS
+#   error "GDBS_STATS_TIMING requires GDBS_STATS"
+#endif
+
+/// Update the statistics.  Unless GDBS_STATS is set, the update is left out entirely, and its
+/// argument is never evaluated.
+#if GDBS_STATS
+#   define GDBS_STATS_UPDATE(x) (x)
+#else
+#   define GDBS_STATS_UPDATE(x) ((void) 0)
+#endif
+
+/// Atomic compare-and-swap of an unsigned int, used to queue stop events and console output from
+/// several contexts at once without a lock.  Must evaluate to nonzero if *p was equal to e and has
+/// been replaced with d, and must act as a full memory barrier.  The default uses the GCC builtin
+/// where it is available.  Otherwise a plain comparison is used, which is only safe if stop events
+/// cannot be raised, and console output cannot be written, concurrently.
+#ifndef GDBS_ATOMIC_CAS
+#   if defined(__GNUC__)
+#       define GDBS_ATOMIC_CAS(p, e, d) __sync_bool_compare_and_swap((p), (e), (d))
+#   else
+#       define GDBS_ATOMIC_CAS(p, e, d) (*(p) == (e) ? (*(p) = (d), 1) : 0)
+#   endif
+#endif
+
 /// If the log implementation requires an include file, define GDBS_LOG_INCLUDE to the necessary
 /// include pattern.
 #ifdef GDBS_LOG_INCLUDE
@@ -11,6 +11,110 @@
 #ifndef GDBSDEVICE_H_
 #define GDBSDEVICE_H_
 
+#include "gdbsconfig.h"
+
+/// Register flag indicating that the register value is sent to GDB with every stop reply.  This
+/// is typically set for the program counter, stack pointer, frame pointer, and link register,
+/// which lets GDB unwind the current frame without requesting the full register file.
+#define GDBS_REGISTER_EXPEDITE 0x0001
+
+/// Register flag identifying the program counter.  Exactly one register should carry this flag.
+#define GDBS_REGISTER_PC       0x0002
+
+/// Description of a single register in the target's register file.
+struct gdbs_register
+{
+    unsigned short regnum; ///< GDB register number.
+    unsigned short offset; ///< Byte offset of the register value within the register frame.
+    unsigned short size;   ///< Size of the register value in bytes.
+    unsigned short flags;  ///< Combination of GDBS_REGISTER_\* flags.
+};
+
+/// Signal numbers reported to GDB.  These follow GDB's own numbering, which matches the common
+/// POSIX values.
+enum gdbs_signal
+{
+    GDBS_SIGNAL_NONE = 0,  ///< No signal.
+    GDBS_SIGNAL_INT  = 2,  ///< Interrupt requested by the debugger.
+    GDBS_SIGNAL_ILL  = 4,  ///< Illegal instruction.
+    GDBS_SIGNAL_TRAP = 5,  ///< Breakpoint, single step, or watchpoint.
+    GDBS_SIGNAL_ABRT = 6,  ///< Abort.
+    GDBS_SIGNAL_FPE  = 8,  ///< Arithmetic exception.
+    GDBS_SIGNAL_BUS  = 10, ///< Bus error.
+    GDBS_SIGNAL_SEGV = 11  ///< Memory access violation.
+};
+
+/// Reason for a stop, beyond the signal itself.
+enum gdbs_stop_reason
+{
+    GDBS_STOP_SIGNAL,  ///< No further detail is available.
+    GDBS_STOP_SWBREAK, ///< A software breakpoint instruction was executed.
+    GDBS_STOP_HWBREAK, ///< A hardware breakpoint was hit.
+    GDBS_STOP_WATCH,   ///< A write watchpoint was triggered.
+    GDBS_STOP_RWATCH,  ///< A read watchpoint was triggered.
+    GDBS_STOP_AWATCH   ///< An access watchpoint was triggered.
+};
+
+/// Description of the event which caused entry into the stub.
+struct gdbs_stop_event
+{
+    enum gdbs_signal        signal;  ///< Signal to report.
+    enum gdbs_stop_reason   reason;  ///< Reason for the stop.
+    gdbs_address_t          address; ///< Data address which triggered a watchpoint.  Ignored for
+                                     ///< other reasons.
+    int                     unit;    ///< Watchpoint comparator unit which triggered, or -1.  When
+                                     ///< set, the stub fills in the reason and address from the
+                                     ///< watchpoint programmed into that unit.
+    gdbs_address_t          thread;  ///< ID of the thread which stopped.
+};
+
+/// Types of hardware comparator.  Breakpoint comparators and watchpoint comparators are allocated
+/// from separate pools of units.
+enum gdbs_comparator_type
+{
+    GDBS_COMPARATOR_BREAK,  ///< Instruction address comparator, for a hardware breakpoint.
+    GDBS_COMPARATOR_WATCH,  ///< Data write comparator.
+    GDBS_COMPARATOR_RWATCH, ///< Data read comparator.
+    GDBS_COMPARATOR_AWATCH  ///< Data access comparator, for either reads or writes.
+};
+
+/// Types of memory region in the memory map.
+enum gdbs_memory_type
+{
+    GDBS_MEMORY_RAM,  ///< Memory written with gdbs_memory_write().
+    GDBS_MEMORY_ROM,  ///< Memory which cannot be written.
+    GDBS_MEMORY_FLASH ///< Memory erased and programmed with the flash hooks.
+};
+
+/// Description of a region of target memory.
+struct gdbs_memory_region
+{
+    enum gdbs_memory_type   type;       ///< Type of memory.
+    gdbs_address_t          start;      ///< First address of the region.  Flash regions must be
+                                        ///< aligned to GDBS_FLASH_PAGE_LENGTH.
+    gdbs_address_t          length;     ///< Length of the region.  Flash regions must be a whole
+                                        ///< number of pages.
+    gdbs_address_t          block_size; ///< Erase block size of a flash region.  Ignored for other
+                                        ///< types.
+    int                     no_execute; ///< Boolean indicating that the region never holds code,
+                                        ///< so writes to it need no instruction cache flush.
+};
+
+/// Command run by GDB's "monitor" command, provided by the target in addition to the built-in
+/// commands of the stub.
+struct gdbs_monitor_command
+{
+    const char  *name;                                  ///< Command name, which is the first word
+                                                        ///< of the command line.
+    const char  *help;                                  ///< One line description, listed by
+                                                        ///< "monitor help".
+    int        (*handler)(const char *, unsigned int);  ///< Command handler, given the rest of the
+                                                        ///< command line after the name and its
+                                                        ///< spaces, and its length.  Returns zero,
+                                                        ///< or a negative enum gdbs_error entry
+                                                        ///< which is reported to GDB as an error.
+};
+
 /**
  * Flush the device's instruction cache.  If the platform has no instruction cache then this
  * function can be implemented as a no-op.
@@ -85,4 +189,344 @@ int gdbs_receive
     void *comm ///< Communication parameter that was passed to gdbs_initialize().
 );
 
+/**
+ * Read one character from the open communication port, if one has already arrived, without
+ * waiting.  This is only called from gdbs_comm_poll().
+ *
+ * @retval >=0              The actual received character value.
+ * @retval -GDBS_ERROR_EOB  No character is waiting.
+ * @retval <0               An error occurred.  The exact value will be a negative enum gdbs_error
+ *                          entry indicating what went wrong.
+ */
+int gdbs_receive_poll
+(
+    void *comm ///< Communication parameter that was passed to gdbs_initialize().
+);
+
+/**
+ * Read a block of target memory on behalf of the debugger.  Implementations must use access widths
+ * which are valid for the addressed region, and must report an inaccessible address as an error
+ * rather than letting the fault propagate.  A generic implementation is provided by the stub
+ * library unless GDBS_GENERIC_MEMORY_ACCESS is set to 0.
+ *
+ * @retval  0 All requested bytes were read.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_FAULT.
+ */
+int gdbs_memory_read
+(
+    void            *comm,    ///< [in]  Communication parameter that was passed to gdbs_initialize().
+    gdbs_address_t   address, ///< [in]  Target address to read from.
+    void            *buffer,  ///< [out] Buffer to receive the memory contents.
+    gdbs_address_t   length   ///< [in]  Number of bytes to read.
+);
+
+/**
+ * Write a block of target memory on behalf of the debugger.  The same access width and fault
+ * handling requirements apply as for gdbs_memory_read().
+ *
+ * @retval  0 All requested bytes were written.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_FAULT.
+ */
+int gdbs_memory_write
+(
+    void            *comm,    ///< [in] Communication parameter that was passed to gdbs_initialize().
+    gdbs_address_t   address, ///< [in] Target address to write to.
+    const void      *buffer,  ///< [in] Data to be written.
+    gdbs_address_t   length   ///< [in] Number of bytes to write.
+);
+
+/**
+ * Obtain the description of the target's register file.  Entries must be listed in the order in
+ * which GDB expects them in the 'g' packet, which for most architectures is ascending register
+ * number.  This is called once, from gdbs_initialize().
+ *
+ * @return Pointer to the register table.  The table must remain valid until gdbs_cleanup().
+ */
+const struct gdbs_register *gdbs_get_register_table
+(
+    unsigned int *count ///< [out] Number of entries in the register table.
+);
+
+/**
+ * Obtain the register values saved on entry to the stub, typically the exception frame.  Register
+ * values are held in target byte order, at the offsets given by the register table.  Changes made
+ * to the frame by the stub must take effect when the target resumes.  This is called on every
+ * entry to the stub.
+ *
+ * @return Pointer to the saved register frame.
+ */
+void *gdbs_get_register_frame(void);
+
+/**
+ * Describe the event which caused entry into the stub.  This is called on every entry to the stub.
+ * When reporting GDBS_STOP_SWBREAK, the program counter in the register frame must already point
+ * at the breakpoint instruction, so that GDB does not need to adjust it.
+ */
+void gdbs_get_stop_event
+(
+    struct gdbs_stop_event *event ///< [out] Event description.  Set to GDBS_SIGNAL_TRAP with
+                                  ///<       GDBS_STOP_SIGNAL, no unit, and the thread from
+                                  ///<       gdbs_get_current_thread() before the call.
+);
+
+/**
+ * List the IDs of the target's threads, such as the tasks of an RTOS.  Threads are listed in a
+ * stable order, and each call continues the list from a position within it.  Thread IDs must be
+ * nonzero, and must not be all ones.  A generic implementation presenting the whole target as
+ * thread 1 is supplied with the stub library unless GDBS_GENERIC_THREADS is set to 0.
+ *
+ * @return Number of IDs stored.  Fewer than requested once the end of the list is reached.
+ */
+unsigned int gdbs_get_threads
+(
+    unsigned int     first, ///< [in]  Position within the list of the first thread to store.
+    gdbs_address_t  *ids,   ///< [out] Thread IDs.
+    unsigned int     count  ///< [in]  Maximum number of IDs to store.
+);
+
+/**
+ * Identify the thread which was running on entry to the stub.  Its registers are held in the frame
+ * from gdbs_get_register_frame().
+ *
+ * @return Thread ID.
+ */
+gdbs_address_t gdbs_get_current_thread(void);
+
+/**
+ * Determine whether a thread still exists.
+ *
+ * @return Boolean indicating that the thread exists.
+ */
+int gdbs_thread_alive
+(
+    gdbs_address_t thread ///< Thread ID.
+);
+
+/**
+ * Obtain a short description of a thread, such as its task name.
+ *
+ * @return NUL-terminated name, or NULL if the thread has none.  The name must remain valid until
+ *         the stub is next entered.
+ */
+const char *gdbs_get_thread_name
+(
+    gdbs_address_t thread ///< Thread ID.
+);
+
+/**
+ * Identify the processor core which a thread last ran on, for multi-core targets.
+ *
+ * @return Core number, or -1 if unknown.
+ */
+int gdbs_get_thread_core
+(
+    gdbs_address_t thread ///< Thread ID.
+);
+
+/**
+ * Read the saved registers of a thread other than the one which was running on entry to the stub,
+ * typically from its task control block.  This is never called for the current thread.
+ *
+ * @retval  0 Registers read.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_get_thread_context
+(
+    gdbs_address_t   thread, ///< [in]  Thread ID.
+    unsigned char   *frame   ///< [out] Register values, in target byte order, at the offsets given
+                             ///<       by the register table.
+);
+
+/**
+ * Write the saved registers of a thread other than the one which was running on entry to the stub.
+ * The thread resumes with the new values.  This is never called for the current thread.  Changes
+ * made by GDB are collected while the stub is active, and written once before the target resumes.
+ *
+ * @retval  0 Registers written.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_set_thread_context
+(
+    gdbs_address_t           thread,  ///< Thread ID.
+    const unsigned char     *frame,   ///< Register values, laid out as for
+                                      ///< gdbs_get_thread_context().
+    const unsigned char     *changed  ///< Bitmap of the registers changed by GDB, with bit
+                                      ///< (n % 8) of byte (n / 8) set for register number n.
+                                      ///< Only these registers need to be written.
+);
+
+/**
+ * Obtain the breakpoint instruction to use for a software breakpoint.
+ *
+ * @return Pointer to the instruction bytes, in target byte order, or NULL if the kind is not
+ *         supported.  The instruction must remain valid until gdbs_cleanup().
+ */
+const unsigned char *gdbs_get_breakpoint_instruction
+(
+    gdbs_address_t   kind,  ///< [in]  Breakpoint kind requested by GDB.  This is usually the
+                            ///<       length of the instruction to be replaced.  Kind 0 is
+                            ///<       requested for tracepoints, and should select the default
+                            ///<       breakpoint instruction.
+    unsigned int    *length ///< [out] Length of the breakpoint instruction.  Must not exceed
+                            ///<       GDBS_BREAKPOINT_LENGTH_MAX.
+);
+
+/**
+ * Arm or disarm single stepping.  This is called each time the target is about to resume.  When
+ * enabled, the target must reenter the stub after executing a single instruction.
+ *
+ * @retval  0 Single stepping configured.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_set_single_step
+(
+    int enable ///< Boolean indicating whether to stop after the next instruction.
+);
+
+/**
+ * Report the number of hardware comparator units available.  This is called once for each pool,
+ * from gdbs_initialize().
+ *
+ * @return Number of units.  Zero if the hardware has none.
+ */
+unsigned int gdbs_get_comparator_count
+(
+    enum gdbs_comparator_type type ///< GDBS_COMPARATOR_BREAK for the breakpoint pool, or
+                                   ///< GDBS_COMPARATOR_WATCH for the watchpoint pool.
+);
+
+/**
+ * Program a hardware comparator unit.  The unit is not in use by any other breakpoint or
+ * watchpoint.
+ *
+ * @retval  0 Comparator programmed.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_INVALID if the unit cannot match the
+ *            requested region.
+ */
+int gdbs_set_comparator
+(
+    unsigned int                unit,    ///< Unit number within the pool for the type.
+    enum gdbs_comparator_type   type,    ///< Type of match.
+    gdbs_address_t              address, ///< Start address to match.
+    gdbs_address_t              length   ///< Length of the region to match.
+);
+
+/**
+ * Disable a hardware comparator unit previously programmed with gdbs_set_comparator().
+ */
+void gdbs_clear_comparator
+(
+    unsigned int                unit, ///< Unit number within the pool for the type.
+    enum gdbs_comparator_type   type  ///< Type the unit was programmed with.
+);
+
+/**
+ * Obtain the map of the target's memory regions, which tells GDB where flash lies and how it is
+ * erased.  Regions are listed in ascending address order, and must not overlap.  A generic
+ * implementation reporting no map is supplied with the stub library unless GDBS_GENERIC_FLASH is
+ * set to 0.  Without a map, GDB treats all memory as RAM.
+ *
+ * @return Pointer to the region table.  The table must remain valid until gdbs_cleanup().
+ */
+const struct gdbs_memory_region *gdbs_get_memory_map
+(
+    unsigned int *count ///< [out] Number of entries in the region table.  Zero if there is no map.
+);
+
+/**
+ * Erase a range of flash.  The range covers whole erase blocks of a single flash region.
+ *
+ * @retval  0 Flash erased.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_flash_erase
+(
+    gdbs_address_t   address, ///< First address to erase.
+    gdbs_address_t   length   ///< Length of the range to erase.
+);
+
+/**
+ * Start programming a page of erased flash.  The data is left untouched until gdbs_flash_wait()
+ * has returned, so the hook may return as soon as programming has started, and the stub receives
+ * the next page from GDB while the hardware is busy.  Bytes which GDB did not write are 0xFF.
+ *
+ * @retval  0 Programming started, or completed.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_flash_program
+(
+    gdbs_address_t           address, ///< Address of the page, aligned to GDBS_FLASH_PAGE_LENGTH.
+    const unsigned char     *data,    ///< Page data.
+    gdbs_address_t           length   ///< Length of the page, which is GDBS_FLASH_PAGE_LENGTH.
+);
+
+/**
+ * Wait for the programming started by the last call to gdbs_flash_program() to complete.
+ *
+ * @retval  0 Programming completed.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_FAULT if verification failed.
+ */
+int gdbs_flash_wait(void);
+
+/**
+ * Obtain the target's own monitor commands, which GDB runs with its "monitor" command.  A command
+ * named like a built-in command of the stub is never run.  A generic implementation providing no
+ * commands is supplied with the stub library unless GDBS_GENERIC_MONITOR is set to 0.
+ *
+ * @return Pointer to the command table.  The table must remain valid until gdbs_cleanup().
+ */
+const struct gdbs_monitor_command *gdbs_get_monitor_commands
+(
+    unsigned int *count ///< [out] Number of entries in the command table.
+);
+
+/**
+ * Send output from a monitor command to GDB, which prints it on its console.  The output is sent
+ * straight away in an 'O' packet, so a command may produce any amount of output without buffering
+ * it.  May only be called from a monitor command handler.
+ *
+ * @retval  0 Output sent.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_monitor_write
+(
+    const char      *text,  ///< Output text.  Need not be NUL-terminated.
+    unsigned int     length ///< Length of the text.
+);
+
+#if GDBS_STATS_TIMING
+/**
+ * Read a free-running timestamp for the statistics, such as a cycle counter.  Only needed when
+ * GDBS_STATS_TIMING is set.  The count must wrap around from ULONG_MAX to zero, so that the
+ * difference between two readings is the time between them.
+ *
+ * @return Current timestamp.
+ */
+unsigned long gdbs_timestamp(void);
+#endif
+
+#if GDBS_GENERIC_MEMORY_ACCESS
+/**
+ * Report a bus or memory fault to the generic memory access hooks.  When the generic hooks are in
+ * use, the port's fault handlers must call this function before anything else.  If it indicates
+ * that the fault was raised by a debugger access, the handler must resume execution at the
+ * instruction following the faulting one, and the access will then be reported to GDB as an error
+ * instead of a crash.
+ *
+ * @retval 1 The fault was caused by a debugger memory access and has been recorded.
+ * @retval 0 The fault was not caused by the debugger and should be handled normally.
+ */
+int gdbs_memory_fault(void);
+#endif
+
 #endif /* end GDBSDEVICE_H_ */
@@ -18,6 +18,8 @@ enum gdbs_error
     GDBS_ERROR_CHECKSUM,  ///< Invalid packet checksum.
     GDBS_ERROR_EOB,       ///< At the end of the buffer.
     GDBS_ERROR_NOT_FOUND, ///< Requested item was not found.
+    GDBS_ERROR_FAULT,     ///< Memory access faulted.
+    GDBS_ERROR_RESOURCES, ///< Insufficient resources to complete the request.
 
     GDBS_ERROR_COUNT      ///< Number of error codes.  Not itself a valid error code.
 };
@@ -67,4 +69,238 @@ void gdbs_breakpoint(void);
  */
 void gdbs_enter(void);
 
+/**
+ * Check for an interrupt request from GDB while the target is running.  Call this periodically,
+ * such as from a timer or communications receive interrupt handler.  Waiting characters are read
+ * with gdbs_receive_poll(), and if GDB has sent an interrupt the stub is entered through
+ * gdbs_breakpoint() and the stop is reported as GDBS_SIGNAL_INT.  In non-stop mode, the stub is
+ * also entered when a packet starts, so that it can be served while the target is running.
+ * Otherwise, waiting console output is sent in a single 'O' packet, which is not permitted in
+ * non-stop mode.  Nothing is read or sent while the stub itself is active.
+ *
+ * @return Boolean indicating that the stub was entered.
+ */
+int gdbs_comm_poll(void);
+
+/**
+ * Write application output to the GDB console, such as from the back end of printf().  Output is
+ * queued in a ring buffer without taking a lock, so this may be called from any context, and is
+ * sent to GDB in batches as 'O' packets: while the stub is active, and from gdbs_comm_poll() while
+ * the target runs.  Output which does not fit in the buffer is discarded.
+ *
+ * @return Number of bytes queued.
+ */
+unsigned int gdbs_console_write
+(
+    const void      *buffer, ///< Output data.
+    unsigned int     length  ///< Length of the data.
+);
+
+/// Number of entries in the command table of struct gdbs_stats: one for each of the commands
+/// "?cDFgGHmMpPqQsTvXzZ", in that order, and a last one for all other commands.
+#define GDBS_STATS_COMMAND_COUNT 20
+
+/// Statistics of the packets received for one command.
+struct gdbs_command_stats
+{
+    char            command;   ///< Command character, or '\0' for the entry counting all other
+                               ///< commands.
+    unsigned long   packets;   ///< Number of packets received.
+    unsigned long   bytes_in;  ///< Number of bytes received in the packets, including framing.
+    unsigned long   bytes_out; ///< Number of bytes sent while handling the packets, including
+                               ///< framing.
+    unsigned long   time;      ///< Time spent handling the packets, less the time spent sending.
+};
+
+/// Statistics of the communication between the stub and GDB.  Only collected when the stub library
+/// is built with GDBS_STATS set.  Times are in gdbs_timestamp() units, and are only accounted when
+/// GDBS_STATS_TIMING is also set.
+struct gdbs_stats
+{
+    struct gdbs_command_stats   commands[GDBS_STATS_COMMAND_COUNT];
+                                                 ///< Statistics by command.
+    unsigned long               packets_received;
+                                                 ///< Number of packets received intact.
+    unsigned long               packets_sent;    ///< Number of packets sent, other than
+                                                 ///< notifications.
+    unsigned long               notifications_sent;
+                                                 ///< Number of notification packets sent.
+    unsigned long               bytes_received;  ///< Number of bytes received, including acks and
+                                                 ///< discarded data.
+    unsigned long               bytes_sent;      ///< Number of bytes sent, including acks.
+    unsigned long               acks_received;   ///< Number of ACKs received.
+    unsigned long               acks_sent;       ///< Number of ACKs sent.
+    unsigned long               nacks_received;  ///< Number of NACKs received.  Packets are sent as
+                                                 ///< they are produced, so they are never sent
+                                                 ///< again.
+    unsigned long               nacks_sent;      ///< Number of NACKs sent.
+    unsigned long               checksum_failures;
+                                                 ///< Number of packets received with a bad
+                                                 ///< checksum.
+    unsigned long               resyncs;         ///< Number of times that data other than acks was
+                                                 ///< discarded while waiting for a packet to start.
+    unsigned long               retransmits;     ///< Number of packets which GDB sent again after a
+                                                 ///< NACK.
+    unsigned long               receive_time;    ///< Time from the start to the end of received
+                                                 ///< packets.
+    unsigned long               dispatch_time;   ///< Time spent handling received packets, less the
+                                                 ///< time spent sending.
+    unsigned long               transmit_time;   ///< Time spent sending.
+};
+
+/**
+ * Read the statistics of the communication between the stub and GDB.  Only available when the stub
+ * library is built with GDBS_STATS set.  Counters are updated without a lock, so the statistics
+ * may be read part way through an update if the stub is active in another context.
+ */
+void gdbs_get_stats
+(
+    struct gdbs_stats *stats ///< [out] Statistics collected since the last reset.
+);
+
+/**
+ * Reset the statistics of the communication between the stub and GDB to zero.  Only available when
+ * the stub library is built with GDBS_STATS set.
+ */
+void gdbs_reset_stats(void);
+
+/// Flags for gdbs_host_open(), as defined by the GDB File-I/O protocol.
+#define GDBS_HOST_O_RDONLY  0x000 ///< Open for reading only.
+#define GDBS_HOST_O_WRONLY  0x001 ///< Open for writing only.
+#define GDBS_HOST_O_RDWR    0x002 ///< Open for reading and writing.
+#define GDBS_HOST_O_APPEND  0x008 ///< Write at the end of the file.
+#define GDBS_HOST_O_CREAT   0x200 ///< Create the file if it does not exist.
+#define GDBS_HOST_O_TRUNC   0x400 ///< Truncate the file to zero length.
+#define GDBS_HOST_O_EXCL    0x800 ///< Fail if the file exists.
+
+/// Errors reported by host calls, as defined by the GDB File-I/O protocol.
+enum gdbs_host_error
+{
+    GDBS_HOST_EPERM        = 1,    ///< Operation not permitted.
+    GDBS_HOST_ENOENT       = 2,    ///< No such file or directory.
+    GDBS_HOST_EINTR        = 4,    ///< Interrupted by the user in GDB.
+    GDBS_HOST_EBADF        = 9,    ///< Bad file descriptor.
+    GDBS_HOST_EACCES       = 13,   ///< Permission denied.
+    GDBS_HOST_EFAULT       = 14,   ///< Bad buffer address.
+    GDBS_HOST_EBUSY        = 16,   ///< Resource busy, such as by another host call in progress.
+    GDBS_HOST_EEXIST       = 17,   ///< File exists.
+    GDBS_HOST_ENODEV       = 19,   ///< No such device.
+    GDBS_HOST_ENOTDIR      = 20,   ///< Not a directory.
+    GDBS_HOST_EISDIR       = 21,   ///< Is a directory.
+    GDBS_HOST_EINVAL       = 22,   ///< Invalid argument.
+    GDBS_HOST_ENFILE       = 23,   ///< Too many open files on the host.
+    GDBS_HOST_EMFILE       = 24,   ///< Too many open files in GDB.
+    GDBS_HOST_EFBIG        = 27,   ///< File too large.
+    GDBS_HOST_ENOSPC       = 28,   ///< No space left on the host.
+    GDBS_HOST_ESPIPE       = 29,   ///< Illegal seek.
+    GDBS_HOST_EROFS        = 30,   ///< Read-only file system.
+    GDBS_HOST_ENAMETOOLONG = 91,   ///< File name too long.
+    GDBS_HOST_EUNKNOWN     = 9999  ///< Any other error, including a call the stub could not make.
+};
+
+/**
+ * Open a file on the host running GDB, through the GDB File-I/O protocol.  This and the other host
+ * calls stop the target while GDB carries them out, and GDB must be attached.  They cannot be made
+ * in non-stop mode, or while the stub is active.  Descriptors 0, 1, and 2 are GDB's console, and
+ * are always open.
+ *
+ * @return File descriptor, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_open
+(
+    const char      *path,  ///< Path of the file on the host.
+    int              flags, ///< GDBS_HOST_O_\* flags.
+    unsigned int     mode   ///< Permissions for a created file, as the usual octal value.
+);
+
+/**
+ * Close a file on the host running GDB.
+ *
+ * @return Zero, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_close
+(
+    int fd ///< File descriptor.
+);
+
+/**
+ * Read from a file on the host running GDB.  GDB writes the data straight into the buffer.
+ *
+ * @return Number of bytes read, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_read
+(
+    int              fd,     ///< File descriptor.
+    void            *buffer, ///< Buffer for the data.
+    unsigned int     length  ///< Length of the buffer.
+);
+
+/**
+ * Write to a file on the host running GDB.  The whole buffer is passed in one call, and GDB reads
+ * it from target memory in packets as large as the stub accepts, so large writes cost few round
+ * trips.
+ *
+ * @return Number of bytes written, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_write
+(
+    int              fd,     ///< File descriptor.
+    const void      *buffer, ///< Data to write.
+    unsigned int     length  ///< Length of the data.
+);
+
+/// Static tracepoint marker, defined with GDBS_TRACE_MARKER().
+struct gdbs_marker
+{
+    volatile unsigned char   enabled; ///< Nonzero while a static tracepoint collects at the marker.
+    const char              *id;      ///< Marker name.
+    const char              *format;  ///< printf-like format of the marker arguments.
+};
+
+/// Attributes which place a marker in the gdbs_markers linker section, where the stub lists it for
+/// GDB, and the hint that a marker is normally disabled.  Without GNU extensions, markers are
+/// invisible to GDB and never enabled.
+#if defined(__GNUC__)
+#   define GDBS_MARKER_ATTRIBUTES \
+        __attribute__((section("gdbs_markers"), used, aligned(sizeof(void *))))
+#   define GDBS_MARKER_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#   define GDBS_MARKER_ATTRIBUTES
+#   define GDBS_MARKER_UNLIKELY(x) (x)
+#endif
+
+/// Select the format from the arguments of GDBS_TRACE_MARKER().
+#define GDBS_MARKER_FORMAT(f, ...) f
+
+/**
+ * Place a static tracepoint marker, which GDB can trace with 'strace -m <id>'.  The arguments
+ * follow the marker name and a printf-like format string, which supports the d, i, u, o, x, X, c,
+ * p, s, and floating point conversions.  While the marker is disabled, this costs one load and one
+ * branch.  While it is enabled, the arguments are recorded in the trace buffer.
+ *
+ * For example: GDBS_TRACE_MARKER(motor_start, "speed=%u dir=%d", speed, dir);
+ */
+#define GDBS_TRACE_MARKER(id, ...)                                                                \
+    do                                                                                            \
+    {                                                                                             \
+        static struct gdbs_marker gdbs_marker_ GDBS_MARKER_ATTRIBUTES =                           \
+            { 0, #id, GDBS_MARKER_FORMAT(__VA_ARGS__, "") };                                      \
+        if (GDBS_MARKER_UNLIKELY(gdbs_marker_.enabled))                                           \
+        {                                                                                         \
+            gdbs_trace_marker(&gdbs_marker_, __VA_ARGS__);                                        \
+        }                                                                                         \
+    } while (0)
+
+/**
+ * Record the arguments of an enabled static tracepoint marker.  Use GDBS_TRACE_MARKER() rather than
+ * calling this directly.  Records are dropped while the stub is active, or while another marker is
+ * being recorded.
+ */
+void gdbs_trace_marker
+(
+    struct gdbs_marker  *marker, ///< Marker which was reached.
+    const char          *format, ///< Format of the arguments, as for the marker.
+    ...                          ///< Marker arguments.
+);
+
 #endif /* end GDBSTUB_H_ */
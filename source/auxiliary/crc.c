@@ -0,0 +1,280 @@
+/**
+ *  @file       crc.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      CRC-32 algorithm used by GDB protocol.
+ *
+ *  By default the CRC is calculated four bytes at a time, using four 256 entry tables.  Setting
+ *  GDBS_CRC_SLICING to 0 trades speed for size, calculating four bits at a time with a single 16
+ *  entry table.
+ */
+#include "gdbsconfig.h"
+
+#include "crc.h"
+
+#include "stdc/assert.h"
+#include "stdc/null.h"
+
+/// Mask of the bits of a CRC value.
+#define CRC_MASK 0xFFFFFFFFUL
+
+#if GDBS_CRC_SLICING
+
+/// Lookup tables for four bytes at a time.  Table k holds the CRC of each byte value followed by k
+/// zero bytes.
+static const unsigned long crc_tables[4][256] =
+{
+    {
+        0x00000000UL, 0x04C11DB7UL, 0x09823B6EUL, 0x0D4326D9UL, 0x130476DCUL, 0x17C56B6BUL,
+        0x1A864DB2UL, 0x1E475005UL, 0x2608EDB8UL, 0x22C9F00FUL, 0x2F8AD6D6UL, 0x2B4BCB61UL,
+        0x350C9B64UL, 0x31CD86D3UL, 0x3C8EA00AUL, 0x384FBDBDUL, 0x4C11DB70UL, 0x48D0C6C7UL,
+        0x4593E01EUL, 0x4152FDA9UL, 0x5F15ADACUL, 0x5BD4B01BUL, 0x569796C2UL, 0x52568B75UL,
+        0x6A1936C8UL, 0x6ED82B7FUL, 0x639B0DA6UL, 0x675A1011UL, 0x791D4014UL, 0x7DDC5DA3UL,
+        0x709F7B7AUL, 0x745E66CDUL, 0x9823B6E0UL, 0x9CE2AB57UL, 0x91A18D8EUL, 0x95609039UL,
+        0x8B27C03CUL, 0x8FE6DD8BUL, 0x82A5FB52UL, 0x8664E6E5UL, 0xBE2B5B58UL, 0xBAEA46EFUL,
+        0xB7A96036UL, 0xB3687D81UL, 0xAD2F2D84UL, 0xA9EE3033UL, 0xA4AD16EAUL, 0xA06C0B5DUL,
+        0xD4326D90UL, 0xD0F37027UL, 0xDDB056FEUL, 0xD9714B49UL, 0xC7361B4CUL, 0xC3F706FBUL,
+        0xCEB42022UL, 0xCA753D95UL, 0xF23A8028UL, 0xF6FB9D9FUL, 0xFBB8BB46UL, 0xFF79A6F1UL,
+        0xE13EF6F4UL, 0xE5FFEB43UL, 0xE8BCCD9AUL, 0xEC7DD02DUL, 0x34867077UL, 0x30476DC0UL,
+        0x3D044B19UL, 0x39C556AEUL, 0x278206ABUL, 0x23431B1CUL, 0x2E003DC5UL, 0x2AC12072UL,
+        0x128E9DCFUL, 0x164F8078UL, 0x1B0CA6A1UL, 0x1FCDBB16UL, 0x018AEB13UL, 0x054BF6A4UL,
+        0x0808D07DUL, 0x0CC9CDCAUL, 0x7897AB07UL, 0x7C56B6B0UL, 0x71159069UL, 0x75D48DDEUL,
+        0x6B93DDDBUL, 0x6F52C06CUL, 0x6211E6B5UL, 0x66D0FB02UL, 0x5E9F46BFUL, 0x5A5E5B08UL,
+        0x571D7DD1UL, 0x53DC6066UL, 0x4D9B3063UL, 0x495A2DD4UL, 0x44190B0DUL, 0x40D816BAUL,
+        0xACA5C697UL, 0xA864DB20UL, 0xA527FDF9UL, 0xA1E6E04EUL, 0xBFA1B04BUL, 0xBB60ADFCUL,
+        0xB6238B25UL, 0xB2E29692UL, 0x8AAD2B2FUL, 0x8E6C3698UL, 0x832F1041UL, 0x87EE0DF6UL,
+        0x99A95DF3UL, 0x9D684044UL, 0x902B669DUL, 0x94EA7B2AUL, 0xE0B41DE7UL, 0xE4750050UL,
+        0xE9362689UL, 0xEDF73B3EUL, 0xF3B06B3BUL, 0xF771768CUL, 0xFA325055UL, 0xFEF34DE2UL,
+        0xC6BCF05FUL, 0xC27DEDE8UL, 0xCF3ECB31UL, 0xCBFFD686UL, 0xD5B88683UL, 0xD1799B34UL,
+        0xDC3ABDEDUL, 0xD8FBA05AUL, 0x690CE0EEUL, 0x6DCDFD59UL, 0x608EDB80UL, 0x644FC637UL,
+        0x7A089632UL, 0x7EC98B85UL, 0x738AAD5CUL, 0x774BB0EBUL, 0x4F040D56UL, 0x4BC510E1UL,
+        0x46863638UL, 0x42472B8FUL, 0x5C007B8AUL, 0x58C1663DUL, 0x558240E4UL, 0x51435D53UL,
+        0x251D3B9EUL, 0x21DC2629UL, 0x2C9F00F0UL, 0x285E1D47UL, 0x36194D42UL, 0x32D850F5UL,
+        0x3F9B762CUL, 0x3B5A6B9BUL, 0x0315D626UL, 0x07D4CB91UL, 0x0A97ED48UL, 0x0E56F0FFUL,
+        0x1011A0FAUL, 0x14D0BD4DUL, 0x19939B94UL, 0x1D528623UL, 0xF12F560EUL, 0xF5EE4BB9UL,
+        0xF8AD6D60UL, 0xFC6C70D7UL, 0xE22B20D2UL, 0xE6EA3D65UL, 0xEBA91BBCUL, 0xEF68060BUL,
+        0xD727BBB6UL, 0xD3E6A601UL, 0xDEA580D8UL, 0xDA649D6FUL, 0xC423CD6AUL, 0xC0E2D0DDUL,
+        0xCDA1F604UL, 0xC960EBB3UL, 0xBD3E8D7EUL, 0xB9FF90C9UL, 0xB4BCB610UL, 0xB07DABA7UL,
+        0xAE3AFBA2UL, 0xAAFBE615UL, 0xA7B8C0CCUL, 0xA379DD7BUL, 0x9B3660C6UL, 0x9FF77D71UL,
+        0x92B45BA8UL, 0x9675461FUL, 0x8832161AUL, 0x8CF30BADUL, 0x81B02D74UL, 0x857130C3UL,
+        0x5D8A9099UL, 0x594B8D2EUL, 0x5408ABF7UL, 0x50C9B640UL, 0x4E8EE645UL, 0x4A4FFBF2UL,
+        0x470CDD2BUL, 0x43CDC09CUL, 0x7B827D21UL, 0x7F436096UL, 0x7200464FUL, 0x76C15BF8UL,
+        0x68860BFDUL, 0x6C47164AUL, 0x61043093UL, 0x65C52D24UL, 0x119B4BE9UL, 0x155A565EUL,
+        0x18197087UL, 0x1CD86D30UL, 0x029F3D35UL, 0x065E2082UL, 0x0B1D065BUL, 0x0FDC1BECUL,
+        0x3793A651UL, 0x3352BBE6UL, 0x3E119D3FUL, 0x3AD08088UL, 0x2497D08DUL, 0x2056CD3AUL,
+        0x2D15EBE3UL, 0x29D4F654UL, 0xC5A92679UL, 0xC1683BCEUL, 0xCC2B1D17UL, 0xC8EA00A0UL,
+        0xD6AD50A5UL, 0xD26C4D12UL, 0xDF2F6BCBUL, 0xDBEE767CUL, 0xE3A1CBC1UL, 0xE760D676UL,
+        0xEA23F0AFUL, 0xEEE2ED18UL, 0xF0A5BD1DUL, 0xF464A0AAUL, 0xF9278673UL, 0xFDE69BC4UL,
+        0x89B8FD09UL, 0x8D79E0BEUL, 0x803AC667UL, 0x84FBDBD0UL, 0x9ABC8BD5UL, 0x9E7D9662UL,
+        0x933EB0BBUL, 0x97FFAD0CUL, 0xAFB010B1UL, 0xAB710D06UL, 0xA6322BDFUL, 0xA2F33668UL,
+        0xBCB4666DUL, 0xB8757BDAUL, 0xB5365D03UL, 0xB1F740B4UL,
+    },
+    {
+        0x00000000UL, 0xD219C1DCUL, 0xA0F29E0FUL, 0x72EB5FD3UL, 0x452421A9UL, 0x973DE075UL,
+        0xE5D6BFA6UL, 0x37CF7E7AUL, 0x8A484352UL, 0x5851828EUL, 0x2ABADD5DUL, 0xF8A31C81UL,
+        0xCF6C62FBUL, 0x1D75A327UL, 0x6F9EFCF4UL, 0xBD873D28UL, 0x10519B13UL, 0xC2485ACFUL,
+        0xB0A3051CUL, 0x62BAC4C0UL, 0x5575BABAUL, 0x876C7B66UL, 0xF58724B5UL, 0x279EE569UL,
+        0x9A19D841UL, 0x4800199DUL, 0x3AEB464EUL, 0xE8F28792UL, 0xDF3DF9E8UL, 0x0D243834UL,
+        0x7FCF67E7UL, 0xADD6A63BUL, 0x20A33626UL, 0xF2BAF7FAUL, 0x8051A829UL, 0x524869F5UL,
+        0x6587178FUL, 0xB79ED653UL, 0xC5758980UL, 0x176C485CUL, 0xAAEB7574UL, 0x78F2B4A8UL,
+        0x0A19EB7BUL, 0xD8002AA7UL, 0xEFCF54DDUL, 0x3DD69501UL, 0x4F3DCAD2UL, 0x9D240B0EUL,
+        0x30F2AD35UL, 0xE2EB6CE9UL, 0x9000333AUL, 0x4219F2E6UL, 0x75D68C9CUL, 0xA7CF4D40UL,
+        0xD5241293UL, 0x073DD34FUL, 0xBABAEE67UL, 0x68A32FBBUL, 0x1A487068UL, 0xC851B1B4UL,
+        0xFF9ECFCEUL, 0x2D870E12UL, 0x5F6C51C1UL, 0x8D75901DUL, 0x41466C4CUL, 0x935FAD90UL,
+        0xE1B4F243UL, 0x33AD339FUL, 0x04624DE5UL, 0xD67B8C39UL, 0xA490D3EAUL, 0x76891236UL,
+        0xCB0E2F1EUL, 0x1917EEC2UL, 0x6BFCB111UL, 0xB9E570CDUL, 0x8E2A0EB7UL, 0x5C33CF6BUL,
+        0x2ED890B8UL, 0xFCC15164UL, 0x5117F75FUL, 0x830E3683UL, 0xF1E56950UL, 0x23FCA88CUL,
+        0x1433D6F6UL, 0xC62A172AUL, 0xB4C148F9UL, 0x66D88925UL, 0xDB5FB40DUL, 0x094675D1UL,
+        0x7BAD2A02UL, 0xA9B4EBDEUL, 0x9E7B95A4UL, 0x4C625478UL, 0x3E890BABUL, 0xEC90CA77UL,
+        0x61E55A6AUL, 0xB3FC9BB6UL, 0xC117C465UL, 0x130E05B9UL, 0x24C17BC3UL, 0xF6D8BA1FUL,
+        0x8433E5CCUL, 0x562A2410UL, 0xEBAD1938UL, 0x39B4D8E4UL, 0x4B5F8737UL, 0x994646EBUL,
+        0xAE893891UL, 0x7C90F94DUL, 0x0E7BA69EUL, 0xDC626742UL, 0x71B4C179UL, 0xA3AD00A5UL,
+        0xD1465F76UL, 0x035F9EAAUL, 0x3490E0D0UL, 0xE689210CUL, 0x94627EDFUL, 0x467BBF03UL,
+        0xFBFC822BUL, 0x29E543F7UL, 0x5B0E1C24UL, 0x8917DDF8UL, 0xBED8A382UL, 0x6CC1625EUL,
+        0x1E2A3D8DUL, 0xCC33FC51UL, 0x828CD898UL, 0x50951944UL, 0x227E4697UL, 0xF067874BUL,
+        0xC7A8F931UL, 0x15B138EDUL, 0x675A673EUL, 0xB543A6E2UL, 0x08C49BCAUL, 0xDADD5A16UL,
+        0xA83605C5UL, 0x7A2FC419UL, 0x4DE0BA63UL, 0x9FF97BBFUL, 0xED12246CUL, 0x3F0BE5B0UL,
+        0x92DD438BUL, 0x40C48257UL, 0x322FDD84UL, 0xE0361C58UL, 0xD7F96222UL, 0x05E0A3FEUL,
+        0x770BFC2DUL, 0xA5123DF1UL, 0x189500D9UL, 0xCA8CC105UL, 0xB8679ED6UL, 0x6A7E5F0AUL,
+        0x5DB12170UL, 0x8FA8E0ACUL, 0xFD43BF7FUL, 0x2F5A7EA3UL, 0xA22FEEBEUL, 0x70362F62UL,
+        0x02DD70B1UL, 0xD0C4B16DUL, 0xE70BCF17UL, 0x35120ECBUL, 0x47F95118UL, 0x95E090C4UL,
+        0x2867ADECUL, 0xFA7E6C30UL, 0x889533E3UL, 0x5A8CF23FUL, 0x6D438C45UL, 0xBF5A4D99UL,
+        0xCDB1124AUL, 0x1FA8D396UL, 0xB27E75ADUL, 0x6067B471UL, 0x128CEBA2UL, 0xC0952A7EUL,
+        0xF75A5404UL, 0x254395D8UL, 0x57A8CA0BUL, 0x85B10BD7UL, 0x383636FFUL, 0xEA2FF723UL,
+        0x98C4A8F0UL, 0x4ADD692CUL, 0x7D121756UL, 0xAF0BD68AUL, 0xDDE08959UL, 0x0FF94885UL,
+        0xC3CAB4D4UL, 0x11D37508UL, 0x63382ADBUL, 0xB121EB07UL, 0x86EE957DUL, 0x54F754A1UL,
+        0x261C0B72UL, 0xF405CAAEUL, 0x4982F786UL, 0x9B9B365AUL, 0xE9706989UL, 0x3B69A855UL,
+        0x0CA6D62FUL, 0xDEBF17F3UL, 0xAC544820UL, 0x7E4D89FCUL, 0xD39B2FC7UL, 0x0182EE1BUL,
+        0x7369B1C8UL, 0xA1707014UL, 0x96BF0E6EUL, 0x44A6CFB2UL, 0x364D9061UL, 0xE45451BDUL,
+        0x59D36C95UL, 0x8BCAAD49UL, 0xF921F29AUL, 0x2B383346UL, 0x1CF74D3CUL, 0xCEEE8CE0UL,
+        0xBC05D333UL, 0x6E1C12EFUL, 0xE36982F2UL, 0x3170432EUL, 0x439B1CFDUL, 0x9182DD21UL,
+        0xA64DA35BUL, 0x74546287UL, 0x06BF3D54UL, 0xD4A6FC88UL, 0x6921C1A0UL, 0xBB38007CUL,
+        0xC9D35FAFUL, 0x1BCA9E73UL, 0x2C05E009UL, 0xFE1C21D5UL, 0x8CF77E06UL, 0x5EEEBFDAUL,
+        0xF33819E1UL, 0x2121D83DUL, 0x53CA87EEUL, 0x81D34632UL, 0xB61C3848UL, 0x6405F994UL,
+        0x16EEA647UL, 0xC4F7679BUL, 0x79705AB3UL, 0xAB699B6FUL, 0xD982C4BCUL, 0x0B9B0560UL,
+        0x3C547B1AUL, 0xEE4DBAC6UL, 0x9CA6E515UL, 0x4EBF24C9UL,
+    },
+    {
+        0x00000000UL, 0x01D8AC87UL, 0x03B1590EUL, 0x0269F589UL, 0x0762B21CUL, 0x06BA1E9BUL,
+        0x04D3EB12UL, 0x050B4795UL, 0x0EC56438UL, 0x0F1DC8BFUL, 0x0D743D36UL, 0x0CAC91B1UL,
+        0x09A7D624UL, 0x087F7AA3UL, 0x0A168F2AUL, 0x0BCE23ADUL, 0x1D8AC870UL, 0x1C5264F7UL,
+        0x1E3B917EUL, 0x1FE33DF9UL, 0x1AE87A6CUL, 0x1B30D6EBUL, 0x19592362UL, 0x18818FE5UL,
+        0x134FAC48UL, 0x129700CFUL, 0x10FEF546UL, 0x112659C1UL, 0x142D1E54UL, 0x15F5B2D3UL,
+        0x179C475AUL, 0x1644EBDDUL, 0x3B1590E0UL, 0x3ACD3C67UL, 0x38A4C9EEUL, 0x397C6569UL,
+        0x3C7722FCUL, 0x3DAF8E7BUL, 0x3FC67BF2UL, 0x3E1ED775UL, 0x35D0F4D8UL, 0x3408585FUL,
+        0x3661ADD6UL, 0x37B90151UL, 0x32B246C4UL, 0x336AEA43UL, 0x31031FCAUL, 0x30DBB34DUL,
+        0x269F5890UL, 0x2747F417UL, 0x252E019EUL, 0x24F6AD19UL, 0x21FDEA8CUL, 0x2025460BUL,
+        0x224CB382UL, 0x23941F05UL, 0x285A3CA8UL, 0x2982902FUL, 0x2BEB65A6UL, 0x2A33C921UL,
+        0x2F388EB4UL, 0x2EE02233UL, 0x2C89D7BAUL, 0x2D517B3DUL, 0x762B21C0UL, 0x77F38D47UL,
+        0x759A78CEUL, 0x7442D449UL, 0x714993DCUL, 0x70913F5BUL, 0x72F8CAD2UL, 0x73206655UL,
+        0x78EE45F8UL, 0x7936E97FUL, 0x7B5F1CF6UL, 0x7A87B071UL, 0x7F8CF7E4UL, 0x7E545B63UL,
+        0x7C3DAEEAUL, 0x7DE5026DUL, 0x6BA1E9B0UL, 0x6A794537UL, 0x6810B0BEUL, 0x69C81C39UL,
+        0x6CC35BACUL, 0x6D1BF72BUL, 0x6F7202A2UL, 0x6EAAAE25UL, 0x65648D88UL, 0x64BC210FUL,
+        0x66D5D486UL, 0x670D7801UL, 0x62063F94UL, 0x63DE9313UL, 0x61B7669AUL, 0x606FCA1DUL,
+        0x4D3EB120UL, 0x4CE61DA7UL, 0x4E8FE82EUL, 0x4F5744A9UL, 0x4A5C033CUL, 0x4B84AFBBUL,
+        0x49ED5A32UL, 0x4835F6B5UL, 0x43FBD518UL, 0x4223799FUL, 0x404A8C16UL, 0x41922091UL,
+        0x44996704UL, 0x4541CB83UL, 0x47283E0AUL, 0x46F0928DUL, 0x50B47950UL, 0x516CD5D7UL,
+        0x5305205EUL, 0x52DD8CD9UL, 0x57D6CB4CUL, 0x560E67CBUL, 0x54679242UL, 0x55BF3EC5UL,
+        0x5E711D68UL, 0x5FA9B1EFUL, 0x5DC04466UL, 0x5C18E8E1UL, 0x5913AF74UL, 0x58CB03F3UL,
+        0x5AA2F67AUL, 0x5B7A5AFDUL, 0xEC564380UL, 0xED8EEF07UL, 0xEFE71A8EUL, 0xEE3FB609UL,
+        0xEB34F19CUL, 0xEAEC5D1BUL, 0xE885A892UL, 0xE95D0415UL, 0xE29327B8UL, 0xE34B8B3FUL,
+        0xE1227EB6UL, 0xE0FAD231UL, 0xE5F195A4UL, 0xE4293923UL, 0xE640CCAAUL, 0xE798602DUL,
+        0xF1DC8BF0UL, 0xF0042777UL, 0xF26DD2FEUL, 0xF3B57E79UL, 0xF6BE39ECUL, 0xF766956BUL,
+        0xF50F60E2UL, 0xF4D7CC65UL, 0xFF19EFC8UL, 0xFEC1434FUL, 0xFCA8B6C6UL, 0xFD701A41UL,
+        0xF87B5DD4UL, 0xF9A3F153UL, 0xFBCA04DAUL, 0xFA12A85DUL, 0xD743D360UL, 0xD69B7FE7UL,
+        0xD4F28A6EUL, 0xD52A26E9UL, 0xD021617CUL, 0xD1F9CDFBUL, 0xD3903872UL, 0xD24894F5UL,
+        0xD986B758UL, 0xD85E1BDFUL, 0xDA37EE56UL, 0xDBEF42D1UL, 0xDEE40544UL, 0xDF3CA9C3UL,
+        0xDD555C4AUL, 0xDC8DF0CDUL, 0xCAC91B10UL, 0xCB11B797UL, 0xC978421EUL, 0xC8A0EE99UL,
+        0xCDABA90CUL, 0xCC73058BUL, 0xCE1AF002UL, 0xCFC25C85UL, 0xC40C7F28UL, 0xC5D4D3AFUL,
+        0xC7BD2626UL, 0xC6658AA1UL, 0xC36ECD34UL, 0xC2B661B3UL, 0xC0DF943AUL, 0xC10738BDUL,
+        0x9A7D6240UL, 0x9BA5CEC7UL, 0x99CC3B4EUL, 0x981497C9UL, 0x9D1FD05CUL, 0x9CC77CDBUL,
+        0x9EAE8952UL, 0x9F7625D5UL, 0x94B80678UL, 0x9560AAFFUL, 0x97095F76UL, 0x96D1F3F1UL,
+        0x93DAB464UL, 0x920218E3UL, 0x906BED6AUL, 0x91B341EDUL, 0x87F7AA30UL, 0x862F06B7UL,
+        0x8446F33EUL, 0x859E5FB9UL, 0x8095182CUL, 0x814DB4ABUL, 0x83244122UL, 0x82FCEDA5UL,
+        0x8932CE08UL, 0x88EA628FUL, 0x8A839706UL, 0x8B5B3B81UL, 0x8E507C14UL, 0x8F88D093UL,
+        0x8DE1251AUL, 0x8C39899DUL, 0xA168F2A0UL, 0xA0B05E27UL, 0xA2D9ABAEUL, 0xA3010729UL,
+        0xA60A40BCUL, 0xA7D2EC3BUL, 0xA5BB19B2UL, 0xA463B535UL, 0xAFAD9698UL, 0xAE753A1FUL,
+        0xAC1CCF96UL, 0xADC46311UL, 0xA8CF2484UL, 0xA9178803UL, 0xAB7E7D8AUL, 0xAAA6D10DUL,
+        0xBCE23AD0UL, 0xBD3A9657UL, 0xBF5363DEUL, 0xBE8BCF59UL, 0xBB8088CCUL, 0xBA58244BUL,
+        0xB831D1C2UL, 0xB9E97D45UL, 0xB2275EE8UL, 0xB3FFF26FUL, 0xB19607E6UL, 0xB04EAB61UL,
+        0xB545ECF4UL, 0xB49D4073UL, 0xB6F4B5FAUL, 0xB72C197DUL,
+    },
+    {
+        0x00000000UL, 0xDC6D9AB7UL, 0xBC1A28D9UL, 0x6077B26EUL, 0x7CF54C05UL, 0xA098D6B2UL,
+        0xC0EF64DCUL, 0x1C82FE6BUL, 0xF9EA980AUL, 0x258702BDUL, 0x45F0B0D3UL, 0x999D2A64UL,
+        0x851FD40FUL, 0x59724EB8UL, 0x3905FCD6UL, 0xE5686661UL, 0xF7142DA3UL, 0x2B79B714UL,
+        0x4B0E057AUL, 0x97639FCDUL, 0x8BE161A6UL, 0x578CFB11UL, 0x37FB497FUL, 0xEB96D3C8UL,
+        0x0EFEB5A9UL, 0xD2932F1EUL, 0xB2E49D70UL, 0x6E8907C7UL, 0x720BF9ACUL, 0xAE66631BUL,
+        0xCE11D175UL, 0x127C4BC2UL, 0xEAE946F1UL, 0x3684DC46UL, 0x56F36E28UL, 0x8A9EF49FUL,
+        0x961C0AF4UL, 0x4A719043UL, 0x2A06222DUL, 0xF66BB89AUL, 0x1303DEFBUL, 0xCF6E444CUL,
+        0xAF19F622UL, 0x73746C95UL, 0x6FF692FEUL, 0xB39B0849UL, 0xD3ECBA27UL, 0x0F812090UL,
+        0x1DFD6B52UL, 0xC190F1E5UL, 0xA1E7438BUL, 0x7D8AD93CUL, 0x61082757UL, 0xBD65BDE0UL,
+        0xDD120F8EUL, 0x017F9539UL, 0xE417F358UL, 0x387A69EFUL, 0x580DDB81UL, 0x84604136UL,
+        0x98E2BF5DUL, 0x448F25EAUL, 0x24F89784UL, 0xF8950D33UL, 0xD1139055UL, 0x0D7E0AE2UL,
+        0x6D09B88CUL, 0xB164223BUL, 0xADE6DC50UL, 0x718B46E7UL, 0x11FCF489UL, 0xCD916E3EUL,
+        0x28F9085FUL, 0xF49492E8UL, 0x94E32086UL, 0x488EBA31UL, 0x540C445AUL, 0x8861DEEDUL,
+        0xE8166C83UL, 0x347BF634UL, 0x2607BDF6UL, 0xFA6A2741UL, 0x9A1D952FUL, 0x46700F98UL,
+        0x5AF2F1F3UL, 0x869F6B44UL, 0xE6E8D92AUL, 0x3A85439DUL, 0xDFED25FCUL, 0x0380BF4BUL,
+        0x63F70D25UL, 0xBF9A9792UL, 0xA31869F9UL, 0x7F75F34EUL, 0x1F024120UL, 0xC36FDB97UL,
+        0x3BFAD6A4UL, 0xE7974C13UL, 0x87E0FE7DUL, 0x5B8D64CAUL, 0x470F9AA1UL, 0x9B620016UL,
+        0xFB15B278UL, 0x277828CFUL, 0xC2104EAEUL, 0x1E7DD419UL, 0x7E0A6677UL, 0xA267FCC0UL,
+        0xBEE502ABUL, 0x6288981CUL, 0x02FF2A72UL, 0xDE92B0C5UL, 0xCCEEFB07UL, 0x108361B0UL,
+        0x70F4D3DEUL, 0xAC994969UL, 0xB01BB702UL, 0x6C762DB5UL, 0x0C019FDBUL, 0xD06C056CUL,
+        0x3504630DUL, 0xE969F9BAUL, 0x891E4BD4UL, 0x5573D163UL, 0x49F12F08UL, 0x959CB5BFUL,
+        0xF5EB07D1UL, 0x29869D66UL, 0xA6E63D1DUL, 0x7A8BA7AAUL, 0x1AFC15C4UL, 0xC6918F73UL,
+        0xDA137118UL, 0x067EEBAFUL, 0x660959C1UL, 0xBA64C376UL, 0x5F0CA517UL, 0x83613FA0UL,
+        0xE3168DCEUL, 0x3F7B1779UL, 0x23F9E912UL, 0xFF9473A5UL, 0x9FE3C1CBUL, 0x438E5B7CUL,
+        0x51F210BEUL, 0x8D9F8A09UL, 0xEDE83867UL, 0x3185A2D0UL, 0x2D075CBBUL, 0xF16AC60CUL,
+        0x911D7462UL, 0x4D70EED5UL, 0xA81888B4UL, 0x74751203UL, 0x1402A06DUL, 0xC86F3ADAUL,
+        0xD4EDC4B1UL, 0x08805E06UL, 0x68F7EC68UL, 0xB49A76DFUL, 0x4C0F7BECUL, 0x9062E15BUL,
+        0xF0155335UL, 0x2C78C982UL, 0x30FA37E9UL, 0xEC97AD5EUL, 0x8CE01F30UL, 0x508D8587UL,
+        0xB5E5E3E6UL, 0x69887951UL, 0x09FFCB3FUL, 0xD5925188UL, 0xC910AFE3UL, 0x157D3554UL,
+        0x750A873AUL, 0xA9671D8DUL, 0xBB1B564FUL, 0x6776CCF8UL, 0x07017E96UL, 0xDB6CE421UL,
+        0xC7EE1A4AUL, 0x1B8380FDUL, 0x7BF43293UL, 0xA799A824UL, 0x42F1CE45UL, 0x9E9C54F2UL,
+        0xFEEBE69CUL, 0x22867C2BUL, 0x3E048240UL, 0xE26918F7UL, 0x821EAA99UL, 0x5E73302EUL,
+        0x77F5AD48UL, 0xAB9837FFUL, 0xCBEF8591UL, 0x17821F26UL, 0x0B00E14DUL, 0xD76D7BFAUL,
+        0xB71AC994UL, 0x6B775323UL, 0x8E1F3542UL, 0x5272AFF5UL, 0x32051D9BUL, 0xEE68872CUL,
+        0xF2EA7947UL, 0x2E87E3F0UL, 0x4EF0519EUL, 0x929DCB29UL, 0x80E180EBUL, 0x5C8C1A5CUL,
+        0x3CFBA832UL, 0xE0963285UL, 0xFC14CCEEUL, 0x20795659UL, 0x400EE437UL, 0x9C637E80UL,
+        0x790B18E1UL, 0xA5668256UL, 0xC5113038UL, 0x197CAA8FUL, 0x05FE54E4UL, 0xD993CE53UL,
+        0xB9E47C3DUL, 0x6589E68AUL, 0x9D1CEBB9UL, 0x4171710EUL, 0x2106C360UL, 0xFD6B59D7UL,
+        0xE1E9A7BCUL, 0x3D843D0BUL, 0x5DF38F65UL, 0x819E15D2UL, 0x64F673B3UL, 0xB89BE904UL,
+        0xD8EC5B6AUL, 0x0481C1DDUL, 0x18033FB6UL, 0xC46EA501UL, 0xA419176FUL, 0x78748DD8UL,
+        0x6A08C61AUL, 0xB6655CADUL, 0xD612EEC3UL, 0x0A7F7474UL, 0x16FD8A1FUL, 0xCA9010A8UL,
+        0xAAE7A2C6UL, 0x768A3871UL, 0x93E25E10UL, 0x4F8FC4A7UL, 0x2FF876C9UL, 0xF395EC7EUL,
+        0xEF171215UL, 0x337A88A2UL, 0x530D3ACCUL, 0x8F60A07BUL,
+    },
+};
+
+/**
+ * Accumulate a data buffer into a CRC value.  This is the CRC-32 calculated by GDB for 'qCRC', with
+ * the polynomial 0x04C11DB7 applied most significant bit first, and no final inversion.
+ *
+ * @return The updated CRC value.
+ */
+unsigned long crc_update
+(
+    unsigned long    crc,    ///< CRC value so far.  CRC_INITIAL to start a calculation.
+    const void      *buffer, ///< Buffer to calculate CRC over.
+    size_t           size    ///< Buffer size.
+)
+{
+    const unsigned char *bytes = (const unsigned char *) buffer;
+
+    assert(bytes != NULL || size == 0);
+
+    crc &= CRC_MASK;
+    for (; size >= 4; size -= 4, bytes += 4)
+    {
+        crc ^= ((unsigned long) bytes[0] << 24) | ((unsigned long) bytes[1] << 16) |
+               ((unsigned long) bytes[2] << 8) | bytes[3];
+        crc = crc_tables[3][crc >> 24] ^ crc_tables[2][(crc >> 16) & 0xFF] ^
+              crc_tables[1][(crc >> 8) & 0xFF] ^ crc_tables[0][crc & 0xFF];
+    }
+    for (; size > 0; --size, ++bytes)
+    {
+        crc = ((crc << 8) & CRC_MASK) ^ crc_tables[0][(crc >> 24) ^ *bytes];
+    }
+    return crc;
+}
+
+#else
+
+/// Lookup table for four bits at a time.
+static const unsigned long crc_table[16] =
+{
+    0x00000000UL, 0x04C11DB7UL, 0x09823B6EUL, 0x0D4326D9UL, 0x130476DCUL, 0x17C56B6BUL,
+    0x1A864DB2UL, 0x1E475005UL, 0x2608EDB8UL, 0x22C9F00FUL, 0x2F8AD6D6UL, 0x2B4BCB61UL,
+    0x350C9B64UL, 0x31CD86D3UL, 0x3C8EA00AUL, 0x384FBDBDUL,
+};
+
+/**
+ * Accumulate a data buffer into a CRC value.  This is the CRC-32 calculated by GDB for 'qCRC', with
+ * the polynomial 0x04C11DB7 applied most significant bit first, and no final inversion.
+ *
+ * @return The updated CRC value.
+ */
+unsigned long crc_update
+(
+    unsigned long    crc,    ///< CRC value so far.  CRC_INITIAL to start a calculation.
+    const void      *buffer, ///< Buffer to calculate CRC over.
+    size_t           size    ///< Buffer size.
+)
+{
+    const unsigned char *bytes = (const unsigned char *) buffer;
+
+    assert(bytes != NULL || size == 0);
+
+    crc &= CRC_MASK;
+    for (; size > 0; --size, ++bytes)
+    {
+        crc = ((crc << 4) & CRC_MASK) ^ crc_table[(crc >> 28) ^ (*bytes >> 4)];
+        crc = ((crc << 4) & CRC_MASK) ^ crc_table[(crc >> 28) ^ (*bytes & 0x0F)];
+    }
+    return crc;
+}
+
+#endif
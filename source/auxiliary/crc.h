@@ -0,0 +1,31 @@
+/**
+ *  @file       crc.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      CRC-32 algorithm used by GDB protocol.
+ */
+#ifndef CRC_H_
+#define CRC_H_
+
+#include "stdc/size.h"
+
+/// Initial value of a CRC calculation.
+#define CRC_INITIAL 0xFFFFFFFFUL
+
+/**
+ * Accumulate a data buffer into a CRC value.  This is the CRC-32 calculated by GDB for 'qCRC', with
+ * the polynomial 0x04C11DB7 applied most significant bit first, and no final inversion.
+ *
+ * @return The updated CRC value.
+ */
+unsigned long crc_update
+(
+    unsigned long    crc,    ///< CRC value so far.  CRC_INITIAL to start a calculation.
+    const void      *buffer, ///< Buffer to calculate CRC over.
+    size_t           size    ///< Buffer size.
+);
+
+#endif /* end CRC_H_ */
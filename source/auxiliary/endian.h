@@ -0,0 +1,68 @@
+/**
+ *  @file       endian.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Conversion of values held in a fixed number of bytes, in either byte order.
+ */
+#ifndef ENDIAN_H_
+#define ENDIAN_H_
+
+/**
+ * Determine whether the target stores multi-byte values least significant byte first.
+ *
+ * @return Boolean indicating a little-endian target.
+ */
+static inline int is_little_endian(void)
+{
+    const unsigned short probe = 1;
+
+    return (*(const unsigned char *) &probe == 1);
+}
+
+/**
+ * Store a value in a fixed number of bytes.  Bytes beyond the width of the value are zero.
+ */
+static inline void value_to_bytes
+(
+    unsigned char       *bytes, ///< [out] Destination.  Must have space for size bytes.
+    unsigned long long   value, ///< [in]  Value to store.
+    unsigned int         size,  ///< [in]  Number of bytes to store.
+    int                  little ///< [in]  Boolean indicating least significant byte first.
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < size; ++i)
+    {
+        bytes[little ? i : size - 1 - i] =
+            (unsigned char) (i < sizeof(value) ? value >> (i * 8) : 0);
+    }
+}
+
+/**
+ * Load a value held in a fixed number of bytes.  Bytes beyond the width of the value are
+ * truncated.
+ *
+ * @return Value loaded.
+ */
+static inline unsigned long long bytes_to_value
+(
+    const unsigned char *bytes, ///< [in] Source.
+    unsigned int         size,  ///< [in] Number of bytes to load.
+    int                  little ///< [in] Boolean indicating least significant byte first.
+)
+{
+    unsigned long long  value = 0;
+    unsigned int        i;
+
+    for (i = 0; i < size; ++i)
+    {
+        value = (value << 8) | bytes[little ? size - 1 - i : i];
+    }
+    return value;
+}
+
+#endif /* end ENDIAN_H_ */
@@ -121,3 +121,82 @@ void byte_to_hex_octet
     buffer[0] = nibble_to_hex_digit(byte >> 4);
     buffer[1] = nibble_to_hex_digit(byte & 0xF);
 }
+
+/**
+ * Convert a variable-length text hexadecimal value to an unsigned integer.
+ *
+ * @retval  0 Conversion successful.
+ * @retval <0 Conversion failed.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int hex_string_to_unsigned
+(
+    const char      *string, ///< [in]  Input string.  Need not be NUL-terminated.
+    size_t           length, ///< [in]  Number of characters to convert.  Must be non-zero, and the
+                             ///<       value must fit within a gdbs_address_t.
+    gdbs_address_t  *value   ///< [out] Converted value.
+)
+{
+    gdbs_address_t  result = 0;
+    size_t          i;
+    unsigned char   nibble;
+
+    assert(string != NULL);
+    assert(value != NULL);
+
+    if (length == 0 || length > sizeof(gdbs_address_t) * 2)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    for (i = 0; i < length; ++i)
+    {
+        nibble = hex_digit_to_byte(string[i]);
+        if (nibble > 0x0F)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+        result = (result << 4) | nibble;
+    }
+
+    *value = result;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Convert a string of text hexadecimal octets to the bytes they represent.
+ *
+ * @retval  0 Conversion successful.
+ * @retval <0 Conversion failed.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.  The output buffer may be partially written.
+ */
+int hex_string_to_bytes
+(
+    const char      *string, ///< [in]  Input string.  Need not be NUL-terminated.
+    size_t           length, ///< [in]  Number of characters to convert.  Must be even.
+    unsigned char   *bytes   ///< [out] Buffer to write the converted bytes to.  Must have space
+                             ///<       for length / 2 bytes.
+)
+{
+    int     result;
+    size_t  i;
+
+    assert(string != NULL);
+    assert(bytes != NULL);
+
+    if ((length % 2) != 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    for (i = 0; i < length; i += 2)
+    {
+        result = hex_octet_to_byte(&string[i], &bytes[i / 2]);
+        if (result != GDBS_ERROR_OK)
+        {
+            return result;
+        }
+    }
+
+    return GDBS_ERROR_OK;
+}
@@ -10,6 +10,10 @@
 #ifndef HEX_H_
 #define HEX_H_
 
+#include "gdbsconfig.h"
+
+#include "stdc/size.h"
+
 /**
  * Convert a single text hexadecimal value to an unsigned byte.
  *
@@ -35,4 +39,34 @@ void byte_to_hex_octet
                             ///<       to have space for two characters.
 );
 
+/**
+ * Convert a variable-length text hexadecimal value to an unsigned integer.
+ *
+ * @retval  0 Conversion successful.
+ * @retval <0 Conversion failed.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int hex_string_to_unsigned
+(
+    const char      *string, ///< [in]  Input string.  Need not be NUL-terminated.
+    size_t           length, ///< [in]  Number of characters to convert.  Must be non-zero, and the
+                             ///<       value must fit within a gdbs_address_t.
+    gdbs_address_t  *value   ///< [out] Converted value.
+);
+
+/**
+ * Convert a string of text hexadecimal octets to the bytes they represent.
+ *
+ * @retval  0 Conversion successful.
+ * @retval <0 Conversion failed.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.  The output buffer may be partially written.
+ */
+int hex_string_to_bytes
+(
+    const char      *string, ///< [in]  Input string.  Need not be NUL-terminated.
+    size_t           length, ///< [in]  Number of characters to convert.  Must be even.
+    unsigned char   *bytes   ///< [out] Buffer to write the converted bytes to.  Must have space
+                             ///<       for length / 2 bytes.
+);
+
 #endif /* end HEX_H_ */
@@ -15,6 +15,8 @@
 #include "auxiliary/binary.h"
 #include "auxiliary/checksum.h"
 #include "auxiliary/hex.h"
+#include "auxiliary/rle.h"
+#include "auxiliary/stats.h"
 #include "stdc/assert.h"
 #include "stdc/null.h"
 
@@ -120,37 +122,44 @@ end:
     return result;
 }
 
+/// Packet reception progress.
+enum packet_state
+{
+    PREFIX,
+    BODY,
+    SUFFIX,
+    DONE
+};
+
 /**
- * Receive a complete packet from a data source.  This function will block until a verified packet
- * of the indicated type is received.
+ * Receive a packet from a data source, starting from a given state.
  *
  * @retval 0    A valid packet has been received into the buffer.
  * @retval <0   An error occured while receiving.  The exact value will be a negative
  *              enum gdbs_error entry indicating what went wrong.
  */
-int packet_receive
+static int receive
 (
     unsigned char       *buffer,        ///< [out]    Buffer into which to receive packet data.
     size_t              *length,        ///< [in,out] Size of the buffer as input, length of the
                                         ///<          packet as output.
     enum packet_type     expected_type, ///< [in]     Type of packet expected.
-    void                *comm           ///< [in]     Communications parameter.
+    void                *comm,          ///< [in]     Communications parameter.
+    enum packet_state    state,         ///< [in]     PREFIX to wait for the start of the packet, or
+                                        ///<          BODY if the lead character is in the buffer.
+    size_t               i              ///< [in]     Number of characters already in the buffer.
 )
 {
-    enum packet_state
-    {
-        PREFIX,
-        BODY,
-        SUFFIX,
-        DONE
-    };
-
-    enum packet_state   state = PREFIX;
     int                 received;
-    size_t              i;
+    int                 result;
     size_t              remaining = *length;
 
-    for (i = 0; i < *length; ++i)
+    if (state == BODY)
+    {
+        GDBS_STATS_UPDATE(stats_receive_start());
+    }
+
+    while (i < *length)
     {
         received = gdbs_receive(comm);
         if (received < 0)
@@ -159,15 +168,23 @@ int packet_receive
         }
         buffer[i] = (unsigned char) received;
 
-        if (state == PREFIX && to_type(buffer[i]) == (int) expected_type)
+        if (state == PREFIX)
         {
-            if (expected_type == PT_ACK)
+            if (to_type(buffer[i]) != (int) expected_type)
+            {
+                // Discard anything preceding the start of the packet, such as acks of packets
+                // previously sent by the stub.
+                GDBS_STATS_UPDATE(stats_discarded(buffer[i]));
+                continue;
+            }
+            else if (expected_type == PT_ACK)
             {
                 state = DONE;
                 break;
             }
             else
             {
+                GDBS_STATS_UPDATE(stats_receive_start());
                 state = BODY;
             }
         }
@@ -186,12 +203,19 @@ int packet_receive
                 break;
             }
         }
+        ++i;
     }
 
     if (state == DONE)
     {
         *length = i + 1;
-        return (expected_type == PT_ACK ? GDBS_ERROR_OK : verify(buffer, *length));
+        if (expected_type == PT_ACK)
+        {
+            return GDBS_ERROR_OK;
+        }
+        result = verify(buffer, *length);
+        GDBS_STATS_UPDATE(stats_received(*length, result));
+        return result;
     }
     else
     {
@@ -199,6 +223,52 @@ int packet_receive
     }
 }
 
+/**
+ * Receive a complete packet from a data source.  This function will block until a verified packet
+ * of the indicated type is received.  Any data preceding the start of the packet is discarded.
+ *
+ * @retval 0    A valid packet has been received into the buffer.
+ * @retval <0   An error occured while receiving.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int packet_receive
+(
+    unsigned char       *buffer,        ///< [out]    Buffer into which to receive packet data.
+    size_t              *length,        ///< [in,out] Size of the buffer as input, length of the
+                                        ///<          packet as output.
+    enum packet_type     expected_type, ///< [in]     Type of packet expected.
+    void                *comm           ///< [in]     Communications parameter.
+)
+{
+    return receive(buffer, length, expected_type, comm, PREFIX, 0);
+}
+
+/**
+ * Receive the remainder of a message or notification packet whose lead character has already been
+ * read from the data source by other means.  This function will block until the packet is complete.
+ *
+ * @retval 0    A valid packet has been received into the buffer.
+ * @retval <0   An error occured while receiving.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int packet_receive_remainder
+(
+    unsigned char       *buffer,        ///< [out]    Buffer into which to receive packet data.  The
+                                        ///<          lead character is filled in.
+    size_t              *length,        ///< [in,out] Size of the buffer as input, length of the
+                                        ///<          packet as output.
+    enum packet_type     expected_type, ///< [in]     Type of packet expected.  Cannot be PT_ACK.
+    void                *comm           ///< [in]     Communications parameter.
+)
+{
+    assert(expected_type != PT_ACK);
+    assert(*length > 0);
+
+    buffer[0] = (expected_type == PT_MESSAGE ?
+                 DATA_PACKET_START_CHAR : NOTIFICATION_PACKET_START_CHAR);
+    return receive(buffer, length, expected_type, comm, BODY, 1);
+}
+
 /**
  * Initialize a tokenizer instance to process a buffered packet.
  */
@@ -331,6 +401,40 @@ int packet_tokenizer_advance
     }
 }
 
+/**
+ * Advance to the next token in the packet and convert it from text hexadecimal to an unsigned
+ * integer.
+ *
+ * @retval 0                     Value converted and delimiter found.
+ * @retval -GDBS_ERROR_NOT_FOUND Value converted, but it was the remainder of the packet.
+ * @retval -GDBS_ERROR_EOB       The end of the packet buffer has been reached.
+ * @retval -GDBS_ERROR_INVALID   The token is not a valid hexadecimal value.
+ */
+int packet_tokenizer_advance_unsigned
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer instance.
+    int                      delimiter, ///< [in]  Delimiter character for next token, as for
+                                        ///<       packet_tokenizer_advance().
+    gdbs_address_t          *value      ///< [out] Converted value.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    int                  result;
+    int                  conversion;
+
+    assert(value != NULL);
+
+    result = packet_tokenizer_advance(tokenizer, delimiter, &token, &length);
+    if (result == -GDBS_ERROR_EOB)
+    {
+        return result;
+    }
+
+    conversion = hex_string_to_unsigned((const char *) token, length, value);
+    return (conversion != GDBS_ERROR_OK ? conversion : result);
+}
+
 /**
  * Rewind the tokenizer by one item.  Only the last advance can be rewound.  This enables
  * inexpensive probing of the packet using different delimiters.
@@ -367,6 +471,8 @@ void packet_writer_init
     packet->comm = comm;
     packet->checksum = 0;
     packet->finished = 0;
+    packet->rle = 0;
+    packet->run_length = 0;
 
     if (packet->type == PT_MESSAGE)
     {
@@ -404,10 +510,13 @@ int packet_writer_push_ack
     assert(packet->type == PT_ACK);
     assert(!packet->finished);
 
+    GDBS_STATS_UPDATE(stats_transmit_start());
     result = gdbs_send(packet->comm, (ack ? ACK_CHAR : NACK_CHAR));
+    GDBS_STATS_UPDATE(stats_transmitted(result));
     if (result == GDBS_ERROR_OK)
     {
         packet->finished = 1;
+        GDBS_STATS_UPDATE(stats_packet_sent(PT_ACK, ack));
     }
     return result;
 }
@@ -428,7 +537,9 @@ static int sink_buffered_data
 
     while (packet->buffered > 0)
     {
+        GDBS_STATS_UPDATE(stats_transmit_start());
         result = gdbs_send(packet->comm, packet->buffer[0]);
+        GDBS_STATS_UPDATE(stats_transmitted(result));
         if (result != GDBS_ERROR_OK)
         {
             break;
@@ -446,13 +557,13 @@ static int sink_buffered_data
 }
 
 /**
- * Push a byte to the packet payload.  Only applicable for non-ack type packets.
+ * Send a byte of payload immediately, bypassing run-length encoding.
  *
  * @retval 0    Byte successfully written.
  * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
  *              what went wrong.
  */
-int packet_writer_push
+static int push_raw
 (
     struct packet_writer *packet, ///< Packet writer instance.
     unsigned char         byte    ///< Byte to write out.
@@ -460,14 +571,12 @@ int packet_writer_push
 {
     int result;
 
-    assert(packet != NULL);
-    assert(packet->type != PT_ACK);
-    assert(!packet->finished);
-
     result = sink_buffered_data(packet);
     if (result == GDBS_ERROR_OK)
     {
+        GDBS_STATS_UPDATE(stats_transmit_start());
         result = gdbs_send(packet->comm, byte);
+        GDBS_STATS_UPDATE(stats_transmitted(result));
         if (result == GDBS_ERROR_OK)
         {
             accumulate_checksum(&packet->checksum, byte);
@@ -477,6 +586,99 @@ int packet_writer_push
     return result;
 }
 
+/**
+ * Encode and send the pending run of repeated payload characters, if any.
+ *
+ * @retval 0    Run successfully written.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+static int flush_run
+(
+    struct packet_writer *packet ///< Packet writer instance.
+)
+{
+    char    encoded[RLE_MAX_ENCODED_LENGTH];
+    int     result = GDBS_ERROR_OK;
+    size_t  count = 0;
+    size_t  i;
+
+    if (packet->run_length > 0)
+    {
+        count = run_length_encode_run(encoded, (char) packet->run_char, packet->run_length);
+        packet->run_length = 0;
+    }
+
+    for (i = 0; i < count && result == GDBS_ERROR_OK; ++i)
+    {
+        result = push_raw(packet, (unsigned char) encoded[i]);
+    }
+
+    return result;
+}
+
+/**
+ * Enable or disable run-length encoding of the pushed payload.  While enabled, runs of repeated
+ * characters are held back and sent in compressed form.  Only suitable for payloads which cannot
+ * themselves contain the RLE marker character, such as hexadecimal text.
+ *
+ * @retval 0    Mode changed successfully.
+ * @retval <0   Sending a pending run failed.  The exact value will be a negative enum gdbs_error
+ *              entry indicating what went wrong.
+ */
+int packet_writer_set_rle
+(
+    struct packet_writer *packet, ///< Packet writer instance.
+    int                   enable  ///< Boolean value to enable or disable run-length encoding.
+)
+{
+    assert(packet != NULL);
+    assert(packet->type != PT_ACK);
+
+    packet->rle = enable;
+    return flush_run(packet);
+}
+
+/**
+ * Push a byte to the packet payload.  Only applicable for non-ack type packets.
+ *
+ * @retval 0    Byte successfully written.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int packet_writer_push
+(
+    struct packet_writer *packet, ///< Packet writer instance.
+    unsigned char         byte    ///< Byte to write out.
+)
+{
+    int result;
+
+    assert(packet != NULL);
+    assert(packet->type != PT_ACK);
+    assert(!packet->finished);
+
+    if (!packet->rle)
+    {
+        return push_raw(packet, byte);
+    }
+
+    // Extend the current run if possible, otherwise send it and start a new one.
+    if (packet->run_length > 0 && packet->run_char == byte && packet->run_length < RLE_MAX_RUN)
+    {
+        ++packet->run_length;
+        return GDBS_ERROR_OK;
+    }
+
+    result = flush_run(packet);
+    if (result == GDBS_ERROR_OK)
+    {
+        packet->run_char = byte;
+        packet->run_length = 1;
+    }
+    return result;
+}
+
 /**
  * A buffer of bytes to the packet payload.  Only applicable for non-ack type packets.
  *
@@ -506,6 +708,77 @@ int packet_writer_push_buffer
     return result;
 }
 
+/**
+ * Push a buffer of bytes to the packet payload as text hexadecimal octets.  Only applicable for
+ * non-ack type packets.
+ *
+ * @retval 0    Bytes successfully written.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int packet_writer_push_hex
+(
+    struct packet_writer    *packet,    ///< Packet writer instance.
+    const unsigned char     *bytes,     ///< Bytes to encode and write out.
+    size_t                   length     ///< Number of bytes in the buffer.
+)
+{
+    char    octet[2];
+    int     result = GDBS_ERROR_OK;
+    size_t  i;
+
+    assert(bytes != NULL || length == 0);
+
+    for (i = 0; i < length && result == GDBS_ERROR_OK; ++i)
+    {
+        byte_to_hex_octet(bytes[i], octet);
+        result = packet_writer_push(packet, (unsigned char) octet[0]);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(packet, (unsigned char) octet[1]);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Write out an unsigned integer as hexadecimal text, without leading zeros.
+ *
+ * @retval 0    Value written.
+ * @retval <0   An error occured while sending.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int packet_writer_push_unsigned
+(
+    struct packet_writer    *packet, ///< Packet writer instance.
+    gdbs_address_t           value   ///< Value to write out.
+)
+{
+    char    octet[2];
+    int     leading = 1;
+    int     result = GDBS_ERROR_OK;
+    size_t  i;
+    size_t  j;
+
+    for (i = sizeof(value); i > 0 && result == GDBS_ERROR_OK; --i)
+    {
+        byte_to_hex_octet((unsigned char) (value >> ((i - 1) * 8)), octet);
+        for (j = 0; j < 2 && result == GDBS_ERROR_OK; ++j)
+        {
+            // Skip leading zeros, but always write at least the final digit.
+            if (leading && octet[j] == '0' && (i > 1 || j == 0))
+            {
+                continue;
+            }
+            leading = 0;
+            result = packet_writer_push(packet, (unsigned char) octet[j]);
+        }
+    }
+
+    return result;
+}
+
 /**
  * Finish writing out a packet.
  *
@@ -528,7 +801,11 @@ int packet_writer_finish
         return GDBS_ERROR_OK;
     }
 
-    result = sink_buffered_data(packet);
+    result = flush_run(packet);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = sink_buffered_data(packet);
+    }
     if (result == GDBS_ERROR_OK && !packet->finished)
     {
         packet->buffer[0] = PAYLOAD_END_CHAR;
@@ -536,6 +813,10 @@ int packet_writer_finish
         packet->buffered = 3;
         packet->finished = 1;
         result = sink_buffered_data(packet);
+        if (result == GDBS_ERROR_OK)
+        {
+            GDBS_STATS_UPDATE(stats_packet_sent(packet->type, 0));
+        }
     }
 
     return result;
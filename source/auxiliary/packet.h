@@ -10,6 +10,8 @@
 #ifndef PACKET_H_
 #define PACKET_H_
 
+#include "gdbsconfig.h"
+
 #include "stdc/size.h"
 
 #define DATA_PACKET_START_CHAR          '$' ///< Character indicating start of a data packet.
@@ -18,6 +20,7 @@
                                             ///< start of checksum field.
 #define ACK_CHAR                        '+' ///< Acknowledgement character.
 #define NACK_CHAR                       '-' ///< Negative acknowledgement character.
+#define INTERRUPT_CHAR                  0x03 ///< Interrupt request sent outside of a packet.
 
 /// Delimiter value used to indicate that the next packet token should be a single character.
 #define TOKEN_SINGLE_CHAR -1
@@ -53,18 +56,21 @@ struct packet_tokenizer
 /// State container for packet assembly.
 struct packet_writer
 {
-    enum packet_type     type;      ///< Packet type.
-    unsigned char        buffer[4]; ///< Scratch buffer for packet data.
-    size_t               buffered;  ///< Number of buffered bytes.
-    unsigned char        checksum;  ///< Running checksum of packet payload.
-    int                  finished;  ///< Boolean flag indicating remaining bytes are buffered.
+    enum packet_type     type;       ///< Packet type.
+    unsigned char        buffer[4];  ///< Scratch buffer for packet data.
+    size_t               buffered;   ///< Number of buffered bytes.
+    unsigned char        checksum;   ///< Running checksum of packet payload.
+    int                  finished;   ///< Boolean flag indicating remaining bytes are buffered.
+    int                  rle;        ///< Boolean flag indicating run-length encoding is enabled.
+    unsigned char        run_char;   ///< Character of the pending run, if any.
+    size_t               run_length; ///< Length of the pending run, or zero if there is none.
 
-    void                *comm;      ///< Communication parameter.
+    void                *comm;       ///< Communication parameter.
 };
 
 /**
  * Receive a complete packet from a data source.  This function will block until a verified packet
- * of the indicated type is received.
+ * of the indicated type is received.  Any data preceding the start of the packet is discarded.
  *
  * @retval 0    A valid packet has been received into the buffer.
  * @retval <0   An error occured while receiving.  The exact value will be a negative
@@ -79,6 +85,24 @@ int packet_receive
     void                *comm           ///< [in]     Communication parameter.
 );
 
+/**
+ * Receive the remainder of a message or notification packet whose lead character has already been
+ * read from the data source by other means.  This function will block until the packet is complete.
+ *
+ * @retval 0    A valid packet has been received into the buffer.
+ * @retval <0   An error occured while receiving.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int packet_receive_remainder
+(
+    unsigned char       *buffer,        ///< [out]    Buffer into which to receive packet data.  The
+                                        ///<          lead character is filled in.
+    size_t              *length,        ///< [in,out] Size of the buffer as input, length of the
+                                        ///<          packet as output.
+    enum packet_type     expected_type, ///< [in]     Type of packet expected.  Cannot be PT_ACK.
+    void                *comm           ///< [in]     Communication parameter.
+);
+
 /**
  * Initialize a tokenizer instance to process a buffered packet.
  */
@@ -110,6 +134,23 @@ int packet_tokenizer_advance
     size_t                   *length    ///< [out] Length of the token.
 );
 
+/**
+ * Advance to the next token in the packet and convert it from text hexadecimal to an unsigned
+ * integer.
+ *
+ * @retval 0                     Value converted and delimiter found.
+ * @retval -GDBS_ERROR_NOT_FOUND Value converted, but it was the remainder of the packet.
+ * @retval -GDBS_ERROR_EOB       The end of the packet buffer has been reached.
+ * @retval -GDBS_ERROR_INVALID   The token is not a valid hexadecimal value.
+ */
+int packet_tokenizer_advance_unsigned
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer instance.
+    int                      delimiter, ///< [in]  Delimiter character for next token, as for
+                                        ///<       packet_tokenizer_advance().
+    gdbs_address_t          *value      ///< [out] Converted value.
+);
+
 /**
  * Rewind the tokenizer by one item.  Only the last advance can be rewound.
  */
@@ -143,6 +184,21 @@ int packet_writer_push_ack
     int                   ack       ///< Push an ack or a nack.
 );
 
+/**
+ * Enable or disable run-length encoding of the pushed payload.  While enabled, runs of repeated
+ * characters are held back and sent in compressed form.  Only suitable for payloads which cannot
+ * themselves contain the RLE marker character, such as hexadecimal text.
+ *
+ * @retval 0    Mode changed successfully.
+ * @retval <0   Sending a pending run failed.  The exact value will be a negative enum gdbs_error
+ *              entry indicating what went wrong.
+ */
+int packet_writer_set_rle
+(
+    struct packet_writer *packet, ///< Packet writer instance.
+    int                   enable  ///< Boolean value to enable or disable run-length encoding.
+);
+
 /**
  * Push a byte to the packet payload.  Only applicable for non-ack type packets.
  *
@@ -170,6 +226,34 @@ int packet_writer_push_buffer
     size_t                   length     ///< Number of bytes in the buffer.
 );
 
+/**
+ * Push a buffer of bytes to the packet payload as text hexadecimal octets.  Only applicable for
+ * non-ack type packets.
+ *
+ * @retval 0    Bytes successfully written.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int packet_writer_push_hex
+(
+    struct packet_writer    *packet,    ///< Packet writer instance.
+    const unsigned char     *bytes,     ///< Bytes to encode and write out.
+    size_t                   length     ///< Number of bytes in the buffer.
+);
+
+/**
+ * Write out an unsigned integer as hexadecimal text, without leading zeros.
+ *
+ * @retval 0    Value written.
+ * @retval <0   An error occured while sending.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int packet_writer_push_unsigned
+(
+    struct packet_writer    *packet, ///< Packet writer instance.
+    gdbs_address_t           value   ///< Value to write out.
+);
+
 /**
  * Finish writing out a packet.
  *
@@ -15,8 +15,8 @@
 #include "stdc/assert.h"
 #include "stdc/null.h"
 
-#define ENCODING_MIN_THRESHOLD 3    ///< No encoding is done for runs of this size or smaller.
-#define ENCODING_MAX_THRESHOLD 98   ///< Runs of longer than this size are split up.
+#define ENCODING_MIN_THRESHOLD 3           ///< No encoding is done for runs of this size or smaller.
+#define ENCODING_MAX_THRESHOLD RLE_MAX_RUN ///< Runs of longer than this size are split up.
 
 /**
  * Format a normal RLE entry.  The provided value and repeats must result in valid encodings.
@@ -183,3 +183,29 @@ void run_length_encode
 
     *size = w;
 }
+
+/**
+ * Encode a single run of a repeated character using the GDB protocol RLE scheme.  This is the
+ * building block for encoding data which is streamed rather than buffered.
+ *
+ * @return Number of characters written to the destination buffer.
+ */
+size_t run_length_encode_run
+(
+    char    *destination, ///< [out] Buffer into which to write the encoded run.  Must have space for
+                          ///<       RLE_MAX_ENCODED_LENGTH characters.
+    char     value,       ///< [in]  Character being repeated.
+    size_t   run          ///< [in]  Number of characters in the run, between 1 and RLE_MAX_RUN.
+)
+{
+    size_t count;
+
+    assert(destination != NULL);
+    assert(run > 0);
+    assert(run <= RLE_MAX_RUN);
+
+    count = encode(destination, &value, run);
+
+    assert(count <= RLE_MAX_ENCODED_LENGTH);
+    return count;
+}
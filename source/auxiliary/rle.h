@@ -14,6 +14,9 @@
 
 #define RLE_CHAR '*' ///< Character used to denote an RLE value.
 
+#define RLE_MAX_RUN             98 ///< Longest run accepted by run_length_encode_run().
+#define RLE_MAX_ENCODED_LENGTH  6  ///< Longest output produced by run_length_encode_run().
+
 /**
  * Run-length encode a buffer using the GDB protocol RLE scheme.
  */
@@ -25,4 +28,18 @@ void run_length_encode
                      ///<           length of the encoded data now occupying the buffer.
 );
 
+/**
+ * Encode a single run of a repeated character using the GDB protocol RLE scheme.  This is the
+ * building block for encoding data which is streamed rather than buffered.
+ *
+ * @return Number of characters written to the destination buffer.
+ */
+size_t run_length_encode_run
+(
+    char    *destination, ///< [out] Buffer into which to write the encoded run.  Must have space for
+                          ///<       RLE_MAX_ENCODED_LENGTH characters.
+    char     value,       ///< [in]  Character being repeated.
+    size_t   run          ///< [in]  Number of characters in the run, between 1 and RLE_MAX_RUN.
+);
+
 #endif /* end RLE_H_ */
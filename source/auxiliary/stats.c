@@ -0,0 +1,251 @@
+/**
+ *  @file       stats.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Statistics of the communication between the stub and GDB.
+ *
+ *  Packets are counted as they are received and sent, and attributed to the command being handled
+ *  at the time.  Sending happens while commands are handled, so the time spent sending is taken out
+ *  of the time spent handling a command, leaving the time spent in the handler itself.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stats.h"
+
+#include "stdc/memchr.h"
+#include "stdc/memset.h"
+
+#if GDBS_STATS
+
+/// Commands counted separately, in the order of the command table of struct gdbs_stats.
+static const char commands[] = "?cDFgGHmMpPqQsTvXzZ";
+
+/// Statistics collected so far.  The command characters are only filled in when read.
+static struct gdbs_stats stats;
+
+/// Entry in the command table for the command being handled, or the last entry if none is.
+static unsigned int current = GDBS_STATS_COMMAND_COUNT - 1;
+
+/// Number of bytes sent when the handling of the current command started.
+static unsigned long dispatch_bytes;
+
+/// Boolean indicating that discarded data has been counted as a resync, until a packet starts.
+static int resyncing;
+
+/// Boolean indicating that GDB has been sent a NACK, and has not yet sent a packet again.
+static int nacked;
+
+#if GDBS_STATS_TIMING
+/// Timestamp at which the current packet started to arrive.
+static unsigned long receive_start;
+/// Timestamp at which the handling of the current command started.
+static unsigned long dispatch_start;
+/// Transmit time accounted when the handling of the current command started.
+static unsigned long dispatch_transmit;
+/// Timestamp at which the current character started to be sent.
+static unsigned long transmit_start;
+#endif
+
+/**
+ * Note that a packet has started to arrive.
+ */
+void stats_receive_start(void)
+{
+    resyncing = 0;
+#if GDBS_STATS_TIMING
+    receive_start = gdbs_timestamp();
+#endif
+}
+
+/**
+ * Count a character discarded while waiting for a packet to start.
+ */
+void stats_discarded
+(
+    unsigned char c ///< Discarded character.
+)
+{
+    ++stats.bytes_received;
+    if (c == ACK_CHAR)
+    {
+        ++stats.acks_received;
+    }
+    else if (c == NACK_CHAR)
+    {
+        ++stats.nacks_received;
+    }
+    else if (!resyncing)
+    {
+        resyncing = 1;
+        ++stats.resyncs;
+    }
+}
+
+/**
+ * Count a packet which has arrived, whether or not it is intact.
+ */
+void stats_received
+(
+    size_t   length, ///< Length of the packet, including framing.
+    int      result  ///< Result of receiving the packet.
+)
+{
+    stats.bytes_received += (unsigned long) length;
+#if GDBS_STATS_TIMING
+    stats.receive_time += gdbs_timestamp() - receive_start;
+#endif
+
+    if (result == -GDBS_ERROR_CHECKSUM)
+    {
+        ++stats.checksum_failures;
+    }
+    else if (result == GDBS_ERROR_OK)
+    {
+        ++stats.packets_received;
+        if (nacked)
+        {
+            nacked = 0;
+            ++stats.retransmits;
+        }
+    }
+}
+
+/**
+ * Note that a character is about to be sent.
+ */
+void stats_transmit_start(void)
+{
+#if GDBS_STATS_TIMING
+    transmit_start = gdbs_timestamp();
+#endif
+}
+
+/**
+ * Count a character sent after stats_transmit_start().
+ */
+void stats_transmitted
+(
+    int result ///< Result of sending the character.
+)
+{
+    if (result == GDBS_ERROR_OK)
+    {
+        ++stats.bytes_sent;
+    }
+#if GDBS_STATS_TIMING
+    stats.transmit_time += gdbs_timestamp() - transmit_start;
+#endif
+}
+
+/**
+ * Count a packet which has been sent.
+ */
+void stats_packet_sent
+(
+    enum packet_type     type, ///< Type of packet.
+    int                  ack   ///< Boolean indicating an ACK rather than a NACK.  Ignored for other
+                               ///< types of packet.
+)
+{
+    if (type == PT_MESSAGE)
+    {
+        ++stats.packets_sent;
+    }
+    else if (type == PT_NOTIFICATION)
+    {
+        ++stats.notifications_sent;
+    }
+    else if (ack)
+    {
+        ++stats.acks_sent;
+    }
+    else
+    {
+        ++stats.nacks_sent;
+        nacked = 1;
+    }
+}
+
+/**
+ * Note that the handling of a received packet is starting.
+ */
+void stats_dispatch_start
+(
+    unsigned char    command, ///< Command character.
+    size_t           length   ///< Length of the packet, including framing.
+)
+{
+    const char *found = memchr(commands, command, sizeof(commands) - 1);
+
+    current = (found != NULL ? (unsigned int) (found - commands) : GDBS_STATS_COMMAND_COUNT - 1);
+    ++stats.commands[current].packets;
+    stats.commands[current].bytes_in += (unsigned long) length;
+    dispatch_bytes = stats.bytes_sent;
+#if GDBS_STATS_TIMING
+    dispatch_transmit = stats.transmit_time;
+    dispatch_start = gdbs_timestamp();
+#endif
+}
+
+/**
+ * Note that the handling of a received packet is finished.
+ */
+void stats_dispatch_end(void)
+{
+#if GDBS_STATS_TIMING
+    unsigned long elapsed = gdbs_timestamp() - dispatch_start;
+
+    elapsed -= stats.transmit_time - dispatch_transmit;
+    stats.commands[current].time += elapsed;
+    stats.dispatch_time += elapsed;
+#endif
+    stats.commands[current].bytes_out += stats.bytes_sent - dispatch_bytes;
+    current = GDBS_STATS_COMMAND_COUNT - 1;
+}
+
+/**
+ * Obtain the statistics collected so far, without copying them.
+ *
+ * @return Statistics, which remain valid until the next update.
+ */
+const struct gdbs_stats *stats_read(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < GDBS_STATS_COMMAND_COUNT; ++i)
+    {
+        stats.commands[i].command = commands[i];
+    }
+    return &stats;
+}
+
+/**
+ * Read the statistics of the communication between the stub and GDB.
+ */
+void gdbs_get_stats
+(
+    struct gdbs_stats *out ///< [out] Statistics collected since the last reset.
+)
+{
+    *out = *stats_read();
+}
+
+/**
+ * Reset the statistics of the communication between the stub and GDB to zero.
+ */
+void gdbs_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    dispatch_bytes = 0;
+    nacked = 0;
+#if GDBS_STATS_TIMING
+    dispatch_transmit = 0;
+#endif
+}
+
+#endif /* GDBS_STATS */
@@ -0,0 +1,86 @@
+/**
+ *  @file       stats.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Statistics of the communication between the stub and GDB.  These routines are only
+ *              called through GDBS_STATS_UPDATE(), so they are left out unless GDBS_STATS is set.
+ */
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "gdbsconfig.h"
+#include "gdbstub.h"
+
+#include "auxiliary/packet.h"
+#include "stdc/size.h"
+
+/**
+ * Note that a packet has started to arrive.
+ */
+void stats_receive_start(void);
+
+/**
+ * Count a character discarded while waiting for a packet to start.
+ */
+void stats_discarded
+(
+    unsigned char c ///< Discarded character.
+);
+
+/**
+ * Count a packet which has arrived, whether or not it is intact.
+ */
+void stats_received
+(
+    size_t   length, ///< Length of the packet, including framing.
+    int      result  ///< Result of receiving the packet.
+);
+
+/**
+ * Note that a character is about to be sent.
+ */
+void stats_transmit_start(void);
+
+/**
+ * Count a character sent after stats_transmit_start().
+ */
+void stats_transmitted
+(
+    int result ///< Result of sending the character.
+);
+
+/**
+ * Count a packet which has been sent.
+ */
+void stats_packet_sent
+(
+    enum packet_type     type, ///< Type of packet.
+    int                  ack   ///< Boolean indicating an ACK rather than a NACK.  Ignored for other
+                               ///< types of packet.
+);
+
+/**
+ * Note that the handling of a received packet is starting.
+ */
+void stats_dispatch_start
+(
+    unsigned char    command, ///< Command character.
+    size_t           length   ///< Length of the packet, including framing.
+);
+
+/**
+ * Note that the handling of a received packet is finished.
+ */
+void stats_dispatch_end(void);
+
+/**
+ * Obtain the statistics collected so far, without copying them.
+ *
+ * @return Statistics, which remain valid until the next update.
+ */
+const struct gdbs_stats *stats_read(void);
+
+#endif /* end STATS_H_ */
@@ -15,10 +15,26 @@
 
 #include "auxiliary/packet.h"
 #include "protocol/ack.h"
+#include "protocol/breakpoint.h"
+#include "protocol/console.h"
+#include "protocol/fileio.h"
+#include "protocol/nonstop.h"
 #include "protocol/receive.h"
+#include "protocol/registers.h"
+#include "protocol/resume.h"
+#include "protocol/threads.h"
 #include "stdc/memset.h"
 #include "stdc/null.h"
 
+/// Reading characters outside of any packet.
+#define POLL_IDLE       0
+/// Reading a packet payload.
+#define POLL_PAYLOAD    1
+/// Reading the first checksum character of a packet.
+#define POLL_CHECKSUM1  2
+/// Reading the second checksum character of a packet.
+#define POLL_CHECKSUM2  3
+
 /// Active stub environment.
 static struct environment env;
 
@@ -39,7 +55,9 @@ const char *gdbs_error_to_string
         [GDBS_ERROR_INVALID]    = "invalid data or parameter",
         [GDBS_ERROR_CHECKSUM]   = "invalid checksum",
         [GDBS_ERROR_EOB]        = "end of buffer",
-        [GDBS_ERROR_NOT_FOUND]  = "item or value not found"
+        [GDBS_ERROR_NOT_FOUND]  = "item or value not found",
+        [GDBS_ERROR_FAULT]      = "memory access fault",
+        [GDBS_ERROR_RESOURCES]  = "out of resources"
     };
 
     return ((0 <= error && error < GDBS_ERROR_COUNT) ? strings[error] : "");
@@ -65,6 +83,10 @@ int gdbs_initialize
     // Set up the stub environment.
     memset(&env, 0, sizeof(env));
     env.comm = comm;
+    env.registers = gdbs_get_register_table(&env.register_count);
+    proto_index_registers();
+    proto_init_comparators();
+    proto_init_stop_queue();
 
     // Acks must always be turned on initially.
     proto_set_ack_mode(1);
@@ -94,6 +116,13 @@ int gdbs_initialize
  */
 void gdbs_cleanup(void)
 {
+    // Leave no breakpoint instructions behind in the application.
+    proto_clear_breakpoints();
+    if (proto_commit_breakpoints() > 0)
+    {
+        gdbs_flush_icache();
+    }
+
     gdbs_deregister_exceptions(env.except_state);
     gdbs_close_comm(env.comm);
 }
@@ -117,6 +146,154 @@ void gdbs_enter(void)
     GDBS_PACKET_BUFFER_DECL unsigned char buffer[GDBS_PACKET_BUFFER_LENGTH];
 
     env.packet_buffer = buffer;
-    proto_process(1);
+    env.register_frame = (unsigned char *) gdbs_get_register_frame();
+    env.general_thread = gdbs_get_current_thread();
+    env.general_frame = (env.trace_selected ? env.trace_registers : env.register_frame);
+    if (env.packet_started)
+    {
+        // In non-stop mode, GDB sent a packet while the target was running.  Serve it without
+        // treating the entry as a stop.
+        proto_process(0);
+
+        // Breakpoints set or removed, and code written, while the target runs take effect straight
+        // away, rather than waiting for a resume which may never come.
+        if (proto_commit_breakpoints() > 0 || env.icache_dirty)
+        {
+            gdbs_flush_icache();
+            env.icache_dirty = 0;
+        }
+        if (proto_flush_thread_contexts() < 0)
+        {
+            GDBS_LOG("Thread registers lost\n");
+        }
+        env.poll_state = POLL_IDLE;
+        env.general_frame = NULL;
+        env.register_frame = NULL;
+        env.packet_buffer = NULL;
+        return;
+    }
+
+    env.stop.signal = GDBS_SIGNAL_TRAP;
+    env.stop.reason = GDBS_STOP_SIGNAL;
+    env.stop.address = 0;
+    env.stop.unit = -1;
+    env.stop.thread = env.general_thread;
+    gdbs_get_stop_event(&env.stop);
+    proto_resolve_watchpoint(&env.stop);
+    if (env.interrupted)
+    {
+        // Whatever the port reports for gdbs_breakpoint(), GDB asked for this stop.
+        env.interrupted = 0;
+        env.stop.signal = GDBS_SIGNAL_INT;
+        env.stop.reason = GDBS_STOP_SIGNAL;
+    }
+    if (env.host_call != NULL)
+    {
+        // The application is waiting for GDB to carry out a host call, rather than stopping.
+        proto_console_flush();
+        if (proto_send_host_call() < 0)
+        {
+            GDBS_LOG("Host call request lost\n");
+        }
+        proto_process(0);
+    }
+    else if (!proto_breakpoint_hit() && !proto_range_step())
+    {
+        if (env.non_stop)
+        {
+            // The stop is reported with a notification, and GDB may carry on with other packets.
+            env.running = 0;
+            if (proto_queue_stop(&env.stop, env.register_frame) < 0)
+            {
+                GDBS_LOG("Stop event lost\n");
+            }
+            proto_notify_stop();
+            proto_process(0);
+        }
+        else
+        {
+            proto_process(1);
+        }
+    }
+
+    // Other threads pick up register changes made by GDB as the target resumes.
+    if (proto_flush_thread_contexts() < 0)
+    {
+        GDBS_LOG("Thread registers lost\n");
+    }
+    env.poll_state = POLL_IDLE;
+    env.general_frame = NULL;
+    env.register_frame = NULL;
     env.packet_buffer = NULL;
 }
+
+/**
+ * Check for an interrupt request from GDB while the target is running.  Call this periodically,
+ * such as from a timer or communications receive interrupt handler.  Waiting characters are read
+ * with gdbs_receive_poll(), and if GDB has sent an interrupt the stub is entered through
+ * gdbs_breakpoint() and the stop is reported as GDBS_SIGNAL_INT.  In non-stop mode, the stub is
+ * also entered when a packet starts, so that it can be served while the target is running.
+ * Otherwise, waiting console output is sent in a single 'O' packet, which is not permitted in
+ * non-stop mode.  Nothing is read or sent while the stub itself is active.
+ *
+ * @return Boolean indicating that the stub was entered.
+ */
+int gdbs_comm_poll(void)
+{
+    int c;
+
+    if (env.packet_buffer != NULL)
+    {
+        return 0;
+    }
+
+    while ((c = gdbs_receive_poll(env.comm)) >= 0)
+    {
+        // The interrupt character may appear within binary packet data, where it has no meaning.
+        switch (env.poll_state)
+        {
+            case POLL_IDLE:
+                if (c == INTERRUPT_CHAR)
+                {
+                    env.interrupted = 1;
+                    gdbs_breakpoint();
+                    return 1;
+                }
+                if (c == DATA_PACKET_START_CHAR)
+                {
+                    if (env.non_stop)
+                    {
+                        env.packet_started = 1;
+                        gdbs_breakpoint();
+                        return 1;
+                    }
+                    env.poll_state = POLL_PAYLOAD;
+                }
+                break;
+            case POLL_PAYLOAD:
+                if (c == PAYLOAD_END_CHAR)
+                {
+                    env.poll_state = POLL_CHECKSUM1;
+                }
+                break;
+            case POLL_CHECKSUM1:
+                env.poll_state = POLL_CHECKSUM2;
+                break;
+            default:
+                env.poll_state = POLL_IDLE;
+                break;
+        }
+    }
+
+    if (c != -GDBS_ERROR_EOB)
+    {
+        GDBS_LOG("Poll error: %s\n", gdbs_error_to_string(-c));
+    }
+
+    // The target is running, so GDB is waiting for a stop reply and accepts console output.
+    if (!env.non_stop)
+    {
+        proto_console_flush();
+    }
+    return 0;
+}
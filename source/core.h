@@ -10,13 +10,263 @@
 #ifndef CORE_H_
 #define CORE_H_
 
+#include "gdbsdevice.h"
+
+/// Software breakpoint table entry.
+struct breakpoint
+{
+    gdbs_address_t       address;                           ///< Address of the breakpoint.
+    const unsigned char *instruction;                       ///< Breakpoint instruction.
+    unsigned char        saved[GDBS_BREAKPOINT_LENGTH_MAX]; ///< Original instruction bytes.
+    unsigned char        length;                            ///< Length of the instruction.
+    unsigned char        flags;                             ///< BREAKPOINT_\* state flags.
+    unsigned short       actions;                           ///< Offset of the attached agent
+                                                            ///< expressions in the agent pool.
+    unsigned short       actions_length;                    ///< Length of the attached agent
+                                                            ///< expressions.  Zero if none.
+};
+
+/// Hardware comparator allocation record.
+struct comparator
+{
+    gdbs_address_t       address; ///< Start address matched by the comparator.
+    gdbs_address_t       length;  ///< Length of the matched region.
+    unsigned char        type;    ///< Type of match, as an enum gdbs_comparator_type value.
+    unsigned char        used;    ///< Boolean indicating that the comparator is allocated.
+};
+
+/// Range of a memory write held back until the target resumes.
+struct pending_write
+{
+    gdbs_address_t   address; ///< First address written.
+    unsigned int     length;  ///< Number of bytes written.
+    unsigned int     offset;  ///< Offset of the data in the pending write pool.
+};
+
+/// Registers of a thread other than the one which stopped, cached while the stub is active.
+struct thread_context
+{
+    gdbs_address_t   thread; ///< Thread ID.  Zero if the entry is unused.
+    unsigned int     used;   ///< Selection count when the thread was last selected.
+    unsigned char    dirty[(GDBS_REGISTER_NUMBER_LIMIT + 7) / 8];
+                             ///< Bitmap of the registers changed by GDB, by register number.
+    unsigned char    frame[GDBS_REGISTER_FRAME_LENGTH];
+                             ///< Register values.
+};
+
+/// Tracepoint defined by GDB.
+struct tracepoint
+{
+    gdbs_address_t   address;        ///< Address of the tracepoint.
+    gdbs_address_t   pass_count;     ///< Number of hits after which tracing stops.  Zero if
+                                     ///< unlimited.
+    gdbs_address_t   hits;           ///< Number of hits since tracing started.
+    unsigned short   number;         ///< Tracepoint number assigned by GDB.
+    unsigned short   actions;        ///< Offset of the condition and collection actions in the
+                                     ///< trace action pool.
+    unsigned short   actions_length; ///< Length of the condition and collection actions.
+    unsigned char    enabled;        ///< Boolean indicating that the tracepoint is enabled.
+    unsigned char    stepping;       ///< Boolean indicating that the remaining actions GDB
+                                     ///< sends are while-stepping actions, which are ignored.
+    unsigned char    marker;         ///< Boolean indicating a static tracepoint, served by the
+                                     ///< marker at its address rather than a breakpoint.
+};
+
+/// Stop event waiting to be reported to GDB in non-stop mode.
+struct stop_record
+{
+    volatile unsigned int    sequence; ///< Queue position for which the record is next written, or
+                                       ///< one past the position it holds an event for.
+    struct gdbs_stop_event   event;    ///< Stop event.
+    unsigned char           *frame;    ///< Register frame of the stopped context.
+};
+
 /// Environmental properties of the stub.
 struct environment
 {
-    int              ack_enabled;   ///< Boolean indicating if ACK/NACK support is enabled.
-    unsigned char   *packet_buffer; ///< Buffer for receiving packets.
-    void            *comm;          ///< Arbitrary parameter to communications functions.
-    void            *except_state;  ///< Arbitrary exception registration data.
+    int                          ack_enabled;     ///< Boolean indicating if ACK/NACK support is
+                                                  ///< enabled.
+    int                          swbreak_enabled; ///< Boolean indicating if GDB accepts swbreak stop
+                                                  ///< reasons.
+    int                          hwbreak_enabled; ///< Boolean indicating if GDB accepts hwbreak stop
+                                                  ///< reasons.
+    unsigned char               *packet_buffer;   ///< Buffer for receiving packets.
+    void                        *comm;            ///< Arbitrary parameter to communications
+                                                  ///< functions.
+    void                        *except_state;    ///< Arbitrary exception registration data.
+    struct gdbs_stop_event       stop;            ///< Event which caused the current stop.
+
+    const struct gdbs_register  *registers;       ///< Register file description.
+    unsigned int                 register_count;  ///< Number of entries in the register file.
+    unsigned char               *register_frame;  ///< Registers saved on entry to the stub.
+    unsigned int                 register_frame_length;
+                                                  ///< Length of the register frame covered by the
+                                                  ///< register table.
+    const struct gdbs_register  *pc_register;     ///< Program counter register, if known.
+    unsigned short               register_index[GDBS_REGISTER_NUMBER_LIMIT];
+                                                  ///< Register table position plus one, indexed
+                                                  ///< by register number.  Zero if absent.
+
+    gdbs_address_t               general_thread;  ///< Thread selected for register access.
+    unsigned char               *general_frame;   ///< Registers of the thread selected for register
+                                                  ///< access.
+    struct thread_context       *general_context; ///< Cached context of the thread selected for
+                                                  ///< register access.  NULL for the thread which
+                                                  ///< stopped.
+    struct thread_context        thread_contexts[GDBS_THREAD_CONTEXT_COUNT];
+                                                  ///< Registers of threads selected by GDB, other
+                                                  ///< than the one which stopped.
+    unsigned int                 thread_selections;
+                                                  ///< Number of thread context selections, for
+                                                  ///< replacing the least recently used context.
+    unsigned int                 thread_cursor;   ///< Position within the thread list reached by
+                                                  ///< 'qsThreadInfo'.
+    unsigned int                 thread_xfer_element;
+                                                  ///< Element of the thread list document reached
+                                                  ///< by the last 'qXfer:threads:read'.
+    gdbs_address_t               thread_xfer_offset;
+                                                  ///< Offset of that element within the document.
+
+    struct breakpoint            breakpoints[GDBS_BREAKPOINT_COUNT];
+                                                  ///< Software breakpoints, sorted by address.
+    unsigned int                 breakpoint_count;
+                                                  ///< Number of software breakpoint entries.
+    int                          icache_dirty;    ///< Boolean indicating that code may have been
+                                                  ///< modified since the last resume.
+    struct pending_write         pending_writes[GDBS_WRITE_COMBINE_COUNT];
+                                                  ///< Memory writes held back, in the order made.
+                                                  ///< The ranges never overlap.
+    unsigned int                 pending_write_count;
+                                                  ///< Number of memory writes held back.
+    unsigned char                pending_data[GDBS_WRITE_COMBINE_LENGTH];
+                                                  ///< Data of the memory writes held back.
+    unsigned int                 pending_data_used;
+                                                  ///< Number of bytes in use in the pending write
+                                                  ///< pool.
+    unsigned char                agent_pool[GDBS_AGENT_BYTECODE_LENGTH];
+                                                  ///< Agent expressions attached to breakpoints.
+    unsigned int                 agent_pool_used; ///< Number of bytes in use in the agent pool.
+    int                          stepping;        ///< Boolean indicating that GDB asked for the
+                                                  ///< last resume to be a single step.
+    int                          stepping_over;   ///< Boolean indicating that the stub is stepping
+                                                  ///< over a breakpoint without involving GDB.
+    gdbs_address_t               step_over_address;
+                                                  ///< Address of the breakpoint being stepped over.
+    int                          range_stepping;  ///< Boolean indicating that the stub keeps
+                                                  ///< stepping while the program counter is within
+                                                  ///< the range.
+    gdbs_address_t               range_start;     ///< First address of the stepping range.
+    gdbs_address_t               range_end;       ///< Address after the end of the stepping range.
+
+    volatile unsigned int        host_call_pending;
+                                                  ///< Nonzero while the application waits for a
+                                                  ///< host call.
+    const char                  *host_call;       ///< Name of the host call for GDB to carry out,
+                                                  ///< such as "write".  NULL once GDB has replied.
+    gdbs_address_t               host_args[4];    ///< Arguments of the host call.
+    unsigned int                 host_arg_count;  ///< Number of arguments of the host call.
+    unsigned int                 host_arg_pairs;  ///< Bitmap of the arguments which are the length
+                                                  ///< of a pointer/length pair, by argument index.
+    int                          host_result;     ///< Result of the host call, or a negated enum
+                                                  ///< gdbs_host_error value.
+
+    int                          interrupted;     ///< Boolean indicating that the stub was entered
+                                                  ///< because GDB requested an interrupt.
+    unsigned int                 poll_state;      ///< Position within packet framing of the
+                                                  ///< characters read by gdbs_comm_poll().
+
+    unsigned char                console[GDBS_CONSOLE_BUFFER_LENGTH];
+                                                  ///< Ring buffer of console output waiting to be
+                                                  ///< sent to GDB.
+    volatile unsigned int        console_claimed; ///< Ring position after the last byte claimed by
+                                                  ///< a writer.
+    volatile unsigned int        console_sent;    ///< Ring position of the oldest byte not yet
+                                                  ///< sent.
+    volatile unsigned int        console_writers; ///< Number of contexts writing into claimed
+                                                  ///< space.
+    volatile unsigned int        console_flushing;
+                                                  ///< Nonzero while console output is being sent.
+
+    int                          non_stop;        ///< Boolean indicating that GDB selected non-stop
+                                                  ///< mode.
+    int                          running;         ///< Boolean indicating that the target is
+                                                  ///< running, as far as GDB knows, in non-stop
+                                                  ///< mode.
+    int                          packet_started;  ///< Boolean indicating that gdbs_comm_poll() has
+                                                  ///< read the start of a packet.
+    struct stop_record           stop_queue[GDBS_STOP_QUEUE_LENGTH];
+                                                  ///< Stop events waiting to be reported.
+    volatile unsigned int        stop_enqueue;    ///< Queue position for the next stop event.
+    unsigned int                 stop_dequeue;    ///< Queue position of the oldest stop event.
+    int                          stop_notified;   ///< Boolean indicating that GDB has been sent a
+                                                  ///< notification for the oldest stop event, and
+                                                  ///< has not yet acknowledged it with 'vStopped'.
+
+    struct tracepoint            tracepoints[GDBS_TRACEPOINT_COUNT];
+                                                  ///< Tracepoints, in the order defined.
+    unsigned int                 tracepoint_count;
+                                                  ///< Number of tracepoints defined.
+    unsigned char                trace_actions[GDBS_TRACE_ACTION_LENGTH];
+                                                  ///< Conditions and collection actions of the
+                                                  ///< tracepoints.
+    unsigned int                 trace_actions_used;
+                                                  ///< Number of bytes in use in the trace action
+                                                  ///< pool.
+    int                          tracing;         ///< Boolean indicating that tracepoints are
+                                                  ///< collecting trace frames.
+    int                          trace_circular;  ///< Boolean indicating that the oldest trace
+                                                  ///< frames are discarded when the buffer fills.
+    unsigned int                 trace_stop_reason;
+                                                  ///< Reason that tracing last stopped.
+    unsigned int                 trace_stop_tracepoint;
+                                                  ///< Tracepoint whose pass count stopped tracing.
+    unsigned int                 trace_head;      ///< Trace buffer position of the oldest frame.
+    unsigned int                 trace_used;      ///< Bytes of the trace buffer holding frames.
+    unsigned int                 trace_frame_count;
+                                                  ///< Number of frames in the trace buffer.
+    unsigned int                 trace_frames_created;
+                                                  ///< Number of frames collected since tracing
+                                                  ///< started, including discarded frames.
+    unsigned int                 trace_frame_length;
+                                                  ///< Length of the frame being collected, which
+                                                  ///< follows the last complete frame.  Zero if no
+                                                  ///< frame is being collected.
+    int                          trace_selected;  ///< Boolean indicating that GDB has selected a
+                                                  ///< trace frame with 'QTFrame'.
+    unsigned int                 trace_selected_frame;
+                                                  ///< Number of the selected trace frame.
+    unsigned int                 trace_selected_offset;
+                                                  ///< Offset of the selected trace frame from the
+                                                  ///< oldest frame.
+    unsigned char                trace_registers[GDBS_REGISTER_FRAME_LENGTH];
+                                                  ///< Registers of the selected trace frame.
+    unsigned int                 trace_marker_cursor;
+                                                  ///< Position within the marker list reached by
+                                                  ///< 'qTsSTM'.
+    volatile unsigned int        trace_marker_busy;
+                                                  ///< Nonzero while a marker or tracepoint hit is
+                                                  ///< being recorded.
+
+    unsigned char                flash_pages[2][GDBS_FLASH_PAGE_LENGTH];
+                                                  ///< Flash page buffers.  One collects writes
+                                                  ///< while the other is programmed.
+    unsigned int                 flash_page;      ///< Index of the page buffer collecting writes.
+    int                          flash_page_open; ///< Boolean indicating that the collecting page
+                                                  ///< buffer holds writes to be programmed.
+    gdbs_address_t               flash_page_address;
+                                                  ///< Flash address of the collecting page buffer.
+    int                          flash_programming;
+                                                  ///< Boolean indicating that the other page buffer
+                                                  ///< may still be being programmed.
+
+    struct comparator            hw_breakpoints[GDBS_COMPARATOR_COUNT];
+                                                  ///< Hardware breakpoint comparators.
+    unsigned int                 hw_breakpoint_count;
+                                                  ///< Number of breakpoint comparators available.
+    struct comparator            watchpoints[GDBS_COMPARATOR_COUNT];
+                                                  ///< Watchpoint comparators.
+    unsigned int                 watchpoint_count;
+                                                  ///< Number of watchpoint comparators available.
 };
 
 /**
@@ -0,0 +1,80 @@
+/**
+ *  @file       flash.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Generic implementation of the flash hooks, for targets loaded without flash
+ *              programming.
+ *
+ *  No memory map is reported, so GDB treats all memory as RAM and never asks for flash to be
+ *  erased or programmed.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stdc/null.h"
+
+#if GDBS_GENERIC_FLASH
+
+/**
+ * Obtain the map of the target's memory regions.
+ *
+ * @return NULL, as there is no map.
+ */
+const struct gdbs_memory_region *gdbs_get_memory_map
+(
+    unsigned int *count ///< [out] Number of entries in the region table.
+)
+{
+    *count = 0;
+    return NULL;
+}
+
+/**
+ * Erase a range of flash.
+ *
+ * @retval -GDBS_ERROR_INVALID There is no flash.
+ */
+int gdbs_flash_erase
+(
+    gdbs_address_t   address, ///< First address to erase.
+    gdbs_address_t   length   ///< Length of the range to erase.
+)
+{
+    (void) address;
+    (void) length;
+    return -GDBS_ERROR_INVALID;
+}
+
+/**
+ * Start programming a page of erased flash.
+ *
+ * @retval -GDBS_ERROR_INVALID There is no flash.
+ */
+int gdbs_flash_program
+(
+    gdbs_address_t           address, ///< Address of the page.
+    const unsigned char     *data,    ///< Page data.
+    gdbs_address_t           length   ///< Length of the page.
+)
+{
+    (void) address;
+    (void) data;
+    (void) length;
+    return -GDBS_ERROR_INVALID;
+}
+
+/**
+ * Wait for the programming started by the last call to gdbs_flash_program() to complete.
+ *
+ * @retval 0 Programming completed, as it never started.
+ */
+int gdbs_flash_wait(void)
+{
+    return GDBS_ERROR_OK;
+}
+
+#endif /* GDBS_GENERIC_FLASH */
@@ -0,0 +1,176 @@
+/**
+ *  @file       memory.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Generic implementation of the debugger memory access hooks.
+ *
+ *  Naturally aligned runs of memory are transferred a word at a time so that peripherals which
+ *  only decode full-width accesses behave correctly, and so that bulk transfers are not limited by
+ *  byte access throughput.  Faults raised during an access are caught by cooperation with the
+ *  port's fault handlers through gdbs_memory_fault().
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stdc/memcpy.h"
+
+#if GDBS_GENERIC_MEMORY_ACCESS
+
+/// Shorthand for the word type used for aligned transfers.
+typedef GDBS_MEMORY_WORD_TYPE word_t;
+
+/// Progress of a debugger memory access, as observed by the fault handler.
+enum access_state
+{
+    ACCESS_IDLE,    ///< No debugger access is in progress.
+    ACCESS_ACTIVE,  ///< A debugger access is in progress and has not faulted.
+    ACCESS_FAULTED  ///< A debugger access is in progress and has faulted.
+};
+
+/// Current access state.  Shared with fault handler context.
+static volatile int state = ACCESS_IDLE;
+
+/**
+ * Report a bus or memory fault to the generic memory access hooks.  When the generic hooks are in
+ * use, the port's fault handlers must call this function before anything else.  If it indicates
+ * that the fault was raised by a debugger access, the handler must resume execution at the
+ * instruction following the faulting one, and the access will then be reported to GDB as an error
+ * instead of a crash.
+ *
+ * @retval 1 The fault was caused by a debugger memory access and has been recorded.
+ * @retval 0 The fault was not caused by the debugger and should be handled normally.
+ */
+int gdbs_memory_fault(void)
+{
+    if (state == ACCESS_ACTIVE)
+    {
+        state = ACCESS_FAULTED;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Conclude an access and determine its outcome.
+ *
+ * @retval 0                    Access completed.
+ * @retval -GDBS_ERROR_FAULT    Access faulted.
+ */
+static int finish_access(void)
+{
+    int faulted = (state == ACCESS_FAULTED);
+
+    state = ACCESS_IDLE;
+    return (faulted ? -GDBS_ERROR_FAULT : GDBS_ERROR_OK);
+}
+
+/**
+ * Read a block of target memory on behalf of the debugger.  Implementations must use access widths
+ * which are valid for the addressed region, and must report an inaccessible address as an error
+ * rather than letting the fault propagate.  A generic implementation is provided by the stub
+ * library unless GDBS_GENERIC_MEMORY_ACCESS is set to 0.
+ *
+ * @retval  0 All requested bytes were read.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_FAULT.
+ */
+int gdbs_memory_read
+(
+    void            *comm,    ///< [in]  Communication parameter that was passed to gdbs_initialize().
+    gdbs_address_t   address, ///< [in]  Target address to read from.
+    void            *buffer,  ///< [out] Buffer to receive the memory contents.
+    gdbs_address_t   length   ///< [in]  Number of bytes to read.
+)
+{
+    unsigned char   *destination = (unsigned char *) buffer;
+    word_t           word;
+
+    (void) comm;
+    state = ACCESS_ACTIVE;
+
+    // Unaligned head.
+    while (length > 0 && (address % sizeof(word_t)) != 0 && state == ACCESS_ACTIVE)
+    {
+        *destination++ = *(const volatile unsigned char *) address;
+        ++address;
+        --length;
+    }
+
+    // Aligned body.  The stub-side buffer may not share the target alignment, so each word is
+    // transferred through a local.
+    while (length >= sizeof(word_t) && state == ACCESS_ACTIVE)
+    {
+        word = *(const volatile word_t *) address;
+        memcpy(destination, &word, sizeof(word_t));
+        destination += sizeof(word_t);
+        address += sizeof(word_t);
+        length -= sizeof(word_t);
+    }
+
+    // Unaligned tail.
+    while (length > 0 && state == ACCESS_ACTIVE)
+    {
+        *destination++ = *(const volatile unsigned char *) address;
+        ++address;
+        --length;
+    }
+
+    return finish_access();
+}
+
+/**
+ * Write a block of target memory on behalf of the debugger.  The same access width and fault
+ * handling requirements apply as for gdbs_memory_read().
+ *
+ * @retval  0 All requested bytes were written.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong, typically GDBS_ERROR_FAULT.
+ */
+int gdbs_memory_write
+(
+    void            *comm,    ///< [in] Communication parameter that was passed to gdbs_initialize().
+    gdbs_address_t   address, ///< [in] Target address to write to.
+    const void      *buffer,  ///< [in] Data to be written.
+    gdbs_address_t   length   ///< [in] Number of bytes to write.
+)
+{
+    const unsigned char *source = (const unsigned char *) buffer;
+    word_t               word;
+
+    (void) comm;
+    state = ACCESS_ACTIVE;
+
+    // Unaligned head.
+    while (length > 0 && (address % sizeof(word_t)) != 0 && state == ACCESS_ACTIVE)
+    {
+        *(volatile unsigned char *) address = *source++;
+        ++address;
+        --length;
+    }
+
+    // Aligned body.
+    while (length >= sizeof(word_t) && state == ACCESS_ACTIVE)
+    {
+        memcpy(&word, source, sizeof(word_t));
+        *(volatile word_t *) address = word;
+        source += sizeof(word_t);
+        address += sizeof(word_t);
+        length -= sizeof(word_t);
+    }
+
+    // Unaligned tail.
+    while (length > 0 && state == ACCESS_ACTIVE)
+    {
+        *(volatile unsigned char *) address = *source++;
+        ++address;
+        --length;
+    }
+
+    return finish_access();
+}
+
+#endif /* GDBS_GENERIC_MEMORY_ACCESS */
@@ -0,0 +1,35 @@
+/**
+ *  @file       monitor.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Generic implementation of the monitor command hook, for targets without monitor
+ *              commands of their own.
+ *
+ *  Only the built-in commands of the stub are run by GDB's "monitor" command.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stdc/null.h"
+
+#if GDBS_GENERIC_MONITOR
+
+/**
+ * Obtain the target's own monitor commands.
+ *
+ * @return NULL, as there are none.
+ */
+const struct gdbs_monitor_command *gdbs_get_monitor_commands
+(
+    unsigned int *count ///< [out] Number of entries in the command table.
+)
+{
+    *count = 0;
+    return NULL;
+}
+
+#endif /* GDBS_GENERIC_MONITOR */
@@ -0,0 +1,129 @@
+/**
+ *  @file       threads.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Generic implementation of the thread hooks, for targets without an RTOS.
+ *
+ *  The whole target is presented to GDB as a single thread, so there is never another thread
+ *  context to read or write.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stdc/null.h"
+
+#if GDBS_GENERIC_THREADS
+
+/// ID of the only thread.
+#define THREAD_ID 1
+
+/**
+ * List the IDs of the target's threads.
+ *
+ * @return Number of IDs stored.  Fewer than requested once the end of the list is reached.
+ */
+unsigned int gdbs_get_threads
+(
+    unsigned int     first, ///< [in]  Position within the list of the first thread to store.
+    gdbs_address_t  *ids,   ///< [out] Thread IDs.
+    unsigned int     count  ///< [in]  Maximum number of IDs to store.
+)
+{
+    if (first > 0 || count == 0)
+    {
+        return 0;
+    }
+    ids[0] = THREAD_ID;
+    return 1;
+}
+
+/**
+ * Identify the thread which was running on entry to the stub.
+ *
+ * @return Thread ID.
+ */
+gdbs_address_t gdbs_get_current_thread(void)
+{
+    return THREAD_ID;
+}
+
+/**
+ * Determine whether a thread still exists.
+ *
+ * @return Boolean indicating that the thread exists.
+ */
+int gdbs_thread_alive
+(
+    gdbs_address_t thread ///< Thread ID.
+)
+{
+    return (thread == THREAD_ID);
+}
+
+/**
+ * Obtain a short description of a thread.
+ *
+ * @return NULL, as the thread has no name.
+ */
+const char *gdbs_get_thread_name
+(
+    gdbs_address_t thread ///< Thread ID.
+)
+{
+    (void) thread;
+    return NULL;
+}
+
+/**
+ * Identify the processor core which a thread last ran on.
+ *
+ * @return -1, as the core is not known.
+ */
+int gdbs_get_thread_core
+(
+    gdbs_address_t thread ///< Thread ID.
+)
+{
+    (void) thread;
+    return -1;
+}
+
+/**
+ * Read the saved registers of a thread other than the one which was running on entry to the stub.
+ *
+ * @retval -GDBS_ERROR_NOT_FOUND There are no other threads.
+ */
+int gdbs_get_thread_context
+(
+    gdbs_address_t   thread, ///< [in]  Thread ID.
+    unsigned char   *frame   ///< [out] Register values.
+)
+{
+    (void) thread;
+    (void) frame;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+/**
+ * Write the saved registers of a thread other than the one which was running on entry to the stub.
+ *
+ * @retval -GDBS_ERROR_NOT_FOUND There are no other threads.
+ */
+int gdbs_set_thread_context
+(
+    gdbs_address_t           thread,  ///< Thread ID.
+    const unsigned char     *frame,   ///< Register values.
+    const unsigned char     *changed  ///< Bitmap of the registers changed.
+)
+{
+    (void) thread;
+    (void) frame;
+    (void) changed;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+#endif /* GDBS_GENERIC_THREADS */
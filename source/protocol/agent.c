@@ -0,0 +1,566 @@
+/**
+ *  @file       agent.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Interpreter for GDB agent expression bytecode.
+ *
+ *  Expressions are checked once, when GDB hands them to the stub, so that the evaluation loop does
+ *  not need to check opcodes, operand lengths, or jump targets on every pass.  Only the stack
+ *  depth, which depends on the path taken, is checked during evaluation.  The top of the stack is
+ *  kept in a local so that most operations touch the stack array at most once.
+ *
+ *  The printf opcode, used by dynamic printf breakpoints, sends its output to the GDB console.  The
+ *  trace opcodes record memory in the trace frame being collected, and do nothing otherwise.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "agent.h"
+
+#include "auxiliary/endian.h"
+#include "core.h"
+#include "protocol/breakpoint.h"
+#include "protocol/console.h"
+#include "protocol/registers.h"
+#include "protocol/trace.h"
+
+/// Agent expression opcodes.
+enum agent_opcode
+{
+    AX_ADD              = 0x02,
+    AX_SUB              = 0x03,
+    AX_MUL              = 0x04,
+    AX_DIV_SIGNED       = 0x05,
+    AX_DIV_UNSIGNED     = 0x06,
+    AX_REM_SIGNED       = 0x07,
+    AX_REM_UNSIGNED     = 0x08,
+    AX_LSH              = 0x09,
+    AX_RSH_SIGNED       = 0x0A,
+    AX_RSH_UNSIGNED     = 0x0B,
+    AX_TRACE            = 0x0C,
+    AX_TRACE_QUICK      = 0x0D,
+    AX_LOG_NOT          = 0x0E,
+    AX_BIT_AND          = 0x0F,
+    AX_BIT_OR           = 0x10,
+    AX_BIT_XOR          = 0x11,
+    AX_BIT_NOT          = 0x12,
+    AX_EQUAL            = 0x13,
+    AX_LESS_SIGNED      = 0x14,
+    AX_LESS_UNSIGNED    = 0x15,
+    AX_EXT              = 0x16,
+    AX_REF8             = 0x17,
+    AX_REF16            = 0x18,
+    AX_REF32            = 0x19,
+    AX_REF64            = 0x1A,
+    AX_IF_GOTO          = 0x20,
+    AX_GOTO             = 0x21,
+    AX_CONST8           = 0x22,
+    AX_CONST16          = 0x23,
+    AX_CONST32          = 0x24,
+    AX_CONST64          = 0x25,
+    AX_REG              = 0x26,
+    AX_END              = 0x27,
+    AX_DUP              = 0x28,
+    AX_POP              = 0x29,
+    AX_ZERO_EXT         = 0x2A,
+    AX_SWAP             = 0x2B,
+    AX_TRACENZ          = 0x2F,
+    AX_TRACE16          = 0x30,
+    AX_PICK             = 0x32,
+    AX_ROT              = 0x33,
+    AX_PRINTF           = 0x34,
+    AX_OPCODE_COUNT
+};
+
+/// Marker for opcodes which are not supported.
+#define UNSUPPORTED -1
+
+/// Length of the inline operand of each opcode, or UNSUPPORTED.
+static const signed char operand_length[AX_OPCODE_COUNT] =
+{
+    UNSUPPORTED,    // 0x00
+    UNSUPPORTED,    // float
+    0,              // add
+    0,              // sub
+    0,              // mul
+    0,              // div_signed
+    0,              // div_unsigned
+    0,              // rem_signed
+    0,              // rem_unsigned
+    0,              // lsh
+    0,              // rsh_signed
+    0,              // rsh_unsigned
+    0,              // trace
+    1,              // trace_quick
+    0,              // log_not
+    0,              // bit_and
+    0,              // bit_or
+    0,              // bit_xor
+    0,              // bit_not
+    0,              // equal
+    0,              // less_signed
+    0,              // less_unsigned
+    1,              // ext
+    0,              // ref8
+    0,              // ref16
+    0,              // ref32
+    0,              // ref64
+    UNSUPPORTED,    // ref_float
+    UNSUPPORTED,    // ref_double
+    UNSUPPORTED,    // ref_long_double
+    UNSUPPORTED,    // l_to_d
+    UNSUPPORTED,    // d_to_l
+    2,              // if_goto
+    2,              // goto
+    1,              // const8
+    2,              // const16
+    4,              // const32
+    8,              // const64
+    2,              // reg
+    0,              // end
+    0,              // dup
+    0,              // pop
+    1,              // zero_ext
+    0,              // swap
+    UNSUPPORTED,    // getv
+    UNSUPPORTED,    // setv
+    UNSUPPORTED,    // tracev
+    0,              // tracenz
+    2,              // trace16
+    UNSUPPORTED,    // invalid2
+    1,              // pick
+    0,              // rot
+    3               // printf, plus the format string
+};
+
+/// Number of bits in an agent expression value.
+#define VALUE_BITS (sizeof(agent_value_t) * 8)
+/// Sign bit of an agent expression value.
+#define SIGN_BIT ((agent_value_t) 1 << (VALUE_BITS - 1))
+
+/**
+ * Read a big-endian operand from the bytecode.
+ *
+ * @return Operand value.
+ */
+static agent_value_t operand
+(
+    const unsigned char *code,  ///< First byte of the operand.
+    unsigned int         length ///< Length of the operand, in bytes.
+)
+{
+    agent_value_t   value = 0;
+    unsigned int    i;
+
+    for (i = 0; i < length; ++i)
+    {
+        value = (value << 8) | code[i];
+    }
+    return value;
+}
+
+/**
+ * Negate a value if it is negative, when interpreted as signed.
+ *
+ * @return Magnitude of the value.
+ */
+static agent_value_t magnitude
+(
+    agent_value_t value ///< Value to convert.
+)
+{
+    return ((value & SIGN_BIT) ? (agent_value_t) 0 - value : value);
+}
+
+/**
+ * Determine the length of the instruction at a position in an expression.
+ *
+ * @return Length of the instruction, including its operands, or zero if the opcode is not
+ *         supported or the instruction runs past the end of the expression.
+ */
+static size_t instruction_length
+(
+    const unsigned char *code,   ///< Expression bytecode.
+    size_t               pc,     ///< Position of the instruction.
+    size_t               length  ///< Length of the bytecode.
+)
+{
+    unsigned char   op = code[pc];
+    size_t          size;
+
+    if (op >= AX_OPCODE_COUNT || operand_length[op] == UNSUPPORTED)
+    {
+        return 0;
+    }
+
+    size = 1 + (size_t) operand_length[op];
+    if (length - pc < size)
+    {
+        return 0;
+    }
+
+    // The printf format string has a 16-bit length, which includes its NUL terminator.
+    if (op == AX_PRINTF)
+    {
+        size += (size_t) operand(&code[pc + 2], 2);
+        if (size == 4 || length - pc < size || code[pc + size - 1] != '\0')
+        {
+            return 0;
+        }
+    }
+    return size;
+}
+
+/**
+ * Check that an agent expression can be evaluated safely.  Every opcode must be supported with
+ * complete operands, every jump must land on an opcode, and the expression must not be able to run
+ * past its end.  Only expressions which pass this check may be given to proto_agent_evaluate().
+ *
+ * @retval 0                    Expression is valid.
+ * @retval -GDBS_ERROR_INVALID  Expression is malformed or uses unsupported opcodes.
+ */
+int proto_agent_validate
+(
+    const unsigned char *code,  ///< Expression bytecode.
+    size_t               length ///< Length of the bytecode.
+)
+{
+    unsigned char   starts[(GDBS_AGENT_BYTECODE_LENGTH + 7) / 8] = { 0 };
+    unsigned char   op = AX_END;
+    size_t          pc;
+    size_t          size;
+    size_t          target;
+
+    if (length == 0 || length > GDBS_AGENT_BYTECODE_LENGTH)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Record where each opcode starts.
+    for (pc = 0; pc < length; pc += size)
+    {
+        op = code[pc];
+        size = instruction_length(code, pc, length);
+        if (size == 0)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+        starts[pc / 8] |= (unsigned char) (1 << (pc % 8));
+    }
+
+    // Every path must finish with an explicit end, never by running out of bytecode.
+    if (op != AX_END && op != AX_GOTO)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Jumps must land on the start of an opcode.
+    for (pc = 0; pc < length; pc += instruction_length(code, pc, length))
+    {
+        op = code[pc];
+        if (op == AX_GOTO || op == AX_IF_GOTO)
+        {
+            target = (size_t) operand(&code[pc + 1], 2);
+            if (target >= length || !(starts[target / 8] & (1 << (target % 8))))
+            {
+                return -GDBS_ERROR_INVALID;
+            }
+        }
+    }
+
+    return GDBS_ERROR_OK;
+}
+
+/// Require at least n values on the stack.
+#define NEED(n)                                                                                   \
+    if (depth < (n))                                                                              \
+    {                                                                                             \
+        return -GDBS_ERROR_INVALID;                                                               \
+    }
+
+/// Push a value onto the stack.
+#define PUSH(v)                                                                                   \
+    if (depth >= GDBS_AGENT_STACK_DEPTH)                                                          \
+    {                                                                                             \
+        return -GDBS_ERROR_RESOURCES;                                                             \
+    }                                                                                             \
+    if (depth > 0)                                                                                \
+    {                                                                                             \
+        stack[depth - 1] = top;                                                                   \
+    }                                                                                             \
+    top = (v);                                                                                    \
+    ++depth
+
+/// Discard the top of the stack, exposing the value below.
+#define DROP()                                                                                    \
+    --depth;                                                                                      \
+    if (depth > 0)                                                                                \
+    {                                                                                             \
+        top = stack[depth - 1];                                                                   \
+    }
+
+/// Replace the top two values with the result of a binary operation on them.
+#define BINARY(expr)                                                                              \
+    NEED(2);                                                                                      \
+    below = stack[depth - 2];                                                                     \
+    top = (expr);                                                                                 \
+    --depth
+
+/**
+ * Evaluate a validated agent expression against the stopped target.
+ *
+ * @retval 0                        Expression evaluated.
+ * @retval -GDBS_ERROR_RESOURCES    The expression overflowed the evaluation stack.
+ * @retval -GDBS_ERROR_INVALID      The expression underflowed the evaluation stack or divided by
+ *                                  zero.
+ * @retval <0                       A memory or register access failed.  The exact value will be a
+ *                                  negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_agent_evaluate
+(
+    const unsigned char *code,  ///< [in]  Expression bytecode.
+    agent_value_t       *value  ///< [out] Value left on top of the stack, or zero if the stack is
+                                ///<       empty.
+)
+{
+    agent_value_t        stack[GDBS_AGENT_STACK_DEPTH];
+    agent_value_t        top = 0;
+    agent_value_t        below;
+    agent_value_t        quotient;
+    unsigned int         depth = 0;
+    size_t               pc = 0;
+    unsigned char        op;
+    unsigned char        bytes[8];
+    const unsigned char *reg;
+    unsigned int         size;
+    unsigned int         count;
+    unsigned int         i;
+    struct environment  *env = core_get_environment();
+    int                  result;
+
+    for (;;)
+    {
+        op = code[pc++];
+        switch (op)
+        {
+            case AX_ADD:
+                BINARY(below + top);
+                break;
+            case AX_SUB:
+                BINARY(below - top);
+                break;
+            case AX_MUL:
+                BINARY(below * top);
+                break;
+            case AX_DIV_SIGNED:
+            case AX_REM_SIGNED:
+                NEED(2);
+                if (top == 0)
+                {
+                    return -GDBS_ERROR_INVALID;
+                }
+                below = stack[depth - 2];
+                if (op == AX_DIV_SIGNED)
+                {
+                    quotient = magnitude(below) / magnitude(top);
+                    top = (((below ^ top) & SIGN_BIT) ? (agent_value_t) 0 - quotient : quotient);
+                }
+                else
+                {
+                    quotient = magnitude(below) % magnitude(top);
+                    top = ((below & SIGN_BIT) ? (agent_value_t) 0 - quotient : quotient);
+                }
+                --depth;
+                break;
+            case AX_DIV_UNSIGNED:
+            case AX_REM_UNSIGNED:
+                NEED(2);
+                if (top == 0)
+                {
+                    return -GDBS_ERROR_INVALID;
+                }
+                below = stack[depth - 2];
+                top = (op == AX_DIV_UNSIGNED ? below / top : below % top);
+                --depth;
+                break;
+            case AX_LSH:
+                BINARY(top >= VALUE_BITS ? 0 : below << top);
+                break;
+            case AX_RSH_SIGNED:
+                BINARY((below & SIGN_BIT) ?
+                       ~(top >= VALUE_BITS ? 0 : ~below >> top) :
+                       (top >= VALUE_BITS ? 0 : below >> top));
+                break;
+            case AX_RSH_UNSIGNED:
+                BINARY(top >= VALUE_BITS ? 0 : below >> top);
+                break;
+            case AX_LOG_NOT:
+                NEED(1);
+                top = !top;
+                break;
+            case AX_BIT_AND:
+                BINARY(below & top);
+                break;
+            case AX_BIT_OR:
+                BINARY(below | top);
+                break;
+            case AX_BIT_XOR:
+                BINARY(below ^ top);
+                break;
+            case AX_BIT_NOT:
+                NEED(1);
+                top = ~top;
+                break;
+            case AX_EQUAL:
+                BINARY(below == top);
+                break;
+            case AX_LESS_SIGNED:
+                BINARY((below ^ SIGN_BIT) < (top ^ SIGN_BIT));
+                break;
+            case AX_LESS_UNSIGNED:
+                BINARY(below < top);
+                break;
+            case AX_EXT:
+                NEED(1);
+                size = code[pc++];
+                if (size > 0 && size < VALUE_BITS)
+                {
+                    below = (agent_value_t) 1 << (size - 1);
+                    top = ((top & ((below << 1) - 1)) ^ below) - below;
+                }
+                break;
+            case AX_ZERO_EXT:
+                NEED(1);
+                size = code[pc++];
+                if (size < VALUE_BITS)
+                {
+                    top &= ((agent_value_t) 1 << size) - 1;
+                }
+                break;
+            case AX_REF8:
+            case AX_REF16:
+            case AX_REF32:
+            case AX_REF64:
+                NEED(1);
+                size = 1U << (op - AX_REF8);
+                result = gdbs_memory_read(env->comm, (gdbs_address_t) top, bytes, size);
+                if (result < 0)
+                {
+                    return result;
+                }
+                proto_breakpoint_filter_read((gdbs_address_t) top, bytes, size);
+                top = (agent_value_t) bytes_to_value(bytes, size, is_little_endian());
+                break;
+            case AX_TRACE:
+            case AX_TRACENZ:
+                NEED(2);
+                below = stack[depth - 2];
+                result = proto_trace_collect_memory((gdbs_address_t) below, (gdbs_address_t) top,
+                                                    op == AX_TRACENZ);
+                if (result < 0)
+                {
+                    return result;
+                }
+                DROP();
+                DROP();
+                break;
+            case AX_TRACE_QUICK:
+            case AX_TRACE16:
+                NEED(1);
+                size = (op == AX_TRACE16 ? 2 : 1);
+                result = proto_trace_collect_memory((gdbs_address_t) top,
+                                                    (gdbs_address_t) operand(&code[pc], size), 0);
+                if (result < 0)
+                {
+                    return result;
+                }
+                pc += size;
+                break;
+            case AX_IF_GOTO:
+                NEED(1);
+                below = top;
+                DROP();
+                pc = (below != 0 ? (size_t) operand(&code[pc], 2) : pc + 2);
+                break;
+            case AX_GOTO:
+                pc = (size_t) operand(&code[pc], 2);
+                break;
+            case AX_CONST8:
+            case AX_CONST16:
+            case AX_CONST32:
+            case AX_CONST64:
+                size = 1U << (op - AX_CONST8);
+                PUSH(operand(&code[pc], size));
+                pc += size;
+                break;
+            case AX_REG:
+                result = proto_get_register_bytes((gdbs_address_t) operand(&code[pc], 2),
+                                                  &reg, &size);
+                if (result < 0)
+                {
+                    return result;
+                }
+                PUSH((agent_value_t) bytes_to_value(reg, size, is_little_endian()));
+                pc += 2;
+                break;
+            case AX_END:
+                *value = (depth > 0 ? top : 0);
+                return GDBS_ERROR_OK;
+            case AX_DUP:
+                NEED(1);
+                PUSH(top);
+                break;
+            case AX_POP:
+                NEED(1);
+                DROP();
+                break;
+            case AX_SWAP:
+                NEED(2);
+                below = stack[depth - 2];
+                stack[depth - 2] = top;
+                top = below;
+                break;
+            case AX_PICK:
+                size = code[pc++];
+                NEED(size + 1);
+                PUSH(size == 0 ? top : stack[depth - 1 - size]);
+                break;
+            case AX_ROT:
+                NEED(3);
+                below = stack[depth - 2];
+                stack[depth - 2] = stack[depth - 3];
+                stack[depth - 3] = top;
+                top = below;
+                break;
+            case AX_PRINTF:
+                // The function and channel are ignored, since output always goes to GDB.
+                count = code[pc];
+                size = (unsigned int) operand(&code[pc + 1], 2);
+                NEED(count + 2);
+                depth -= count + 2;
+
+                // Arguments are stacked last first.  Reverse them in place for the formatter.
+                for (i = 0; i < count / 2; ++i)
+                {
+                    below = stack[depth + i];
+                    stack[depth + i] = stack[depth + count - 1 - i];
+                    stack[depth + count - 1 - i] = below;
+                }
+                proto_console_format(&code[pc + 3], size - 1, &stack[depth], count);
+
+                if (depth > 0)
+                {
+                    top = stack[depth - 1];
+                }
+                pc += 3 + size;
+                break;
+            default:
+                // Unreachable for validated expressions.
+                return -GDBS_ERROR_INVALID;
+        }
+    }
+}
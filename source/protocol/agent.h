@@ -0,0 +1,51 @@
+/**
+ *  @file       agent.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Interpreter for GDB agent expression bytecode.
+ */
+#ifndef AGENT_H_
+#define AGENT_H_
+
+#include "gdbsconfig.h"
+
+#include "stdc/size.h"
+
+/// Agent expression value type.
+typedef GDBS_AGENT_VALUE_TYPE agent_value_t;
+
+/**
+ * Check that an agent expression can be evaluated safely.  Every opcode must be supported with
+ * complete operands, every jump must land on an opcode, and the expression must not be able to run
+ * past its end.  Only expressions which pass this check may be given to proto_agent_evaluate().
+ *
+ * @retval 0                    Expression is valid.
+ * @retval -GDBS_ERROR_INVALID  Expression is malformed or uses unsupported opcodes.
+ */
+int proto_agent_validate
+(
+    const unsigned char *code,  ///< Expression bytecode.
+    size_t               length ///< Length of the bytecode.
+);
+
+/**
+ * Evaluate a validated agent expression against the stopped target.
+ *
+ * @retval 0                        Expression evaluated.
+ * @retval -GDBS_ERROR_RESOURCES    The expression overflowed the evaluation stack.
+ * @retval -GDBS_ERROR_INVALID      The expression underflowed the evaluation stack or divided by
+ *                                  zero.
+ * @retval <0                       A memory or register access failed.  The exact value will be a
+ *                                  negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_agent_evaluate
+(
+    const unsigned char *code,  ///< [in]  Expression bytecode.
+    agent_value_t       *value  ///< [out] Value left on top of the stack, or zero if the stack is
+                                ///<       empty.
+);
+
+#endif /* end AGENT_H_ */
@@ -0,0 +1,1110 @@
+/**
+ *  @file       breakpoint.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Breakpoint commands for the GDB protocol.
+ *
+ *  GDB removes every breakpoint when the target stops and inserts them all again before it resumes.
+ *  Rather than patching target memory and flushing the instruction cache for each of these
+ *  commands, software breakpoints are kept in a table sorted by address, and only the net changes
+ *  are applied when the target actually resumes.  Memory accesses made while the target is stopped
+ *  are filtered so that GDB never sees the breakpoint instructions which are still in place.
+ *
+ *  Hardware breakpoints and watchpoints do not touch target memory, so they are programmed into a
+ *  comparator unit immediately.  The stub keeps track of which units are allocated, so that the
+ *  port only has to provide the register-level hooks.
+ *
+ *  Software breakpoints may carry conditions, as agent expressions, which are evaluated by the stub
+ *  when the breakpoint is hit.  If every condition is false, the stub steps over the breakpoint and
+ *  lets the target continue without sending anything to GDB.  Conditions on hardware breakpoints
+ *  are ignored, which is safe because GDB evaluates the condition again for any reported stop.
+ *
+ *  Breakpoints may also carry commands, which GDB uses for dynamic printf.  When a breakpoint with
+ *  commands is hit and its conditions allow, the stub runs the commands and continues, without
+ *  reporting the stop.  Console output from the commands is batched by the console module.
+ *
+ *  Tracepoints share the breakpoint table, so that their breakpoint instructions are hidden from
+ *  memory accesses in the same way.  A breakpoint placed for a tracepoint hands each hit to the
+ *  trace module, then steps over and continues unless GDB has also asked for a breakpoint there.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "breakpoint.h"
+
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/agent.h"
+#include "protocol/console.h"
+#include "protocol/memory.h"
+#include "protocol/registers.h"
+#include "protocol/response.h"
+#include "protocol/trace.h"
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/null.h"
+
+/// Breakpoint state flag indicating that GDB has requested the breakpoint.
+#define BREAKPOINT_REQUESTED 0x01
+/// Breakpoint state flag indicating that the breakpoint instruction is present in target memory.
+#define BREAKPOINT_INSERTED  0x02
+/// Breakpoint state flag indicating that a tracepoint needs the breakpoint while tracing.
+#define BREAKPOINT_TRACE     0x04
+/// Breakpoint state flags indicating that the breakpoint is wanted in target memory.
+#define BREAKPOINT_WANTED    (BREAKPOINT_REQUESTED | BREAKPOINT_TRACE)
+
+/// Agent pool record tag for a breakpoint condition.
+#define ACTION_CONDITION 'X'
+/// Agent pool record tag for a breakpoint command.
+#define ACTION_COMMAND   'C'
+/// Length of the header preceding each agent expression in the agent pool: the record tag, then
+/// the bytecode length as a big-endian 16-bit value.
+#define ACTION_HEADER_LENGTH 3
+
+/// Breakpoint types used by the 'Z' and 'z' commands.
+enum breakpoint_type
+{
+    BT_SOFTWARE,    ///< Software breakpoint.
+    BT_HARDWARE,    ///< Hardware breakpoint.
+    BT_WRITE_WATCH, ///< Write watchpoint.
+    BT_READ_WATCH,  ///< Read watchpoint.
+    BT_ACCESS_WATCH ///< Access watchpoint.
+};
+
+/**
+ * Parse the arguments of a 'Z' or 'z' command.
+ *
+ * @retval 0                    Arguments parsed.
+ * @retval -GDBS_ERROR_INVALID  The arguments are malformed.
+ */
+static int parse
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer positioned after the command character.
+    gdbs_address_t          *type,      ///< [out] Breakpoint type.
+    gdbs_address_t          *address,   ///< [out] Breakpoint address.
+    gdbs_address_t          *kind       ///< [out] Breakpoint kind, which is usually a length.
+)
+{
+    int result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', type) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, ',', address) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // The kind may be followed by a list of conditions.
+    result = packet_tokenizer_advance_unsigned(tokenizer, ';', kind);
+    return ((result == GDBS_ERROR_OK || result == -GDBS_ERROR_NOT_FOUND) ?
+            GDBS_ERROR_OK : -GDBS_ERROR_INVALID);
+}
+
+/**
+ * Find the position of an address in the breakpoint table.
+ *
+ * @return Index of the first breakpoint at or above the address.
+ */
+static unsigned int find
+(
+    const struct environment    *env,    ///< Stub environment.
+    gdbs_address_t               address ///< Address to search for.
+)
+{
+    unsigned int low = 0;
+    unsigned int high = env->breakpoint_count;
+    unsigned int middle;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (env->breakpoints[middle].address < address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Decode a list of agent expressions into the free space at the end of the agent pool.  Staged
+ * expressions only become part of the pool once attach_actions() is called.
+ *
+ * @retval 0                        Expressions staged.
+ * @retval -GDBS_ERROR_INVALID      The list is malformed, or an expression failed validation.
+ * @retval -GDBS_ERROR_RESOURCES    The agent pool is full.
+ */
+static int stage_expressions
+(
+    struct environment  *env,    ///< [in]     Stub environment.
+    unsigned char        tag,    ///< [in]     Record tag for the expressions.
+    const unsigned char *text,   ///< [in]     Expression list, as "X<length>,<bytecode>" repeated.
+    size_t               length, ///< [in]     Length of the list.
+    size_t              *staged  ///< [in,out] Number of bytes staged beyond the used part of the
+                                 ///<          pool.
+)
+{
+    unsigned char   *record;
+    gdbs_address_t   size;
+    size_t           i = 0;
+    size_t           start;
+    int              result;
+
+    while (i < length)
+    {
+        if (text[i++] != 'X')
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+
+        for (start = i; i < length && text[i] != ','; ++i)
+        {
+        }
+        if (i == start || i == length ||
+            hex_string_to_unsigned((const char *) &text[start], i - start, &size) < 0)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+        ++i;
+
+        if (size == 0 || size > GDBS_AGENT_BYTECODE_LENGTH || (length - i) / 2 < size)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+        if (GDBS_AGENT_BYTECODE_LENGTH - env->agent_pool_used - *staged <
+            ACTION_HEADER_LENGTH + size)
+        {
+            return -GDBS_ERROR_RESOURCES;
+        }
+
+        record = &env->agent_pool[env->agent_pool_used + *staged];
+        record[0] = tag;
+        record[1] = (unsigned char) (size >> 8);
+        record[2] = (unsigned char) size;
+        result = hex_string_to_bytes((const char *) &text[i], size * 2,
+                                     &record[ACTION_HEADER_LENGTH]);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = proto_agent_validate(&record[ACTION_HEADER_LENGTH], size);
+        }
+        if (result < 0)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+
+        i += size * 2;
+        *staged += ACTION_HEADER_LENGTH + size;
+    }
+
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Decode the optional parameters which follow the kind in a 'Z' command.
+ *
+ * @retval 0    Parameters staged.
+ * @retval <0   The parameters could not be staged.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+static int stage_actions
+(
+    struct environment      *env,       ///< [in]  Stub environment.
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer positioned after the kind.
+    size_t                  *staged     ///< [out] Number of bytes staged beyond the used part of
+                                        ///<       the agent pool.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    size_t               i;
+    int                  result = GDBS_ERROR_OK;
+
+    *staged = 0;
+    while (result == GDBS_ERROR_OK &&
+           packet_tokenizer_advance(tokenizer, ';', &token, &length) != -GDBS_ERROR_EOB)
+    {
+        if (length > 0 && token[0] == 'X')
+        {
+            result = stage_expressions(env, ACTION_CONDITION, token, length, staged);
+        }
+        else if (length > 5 && memcmp(token, "cmds:", 5) == 0)
+        {
+            // The persist flag only matters for disconnected tracing, so it is skipped.
+            for (i = 5; i < length && token[i] != ','; ++i)
+            {
+            }
+            result = (i == length ? -GDBS_ERROR_INVALID :
+                      stage_expressions(env, ACTION_COMMAND, &token[i + 1], length - i - 1,
+                                        staged));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Replace the agent expressions attached to a breakpoint with those staged at the end of the pool.
+ * The previous expressions are removed from the pool, and the pool is compacted.
+ */
+static void attach_actions
+(
+    struct environment  *env,   ///< Stub environment.
+    struct breakpoint   *bp,    ///< Breakpoint to update.
+    size_t               staged ///< Number of bytes staged beyond the used part of the pool.
+)
+{
+    size_t          end = env->agent_pool_used + staged;
+    size_t          offset = bp->actions;
+    size_t          old = bp->actions_length;
+    size_t          i;
+
+    if (old > 0)
+    {
+        for (i = offset; i + old < end; ++i)
+        {
+            env->agent_pool[i] = env->agent_pool[i + old];
+        }
+        for (i = 0; i < env->breakpoint_count; ++i)
+        {
+            if (env->breakpoints[i].actions_length > 0 && env->breakpoints[i].actions > offset)
+            {
+                env->breakpoints[i].actions = (unsigned short) (env->breakpoints[i].actions - old);
+            }
+        }
+        env->agent_pool_used -= (unsigned int) old;
+    }
+
+    bp->actions = (unsigned short) env->agent_pool_used;
+    bp->actions_length = (unsigned short) staged;
+    env->agent_pool_used += (unsigned int) staged;
+}
+
+/**
+ * Request a software breakpoint, on behalf of GDB or of a tracepoint.
+ *
+ * @retval 0    Breakpoint recorded.
+ * @retval <0   The breakpoint could not be recorded.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+static int insert_software
+(
+    struct environment  *env,       ///< Stub environment.
+    gdbs_address_t       address,   ///< Breakpoint address.
+    gdbs_address_t       kind,      ///< Breakpoint kind.
+    size_t               staged,    ///< Number of bytes of agent expressions staged for the
+                                    ///< breakpoint.
+    unsigned char        flag       ///< BREAKPOINT_REQUESTED or BREAKPOINT_TRACE.
+)
+{
+    struct breakpoint   *bp;
+    const unsigned char *instruction;
+    unsigned char        saved[GDBS_BREAKPOINT_LENGTH_MAX];
+    unsigned int         i;
+    unsigned int         length = 0;
+    unsigned int         position;
+    int                  result;
+
+    position = find(env, address);
+    bp = &env->breakpoints[position];
+    if (position < env->breakpoint_count && bp->address == address)
+    {
+        // Typically a breakpoint which GDB removed and reinserted while the target was stopped, or
+        // one shared by GDB and a tracepoint.  Only GDB attaches agent expressions.
+        bp->flags |= flag;
+        if (flag == BREAKPOINT_REQUESTED)
+        {
+            attach_actions(env, bp, staged);
+        }
+        return GDBS_ERROR_OK;
+    }
+
+    if (env->breakpoint_count >= GDBS_BREAKPOINT_COUNT)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+
+    instruction = gdbs_get_breakpoint_instruction(kind, &length);
+    if (instruction == NULL || length == 0 || length > GDBS_BREAKPOINT_LENGTH_MAX)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Save the original instruction now, so that an inaccessible address is reported immediately.
+    result = proto_sync_writes(address, length);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = gdbs_memory_read(env->comm, address, saved, length);
+    }
+    if (result < 0)
+    {
+        return result;
+    }
+
+    for (i = env->breakpoint_count; i > position; --i)
+    {
+        env->breakpoints[i] = env->breakpoints[i - 1];
+    }
+    ++env->breakpoint_count;
+
+    bp->address = address;
+    bp->instruction = instruction;
+    memcpy(bp->saved, saved, length);
+    bp->length = (unsigned char) length;
+    bp->flags = flag;
+    bp->actions_length = 0;
+    attach_actions(env, bp, staged);
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Withdraw the request for a software breakpoint.
+ */
+static void remove_software
+(
+    struct environment  *env,    ///< Stub environment.
+    gdbs_address_t       address ///< Breakpoint address.
+)
+{
+    unsigned int i = find(env, address);
+
+    if (i < env->breakpoint_count && env->breakpoints[i].address == address)
+    {
+        env->breakpoints[i].flags &= ~BREAKPOINT_REQUESTED;
+    }
+}
+
+/**
+ * Select the comparator pool which serves a comparator type.
+ *
+ * @return First comparator record of the pool.
+ */
+static struct comparator *comparator_pool
+(
+    struct environment          *env,  ///< [in]  Stub environment.
+    enum gdbs_comparator_type    type, ///< [in]  Comparator type.
+    unsigned int                *count ///< [out] Number of units in the pool.
+)
+{
+    if (type == GDBS_COMPARATOR_BREAK)
+    {
+        *count = env->hw_breakpoint_count;
+        return env->hw_breakpoints;
+    }
+
+    *count = env->watchpoint_count;
+    return env->watchpoints;
+}
+
+/**
+ * Allocate and program a comparator for a hardware breakpoint or watchpoint.
+ *
+ * @retval 0    Comparator programmed.
+ * @retval <0   The comparator could not be programmed.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+static int insert_hardware
+(
+    struct environment          *env,     ///< Stub environment.
+    enum gdbs_comparator_type    type,    ///< Comparator type.
+    gdbs_address_t               address, ///< Start address.
+    gdbs_address_t               length   ///< Length of the region.
+)
+{
+    struct comparator   *pool;
+    unsigned int         count;
+    unsigned int         free = GDBS_COMPARATOR_COUNT;
+    unsigned int         i;
+    int                  result;
+
+    pool = comparator_pool(env, type, &count);
+    for (i = 0; i < count; ++i)
+    {
+        if (!pool[i].used)
+        {
+            if (free == GDBS_COMPARATOR_COUNT)
+            {
+                free = i;
+            }
+        }
+        else if (pool[i].type == type && pool[i].address == address && pool[i].length == length)
+        {
+            // Already programmed.
+            return GDBS_ERROR_OK;
+        }
+    }
+
+    if (free == GDBS_COMPARATOR_COUNT)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+
+    result = gdbs_set_comparator(free, type, address, length);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    pool[free].address = address;
+    pool[free].length = length;
+    pool[free].type = (unsigned char) type;
+    pool[free].used = 1;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Disable and release the comparator for a hardware breakpoint or watchpoint.
+ */
+static void remove_hardware
+(
+    struct environment          *env,     ///< Stub environment.
+    enum gdbs_comparator_type    type,    ///< Comparator type.
+    gdbs_address_t               address, ///< Start address.
+    gdbs_address_t               length   ///< Length of the region.
+)
+{
+    struct comparator   *pool;
+    unsigned int         count;
+    unsigned int         i;
+
+    pool = comparator_pool(env, type, &count);
+    for (i = 0; i < count; ++i)
+    {
+        if (pool[i].used && pool[i].type == type &&
+            pool[i].address == address && pool[i].length == length)
+        {
+            gdbs_clear_comparator(i, type);
+            pool[i].used = 0;
+            return;
+        }
+    }
+}
+
+/**
+ * Release every comparator in a pool.
+ */
+static void clear_hardware
+(
+    struct comparator   *pool, ///< First comparator record of the pool.
+    unsigned int         count ///< Number of units in the pool.
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (pool[i].used)
+        {
+            gdbs_clear_comparator(i, (enum gdbs_comparator_type) pool[i].type);
+            pool[i].used = 0;
+        }
+    }
+}
+
+/**
+ * Query the port for the number of comparator units in each pool.  This must be called once the
+ * environment has been reset.
+ */
+void proto_init_comparators(void)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         count;
+
+    count = gdbs_get_comparator_count(GDBS_COMPARATOR_BREAK);
+    env->hw_breakpoint_count = (count < GDBS_COMPARATOR_COUNT ? count : GDBS_COMPARATOR_COUNT);
+    count = gdbs_get_comparator_count(GDBS_COMPARATOR_WATCH);
+    env->watchpoint_count = (count < GDBS_COMPARATOR_COUNT ? count : GDBS_COMPARATOR_COUNT);
+}
+
+/**
+ * Fill in the details of a watchpoint stop from the comparator unit which triggered it.  Events
+ * which do not name a valid, allocated watchpoint unit are left unchanged.
+ */
+void proto_resolve_watchpoint
+(
+    struct gdbs_stop_event *event ///< [in,out] Stop event reported by the port.
+)
+{
+    const struct comparator     *watch;
+    struct environment          *env = core_get_environment();
+
+    if (event->unit < 0 || (unsigned int) event->unit >= env->watchpoint_count)
+    {
+        return;
+    }
+
+    watch = &env->watchpoints[event->unit];
+    if (!watch->used)
+    {
+        return;
+    }
+
+    switch (watch->type)
+    {
+        case GDBS_COMPARATOR_RWATCH:
+            event->reason = GDBS_STOP_RWATCH;
+            break;
+        case GDBS_COMPARATOR_AWATCH:
+            event->reason = GDBS_STOP_AWATCH;
+            break;
+        default:
+            event->reason = GDBS_STOP_WATCH;
+            break;
+    }
+    event->address = watch->address;
+}
+
+/**
+ * Handle the 'Z' command, which inserts a breakpoint.  Software breakpoints are only recorded
+ * here, and are written to target memory by proto_commit_breakpoints() when the target resumes.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_insert_breakpoint
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       type;
+    gdbs_address_t       address;
+    gdbs_address_t       kind;
+    size_t               staged;
+    int                  result;
+
+    result = parse(tokenizer, &type, &address, &kind);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    switch (type)
+    {
+        case BT_SOFTWARE:
+            result = stage_actions(env, tokenizer, &staged);
+            if (result == GDBS_ERROR_OK)
+            {
+                result = insert_software(env, address, kind, staged, BREAKPOINT_REQUESTED);
+            }
+            break;
+        case BT_HARDWARE:
+        case BT_WRITE_WATCH:
+        case BT_READ_WATCH:
+        case BT_ACCESS_WATCH:
+            result = insert_hardware(env, (enum gdbs_comparator_type) (type - BT_HARDWARE),
+                                     address, kind);
+            break;
+        default:
+            return proto_send_empty();
+    }
+
+    return (result < 0 ? result : proto_send_ok());
+}
+
+/**
+ * Handle the 'z' command, which removes a breakpoint.  Software breakpoints are only recorded
+ * here, and are removed from target memory by proto_commit_breakpoints() when the target resumes.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_remove_breakpoint
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    gdbs_address_t   type;
+    gdbs_address_t   address;
+    gdbs_address_t   kind;
+    int              result;
+
+    result = parse(tokenizer, &type, &address, &kind);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    switch (type)
+    {
+        case BT_SOFTWARE:
+            remove_software(core_get_environment(), address);
+            break;
+        case BT_HARDWARE:
+        case BT_WRITE_WATCH:
+        case BT_READ_WATCH:
+        case BT_ACCESS_WATCH:
+            remove_hardware(core_get_environment(),
+                            (enum gdbs_comparator_type) (type - BT_HARDWARE),
+                            address, kind);
+            break;
+        default:
+            return proto_send_empty();
+    }
+
+    return proto_send_ok();
+}
+
+/**
+ * Request a software breakpoint for a tracepoint.  The breakpoint is inserted into target memory
+ * by proto_commit_breakpoints() when the target resumes, using the breakpoint instruction of
+ * kind 0.
+ *
+ * @retval 0    Breakpoint recorded.
+ * @retval <0   The breakpoint could not be recorded.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int proto_insert_trace_breakpoint
+(
+    gdbs_address_t address ///< Tracepoint address.
+)
+{
+    return insert_software(core_get_environment(), address, 0, 0, BREAKPOINT_TRACE);
+}
+
+/**
+ * Withdraw the requests for every breakpoint placed for a tracepoint.  As with 'z', the removal
+ * takes effect on the next call to proto_commit_breakpoints().
+ */
+void proto_clear_trace_breakpoints(void)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+
+    for (i = 0; i < env->breakpoint_count; ++i)
+    {
+        env->breakpoints[i].flags &= ~BREAKPOINT_TRACE;
+    }
+}
+
+/**
+ * Request the removal of all breakpoints and watchpoints, including those placed for tracepoints.
+ * Hardware comparators are released immediately.  As with 'z', the removal of software
+ * breakpoints takes effect on the next call to proto_commit_breakpoints().
+ */
+void proto_clear_breakpoints(void)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+
+    for (i = 0; i < env->breakpoint_count; ++i)
+    {
+        env->breakpoints[i].flags &= ~BREAKPOINT_WANTED;
+    }
+
+    clear_hardware(env->hw_breakpoints, env->hw_breakpoint_count);
+    clear_hardware(env->watchpoints, env->watchpoint_count);
+}
+
+/**
+ * Bring target memory in line with the breakpoint table, inserting and removing breakpoint
+ * instructions as requested since the last call.  This must be called before the target resumes.
+ * The instruction cache is not flushed here, so that the caller can flush it once for all changes.
+ *
+ * @return Number of breakpoints inserted or removed.
+ */
+unsigned int proto_commit_breakpoints(void)
+{
+    struct breakpoint   *bp;
+    unsigned int         changed = 0;
+    unsigned int         i;
+    unsigned int         kept = 0;
+    int                  result;
+    struct environment  *env = core_get_environment();
+
+    for (i = 0; i < env->breakpoint_count; ++i)
+    {
+        bp = &env->breakpoints[i];
+
+        if ((bp->flags & BREAKPOINT_WANTED) && !(bp->flags & BREAKPOINT_INSERTED))
+        {
+            result = gdbs_memory_write(env->comm, bp->address, bp->instruction, bp->length);
+            if (result == GDBS_ERROR_OK)
+            {
+                bp->flags |= BREAKPOINT_INSERTED;
+                ++changed;
+            }
+            else
+            {
+                GDBS_LOG("Failed to insert breakpoint at 0x%lx: %s\n",
+                         (unsigned long) bp->address, gdbs_error_to_string(-result));
+            }
+        }
+        else if (bp->flags == BREAKPOINT_INSERTED)
+        {
+            result = gdbs_memory_write(env->comm, bp->address, bp->saved, bp->length);
+            if (result == GDBS_ERROR_OK)
+            {
+                bp->flags = 0;
+                ++changed;
+            }
+            else
+            {
+                GDBS_LOG("Failed to remove breakpoint at 0x%lx: %s\n",
+                         (unsigned long) bp->address, gdbs_error_to_string(-result));
+            }
+        }
+
+        // Drop entries which are neither wanted nor in memory.
+        if (bp->flags != 0)
+        {
+            env->breakpoints[kept++] = *bp;
+        }
+        else if (bp->actions_length > 0)
+        {
+            attach_actions(env, bp, 0);
+        }
+    }
+    env->breakpoint_count = kept;
+
+    return changed;
+}
+
+/**
+ * Reconcile a block of memory data with the breakpoints which overlap it.
+ */
+static void filter
+(
+    gdbs_address_t   address, ///< [in]     Target address of the data.
+    unsigned char   *data,    ///< [in,out] Data read from, or to be written to, target memory.
+    gdbs_address_t   length,  ///< [in]     Length of the data.
+    int              write    ///< [in]     Boolean indicating that the data is to be written.
+)
+{
+    struct breakpoint   *bp;
+    gdbs_address_t       offset;
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+    unsigned int         j;
+
+    // Breakpoints starting shortly before the block may still overlap it.
+    i = find(env, (address > GDBS_BREAKPOINT_LENGTH_MAX ? address - GDBS_BREAKPOINT_LENGTH_MAX : 0));
+
+    for (; i < env->breakpoint_count; ++i)
+    {
+        bp = &env->breakpoints[i];
+        if (bp->address >= address && bp->address - address >= length)
+        {
+            break;
+        }
+
+        for (j = 0; j < bp->length; ++j)
+        {
+            offset = bp->address + j - address;
+            if (bp->address + j < address || offset >= length)
+            {
+                continue;
+            }
+
+            if (write)
+            {
+                bp->saved[j] = data[offset];
+                if (bp->flags & BREAKPOINT_INSERTED)
+                {
+                    data[offset] = bp->instruction[j];
+                }
+            }
+            else if (bp->flags & BREAKPOINT_INSERTED)
+            {
+                data[offset] = bp->saved[j];
+            }
+        }
+    }
+}
+
+/**
+ * Hide inserted breakpoints from data read out of target memory, by replacing breakpoint
+ * instructions with the original instruction bytes.
+ */
+void proto_breakpoint_filter_read
+(
+    gdbs_address_t   address, ///< [in]     Target address the data was read from.
+    unsigned char   *data,    ///< [in,out] Data read from target memory.
+    gdbs_address_t   length   ///< [in]     Length of the data.
+)
+{
+    filter(address, data, length, 0);
+}
+
+/**
+ * Preserve inserted breakpoints in data about to be written to target memory.  Bytes which overlap
+ * a breakpoint are saved as the new original instruction, and replaced with the breakpoint
+ * instruction so that the breakpoint remains in place.
+ */
+void proto_breakpoint_filter_write
+(
+    gdbs_address_t   address, ///< [in]     Target address the data will be written to.
+    unsigned char   *data,    ///< [in,out] Data to be written to target memory.
+    gdbs_address_t   length   ///< [in]     Length of the data.
+)
+{
+    filter(address, data, length, 1);
+}
+
+/**
+ * Determine whether GDB has requested a software or hardware breakpoint at an address.
+ *
+ * @return Boolean indicating that a breakpoint is requested at the address.
+ */
+int proto_breakpoint_at
+(
+    gdbs_address_t address ///< Address to check.
+)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+
+    i = find(env, address);
+    if (i < env->breakpoint_count && env->breakpoints[i].address == address &&
+        (env->breakpoints[i].flags & BREAKPOINT_REQUESTED))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < env->hw_breakpoint_count; ++i)
+    {
+        if (env->hw_breakpoints[i].used && env->hw_breakpoints[i].address == address)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Evaluate the conditions attached to a breakpoint.  A condition which cannot be evaluated is
+ * treated as true, so that GDB gets to decide.
+ *
+ * @return Boolean indicating that the breakpoint has no conditions, or that at least one is true.
+ */
+static int condition_true
+(
+    const struct environment    *env, ///< Stub environment.
+    const struct breakpoint     *bp   ///< Breakpoint which was hit.
+)
+{
+    const unsigned char *record = &env->agent_pool[bp->actions];
+    const unsigned char *end = record + bp->actions_length;
+    unsigned int         length;
+    int                  conditions = 0;
+    int                  result;
+    agent_value_t        value;
+
+    for (; record < end; record += ACTION_HEADER_LENGTH + length)
+    {
+        length = ((unsigned int) record[1] << 8) | record[2];
+        if (record[0] != ACTION_CONDITION)
+        {
+            continue;
+        }
+
+        ++conditions;
+        result = proto_agent_evaluate(&record[ACTION_HEADER_LENGTH], &value);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to evaluate condition at 0x%lx: %s\n",
+                     (unsigned long) bp->address, gdbs_error_to_string(-result));
+            return 1;
+        }
+        if (value != 0)
+        {
+            return 1;
+        }
+    }
+
+    return (conditions == 0);
+}
+
+/**
+ * Run the commands attached to a breakpoint.  Commands which fail are skipped.
+ *
+ * @return Number of commands attached to the breakpoint.
+ */
+static unsigned int run_commands
+(
+    const struct environment    *env, ///< Stub environment.
+    const struct breakpoint     *bp   ///< Breakpoint which was hit.
+)
+{
+    const unsigned char *record = &env->agent_pool[bp->actions];
+    const unsigned char *end = record + bp->actions_length;
+    unsigned int         length;
+    unsigned int         commands = 0;
+    int                  result;
+    agent_value_t        value;
+
+    for (; record < end; record += ACTION_HEADER_LENGTH + length)
+    {
+        length = ((unsigned int) record[1] << 8) | record[2];
+        if (record[0] != ACTION_COMMAND)
+        {
+            continue;
+        }
+
+        ++commands;
+        result = proto_agent_evaluate(&record[ACTION_HEADER_LENGTH], &value);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to run command at 0x%lx: %s\n",
+                     (unsigned long) bp->address, gdbs_error_to_string(-result));
+        }
+    }
+
+    return commands;
+}
+
+/**
+ * Arrange for the target to execute the original instruction under a breakpoint, by removing the
+ * breakpoint instruction for the duration of a single step.
+ *
+ * @return Boolean indicating that the step has been set up.
+ */
+static int begin_step_over
+(
+    struct environment  *env, ///< Stub environment.
+    struct breakpoint   *bp   ///< Breakpoint to step over.
+)
+{
+    int result;
+
+    result = gdbs_memory_write(env->comm, bp->address, bp->saved, bp->length);
+    if (result == GDBS_ERROR_OK)
+    {
+        gdbs_flush_icache();
+        result = gdbs_set_single_step(1);
+        if (result < 0)
+        {
+            gdbs_memory_write(env->comm, bp->address, bp->instruction, bp->length);
+            gdbs_flush_icache();
+        }
+    }
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to step over breakpoint at 0x%lx: %s\n",
+                 (unsigned long) bp->address, gdbs_error_to_string(-result));
+        return 0;
+    }
+
+    env->stepping_over = 1;
+    env->step_over_address = bp->address;
+    return 1;
+}
+
+/**
+ * Put the breakpoint instruction back after stepping over it, and stop single stepping.
+ */
+static void end_step_over
+(
+    struct environment  *env ///< Stub environment.
+)
+{
+    struct breakpoint   *bp;
+    unsigned int         i = find(env, env->step_over_address);
+    int                  result;
+
+    env->stepping_over = 0;
+    gdbs_set_single_step(0);
+
+    bp = &env->breakpoints[i];
+    if (i >= env->breakpoint_count || bp->address != env->step_over_address ||
+        !(bp->flags & BREAKPOINT_INSERTED))
+    {
+        return;
+    }
+
+    // A tracepoint which stopped tracing during the hit no longer needs its breakpoint, and the
+    // original instruction is already back in place.
+    if (!(bp->flags & BREAKPOINT_WANTED))
+    {
+        bp->flags &= ~BREAKPOINT_INSERTED;
+    }
+    else
+    {
+        result = gdbs_memory_write(env->comm, bp->address, bp->instruction, bp->length);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to restore breakpoint at 0x%lx: %s\n",
+                     (unsigned long) bp->address, gdbs_error_to_string(-result));
+        }
+        gdbs_flush_icache();
+    }
+}
+
+/**
+ * Handle a stop which may have been caused by a breakpoint with conditions or commands, before
+ * anything is reported to GDB.  If every condition of the breakpoint is false, or the breakpoint
+ * has commands to run instead, the stub steps over it and the target continues.  The trap raised at
+ * the end of that step is absorbed in the same way.
+ *
+ * @return Boolean indicating that the stub has arranged for the target to continue, and the stop
+ *         must not be reported to GDB.
+ */
+int proto_breakpoint_hit(void)
+{
+    struct breakpoint   *bp;
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+    gdbs_address_t       pc;
+
+    if (env->stepping_over)
+    {
+        end_step_over(env);
+        return (env->stop.signal == GDBS_SIGNAL_TRAP && env->stop.reason == GDBS_STOP_SIGNAL);
+    }
+
+    if (env->stepping || env->breakpoint_count == 0 ||
+        env->stop.signal != GDBS_SIGNAL_TRAP ||
+        (env->stop.reason != GDBS_STOP_SIGNAL && env->stop.reason != GDBS_STOP_SWBREAK) ||
+        proto_get_pc(&pc) < 0)
+    {
+        return 0;
+    }
+
+    i = find(env, pc);
+    bp = &env->breakpoints[i];
+    if (i >= env->breakpoint_count || bp->address != pc || !(bp->flags & BREAKPOINT_INSERTED))
+    {
+        return 0;
+    }
+
+    // Tracepoints collect their data and carry on, unless GDB wants the breakpoint as well.  The
+    // same goes for a breakpoint left in place after its tracepoint stopped tracing.
+    if (bp->flags & BREAKPOINT_TRACE)
+    {
+        proto_trace_hit(pc);
+    }
+    if (!(bp->flags & BREAKPOINT_REQUESTED))
+    {
+        return begin_step_over(env, bp);
+    }
+    if (bp->actions_length == 0)
+    {
+        return 0;
+    }
+
+    if (condition_true(env, bp))
+    {
+        // Breakpoints with commands are handled entirely by the stub.
+        if (run_commands(env, bp) == 0)
+        {
+            return 0;
+        }
+        // GDB does not accept console output in non-stop mode, so it stays queued there.
+        if (!env->non_stop && proto_console_pending() >= GDBS_CONSOLE_FLUSH_THRESHOLD)
+        {
+            proto_console_flush();
+        }
+    }
+
+    return begin_step_over(env, bp);
+}
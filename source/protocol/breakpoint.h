@@ -0,0 +1,139 @@
+/**
+ *  @file       breakpoint.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Breakpoint commands for the GDB protocol.
+ */
+#ifndef BREAKPOINT_H_
+#define BREAKPOINT_H_
+
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Query the port for the number of comparator units in each pool.  This must be called once the
+ * environment has been reset.
+ */
+void proto_init_comparators(void);
+
+/**
+ * Fill in the details of a watchpoint stop from the comparator unit which triggered it.  Events
+ * which do not name a valid, allocated watchpoint unit are left unchanged.
+ */
+void proto_resolve_watchpoint
+(
+    struct gdbs_stop_event *event ///< [in,out] Stop event reported by the port.
+);
+
+/**
+ * Handle the 'Z' command, which inserts a breakpoint.  Software breakpoints are only recorded
+ * here, and are written to target memory by proto_commit_breakpoints() when the target resumes.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_insert_breakpoint
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'z' command, which removes a breakpoint.  Software breakpoints are only recorded
+ * here, and are removed from target memory by proto_commit_breakpoints() when the target resumes.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_remove_breakpoint
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Request a software breakpoint for a tracepoint.  The breakpoint is inserted into target memory
+ * by proto_commit_breakpoints() when the target resumes, using the breakpoint instruction of
+ * kind 0.
+ *
+ * @retval 0    Breakpoint recorded.
+ * @retval <0   The breakpoint could not be recorded.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+int proto_insert_trace_breakpoint
+(
+    gdbs_address_t address ///< Tracepoint address.
+);
+
+/**
+ * Withdraw the requests for every breakpoint placed for a tracepoint.  As with 'z', the removal
+ * takes effect on the next call to proto_commit_breakpoints().
+ */
+void proto_clear_trace_breakpoints(void);
+
+/**
+ * Request the removal of all breakpoints and watchpoints, including those placed for tracepoints.
+ * Hardware comparators are released immediately.  As with 'z', the removal of software
+ * breakpoints takes effect on the next call to proto_commit_breakpoints().
+ */
+void proto_clear_breakpoints(void);
+
+/**
+ * Bring target memory in line with the breakpoint table, inserting and removing breakpoint
+ * instructions as requested since the last call.  This must be called before the target resumes.
+ * The instruction cache is not flushed here, so that the caller can flush it once for all changes.
+ *
+ * @return Number of breakpoints inserted or removed.
+ */
+unsigned int proto_commit_breakpoints(void);
+
+/**
+ * Hide inserted breakpoints from data read out of target memory, by replacing breakpoint
+ * instructions with the original instruction bytes.
+ */
+void proto_breakpoint_filter_read
+(
+    gdbs_address_t   address, ///< [in]     Target address the data was read from.
+    unsigned char   *data,    ///< [in,out] Data read from target memory.
+    gdbs_address_t   length   ///< [in]     Length of the data.
+);
+
+/**
+ * Preserve inserted breakpoints in data about to be written to target memory.  Bytes which overlap
+ * a breakpoint are saved as the new original instruction, and replaced with the breakpoint
+ * instruction so that the breakpoint remains in place.
+ */
+void proto_breakpoint_filter_write
+(
+    gdbs_address_t   address, ///< [in]     Target address the data will be written to.
+    unsigned char   *data,    ///< [in,out] Data to be written to target memory.
+    gdbs_address_t   length   ///< [in]     Length of the data.
+);
+
+/**
+ * Determine whether GDB has requested a software or hardware breakpoint at an address.
+ *
+ * @return Boolean indicating that a breakpoint is requested at the address.
+ */
+int proto_breakpoint_at
+(
+    gdbs_address_t address ///< Address to check.
+);
+
+/**
+ * Handle a stop which may have been caused by a breakpoint with conditions or commands, before
+ * anything is reported to GDB.  If every condition of the breakpoint is false, or the breakpoint
+ * has commands to run instead, the stub steps over it and the target continues.  The trap raised at
+ * the end of that step is absorbed in the same way.
+ *
+ * @return Boolean indicating that the stub has arranged for the target to continue, and the stop
+ *         must not be reported to GDB.
+ */
+int proto_breakpoint_hit(void);
+
+#endif /* end BREAKPOINT_H_ */
@@ -0,0 +1,592 @@
+/**
+ *  @file       console.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Console output to GDB for the GDB protocol.
+ *
+ *  Output produced while the target runs, such as by dynamic printf breakpoints or by the
+ *  application through gdbs_console_write(), is collected in a ring buffer and sent to GDB in
+ *  batches, so that output does not cost a packet per character or a round trip on every
+ *  breakpoint hit.  Any number of contexts may write at once: each claims its space in the ring
+ *  with a compare-and-swap, and counts itself as a writer until its data is in place.  Output is
+ *  only sent while there are no writers, so that claimed space which does not yet hold its data is
+ *  never sent.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "console.h"
+
+#include "auxiliary/packet.h"
+#include "core.h"
+
+/// Mask selecting the index in the ring buffer for a ring position.
+#define RING_MASK (GDBS_CONSOLE_BUFFER_LENGTH - 1)
+
+/// Longest string which a '%s' conversion reads from target memory.
+#define STRING_LIMIT 256
+
+/// Conversion specification flag for left justification.
+#define SPEC_LEFT       0x01
+/// Conversion specification flag for padding with zeros.
+#define SPEC_ZERO       0x02
+/// Conversion specification flag for a '+' on positive values.
+#define SPEC_PLUS       0x04
+/// Conversion specification flag for a space on positive values.
+#define SPEC_SPACE      0x08
+/// Conversion specification flag for the alternate form.
+#define SPEC_ALTERNATE  0x10
+
+/// Parsed printf() conversion specification.
+struct spec
+{
+    unsigned int    flags;      ///< SPEC_\* flags.
+    unsigned int    width;      ///< Minimum field width.
+    int             precision;  ///< Precision, or -1 if not given.
+    unsigned int    bits;       ///< Width of the argument type, in bits.
+};
+
+/**
+ * Add to or remove from the number of contexts writing into the ring buffer.
+ */
+static void count_writer
+(
+    struct environment  *env,  ///< Stub environment.
+    int                  delta ///< Change in the number of writers.
+)
+{
+    unsigned int count;
+
+    do
+    {
+        count = env->console_writers;
+    } while (!GDBS_ATOMIC_CAS(&env->console_writers, count, count + (unsigned int) delta));
+}
+
+/**
+ * Queue console output in the ring buffer, as far as it fits.  This may be called from several
+ * contexts at once.
+ *
+ * @return Number of bytes queued.
+ */
+static unsigned int append
+(
+    struct environment  *env,   ///< Stub environment.
+    const unsigned char *data,  ///< Output data.
+    unsigned int         length ///< Length of the data.
+)
+{
+    unsigned int    position;
+    unsigned int    count;
+    unsigned int    space;
+    unsigned int    i;
+
+    count_writer(env, 1);
+
+    // Claim space after the last claim, as far as the oldest unsent output allows.
+    do
+    {
+        position = env->console_claimed;
+        space = GDBS_CONSOLE_BUFFER_LENGTH - (position - env->console_sent);
+        count = (length < space ? length : space);
+    } while (count > 0 && !GDBS_ATOMIC_CAS(&env->console_claimed, position, position + count));
+
+    for (i = 0; i < count; ++i)
+    {
+        env->console[(position + i) & RING_MASK] = data[i];
+    }
+
+    count_writer(env, -1);
+    return count;
+}
+
+/**
+ * Queue a single character of console output.  If the buffer is full, the waiting output is sent
+ * to make room.
+ */
+static void put
+(
+    struct environment  *env, ///< Stub environment.
+    unsigned char        c    ///< Character to queue.
+)
+{
+    if (append(env, &c, 1) == 0)
+    {
+        proto_console_flush();
+        append(env, &c, 1);
+    }
+}
+
+/**
+ * Queue a run of padding characters.
+ */
+static void pad
+(
+    struct environment  *env,  ///< Stub environment.
+    unsigned char        c,    ///< Padding character.
+    unsigned int         count ///< Number of characters.
+)
+{
+    while (count-- > 0)
+    {
+        put(env, c);
+    }
+}
+
+/**
+ * Queue console output for GDB.  Output is sent when the buffer fills up, or when
+ * proto_console_flush() is called.
+ */
+void proto_console_write
+(
+    const unsigned char *data,  ///< Output data.
+    size_t               length ///< Length of the data.
+)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         count;
+
+    while (length > 0)
+    {
+        count = append(env, data, (unsigned int) (length < GDBS_CONSOLE_BUFFER_LENGTH ?
+                                                  length : GDBS_CONSOLE_BUFFER_LENGTH));
+        if (count == 0)
+        {
+            // The buffer is full.  Give up if sending cannot make room.
+            proto_console_flush();
+            if ((count = append(env, data, 1)) == 0)
+            {
+                break;
+            }
+        }
+        data += count;
+        length -= count;
+    }
+}
+
+/**
+ * Queue application output for the GDB console.
+ *
+ * @return Number of bytes queued.
+ */
+unsigned int gdbs_console_write
+(
+    const void      *buffer, ///< Output data.
+    unsigned int     length  ///< Length of the data.
+)
+{
+    return append(core_get_environment(), buffer, length);
+}
+
+/**
+ * Count the console output waiting to be sent to GDB.
+ *
+ * @return Number of bytes waiting.
+ */
+unsigned int proto_console_pending(void)
+{
+    struct environment *env = core_get_environment();
+
+    return env->console_claimed - env->console_sent;
+}
+
+/**
+ * Translate the character following a backslash in a format string.
+ *
+ * @return Translated character.
+ */
+static unsigned char unescape
+(
+    unsigned char c ///< Character following the backslash.
+)
+{
+    switch (c)
+    {
+        case 'a':
+            return '\a';
+        case 'b':
+            return '\b';
+        case 'e':
+            return 0x1B;
+        case 'f':
+            return '\f';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 't':
+            return '\t';
+        case 'v':
+            return '\v';
+        default:
+            return c;
+    }
+}
+
+/**
+ * Queue an integer conversion.
+ */
+static void put_number
+(
+    struct environment  *env,       ///< Stub environment.
+    const struct spec   *spec,      ///< Conversion specification.
+    agent_value_t        value,     ///< Magnitude of the value.
+    unsigned char        sign,      ///< Sign character, or zero for none.
+    unsigned int         base,      ///< Number base.
+    const char          *prefix,    ///< Prefix for the alternate form, or an empty string.
+    int                  upper      ///< Boolean indicating upper case digits.
+)
+{
+    char            digits[sizeof(agent_value_t) * 3];
+    unsigned int    count = 0;
+    unsigned int    prefix_length = 0;
+    unsigned int    total;
+    unsigned int    zeros = 0;
+    unsigned int    digit;
+
+    while (value != 0)
+    {
+        digit = (unsigned int) (value % base);
+        digits[count++] = (char) (digit < 10 ? '0' + digit : (upper ? 'A' : 'a') + digit - 10);
+        value /= base;
+    }
+
+    // Zero is written as a single digit, unless the precision is zero.
+    if (count == 0 && spec->precision != 0)
+    {
+        digits[count++] = '0';
+    }
+
+    while (prefix[prefix_length] != '\0')
+    {
+        ++prefix_length;
+    }
+    if (spec->precision >= 0 && (unsigned int) spec->precision > count)
+    {
+        zeros = (unsigned int) spec->precision - count;
+    }
+    total = (sign != 0) + prefix_length + zeros + count;
+    if ((spec->flags & (SPEC_ZERO | SPEC_LEFT)) == SPEC_ZERO && spec->precision < 0 &&
+        spec->width > total)
+    {
+        zeros += spec->width - total;
+        total = spec->width;
+    }
+
+    if (!(spec->flags & SPEC_LEFT) && spec->width > total)
+    {
+        pad(env, ' ', spec->width - total);
+    }
+    if (sign != 0)
+    {
+        put(env, sign);
+    }
+    proto_console_write((const unsigned char *) prefix, prefix_length);
+    pad(env, '0', zeros);
+    while (count > 0)
+    {
+        put(env, (unsigned char) digits[--count]);
+    }
+    if ((spec->flags & SPEC_LEFT) && spec->width > total)
+    {
+        pad(env, ' ', spec->width - total);
+    }
+}
+
+/**
+ * Queue a string conversion, reading the string from target memory.
+ */
+static void put_string
+(
+    struct environment  *env,    ///< Stub environment.
+    const struct spec   *spec,   ///< Conversion specification.
+    gdbs_address_t       address ///< Target address of the string.
+)
+{
+    unsigned char   c;
+    unsigned int    length;
+    unsigned int    limit = STRING_LIMIT;
+    unsigned int    i;
+
+    if (spec->precision >= 0 && (unsigned int) spec->precision < limit)
+    {
+        limit = (unsigned int) spec->precision;
+    }
+
+    // Measure the string first, so that it can be padded.
+    for (length = 0; length < limit; ++length)
+    {
+        if (gdbs_memory_read(env->comm, address + length, &c, 1) < 0 || c == '\0')
+        {
+            break;
+        }
+    }
+
+    if (!(spec->flags & SPEC_LEFT) && spec->width > length)
+    {
+        pad(env, ' ', spec->width - length);
+    }
+    for (i = 0; i < length; ++i)
+    {
+        gdbs_memory_read(env->comm, address + i, &c, 1);
+        put(env, c);
+    }
+    if ((spec->flags & SPEC_LEFT) && spec->width > length)
+    {
+        pad(env, ' ', spec->width - length);
+    }
+}
+
+/**
+ * Format console output for GDB in the style of printf().  The format string is written as it would
+ * appear in C source, so backslash escape sequences are translated.  Integer conversions with the
+ * usual flags, width, precision, and length modifiers are supported, as are '%c', '%s', and '%p'.
+ * Strings are read from target memory.  Floating point conversions are not supported, and are
+ * replaced with a '?'.
+ */
+void proto_console_format
+(
+    const unsigned char *format, ///< Format string.  Need not be NUL-terminated.
+    size_t               length, ///< Length of the format string.
+    const agent_value_t *args,   ///< Arguments, in the order they appear in the format string.
+    unsigned int         count   ///< Number of arguments.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct spec          spec;
+    agent_value_t        value;
+    agent_value_t        mask;
+    unsigned char        c;
+    unsigned char        sign;
+    unsigned int         arg = 0;
+    unsigned int         longs;
+    size_t               i = 0;
+
+    while (i < length)
+    {
+        c = format[i++];
+        if (c == '\\' && i < length)
+        {
+            put(env, unescape(format[i++]));
+            continue;
+        }
+        if (c != '%' || i >= length)
+        {
+            put(env, c);
+            continue;
+        }
+
+        // Flags.
+        spec.flags = 0;
+        for (; i < length; ++i)
+        {
+            c = format[i];
+            if (c == '-')
+            {
+                spec.flags |= SPEC_LEFT;
+            }
+            else if (c == '0')
+            {
+                spec.flags |= SPEC_ZERO;
+            }
+            else if (c == '+')
+            {
+                spec.flags |= SPEC_PLUS;
+            }
+            else if (c == ' ')
+            {
+                spec.flags |= SPEC_SPACE;
+            }
+            else if (c == '#')
+            {
+                spec.flags |= SPEC_ALTERNATE;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // Width and precision.
+        for (spec.width = 0; i < length && format[i] >= '0' && format[i] <= '9'; ++i)
+        {
+            spec.width = spec.width * 10 + (format[i] - '0');
+        }
+        spec.precision = -1;
+        if (i < length && format[i] == '.')
+        {
+            for (spec.precision = 0, ++i; i < length && format[i] >= '0' && format[i] <= '9'; ++i)
+            {
+                spec.precision = spec.precision * 10 + (format[i] - '0');
+            }
+        }
+
+        // Length modifiers select the width of the argument type.
+        spec.bits = sizeof(int) * 8;
+        longs = 0;
+        for (; i < length; ++i)
+        {
+            c = format[i];
+            if (c == 'h')
+            {
+                spec.bits /= 2;
+            }
+            else if (c == 'l')
+            {
+                spec.bits = (longs++ > 0 ? sizeof(long long) : sizeof(long)) * 8;
+            }
+            else if (c == 'j' || c == 'L' || c == 'q')
+            {
+                spec.bits = sizeof(long long) * 8;
+            }
+            else if (c == 'z' || c == 't')
+            {
+                spec.bits = sizeof(size_t) * 8;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (i >= length)
+        {
+            break;
+        }
+
+        c = format[i++];
+        if (c == '%')
+        {
+            put(env, '%');
+            continue;
+        }
+        if (arg >= count)
+        {
+            break;
+        }
+        value = args[arg++];
+
+        if (c == 'p')
+        {
+            spec.bits = sizeof(void *) * 8;
+        }
+        mask = (spec.bits < sizeof(agent_value_t) * 8 ?
+                ((agent_value_t) 1 << spec.bits) - 1 : ~(agent_value_t) 0);
+        value &= mask;
+
+        switch (c)
+        {
+            case 'd':
+            case 'i':
+                sign = (spec.flags & SPEC_PLUS ? '+' : (spec.flags & SPEC_SPACE ? ' ' : 0));
+                if (value & (mask ^ (mask >> 1)))
+                {
+                    sign = '-';
+                    value = ((agent_value_t) 0 - value) & mask;
+                }
+                put_number(env, &spec, value, sign, 10, "", 0);
+                break;
+            case 'u':
+                put_number(env, &spec, value, 0, 10, "", 0);
+                break;
+            case 'o':
+                put_number(env, &spec, value, 0, 8,
+                           (spec.flags & SPEC_ALTERNATE && value != 0 ? "0" : ""), 0);
+                break;
+            case 'x':
+            case 'X':
+                put_number(env, &spec, value, 0, 16,
+                           (spec.flags & SPEC_ALTERNATE && value != 0 ?
+                            (c == 'x' ? "0x" : "0X") : ""), c == 'X');
+                break;
+            case 'p':
+                put_number(env, &spec, value, 0, 16, "0x", 0);
+                break;
+            case 'c':
+                spec.precision = -1;
+                if (!(spec.flags & SPEC_LEFT) && spec.width > 1)
+                {
+                    pad(env, ' ', spec.width - 1);
+                }
+                put(env, (unsigned char) value);
+                if ((spec.flags & SPEC_LEFT) && spec.width > 1)
+                {
+                    pad(env, ' ', spec.width - 1);
+                }
+                break;
+            case 's':
+                put_string(env, &spec, (gdbs_address_t) value);
+                break;
+            default:
+                put(env, '?');
+                break;
+        }
+    }
+}
+
+/**
+ * Send all queued console output to GDB in 'O' packets.
+ *
+ * @retval 0    Output sent, or there was none.
+ * @retval <0   Sending failed and the output has been discarded.  The exact value will be a
+ *              negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_console_flush(void)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    unsigned int             start;
+    unsigned int             end;
+    unsigned int             first;
+    int                      result;
+
+    // Only one context sends at a time.
+    if (!GDBS_ATOMIC_CAS(&env->console_flushing, 0, 1))
+    {
+        return GDBS_ERROR_OK;
+    }
+
+    // Output is left for later while any writer may still be filling its claimed space.  The swap
+    // leaves the count unchanged, but orders the reads of the ring after it.
+    start = env->console_sent;
+    end = env->console_claimed;
+    if (start == end || !GDBS_ATOMIC_CAS(&env->console_writers, 0, 0))
+    {
+        env->console_flushing = 0;
+        return GDBS_ERROR_OK;
+    }
+
+    // Output which wraps around the end of the ring is sent in two parts.
+    first = GDBS_CONSOLE_BUFFER_LENGTH - (start & RING_MASK);
+    if (first > end - start)
+    {
+        first = end - start;
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push(&packet, 'O');
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(&packet, &env->console[start & RING_MASK], first);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(&packet, env->console, end - start - first);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to send console output: %s\n", gdbs_error_to_string(-result));
+    }
+
+    // Release the space to writers once the ring has been read.
+    GDBS_ATOMIC_CAS(&env->console_sent, start, end);
+    env->console_flushing = 0;
+    return result;
+}
@@ -0,0 +1,59 @@
+/**
+ *  @file       console.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Console output to GDB for the GDB protocol.
+ */
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include "gdbsconfig.h"
+
+#include "protocol/agent.h"
+#include "stdc/size.h"
+
+/**
+ * Queue console output for GDB.  Output is sent when the buffer fills up, or when
+ * proto_console_flush() is called.
+ */
+void proto_console_write
+(
+    const unsigned char *data,  ///< Output data.
+    size_t               length ///< Length of the data.
+);
+
+/**
+ * Format console output for GDB in the style of printf().  The format string is written as it would
+ * appear in C source, so backslash escape sequences are translated.  Integer conversions with the
+ * usual flags, width, precision, and length modifiers are supported, as are '%c', '%s', and '%p'.
+ * Strings are read from target memory.  Floating point conversions are not supported, and are
+ * replaced with a '?'.
+ */
+void proto_console_format
+(
+    const unsigned char *format, ///< Format string.  Need not be NUL-terminated.
+    size_t               length, ///< Length of the format string.
+    const agent_value_t *args,   ///< Arguments, in the order they appear in the format string.
+    unsigned int         count   ///< Number of arguments.
+);
+
+/**
+ * Count the console output waiting to be sent to GDB.
+ *
+ * @return Number of bytes waiting.
+ */
+unsigned int proto_console_pending(void);
+
+/**
+ * Send all queued console output to GDB in 'O' packets.
+ *
+ * @retval 0    Output sent, or there was none.
+ * @retval <0   Sending failed and the output has been discarded.  The exact value will be a
+ *              negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_console_flush(void);
+
+#endif /* end CONSOLE_H_ */
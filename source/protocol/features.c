@@ -0,0 +1,134 @@
+/**
+ *  @file       features.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Target description transfers for the GDB protocol.
+ *
+ *  Target descriptions are embedded at build time, minified, and optionally run-length compressed.
+ *  Plain documents are read directly.  Compressed documents are split into blocks of a fixed
+ *  expanded length, with an index of where each block starts in the compressed data, so that a
+ *  window is expanded from the block holding its offset rather than from the start of the document.
+ */
+#include "gdbstub.h"
+
+#include "features.h"
+
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/// Flag marking a run in compressed data.  The rest of the byte holds the run length, less
+/// RUN_MIN, and the repeated byte follows.
+#define RUN_FLAG 0x80
+
+/// Shortest run in compressed data.
+#define RUN_MIN 3
+
+/**
+ * Expand a window of a compressed document.
+ */
+static void expand
+(
+    const struct features_file  *file,   ///< [in]  Document.
+    gdbs_address_t               offset, ///< [in]  Offset within the document of the window.
+    unsigned char               *data,   ///< [out] Window data.
+    size_t                       length  ///< [in]  Length of the window, which lies within the
+                                         ///<       document.
+)
+{
+    const unsigned char *in = &file->data[file->index[offset / file->block_length]];
+    size_t               skip = (size_t) (offset % file->block_length);
+    size_t               count = 0;
+    size_t               run;
+    unsigned char        value;
+
+    while (count < length)
+    {
+        value = *in++;
+        run = 1;
+        if (value & RUN_FLAG)
+        {
+            run = (size_t) (value & ~RUN_FLAG) + RUN_MIN;
+            value = *in++;
+        }
+
+        // Runs before the window within its block are skipped over.
+        if (skip >= run)
+        {
+            skip -= run;
+            continue;
+        }
+        run -= skip;
+        skip = 0;
+        for (; run > 0 && count < length; --run)
+        {
+            data[count++] = value;
+        }
+    }
+}
+
+/**
+ * Determine whether the target has target descriptions to offer GDB.
+ *
+ * @return Boolean indicating that target descriptions are available.
+ */
+int proto_features_available(void)
+{
+    return (features_file_count > 0);
+}
+
+/**
+ * Read a window of a target description document for 'qXfer:features:read'.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND No document is named by the annex.
+ */
+int proto_xfer_features
+(
+    const unsigned char *annex,        ///< [in]  Annex naming the document.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+)
+{
+    const struct features_file  *file = NULL;
+    unsigned int                 i;
+
+    for (i = 0; i < features_file_count; ++i)
+    {
+        if (strlen(features_files[i].name) == annex_length &&
+            memcmp(features_files[i].name, annex, annex_length) == 0)
+        {
+            file = &features_files[i];
+            break;
+        }
+    }
+    if (file == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    if (offset >= file->length)
+    {
+        return 0;
+    }
+    if (length > file->length - offset)
+    {
+        length = (size_t) (file->length - offset);
+    }
+
+    if (file->block_length == 0)
+    {
+        memcpy(data, &file->data[offset], length);
+    }
+    else
+    {
+        expand(file, offset, data, length);
+    }
+    return (int) length;
+}
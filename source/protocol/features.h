@@ -0,0 +1,61 @@
+/**
+ *  @file       features.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Target description transfers for the GDB protocol.
+ */
+#ifndef FEATURES_H_
+#define FEATURES_H_
+
+#include "gdbsdevice.h"
+
+#include "stdc/size.h"
+
+/// Target description document embedded in the stub library.
+struct features_file
+{
+    const char              *name;         ///< Annex under which GDB reads the document, such as
+                                           ///< "target.xml".
+    const unsigned char     *data;         ///< Document data, compressed if block_length is
+                                           ///< nonzero.
+    const unsigned short    *index;        ///< Offset within the compressed data of each block.
+                                           ///< NULL if the data is not compressed.
+    unsigned long            length;       ///< Length of the document, after expansion.
+    unsigned short           block_length; ///< Length of each block after expansion.  Zero if the
+                                           ///< data is not compressed.
+};
+
+/// Target description documents.  This table is generated from XML files at build time by
+/// cmake/EmbedFeatures.cmake, which is given the files in the GDBS_TARGET_DESCRIPTIONS CMake
+/// variable.  When not building with CMake, run the script with "cmake -P" to generate it.
+extern const struct features_file   features_files[];
+
+/// Number of entries in features_files.
+extern const unsigned int           features_file_count;
+
+/**
+ * Determine whether the target has target descriptions to offer GDB.
+ *
+ * @return Boolean indicating that target descriptions are available.
+ */
+int proto_features_available(void);
+
+/**
+ * Read a window of a target description document for 'qXfer:features:read'.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND No document is named by the annex.
+ */
+int proto_xfer_features
+(
+    const unsigned char *annex,        ///< [in]  Annex naming the document.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+);
+
+#endif /* end FEATURES_H_ */
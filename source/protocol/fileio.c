@@ -0,0 +1,270 @@
+/**
+ *  @file       fileio.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      File-I/O host calls for the GDB protocol.
+ *
+ *  A host call enters the stub through gdbs_breakpoint(), and instead of a stop reply the stub
+ *  sends an 'F' request naming the call and its arguments.  Buffers are passed by address: GDB
+ *  reads and writes them with the usual memory commands, before answering with an 'F' reply that
+ *  resumes the target.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "fileio.h"
+
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/response.h"
+#include "protocol/resume.h"
+#include "protocol/stop.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/**
+ * Have GDB carry out a host call, and wait for the result.  The arguments are in env->host_args.
+ *
+ * @return Result of the call, or a negated enum gdbs_host_error value if the call failed.
+ */
+static int host_call
+(
+    struct environment  *env,   ///< Stub environment.
+    const char          *name,  ///< Name of the call.
+    unsigned int         count, ///< Number of arguments.
+    unsigned int         pairs  ///< Bitmap of the arguments which are the length of a
+                                ///< pointer/length pair.
+)
+{
+    env->host_arg_count = count;
+    env->host_arg_pairs = pairs;
+    env->host_result = -GDBS_HOST_EUNKNOWN;
+    env->host_call = name;
+
+    gdbs_breakpoint();
+
+    env->host_call = NULL;
+    env->host_call_pending = 0;
+    return env->host_result;
+}
+
+/**
+ * Claim the host call arguments for the calling context.
+ *
+ * @return Stub environment, or NULL if no host call can be made.
+ */
+static struct environment *claim(void)
+{
+    struct environment *env = core_get_environment();
+
+    // In non-stop mode GDB does not wait on a single stop, and the stub cannot call itself.
+    if (env->non_stop || env->packet_buffer != NULL ||
+        !GDBS_ATOMIC_CAS(&env->host_call_pending, 0, 1))
+    {
+        return NULL;
+    }
+    return env;
+}
+
+/**
+ * Open a file on the host running GDB.
+ *
+ * @return File descriptor, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_open
+(
+    const char      *path,  ///< Path of the file on the host.
+    int              flags, ///< GDBS_HOST_O_\* flags.
+    unsigned int     mode   ///< Permissions for a created file, as the usual octal value.
+)
+{
+    struct environment *env = claim();
+
+    if (env == NULL)
+    {
+        return -GDBS_HOST_EBUSY;
+    }
+
+    // The path length includes its terminator.
+    env->host_args[0] = (gdbs_address_t) path;
+    env->host_args[1] = (gdbs_address_t) strlen(path) + 1;
+    env->host_args[2] = (gdbs_address_t) flags;
+    env->host_args[3] = (gdbs_address_t) mode;
+    return host_call(env, "open", 4, 1u << 1);
+}
+
+/**
+ * Close a file on the host running GDB.
+ *
+ * @return Zero, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_close
+(
+    int fd ///< File descriptor.
+)
+{
+    struct environment *env = claim();
+
+    if (env == NULL)
+    {
+        return -GDBS_HOST_EBUSY;
+    }
+
+    env->host_args[0] = (gdbs_address_t) fd;
+    return host_call(env, "close", 1, 0);
+}
+
+/**
+ * Read from a file on the host running GDB.
+ *
+ * @return Number of bytes read, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_read
+(
+    int              fd,     ///< File descriptor.
+    void            *buffer, ///< Buffer for the data.
+    unsigned int     length  ///< Length of the buffer.
+)
+{
+    struct environment *env = claim();
+
+    if (env == NULL)
+    {
+        return -GDBS_HOST_EBUSY;
+    }
+
+    env->host_args[0] = (gdbs_address_t) fd;
+    env->host_args[1] = (gdbs_address_t) buffer;
+    env->host_args[2] = (gdbs_address_t) length;
+    return host_call(env, "read", 3, 0);
+}
+
+/**
+ * Write to a file on the host running GDB.
+ *
+ * @return Number of bytes written, or a negated enum gdbs_host_error value if the call failed.
+ */
+int gdbs_host_write
+(
+    int              fd,     ///< File descriptor.
+    const void      *buffer, ///< Data to write.
+    unsigned int     length  ///< Length of the data.
+)
+{
+    struct environment *env = claim();
+
+    if (env == NULL)
+    {
+        return -GDBS_HOST_EBUSY;
+    }
+
+    env->host_args[0] = (gdbs_address_t) fd;
+    env->host_args[1] = (gdbs_address_t) buffer;
+    env->host_args[2] = (gdbs_address_t) length;
+    return host_call(env, "write", 3, 0);
+}
+
+/**
+ * Send GDB the 'F' request for the host call which the application is waiting on, in place of a
+ * stop reply.
+ *
+ * @retval 0    Request sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_host_call(void)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    unsigned int             i;
+    int                      result;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push(&packet, 'F');
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) env->host_call,
+                                           strlen(env->host_call));
+    }
+    for (i = 0; i < env->host_arg_count && result == GDBS_ERROR_OK; ++i)
+    {
+        result = packet_writer_push(&packet, (env->host_arg_pairs & (1u << i) ? '/' : ','));
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, env->host_args[i]);
+        }
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'F' reply, which gives the result of a host call.  The target then resumes as it last
+ * did, unless the user interrupted the call, in which case the interrupt is reported as a stop.
+ *
+ * @retval 0            Response sent.
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_host_reply
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    struct environment      *env = core_get_environment();
+    const unsigned char     *token;
+    size_t                   length;
+    gdbs_address_t           code;
+    gdbs_address_t           error = GDBS_HOST_EUNKNOWN;
+    int                      negative;
+    int                      interrupted = 0;
+    int                      result;
+
+    if (env->host_call == NULL)
+    {
+        GDBS_LOG("Host call reply without a call\n");
+        return proto_send_empty();
+    }
+
+    // The return code may be negative, in which case an error number follows.  Either may end the
+    // packet, so a missing delimiter is not an error.
+    result = packet_tokenizer_advance(tokenizer, ',', &token, &length);
+    negative = (length > 0 && token[0] == '-');
+    if ((result != GDBS_ERROR_OK && result != -GDBS_ERROR_NOT_FOUND) ||
+        length <= (size_t) negative ||
+        hex_string_to_unsigned((const char *) &token[negative], length - negative, &code) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    result = packet_tokenizer_advance(tokenizer, ',', &token, &length);
+    if ((result == GDBS_ERROR_OK || result == -GDBS_ERROR_NOT_FOUND) &&
+        (length == 0 || hex_string_to_unsigned((const char *) token, length, &error) < 0))
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) == GDBS_ERROR_OK)
+    {
+        interrupted = (length == 1 && token[0] == 'C');
+    }
+
+    env->host_result = (negative ? -(int) error : (int) code);
+    env->host_call = NULL;
+
+    // An interrupted call returns once GDB resumes the target from the interrupt.
+    if (interrupted)
+    {
+        env->stop.signal = GDBS_SIGNAL_INT;
+        env->stop.reason = GDBS_STOP_SIGNAL;
+        return proto_send_stop_reply();
+    }
+    return proto_resume(env->stepping);
+}
@@ -0,0 +1,40 @@
+/**
+ *  @file       fileio.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      File-I/O host calls for the GDB protocol.
+ */
+#ifndef FILEIO_H_
+#define FILEIO_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Send GDB the 'F' request for the host call which the application is waiting on, in place of a
+ * stop reply.
+ *
+ * @retval 0    Request sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_host_call(void);
+
+/**
+ * Handle the 'F' reply, which gives the result of a host call.  The target then resumes as it last
+ * did, unless the user interrupted the call, in which case the interrupt is reported as a stop.
+ *
+ * @retval 0            Response sent.
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_host_reply
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+#endif /* end FILEIO_H_ */
@@ -0,0 +1,439 @@
+/**
+ *  @file       flash.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Memory map and flash programming commands for the GDB protocol.
+ *
+ *  The memory map is supplied by gdbs_get_memory_map(), and generated one element at a time as
+ *  GDB reads it.  Flash writes are collected into page buffers, so that GDB's unaligned writes
+ *  program each page once.  There are two page buffers: while one is being programmed, the next
+ *  page is received into the other, and programming is only waited for when that buffer is needed
+ *  again.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "flash.h"
+
+#include "auxiliary/binary.h"
+#include "core.h"
+#include "protocol/response.h"
+#include "stdc/assert.h"
+#include "stdc/memcpy.h"
+#include "stdc/memset.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/// Longest element of the memory map document.
+#define ELEMENT_LENGTH 192
+
+/// Start of the memory map document.
+#define DOCUMENT_HEADER                                                                            \
+    "<?xml version=\"1.0\"?>\n"                                                                    \
+    "<!DOCTYPE memory-map PUBLIC \"+//IDN gnu.org//DTD GDB Memory Map V1.0//EN\""                  \
+    " \"http://sourceware.org/gdb/gdb-memory-map.dtd\">\n<memory-map>\n"
+
+/// End of the memory map document.
+#define DOCUMENT_FOOTER "</memory-map>\n"
+
+/// Value of erased flash, which leaves bytes that GDB did not write unprogrammed.
+#define ERASED_VALUE 0xFF
+
+/**
+ * Append text to a memory map element.
+ */
+static void append
+(
+    char        *element, ///< [in,out] Element text.
+    size_t      *used,    ///< [in,out] Length of the element text.
+    const char  *text,    ///< [in]     Text to append.
+    size_t       length   ///< [in]     Length of the text.
+)
+{
+    assert(*used + length <= ELEMENT_LENGTH);
+
+    memcpy(&element[*used], text, length);
+    *used += length;
+}
+
+/**
+ * Append a number to a memory map element, in hexadecimal with a leading "0x".
+ */
+static void append_hex
+(
+    char            *element, ///< [in,out] Element text.
+    size_t          *used,    ///< [in,out] Length of the element text.
+    gdbs_address_t   value    ///< [in]     Number to append.
+)
+{
+    char            digits[sizeof(gdbs_address_t) * 2];
+    unsigned int    i = sizeof(digits);
+
+    do
+    {
+        digits[--i] = "0123456789abcdef"[value % 16];
+        value /= 16;
+    } while (value != 0);
+    append(element, used, "0x", 2);
+    append(element, used, &digits[i], sizeof(digits) - i);
+}
+
+/**
+ * Generate an element of the memory map document.  The first element is the document header,
+ * followed by an element for each region, and then the document footer.
+ *
+ * @return Length of the element, or zero beyond the end of the document.
+ */
+static size_t generate_element
+(
+    const struct gdbs_memory_region *regions,  ///< [in]  Region table.
+    unsigned int                     count,    ///< [in]  Number of entries in the region table.
+    unsigned int                     position, ///< [in]  Position of the element.
+    char                            *element   ///< [out] Element text, of up to ELEMENT_LENGTH
+                                               ///<       characters.
+)
+{
+    static const char *const types[] = { "ram", "rom", "flash" };
+    const struct gdbs_memory_region *region;
+    size_t                           used = 0;
+
+    if (position == 0)
+    {
+        append(element, &used, DOCUMENT_HEADER, sizeof(DOCUMENT_HEADER) - 1);
+        return used;
+    }
+    if (position > count + 1)
+    {
+        return 0;
+    }
+    if (position == count + 1)
+    {
+        append(element, &used, DOCUMENT_FOOTER, sizeof(DOCUMENT_FOOTER) - 1);
+        return used;
+    }
+
+    region = &regions[position - 1];
+    append(element, &used, "<memory type=\"", 14);
+    append(element, &used, types[region->type], strlen(types[region->type]));
+    append(element, &used, "\" start=\"", 9);
+    append_hex(element, &used, region->start);
+    append(element, &used, "\" length=\"", 10);
+    append_hex(element, &used, region->length);
+    if (region->type != GDBS_MEMORY_FLASH)
+    {
+        append(element, &used, "\"/>\n", 4);
+        return used;
+    }
+    append(element, &used, "\">\n<property name=\"blocksize\">", 30);
+    append_hex(element, &used, region->block_size);
+    append(element, &used, "</property>\n</memory>\n", 22);
+    return used;
+}
+
+/**
+ * Determine whether the target has a memory map to offer GDB.
+ *
+ * @return Boolean indicating that the memory map is available.
+ */
+int proto_memory_map_available(void)
+{
+    unsigned int count;
+
+    gdbs_get_memory_map(&count);
+    return (count > 0);
+}
+
+/**
+ * Determine whether a range of target memory may hold code, so that writing it calls for an
+ * instruction cache flush.  Only ranges within a region marked as never holding code are excluded;
+ * without a memory map, any memory may hold code.
+ *
+ * @return Boolean indicating that the range may hold code.
+ */
+int proto_memory_executable
+(
+    gdbs_address_t   address, ///< First address of the range.
+    gdbs_address_t   length   ///< Length of the range.
+)
+{
+    const struct gdbs_memory_region *regions;
+    unsigned int                     count;
+    unsigned int                     i;
+
+    regions = gdbs_get_memory_map(&count);
+    for (i = 0; i < count; ++i)
+    {
+        if (regions[i].no_execute && address >= regions[i].start &&
+            address - regions[i].start + length <= regions[i].length)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Read a window of the memory map document for 'qXfer:memory-map:read'.  The map is short, so
+ * each read generates the document afresh from the start.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given, or there is no memory map.
+ */
+int proto_xfer_memory_map
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+)
+{
+    const struct gdbs_memory_region *regions;
+    unsigned int                     count;
+    unsigned int                     position;
+    char                             element[ELEMENT_LENGTH];
+    size_t                           element_length;
+    gdbs_address_t                   start = 0;
+    size_t                           copied = 0;
+    size_t                           skip;
+    size_t                           n;
+
+    (void) annex;
+    regions = gdbs_get_memory_map(&count);
+    if (annex_length != 0 || count == 0)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    for (position = 0; copied < length; ++position)
+    {
+        element_length = generate_element(regions, count, position, element);
+        if (element_length == 0)
+        {
+            break;
+        }
+
+        // Elements wholly before the window are skipped.
+        if (offset + copied < start + element_length)
+        {
+            skip = (size_t) (offset + copied - start);
+            n = element_length - skip;
+            if (n > length - copied)
+            {
+                n = length - copied;
+            }
+            memcpy(&data[copied], &element[skip], n);
+            copied += n;
+        }
+        start += element_length;
+    }
+    return (int) copied;
+}
+
+/**
+ * Wait for the page buffer that is not collecting writes to finish being programmed.
+ *
+ * @retval 0    The page buffer is free.
+ * @retval <0   Programming failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int wait_program
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    int result;
+
+    if (!env->flash_programming)
+    {
+        return GDBS_ERROR_OK;
+    }
+    env->flash_programming = 0;
+    result = gdbs_flash_wait();
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to program flash: %s\n", gdbs_error_to_string(-result));
+    }
+    return result;
+}
+
+/**
+ * Start programming the page collected so far, if any, and switch to the other page buffer for
+ * further writes.
+ *
+ * @retval 0    Programming started, or there was no page to program.
+ * @retval <0   Programming failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int program_page
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    int result;
+
+    if (!env->flash_page_open)
+    {
+        return GDBS_ERROR_OK;
+    }
+
+    // The other buffer is collected into next, so its own programming has to be complete.
+    result = wait_program(env);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    env->flash_page_open = 0;
+    result = gdbs_flash_program(env->flash_page_address, env->flash_pages[env->flash_page],
+                                GDBS_FLASH_PAGE_LENGTH);
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to program flash page at 0x%lx: %s\n",
+                 (unsigned long) env->flash_page_address, gdbs_error_to_string(-result));
+        return result;
+    }
+    env->flash_programming = 1;
+    env->flash_page ^= 1;
+    env->icache_dirty = 1;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Handle the 'vFlashErase' command, which erases a range of flash.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_erase
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       address;
+    gdbs_address_t       length;
+    int                  result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Pending writes are programmed first, in case they lie within the range.
+    result = program_page(env);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = wait_program(env);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = gdbs_flash_erase(address, length);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to erase %lu bytes of flash at 0x%lx: %s\n",
+                     (unsigned long) length, (unsigned long) address,
+                     gdbs_error_to_string(-result));
+        }
+    }
+    if (result < 0)
+    {
+        return result;
+    }
+
+    env->icache_dirty = 1;
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'vFlashWrite' command, which writes binary data to flash.  The data is collected into
+ * page buffers, and each page is programmed once the writes have moved on to another page.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_write
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       address;
+    gdbs_address_t       page;
+    const unsigned char *token;
+    size_t               length;
+    size_t               i;
+    unsigned char        byte;
+    int                  result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ':', &address) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) == -GDBS_ERROR_EOB)
+    {
+        length = 0;
+    }
+
+    for (i = 0; i < length; ++i, ++address)
+    {
+        byte = token[i];
+        if (byte == BINARY_ESCAPE_CHAR)
+        {
+            if (++i == length)
+            {
+                return -GDBS_ERROR_INVALID;
+            }
+            byte = binary_decode((char) token[i]);
+        }
+
+        // Moving on to another page programs the one collected so far.
+        page = address & ~(gdbs_address_t) (GDBS_FLASH_PAGE_LENGTH - 1);
+        if (!env->flash_page_open || page != env->flash_page_address)
+        {
+            result = program_page(env);
+            if (result < 0)
+            {
+                return result;
+            }
+            memset(env->flash_pages[env->flash_page], ERASED_VALUE, GDBS_FLASH_PAGE_LENGTH);
+            env->flash_page_address = page;
+            env->flash_page_open = 1;
+        }
+        env->flash_pages[env->flash_page][address - page] = byte;
+    }
+
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'vFlashDone' command, which programs any remaining page and waits for programming to
+ * complete.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_done
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    int                  result;
+
+    (void) tokenizer;
+    result = program_page(env);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = wait_program(env);
+    }
+    return (result < 0 ? result : proto_send_ok());
+}
@@ -0,0 +1,90 @@
+/**
+ *  @file       flash.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Memory map and flash programming commands for the GDB protocol.
+ */
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Determine whether the target has a memory map to offer GDB.
+ *
+ * @return Boolean indicating that the memory map is available.
+ */
+int proto_memory_map_available(void);
+
+/**
+ * Determine whether a range of target memory may hold code, so that writing it calls for an
+ * instruction cache flush.  Only ranges within a region marked as never holding code are excluded;
+ * without a memory map, any memory may hold code.
+ *
+ * @return Boolean indicating that the range may hold code.
+ */
+int proto_memory_executable
+(
+    gdbs_address_t   address, ///< First address of the range.
+    gdbs_address_t   length   ///< Length of the range.
+);
+
+/**
+ * Read a window of the memory map document for 'qXfer:memory-map:read'.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given, or there is no memory map.
+ */
+int proto_xfer_memory_map
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+);
+
+/**
+ * Handle the 'vFlashErase' command, which erases a range of flash.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_erase
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'vFlashWrite' command, which writes binary data to flash.  The data is collected into
+ * page buffers, and each page is programmed once the writes have moved on to another page.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_write
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'vFlashDone' command, which programs any remaining page and waits for programming to
+ * complete.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_flash_done
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+#endif /* end FLASH_H_ */
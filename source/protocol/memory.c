@@ -0,0 +1,737 @@
+/**
+ *  @file       memory.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Memory access commands for the GDB protocol.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "memory.h"
+
+#include "auxiliary/binary.h"
+#include "auxiliary/crc.h"
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/breakpoint.h"
+#include "protocol/flash.h"
+#include "protocol/response.h"
+#include "protocol/trace.h"
+#include "stdc/assert.h"
+#include "stdc/memchr.h"
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/null.h"
+
+/// Largest number of bytes returned by a single read.  Read data is staged in the back half of the
+/// packet buffer, so that the hex encoded response always fits within the advertised packet size and
+/// the command itself is left intact.
+#define READ_LIMIT (GDBS_PACKET_BUFFER_LENGTH / 2)
+
+/// Size of the chunks in which write data is decoded.  Must be a multiple of the widest memory access
+/// size, so that chunk boundaries never split an aligned word.
+#define WRITE_CHUNK_LENGTH 64
+
+/// Largest shift held by the search skip table.  Shifts are clamped so that the table fits in
+/// bytes, since shifting less than the full pattern length never skips over a match.
+#define SEARCH_SKIP_LIMIT 255
+
+/**
+ * Build the skip table for a Boyer-Moore-Horspool search.  Each entry holds how far the search
+ * window may shift when the byte under its last position is that entry's byte.
+ */
+static void search_init
+(
+    const unsigned char *pattern,        ///< [in]  Pattern to search for.
+    size_t               pattern_length, ///< [in]  Length of the pattern.  Must be at least 2.
+    unsigned char       *skip            ///< [out] Skip table of 256 entries.
+)
+{
+    size_t i;
+
+    for (i = 0; i < 256; ++i)
+    {
+        skip[i] = (unsigned char) (pattern_length < SEARCH_SKIP_LIMIT ?
+                                   pattern_length : SEARCH_SKIP_LIMIT);
+    }
+    for (i = 0; i < pattern_length - 1; ++i)
+    {
+        skip[pattern[i]] = (unsigned char) (pattern_length - 1 - i < SEARCH_SKIP_LIMIT ?
+                                            pattern_length - 1 - i : SEARCH_SKIP_LIMIT);
+    }
+}
+
+/**
+ * Search a buffer for the first occurrence of a pattern.  Single byte patterns are located with
+ * memchr(), while longer patterns use a Boyer-Moore-Horspool search.
+ *
+ * @return Offset of the first match, or the buffer length if the pattern does not occur.
+ */
+static size_t search_buffer
+(
+    const unsigned char *data,           ///< Buffer to search.
+    size_t               length,         ///< Length of the buffer.
+    const unsigned char *pattern,        ///< Pattern to search for.
+    size_t               pattern_length, ///< Length of the pattern.
+    const unsigned char *skip            ///< Skip table from search_init().  Unused for single byte
+                                         ///< patterns.
+)
+{
+    const unsigned char *match;
+    size_t               i;
+
+    if (pattern_length == 1)
+    {
+        match = (const unsigned char *) memchr(data, pattern[0], length);
+        return (match != NULL ? (size_t) (match - data) : length);
+    }
+
+    for (i = 0; length >= pattern_length && i <= length - pattern_length;
+         i += skip[data[i + pattern_length - 1]])
+    {
+        if (data[i + pattern_length - 1] == pattern[pattern_length - 1] &&
+            memcmp(&data[i], pattern, pattern_length - 1) == 0)
+        {
+            return i;
+        }
+    }
+    return length;
+}
+
+/**
+ * Write target memory straight away, noting whether code may have changed.
+ *
+ * @retval 0    Memory written.
+ * @retval <0   Writing failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int write_through
+(
+    struct environment      *env,     ///< Stub environment.
+    gdbs_address_t           address, ///< Address to write to.
+    const unsigned char     *data,    ///< Data to write.
+    gdbs_address_t           length   ///< Number of bytes to write.
+)
+{
+    int result;
+
+    result = gdbs_memory_write(env->comm, address, data, length);
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to write %lu bytes at 0x%lx: %s\n",
+                 (unsigned long) length, (unsigned long) address, gdbs_error_to_string(-result));
+        return result;
+    }
+    if (proto_memory_executable(address, length))
+    {
+        env->icache_dirty = 1;
+    }
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Determine whether a range of memory overlaps any of the first pending writes.
+ *
+ * @return Boolean indicating an overlap.
+ */
+static int overlaps_pending
+(
+    const struct environment    *env,     ///< Stub environment.
+    gdbs_address_t               address, ///< First address of the range.
+    gdbs_address_t               length,  ///< Length of the range.
+    unsigned int                 count    ///< Number of pending writes to check.
+)
+{
+    const struct pending_write  *pending;
+    unsigned int                 i;
+
+    for (i = 0; i < count; ++i)
+    {
+        pending = &env->pending_writes[i];
+        if (address < pending->address + pending->length && pending->address < address + length)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Hold back a memory write until the target resumes.  A write within a range already held back
+ * replaces its data, and a write continuing the most recent range extends it.  Other writes which
+ * overlap a held range, or which do not fit, commit the held writes first.  While the target runs
+ * in non-stop mode, there is no resume to wait for, so the write is made straight away.
+ *
+ * @retval 0    Write held back, or made.
+ * @retval <0   Writing failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int stage_write
+(
+    struct environment      *env,     ///< Stub environment.
+    gdbs_address_t           address, ///< Address to write to.
+    const unsigned char     *data,    ///< Data to write.
+    gdbs_address_t           length   ///< Number of bytes to write.
+)
+{
+    struct pending_write    *pending;
+    unsigned int             i;
+    int                      result;
+
+    if (env->non_stop && env->running)
+    {
+        return write_through(env, address, data, length);
+    }
+
+    for (i = 0; i < env->pending_write_count; ++i)
+    {
+        pending = &env->pending_writes[i];
+        if (address >= pending->address && address - pending->address + length <= pending->length)
+        {
+            memcpy(&env->pending_data[pending->offset + (address - pending->address)], data,
+                   (size_t) length);
+            return GDBS_ERROR_OK;
+        }
+    }
+
+    // The most recent range ends the pool, so it can grow as long as it keeps clear of the others.
+    if (env->pending_write_count > 0)
+    {
+        pending = &env->pending_writes[env->pending_write_count - 1];
+        if (address == pending->address + pending->length &&
+            length <= GDBS_WRITE_COMBINE_LENGTH - env->pending_data_used &&
+            !overlaps_pending(env, address, length, env->pending_write_count - 1))
+        {
+            memcpy(&env->pending_data[env->pending_data_used], data, (size_t) length);
+            env->pending_data_used += (unsigned int) length;
+            pending->length += (unsigned int) length;
+            return GDBS_ERROR_OK;
+        }
+    }
+
+    result = proto_sync_writes(address, length);
+    if (result == GDBS_ERROR_OK &&
+        (env->pending_write_count == GDBS_WRITE_COMBINE_COUNT ||
+         length > GDBS_WRITE_COMBINE_LENGTH - env->pending_data_used))
+    {
+        result = proto_commit_writes();
+    }
+    if (result < 0)
+    {
+        return result;
+    }
+    if (length > GDBS_WRITE_COMBINE_LENGTH)
+    {
+        return write_through(env, address, data, length);
+    }
+
+    pending = &env->pending_writes[env->pending_write_count++];
+    pending->address = address;
+    pending->length = (unsigned int) length;
+    pending->offset = env->pending_data_used;
+    memcpy(&env->pending_data[env->pending_data_used], data, (size_t) length);
+    env->pending_data_used += (unsigned int) length;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Make the memory writes held back by 'M' commands, in the order they were made.  Every write is
+ * attempted, even after one fails.  The instruction cache is marked for flushing if any write may
+ * have modified code.
+ *
+ * @retval 0    Memory written, or nothing was held back.
+ * @retval <0   A write failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong with the first failure.
+ */
+int proto_commit_writes(void)
+{
+    struct environment          *env = core_get_environment();
+    const struct pending_write  *pending;
+    unsigned int                 i;
+    int                          result = GDBS_ERROR_OK;
+    int                          status;
+
+    for (i = 0; i < env->pending_write_count; ++i)
+    {
+        pending = &env->pending_writes[i];
+        status = write_through(env, pending->address, &env->pending_data[pending->offset],
+                               pending->length);
+        if (status < 0 && result == GDBS_ERROR_OK)
+        {
+            result = status;
+        }
+    }
+    env->pending_write_count = 0;
+    env->pending_data_used = 0;
+    return result;
+}
+
+/**
+ * Make the memory writes held back by 'M' commands if any of them overlap a range about to be
+ * read, so that the read observes them.
+ *
+ * @retval 0    No held writes overlap, or they were made.
+ * @retval <0   A write failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_sync_writes
+(
+    gdbs_address_t   address, ///< First address to be read.
+    gdbs_address_t   length   ///< Number of bytes to be read.
+)
+{
+    struct environment *env = core_get_environment();
+
+    if (!overlaps_pending(env, address, length, env->pending_write_count))
+    {
+        return GDBS_ERROR_OK;
+    }
+    return proto_commit_writes();
+}
+
+/**
+ * Handle the 'm' command, which reads target memory.  The tokenizer must be positioned just after
+ * the command character.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    gdbs_address_t           address;
+    gdbs_address_t           length;
+    unsigned char           *data;
+    int                      result;
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+
+    assert(env->packet_buffer != NULL);
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // GDB accepts a short read, so clamp oversized requests rather than failing them.
+    if (length > READ_LIMIT)
+    {
+        length = READ_LIMIT;
+    }
+
+    // Complete the whole read before sending anything, so that a fault can still be reported.
+    data = &env->packet_buffer[GDBS_PACKET_BUFFER_LENGTH - READ_LIMIT];
+    if (env->trace_selected)
+    {
+        // Memory is read from the selected trace frame instead, which may hold less than asked.
+        result = proto_trace_read_memory(address, data, length);
+        if (result < 0)
+        {
+            return result;
+        }
+        length = (gdbs_address_t) result;
+    }
+    else
+    {
+        result = proto_sync_writes(address, length);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = gdbs_memory_read(env->comm, address, data, length);
+        }
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to read %lu bytes at 0x%lx: %s\n",
+                     (unsigned long) length, (unsigned long) address,
+                     gdbs_error_to_string(-result));
+            return result;
+        }
+        proto_breakpoint_filter_read(address, data, length);
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_hex(&packet, data, (size_t) length);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'M' command, which writes target memory.  The tokenizer must be positioned just after
+ * the command character.  Writes are held back until the target resumes, or until GDB reads the
+ * memory, so a failed write may only be reported then.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    gdbs_address_t           address;
+    gdbs_address_t           length;
+    gdbs_address_t           chunk;
+    unsigned char            data[WRITE_CHUNK_LENGTH];
+    const unsigned char     *token;
+    size_t                   token_length;
+    int                      result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, ':', &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    result = packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &token_length);
+    if (result == -GDBS_ERROR_EOB)
+    {
+        token_length = 0;
+    }
+    if (token_length != length * 2)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Decode in chunks, leaving the command intact.  The first chunk is shortened so that every
+    // following chunk begins on an aligned address.
+    chunk = WRITE_CHUNK_LENGTH - (address % WRITE_CHUNK_LENGTH);
+    while (length > 0)
+    {
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        result = hex_string_to_bytes((const char *) token, (size_t) chunk * 2, data);
+        if (result == GDBS_ERROR_OK)
+        {
+            proto_breakpoint_filter_write(address, data, chunk);
+            result = stage_write(core_get_environment(), address, data, chunk);
+        }
+        if (result < 0)
+        {
+            return result;
+        }
+
+        token += chunk * 2;
+        address += chunk;
+        length -= chunk;
+        chunk = WRITE_CHUNK_LENGTH;
+    }
+
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'X' command, which writes target memory with binary data, avoiding the doubling of
+ * hexadecimal encoding.  The tokenizer must be positioned just after the command character.  Writes
+ * are held back as for 'M'.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_memory_binary
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    gdbs_address_t           address;
+    gdbs_address_t           length;
+    gdbs_address_t           chunk;
+    gdbs_address_t           n;
+    unsigned char            data[WRITE_CHUNK_LENGTH];
+    unsigned char            byte;
+    const unsigned char     *token;
+    size_t                   token_length;
+    size_t                   i = 0;
+    int                      result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, ':', &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    result = packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &token_length);
+    if (result == -GDBS_ERROR_EOB)
+    {
+        token_length = 0;
+    }
+
+    // The escaped data only shows its length once decoded, so check it before anything is staged.
+    for (n = 0; i < token_length; ++n)
+    {
+        i += (token[i] == BINARY_ESCAPE_CHAR ? 2 : 1);
+    }
+    if (i != token_length || n != length)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Decode in aligned chunks, as for 'M'.
+    i = 0;
+    chunk = WRITE_CHUNK_LENGTH - (address % WRITE_CHUNK_LENGTH);
+    while (length > 0)
+    {
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        for (n = 0; n < chunk; ++n)
+        {
+            byte = token[i++];
+            if (byte == BINARY_ESCAPE_CHAR)
+            {
+                byte = binary_decode((char) token[i++]);
+            }
+            data[n] = byte;
+        }
+
+        proto_breakpoint_filter_write(address, data, chunk);
+        result = stage_write(core_get_environment(), address, data, chunk);
+        if (result < 0)
+        {
+            return result;
+        }
+
+        address += chunk;
+        length -= chunk;
+        chunk = WRITE_CHUNK_LENGTH;
+    }
+
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'qCRC' query, which calculates the CRC of a block of target memory, so that GDB can
+ * verify loaded sections without reading them back.  The tokenizer must be positioned just after
+ * the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_memory_crc
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    gdbs_address_t           address;
+    gdbs_address_t           length;
+    gdbs_address_t           chunk;
+    unsigned long            crc = CRC_INITIAL;
+    unsigned char            digest[4];
+    int                      result;
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+
+    assert(env->packet_buffer != NULL);
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    result = proto_sync_writes(address, length);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    // The arguments have been parsed, so the whole packet buffer is free to stage the memory in.
+    while (length > 0)
+    {
+        chunk = length < GDBS_PACKET_BUFFER_LENGTH ? length : GDBS_PACKET_BUFFER_LENGTH;
+        result = gdbs_memory_read(env->comm, address, env->packet_buffer, chunk);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to read %lu bytes at 0x%lx: %s\n",
+                     (unsigned long) chunk, (unsigned long) address, gdbs_error_to_string(-result));
+            return result;
+        }
+        proto_breakpoint_filter_read(address, env->packet_buffer, chunk);
+        crc = crc_update(crc, env->packet_buffer, (size_t) chunk);
+
+        address += chunk;
+        length -= chunk;
+    }
+
+    // Encode the CRC most significant byte first, as the address type may be narrower than it.
+    digest[0] = (unsigned char) (crc >> 24);
+    digest[1] = (unsigned char) (crc >> 16);
+    digest[2] = (unsigned char) (crc >> 8);
+    digest[3] = (unsigned char) crc;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_buffer(&packet, (const unsigned char *) "C", 1);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(&packet, digest, sizeof(digest));
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qSearch:memory' query, which searches a block of target memory for a byte pattern.
+ * The tokenizer must be positioned just after the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_search_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    gdbs_address_t           address;
+    gdbs_address_t           length;
+    gdbs_address_t           base;
+    gdbs_address_t           chunk;
+    const unsigned char     *token;
+    size_t                   token_length;
+    unsigned char           *pattern;
+    size_t                   pattern_length;
+    unsigned char           *window;
+    size_t                   capacity;
+    size_t                   filled;
+    size_t                   offset;
+    size_t                   i;
+    unsigned char            skip[256];
+    int                      result;
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+
+    assert(env->packet_buffer != NULL);
+
+    if (packet_tokenizer_advance(tokenizer, ':', &token, &token_length) != GDBS_ERROR_OK ||
+        token_length != 6 || memcmp(token, "memory", 6) != 0)
+    {
+        return proto_send_empty();
+    }
+    if (packet_tokenizer_advance_unsigned(tokenizer, ';', &address) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, ';', &length) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &token_length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Decode the pattern to the front of the packet buffer.  Decoding never writes ahead of the
+    // encoded data, so it can safely be done in place.
+    pattern = env->packet_buffer;
+    for (pattern_length = 0, i = 0; i < token_length; ++i, ++pattern_length)
+    {
+        if (token[i] == BINARY_ESCAPE_CHAR)
+        {
+            if (++i == token_length)
+            {
+                return -GDBS_ERROR_INVALID;
+            }
+            pattern[pattern_length] = binary_decode((char) token[i]);
+        }
+        else
+        {
+            pattern[pattern_length] = token[i];
+        }
+    }
+    if (pattern_length == 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Target memory is staged in the rest of the buffer, which must hold at least a full pattern so
+    // that every window makes progress.
+    window = &pattern[pattern_length];
+    capacity = GDBS_PACKET_BUFFER_LENGTH - pattern_length;
+    if (capacity < pattern_length)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+    if (pattern_length > 1)
+    {
+        search_init(pattern, pattern_length, skip);
+    }
+
+    result = proto_sync_writes(address, length);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    // Slide the window through the block, carrying over the bytes which could still begin a match.
+    base = address;
+    filled = 0;
+    while (length > 0)
+    {
+        chunk = (gdbs_address_t) (capacity - filled);
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        result = gdbs_memory_read(env->comm, address, &window[filled], chunk);
+        if (result < 0)
+        {
+            GDBS_LOG("Failed to read %lu bytes at 0x%lx: %s\n",
+                     (unsigned long) chunk, (unsigned long) address, gdbs_error_to_string(-result));
+            return result;
+        }
+        proto_breakpoint_filter_read(address, &window[filled], chunk);
+        address += chunk;
+        length -= chunk;
+        filled += (size_t) chunk;
+
+        offset = search_buffer(window, filled, pattern, pattern_length, skip);
+        if (offset < filled)
+        {
+            packet_writer_init(&packet, PT_MESSAGE, env->comm);
+            result = packet_writer_push_buffer(&packet, (const unsigned char *) "1,", 2);
+            if (result == GDBS_ERROR_OK)
+            {
+                result = packet_writer_push_unsigned(&packet, base + (gdbs_address_t) offset);
+            }
+            if (result == GDBS_ERROR_OK)
+            {
+                result = packet_writer_finish(&packet);
+            }
+            return result;
+        }
+
+        // The regions may overlap, but the copy always moves data towards the front.
+        if (filled >= pattern_length)
+        {
+            offset = filled - (pattern_length - 1);
+            for (i = 0; i < pattern_length - 1; ++i)
+            {
+                window[i] = window[offset + i];
+            }
+            base += (gdbs_address_t) offset;
+            filled = pattern_length - 1;
+        }
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_buffer(&packet, (const unsigned char *) "0", 1);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
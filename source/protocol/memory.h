@@ -0,0 +1,108 @@
+/**
+ *  @file       memory.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Memory access commands for the GDB protocol.
+ */
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Make the memory writes held back by 'M' commands, in the order they were made.  Every write is
+ * attempted, even after one fails.  The instruction cache is marked for flushing if any write may
+ * have modified code.
+ *
+ * @retval 0    Memory written, or nothing was held back.
+ * @retval <0   A write failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong with the first failure.
+ */
+int proto_commit_writes(void);
+
+/**
+ * Make the memory writes held back by 'M' commands if any of them overlap a range about to be
+ * read, so that the read observes them.
+ *
+ * @retval 0    No held writes overlap, or they were made.
+ * @retval <0   A write failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_sync_writes
+(
+    gdbs_address_t   address, ///< First address to be read.
+    gdbs_address_t   length   ///< Number of bytes to be read.
+);
+
+/**
+ * Handle the 'm' command, which reads target memory.  The tokenizer must be positioned just after
+ * the command character.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'M' command, which writes target memory.  The tokenizer must be positioned just after
+ * the command character.  Writes are held back until the target resumes, or until GDB reads the
+ * memory, so a failed write may only be reported then.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'X' command, which writes target memory with binary data, avoiding the doubling of
+ * hexadecimal encoding.  The tokenizer must be positioned just after the command character.  Writes
+ * are held back as for 'M'.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_memory_binary
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'qCRC' query, which calculates the CRC of a block of target memory, so that GDB can
+ * verify loaded sections without reading them back.  The tokenizer must be positioned just after
+ * the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_memory_crc
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qSearch:memory' query, which searches a block of target memory for a byte pattern.
+ * The tokenizer must be positioned just after the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_search_memory
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+#endif /* end MEMORY_H_ */
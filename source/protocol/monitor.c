@@ -0,0 +1,553 @@
+/**
+ *  @file       monitor.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Monitor commands for the GDB protocol.
+ *
+ *  GDB's "monitor" command passes its command line to the stub, which runs the built-in command or
+ *  target command named by its first word.  Output is streamed back to GDB in 'O' packets as it is
+ *  produced, before the final reply, so no command needs to buffer its output.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "monitor.h"
+
+#include "auxiliary/hex.h"
+#include "auxiliary/stats.h"
+#include "core.h"
+#include "protocol/console.h"
+#include "protocol/response.h"
+#include "stdc/memcmp.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/// Width of the label column in the output of built-in commands.
+#define LABEL_WIDTH 24
+
+/// Longest line of output from a built-in command.
+#define LINE_LENGTH 128
+
+/// Send a string literal as output.
+#define WRITE_TEXT(s) gdbs_monitor_write((s), sizeof(s) - 1)
+
+/// Line of output from a built-in command, which is sent once it is complete.
+struct line
+{
+    char            text[LINE_LENGTH]; ///< Text of the line.
+    unsigned int    length;            ///< Length of the text.
+};
+
+/**
+ * Append text to a line of output, as far as it fits.
+ */
+static void append
+(
+    struct line *line, ///< Line of output.
+    const char  *text  ///< NUL-terminated text.
+)
+{
+    while (*text != '\0' && line->length < LINE_LENGTH)
+    {
+        line->text[line->length++] = *text++;
+    }
+}
+
+/**
+ * Append an unsigned value in decimal to a line of output, as far as it fits.
+ */
+static void append_decimal
+(
+    struct line     *line, ///< Line of output.
+    unsigned long    value ///< Value to append.
+)
+{
+    char            digits[24];
+    unsigned int    count = 0;
+
+    do
+    {
+        digits[count++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0 && line->length < LINE_LENGTH)
+    {
+        line->text[line->length++] = digits[--count];
+    }
+}
+
+/**
+ * Pad a line of output with spaces up to the end of the label column.
+ */
+static void pad_label
+(
+    struct line *line ///< Line of output.
+)
+{
+    while (line->length < LABEL_WIDTH)
+    {
+        line->text[line->length++] = ' ';
+    }
+}
+
+/**
+ * Send a line reporting how much of a resource is in use.
+ *
+ * @retval 0    Output sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int report
+(
+    const char      *label, ///< Name of the resource.
+    unsigned long    used,  ///< Amount in use.
+    unsigned long    total  ///< Amount available.
+)
+{
+    struct line line;
+
+    line.length = 0;
+    append(&line, label);
+    pad_label(&line);
+    append_decimal(&line, used);
+    append(&line, " / ");
+    append_decimal(&line, total);
+    append(&line, "\n");
+    return gdbs_monitor_write(line.text, line.length);
+}
+
+/**
+ * Count the comparator units which are in use.
+ *
+ * @return Number of units in use.
+ */
+static unsigned int count_comparators
+(
+    const struct comparator *units, ///< Comparator allocation records.
+    unsigned int             count  ///< Number of units available.
+)
+{
+    unsigned int used = 0;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        used += (units[i].used != 0);
+    }
+    return used;
+}
+
+/**
+ * Run the "buffers" command, which reports how full the buffers and pools of the stub are.
+ *
+ * @return Result of sending the output.
+ */
+static int monitor_buffers
+(
+    const char      *args,  ///< Command arguments, which are ignored.
+    unsigned int     length ///< Length of the arguments.
+)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         contexts = 0;
+    unsigned int         i;
+    int                  result;
+
+    (void) args;
+    (void) length;
+
+    for (i = 0; i < GDBS_THREAD_CONTEXT_COUNT; ++i)
+    {
+        contexts += (env->thread_contexts[i].thread != 0);
+    }
+
+    result = report("Console output", proto_console_pending(), GDBS_CONSOLE_BUFFER_LENGTH);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Held writes", env->pending_data_used, GDBS_WRITE_COMBINE_LENGTH);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Held write ranges", env->pending_write_count, GDBS_WRITE_COMBINE_COUNT);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Thread contexts", contexts, GDBS_THREAD_CONTEXT_COUNT);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Agent bytecode", env->agent_pool_used, GDBS_AGENT_BYTECODE_LENGTH);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Trace actions", env->trace_actions_used, GDBS_TRACE_ACTION_LENGTH);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Trace buffer", env->trace_used, GDBS_TRACE_BUFFER_LENGTH);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Stop queue", env->stop_enqueue - env->stop_dequeue,
+                        GDBS_STOP_QUEUE_LENGTH);
+    }
+    return result;
+}
+
+#if GDBS_STATS
+/**
+ * Send the statistics of the communication with GDB.
+ *
+ * @return Result of sending the output.
+ */
+static int report_stats(void)
+{
+    const struct gdbs_stats         *stats = stats_read();
+    const struct gdbs_command_stats *command;
+    struct line                      line;
+    unsigned int                     i;
+    int                              result = GDBS_ERROR_OK;
+    const struct
+    {
+        const char      *label;
+        unsigned long    value;
+    } counters[] =
+    {
+        { "Packets received", stats->packets_received },
+        { "Packets sent", stats->packets_sent },
+        { "Notifications sent", stats->notifications_sent },
+        { "Bytes received", stats->bytes_received },
+        { "Bytes sent", stats->bytes_sent },
+        { "ACKs received", stats->acks_received },
+        { "ACKs sent", stats->acks_sent },
+        { "NACKs received", stats->nacks_received },
+        { "NACKs sent", stats->nacks_sent },
+        { "Checksum failures", stats->checksum_failures },
+        { "Resyncs", stats->resyncs },
+        { "Retransmits", stats->retransmits },
+#if GDBS_STATS_TIMING
+        { "Receive time", stats->receive_time },
+        { "Dispatch time", stats->dispatch_time },
+        { "Transmit time", stats->transmit_time },
+#endif
+    };
+
+    for (i = 0; i < sizeof(counters) / sizeof(counters[0]) && result == GDBS_ERROR_OK; ++i)
+    {
+        line.length = 0;
+        append(&line, counters[i].label);
+        pad_label(&line);
+        append_decimal(&line, counters[i].value);
+        append(&line, "\n");
+        result = gdbs_monitor_write(line.text, line.length);
+    }
+
+    // Only the commands which GDB has sent are listed.
+    for (i = 0; i < GDBS_STATS_COMMAND_COUNT && result == GDBS_ERROR_OK; ++i)
+    {
+        command = &stats->commands[i];
+        if (command->packets == 0)
+        {
+            continue;
+        }
+
+        line.length = 0;
+        if (command->command != '\0')
+        {
+            append(&line, "Command ");
+            line.text[line.length++] = command->command;
+        }
+        else
+        {
+            append(&line, "Other commands");
+        }
+        pad_label(&line);
+        append_decimal(&line, command->packets);
+        append(&line, " packets, ");
+        append_decimal(&line, command->bytes_in);
+        append(&line, " bytes in, ");
+        append_decimal(&line, command->bytes_out);
+        append(&line, " bytes out");
+#if GDBS_STATS_TIMING
+        append(&line, ", ");
+        append_decimal(&line, command->time);
+        append(&line, " time");
+#endif
+        append(&line, "\n");
+        result = gdbs_monitor_write(line.text, line.length);
+    }
+    return result;
+}
+#endif
+
+/**
+ * Run the "stats" command, which reports the breakpoints, watchpoints, and tracepoints in use,
+ * followed by the statistics of the communication with GDB when they are collected.  With the
+ * "reset" argument, the statistics are reset instead.
+ *
+ * @return Result of sending the output.
+ */
+static int monitor_stats
+(
+    const char      *args,  ///< Command arguments.
+    unsigned int     length ///< Length of the arguments.
+)
+{
+    struct environment  *env = core_get_environment();
+    int                  result;
+
+    if (length == 5 && memcmp(args, "reset", 5) == 0)
+    {
+#if GDBS_STATS
+        gdbs_reset_stats();
+        return WRITE_TEXT("Statistics reset\n");
+#else
+        return WRITE_TEXT("Statistics are not collected\n");
+#endif
+    }
+
+    result = report("Software breakpoints", env->breakpoint_count, GDBS_BREAKPOINT_COUNT);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Hardware breakpoints",
+                        count_comparators(env->hw_breakpoints, env->hw_breakpoint_count),
+                        env->hw_breakpoint_count);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Watchpoints", count_comparators(env->watchpoints, env->watchpoint_count),
+                        env->watchpoint_count);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Tracepoints", env->tracepoint_count, GDBS_TRACEPOINT_COUNT);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report("Trace frames", env->trace_frame_count, env->trace_frames_created);
+    }
+#if GDBS_STATS
+    if (result == GDBS_ERROR_OK)
+    {
+        result = report_stats();
+    }
+#endif
+    return result;
+}
+
+static int monitor_help(const char *args, unsigned int length);
+
+/// Built-in monitor commands, which take precedence over the target's own commands.
+static const struct gdbs_monitor_command builtins[] =
+{
+    { "buffers", "Report how full the buffers of the stub are", monitor_buffers },
+    { "help", "List the monitor commands", monitor_help },
+    { "stats", "Report the breakpoints in use and packet statistics; \"stats reset\" resets them",
+      monitor_stats },
+};
+
+/// Number of built-in monitor commands.
+#define BUILTIN_COUNT (sizeof(builtins) / sizeof(builtins[0]))
+
+/**
+ * Send the names and descriptions of a table of monitor commands.
+ *
+ * @return Result of sending the output.
+ */
+static int list
+(
+    const struct gdbs_monitor_command   *table, ///< Command table.
+    unsigned int                         count  ///< Number of entries in the table.
+)
+{
+    struct line     line;
+    unsigned int    i;
+    int             result = GDBS_ERROR_OK;
+
+    for (i = 0; i < count && result == GDBS_ERROR_OK; ++i)
+    {
+        // Descriptions are sent as they are, so that they need not fit in a line.
+        line.length = 0;
+        append(&line, table[i].name);
+        pad_label(&line);
+        result = gdbs_monitor_write(line.text, line.length);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = gdbs_monitor_write(table[i].help, strlen(table[i].help));
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = WRITE_TEXT("\n");
+        }
+    }
+    return result;
+}
+
+/**
+ * Run the "help" command, which lists the monitor commands.
+ *
+ * @return Result of sending the output.
+ */
+static int monitor_help
+(
+    const char      *args,  ///< Command arguments, which are ignored.
+    unsigned int     length ///< Length of the arguments.
+)
+{
+    const struct gdbs_monitor_command   *table;
+    unsigned int                         count;
+    int                                  result;
+
+    (void) args;
+    (void) length;
+
+    table = gdbs_get_monitor_commands(&count);
+    result = list(builtins, BUILTIN_COUNT);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = list(table, count);
+    }
+    return result;
+}
+
+/**
+ * Find a command by name in a table of monitor commands.
+ *
+ * @return Matching command, or NULL if there is none.
+ */
+static const struct gdbs_monitor_command *find
+(
+    const struct gdbs_monitor_command   *table,  ///< Command table.
+    unsigned int                         count,  ///< Number of entries in the table.
+    const char                          *name,   ///< Command name.  Need not be NUL-terminated.
+    size_t                               length  ///< Length of the name.
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (strlen(table[i].name) == length && memcmp(table[i].name, name, length) == 0)
+        {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Send output from a monitor command to GDB, which prints it on its console.  The output is sent
+ * straight away in an 'O' packet, so a command may produce any amount of output without buffering
+ * it.  May only be called from a monitor command handler.
+ *
+ * @retval  0 Output sent.
+ * @retval <0 An error occurred.  The exact value will be a negative enum gdbs_error entry
+ *            indicating what went wrong.
+ */
+int gdbs_monitor_write
+(
+    const char      *text,  ///< Output text.  Need not be NUL-terminated.
+    unsigned int     length ///< Length of the text.
+)
+{
+    struct packet_writer    packet;
+    int                     result;
+
+    if (length == 0)
+    {
+        return GDBS_ERROR_OK;
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, core_get_environment()->comm);
+    result = packet_writer_push(&packet, 'O');
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(&packet, (const unsigned char *) text, length);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qRcmd' query, which runs a command given to GDB's "monitor" command.  The tokenizer
+ * must be positioned just after the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_monitor
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    char                                 line[GDBS_MONITOR_LINE_LENGTH];
+    const struct gdbs_monitor_command   *table;
+    const struct gdbs_monitor_command   *command;
+    const unsigned char                 *token;
+    size_t                               length = 0;
+    size_t                               name_length;
+    size_t                               i;
+    unsigned int                         count;
+    int                                  result;
+
+    // The command line is hex encoded.  A bare "monitor" sends an empty one.
+    if (packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) == GDBS_ERROR_OK)
+    {
+        if (length % 2 != 0 || length / 2 > sizeof(line) ||
+            hex_string_to_bytes((const char *) token, length, (unsigned char *) line) < 0)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+        length /= 2;
+    }
+    else
+    {
+        length = 0;
+    }
+
+    // The first word names the command, and the rest of the line after its spaces is passed on.
+    for (name_length = 0; name_length < length && line[name_length] != ' '; ++name_length)
+    {
+    }
+    for (i = name_length; i < length && line[i] == ' '; ++i)
+    {
+    }
+
+    if (name_length == 0)
+    {
+        command = find(builtins, BUILTIN_COUNT, "help", 4);
+    }
+    else
+    {
+        command = find(builtins, BUILTIN_COUNT, line, name_length);
+    }
+    if (command == NULL)
+    {
+        table = gdbs_get_monitor_commands(&count);
+        command = find(table, count, line, name_length);
+    }
+
+    if (command == NULL)
+    {
+        GDBS_LOG("Unsupported monitor command: '%.*s'\n", (int) name_length, line);
+        result = WRITE_TEXT("Unknown monitor command, see \"monitor help\"\n");
+    }
+    else
+    {
+        result = command->handler(&line[i], (unsigned int) (length - i));
+    }
+    if (result < 0)
+    {
+        return result;
+    }
+    return proto_send_ok();
+}
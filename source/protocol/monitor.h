@@ -0,0 +1,28 @@
+/**
+ *  @file       monitor.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Monitor commands for the GDB protocol.
+ */
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'qRcmd' query, which runs a command given to GDB's "monitor" command.  The tokenizer
+ * must be positioned just after the query name.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_monitor
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+#endif /* end MONITOR_H_ */
@@ -0,0 +1,227 @@
+/**
+ *  @file       nonstop.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Non-stop mode stop event queue for the GDB protocol.
+ *
+ *  In non-stop mode, stops are reported with asynchronous "%Stop" notifications rather than as the
+ *  reply to a resume command.  Only one notification may be outstanding at a time: once GDB has
+ *  received it, GDB drains the remaining events with 'vStopped' commands.  Events wait in a bounded
+ *  queue in the meantime.  Only the packet loop removes events.
+ *
+ *  GDB is not offered non-stop mode, and "QNonStop:1" is refused.  The stub stops the whole target
+ *  while it serves each packet, and controls it as a single thread, so it cannot keep other threads
+ *  running while one is stopped.  Doing so needs ports to stop and resume threads individually.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "nonstop.h"
+
+#include "core.h"
+#include "protocol/response.h"
+#include "protocol/stop.h"
+
+/// Mask selecting the queue slot for a queue position.
+#define QUEUE_MASK (GDBS_STOP_QUEUE_LENGTH - 1)
+
+/**
+ * Make every stop queue slot available for the first pass of queue positions.
+ */
+void proto_init_stop_queue(void)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+
+    for (i = 0; i < GDBS_STOP_QUEUE_LENGTH; ++i)
+    {
+        env->stop_queue[i].sequence = i;
+    }
+    env->stop_enqueue = 0;
+    env->stop_dequeue = 0;
+    env->stop_notified = 0;
+}
+
+/**
+ * Add a stop event to the queue of events to be reported to GDB.  This may be called from several
+ * contexts at once.
+ *
+ * @retval 0                        Event queued.
+ * @retval -GDBS_ERROR_RESOURCES    The queue is full, and the event has been discarded.
+ */
+int proto_queue_stop
+(
+    const struct gdbs_stop_event    *event, ///< Stop event.
+    unsigned char                   *frame  ///< Register frame of the stopped context.  Must
+                                            ///< remain valid until the event is reported.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct stop_record  *record;
+    unsigned int         position;
+    int                  distance;
+
+    // Claim the next position.  A slot is free for a position once its sequence matches it.
+    for (;;)
+    {
+        position = env->stop_enqueue;
+        record = &env->stop_queue[position & QUEUE_MASK];
+        distance = (int) (record->sequence - position);
+        if (distance < 0)
+        {
+            GDBS_LOG("Stop queue full\n");
+            return -GDBS_ERROR_RESOURCES;
+        }
+        if (distance == 0 && GDBS_ATOMIC_CAS(&env->stop_enqueue, position, position + 1))
+        {
+            break;
+        }
+    }
+
+    record->event = *event;
+    record->frame = frame;
+
+    // Publish the record.  The swap orders the writes above before the change of sequence.
+    GDBS_ATOMIC_CAS(&record->sequence, position, position + 1);
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Find the oldest stop event in the queue.
+ *
+ * @return Oldest queued record, or NULL if the queue is empty.
+ */
+static struct stop_record *oldest
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    struct stop_record  *record = &env->stop_queue[env->stop_dequeue & QUEUE_MASK];
+    unsigned int         position = env->stop_dequeue + 1;
+
+    // The swap leaves the sequence unchanged, but orders the reads of the record after it.
+    return (GDBS_ATOMIC_CAS(&record->sequence, position, position) ? record : NULL);
+}
+
+/**
+ * Remove the oldest stop event from the queue.  The queue must not be empty.
+ */
+static void remove_oldest
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    struct stop_record *record = &env->stop_queue[env->stop_dequeue & QUEUE_MASK];
+
+    // Make the slot available again for the next pass of queue positions.
+    record->sequence = env->stop_dequeue + GDBS_STOP_QUEUE_LENGTH;
+    ++env->stop_dequeue;
+}
+
+/**
+ * Send a "%Stop" notification for the oldest queued stop event, unless one is already outstanding.
+ * Nothing is sent outside of non-stop mode.  Console output is left queued, as GDB does not accept
+ * 'O' packets in non-stop mode.
+ *
+ * @retval 0    Notification sent, or there was nothing to send.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_notify_stop(void)
+{
+    struct environment  *env = core_get_environment();
+    struct stop_record  *record;
+
+    if (!env->non_stop || env->stop_notified || (record = oldest(env)) == NULL)
+    {
+        return GDBS_ERROR_OK;
+    }
+
+    env->stop_notified = 1;
+    return proto_send_stop(PT_NOTIFICATION, &record->event, record->frame);
+}
+
+/**
+ * Reply with the oldest queued stop event, or "OK" if there are none.  Either way, GDB follows up
+ * with 'vStopped' until the queue is empty.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_report_stopped(void)
+{
+    struct environment  *env = core_get_environment();
+    struct stop_record  *record = oldest(env);
+
+    if (record == NULL)
+    {
+        env->stop_notified = 0;
+        return proto_send_ok();
+    }
+
+    env->stop_notified = 1;
+    return proto_send_stop(PT_MESSAGE, &record->event, record->frame);
+}
+
+/**
+ * Handle the 'vStopped' command, which acknowledges the last stop event reported and asks for the
+ * next.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_stopped
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment *env = core_get_environment();
+
+    (void) tokenizer;
+
+    if (env->stop_notified && oldest(env) != NULL)
+    {
+        remove_oldest(env);
+    }
+    return proto_report_stopped();
+}
+
+/**
+ * Handle the 'QNonStop' command, which selects all-stop mode with "QNonStop:0".  Any stop events
+ * waiting to be reported are discarded.  Non-stop mode is refused, and is not offered in the
+ * 'qSupported' reply: the stub controls the target as a single thread, and stops all of it while
+ * serving a packet, so it cannot keep other threads running as GDB would expect.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_set_non_stop
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       value;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &value) != GDBS_ERROR_OK ||
+        value != 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    while (oldest(env) != NULL)
+    {
+        remove_oldest(env);
+    }
+    env->stop_notified = 0;
+    env->non_stop = 0;
+    env->running = 0;
+    return proto_send_ok();
+}
@@ -0,0 +1,85 @@
+/**
+ *  @file       nonstop.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Non-stop mode stop event queue for the GDB protocol.
+ */
+#ifndef NONSTOP_H_
+#define NONSTOP_H_
+
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Make every stop queue slot available for the first pass of queue positions.
+ */
+void proto_init_stop_queue(void);
+
+/**
+ * Add a stop event to the queue of events to be reported to GDB.  This may be called from several
+ * contexts at once.
+ *
+ * @retval 0                        Event queued.
+ * @retval -GDBS_ERROR_RESOURCES    The queue is full, and the event has been discarded.
+ */
+int proto_queue_stop
+(
+    const struct gdbs_stop_event    *event, ///< Stop event.
+    unsigned char                   *frame  ///< Register frame of the stopped context.  Must
+                                            ///< remain valid until the event is reported.
+);
+
+/**
+ * Send a "%Stop" notification for the oldest queued stop event, unless one is already outstanding.
+ * Nothing is sent outside of non-stop mode.  Console output is left queued, as GDB does not accept
+ * 'O' packets in non-stop mode.
+ *
+ * @retval 0    Notification sent, or there was nothing to send.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_notify_stop(void);
+
+/**
+ * Reply with the oldest queued stop event, or "OK" if there are none.  Either way, GDB follows up
+ * with 'vStopped' until the queue is empty.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_report_stopped(void);
+
+/**
+ * Handle the 'vStopped' command, which acknowledges the last stop event reported and asks for the
+ * next.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_stopped
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'QNonStop' command, which selects all-stop mode with "QNonStop:0".  Any stop events
+ * waiting to be reported are discarded.  Non-stop mode is refused, and is not offered in the
+ * 'qSupported' reply: the stub controls the target as a single thread, and stops all of it while
+ * serving a packet, so it cannot keep other threads running as GDB would expect.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_set_non_stop
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+#endif /* end NONSTOP_H_ */
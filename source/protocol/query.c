@@ -0,0 +1,245 @@
+/**
+ *  @file       query.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      General query and multi-letter commands for the GDB protocol.
+ */
+#include "gdbsconfig.h"
+#include "gdbstub.h"
+
+#include "query.h"
+
+#include "core.h"
+#include "protocol/features.h"
+#include "protocol/flash.h"
+#include "protocol/memory.h"
+#include "protocol/monitor.h"
+#include "protocol/nonstop.h"
+#include "protocol/response.h"
+#include "protocol/resume.h"
+#include "protocol/threads.h"
+#include "protocol/trace.h"
+#include "protocol/xfer.h"
+#include "stdc/memcmp.h"
+
+/// Determine whether a token matches a string literal exactly.
+#define TOKEN_IS(t, l, s) ((l) == sizeof(s) - 1 && memcmp((t), (s), sizeof(s) - 1) == 0)
+
+/// Push a string literal to a packet.
+#define PUSH_TEXT(p, s) packet_writer_push_buffer((p), (const unsigned char *) (s), sizeof(s) - 1)
+
+/// Description of a query handler.
+struct query
+{
+    const char  *name;                                ///< Query name, without the command
+                                                      ///< character.
+    size_t       length;                              ///< Length of the name.
+    int        (*handler)(struct packet_tokenizer *); ///< Query handler.
+};
+
+/// Define a query table entry.
+#define QUERY(n, h) { (n), sizeof(n) - 1, (h) }
+
+/**
+ * Handle the 'qSupported' query, which exchanges the features supported by GDB and the stub.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int query_supported
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    int                  result;
+    struct environment  *env = core_get_environment();
+    struct packet_writer packet;
+
+    // Record the features offered by GDB.
+    env->swbreak_enabled = 0;
+    env->hwbreak_enabled = 0;
+    while (packet_tokenizer_advance(tokenizer, ';', &token, &length) != -GDBS_ERROR_EOB)
+    {
+        if (TOKEN_IS(token, length, "swbreak+"))
+        {
+            env->swbreak_enabled = 1;
+        }
+        else if (TOKEN_IS(token, length, "hwbreak+"))
+        {
+            env->hwbreak_enabled = 1;
+        }
+    }
+
+    // Allow room for the packet framing within the receive buffer.
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = PUSH_TEXT(&packet, "PacketSize=");
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_unsigned(&packet, GDBS_PACKET_BUFFER_LENGTH - 4);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = PUSH_TEXT(&packet, ";swbreak+;hwbreak+;ConditionalBreakpoints+"
+                                    ";BreakpointCommands+"
+                                    ";qXfer:threads:read+;ConditionalTracepoints+"
+                                    ";StaticTracepoints+;qXfer:statictrace:read+");
+    }
+    if (result == GDBS_ERROR_OK && proto_memory_map_available())
+    {
+        result = PUSH_TEXT(&packet, ";qXfer:memory-map:read+");
+    }
+    if (result == GDBS_ERROR_OK && proto_features_available())
+    {
+        result = PUSH_TEXT(&packet, ";qXfer:features:read+");
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/// Supported general queries.
+static const struct query queries[] =
+{
+    QUERY("C", proto_current_thread),
+    QUERY("CRC", proto_memory_crc),
+    QUERY("Rcmd", proto_monitor),
+    QUERY("Search", proto_search_memory),
+    QUERY("Supported", query_supported),
+    QUERY("TBuffer", proto_trace_read_buffer),
+    QUERY("TSTMat", proto_trace_marker_at),
+    QUERY("TStatus", proto_trace_status),
+    QUERY("TfSTM", proto_trace_marker_list_first),
+    QUERY("ThreadExtraInfo", proto_thread_extra_info),
+    QUERY("TsSTM", proto_trace_marker_list_next),
+    QUERY("Xfer", proto_xfer),
+    QUERY("fThreadInfo", proto_thread_list_first),
+    QUERY("sThreadInfo", proto_thread_list_next),
+};
+
+/// Supported general settings.
+static const struct query settings[] =
+{
+    QUERY("NonStop", proto_set_non_stop),
+    QUERY("TBuffer", proto_trace_set_buffer),
+    QUERY("TDP", proto_trace_define),
+    QUERY("TFrame", proto_trace_select_frame),
+    QUERY("TStart", proto_trace_start),
+    QUERY("TStop", proto_trace_stop),
+    QUERY("Tinit", proto_trace_init),
+};
+
+/// Supported multi-letter commands.
+static const struct query commands[] =
+{
+    QUERY("Cont", proto_vcont),
+    QUERY("Cont?", proto_vcont_query),
+    QUERY("CtrlC", proto_ctrl_c),
+    QUERY("FlashDone", proto_flash_done),
+    QUERY("FlashErase", proto_flash_erase),
+    QUERY("FlashWrite", proto_flash_write),
+    QUERY("Stopped", proto_stopped),
+};
+
+/**
+ * Dispatch a query to the matching handler from a table.  The query name is terminated by a colon,
+ * a comma, a semicolon, or the end of the packet.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int dispatch
+(
+    struct packet_tokenizer *tokenizer, ///< Tokenizer positioned after the command character.
+    const struct query      *table,     ///< Table of queries.
+    size_t                   count      ///< Number of entries in the table.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    size_t               i;
+
+    if (packet_tokenizer_advance(tokenizer, ':', &token, &length) == -GDBS_ERROR_EOB)
+    {
+        return proto_send_empty();
+    }
+
+    // Some queries separate their name from the arguments with a comma or semicolon instead.
+    for (i = 0; i < length && token[i] != ',' && token[i] != ';'; ++i)
+    {
+    }
+    if (i < length)
+    {
+        packet_tokenizer_rewind(tokenizer);
+        packet_tokenizer_advance(tokenizer, token[i], &token, &length);
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (length == table[i].length && memcmp(token, table[i].name, length) == 0)
+        {
+            return table[i].handler(tokenizer);
+        }
+    }
+
+    GDBS_LOG("Unsupported query: '%.*s'\n", (int) length, (const char *) token);
+    return proto_send_empty();
+}
+
+/**
+ * Handle the 'q' command, which performs a general query.  Queries which are not recognized are
+ * answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_general_query
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    return dispatch(tokenizer, queries, sizeof(queries) / sizeof(queries[0]));
+}
+
+/**
+ * Handle the 'Q' command, which changes a general setting.  Settings which are not recognized are
+ * answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_general_set
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    return dispatch(tokenizer, settings, sizeof(settings) / sizeof(settings[0]));
+}
+
+/**
+ * Handle the 'v' command, which carries a multi-letter command name.  Commands which are not
+ * recognized are answered with an empty response.
+ *
+ * @retval 0            Response sent.
+ * @retval PROTO_RESUME The command requested that the target resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_multi_letter_command
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    return dispatch(tokenizer, commands, sizeof(commands) / sizeof(commands[0]));
+}
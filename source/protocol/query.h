@@ -0,0 +1,56 @@
+/**
+ *  @file       query.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      General query and multi-letter commands for the GDB protocol.
+ */
+#ifndef QUERY_H_
+#define QUERY_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'q' command, which performs a general query.  Queries which are not recognized are
+ * answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_general_query
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'Q' command, which changes a general setting.  Settings which are not recognized are
+ * answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_general_set
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'v' command, which carries a multi-letter command name.  Commands which are not
+ * recognized are answered with an empty response.
+ *
+ * @retval 0            Response sent.
+ * @retval PROTO_RESUME The command requested that the target resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_multi_letter_command
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+#endif /* end QUERY_H_ */
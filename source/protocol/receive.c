@@ -8,74 +8,127 @@
  *  @brief      Packet reception implementation for GDB protocol.
  */
 #include "gdbsconfig.h"
+#include "gdbstub.h"
 
 #include "receive.h"
 
+#include "auxiliary/packet.h"
+#include "auxiliary/stats.h"
 #include "core.h"
+#include "protocol/ack.h"
+#include "protocol/breakpoint.h"
+#include "protocol/console.h"
+#include "protocol/fileio.h"
+#include "protocol/memory.h"
+#include "protocol/query.h"
+#include "protocol/registers.h"
+#include "protocol/response.h"
+#include "protocol/resume.h"
+#include "protocol/stop.h"
+#include "protocol/threads.h"
 
-// void proto_receive_packet
-// (
-//     struct packet_tokenizer *tokenizer
-// )
-// {
-//     const char      *token = NULL;
-//     int              result = 0;
-//     unsigned long    length = 0;
-
-//     // Extract the first token of the packet, which indicates the type of command.
-//     result = packet_tokenizer_advance(tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
-//     if (result < 0)
-//     {
-//         GDBS_LOG("Packet tokenization failed: %s", gdbs_error_to_string(-result));
-//         return 0;
-//     }
-//     else if (length == 0)
-//     {
-//         GDBS_LOG("Ignoring zero-length packet token");
-//         return 0;
-//     }
+/**
+ * Dispatch a received packet to the appropriate command handler.
+ *
+ * @retval 0            The command was handled and the stub should continue processing packets.
+ * @retval PROTO_RESUME The command requested that the target resume.
+ */
+static int proto_receive_packet
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received packet.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    int                  result;
 
-//     // Dispatch packet to appropriate handler based on initial character.
-//     switch (token[0])
-//     {
-//         case '?':
-//             result = proto_stop_reply();
-//             break;
-//         case 'c':
-//             result = proto_continue(tokenizer);
-//             break;
-//         case 'g':
-//             result = proto_read_general_registers(tokenizer);
-//             break;
-//         case 'G':
-//             result = proto_write_general_registers(tokenizer);
-//             break;
-//         case 'k':
-//             result = proto_kill();
-//             break;
-//         case 'm':
-//             result = proto_read_memory(tokenizer);
-//             break;
-//         case 'M':
-//             result = proto_write_memory(tokenizer);
-//             break;
-//         case 'q':
-//             result = proto_general_query(tokenizer);
-//             break;
-//         case 's':
-//             result = proto_single_step(tokenizer);
-//             break;
-//         case 'v':
-//             result = proto_extended_command(tokenizer);
-//             break;
-//         default:
-//             GDBS_LOG("Unrecognized command prefix: '%c'\n", token[0]);
-//             break;
-//     }
+    // Extract the first token of the packet, which indicates the type of command.
+    result = packet_tokenizer_advance(tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    if (result < 0)
+    {
+        GDBS_LOG("Packet tokenization failed: %s\n", gdbs_error_to_string(-result));
+        return 0;
+    }
+    else if (length == 0)
+    {
+        GDBS_LOG("Ignoring zero-length packet token\n");
+        return 0;
+    }
 
-//     return result;
-// }
+    // Dispatch packet to appropriate handler based on initial character.
+    switch (token[0])
+    {
+        case '?':
+            result = proto_stop_reply(tokenizer);
+            break;
+        case 'c':
+            result = proto_continue(tokenizer);
+            break;
+        case 'D':
+            result = proto_detach(tokenizer);
+            break;
+        case 'F':
+            result = proto_host_reply(tokenizer);
+            break;
+        case 'g':
+            result = proto_read_general_registers(tokenizer);
+            break;
+        case 'G':
+            result = proto_write_general_registers(tokenizer);
+            break;
+        case 'H':
+            result = proto_set_thread(tokenizer);
+            break;
+        case 'm':
+            result = proto_read_memory(tokenizer);
+            break;
+        case 'M':
+            result = proto_write_memory(tokenizer);
+            break;
+        case 'p':
+            result = proto_read_register(tokenizer);
+            break;
+        case 'P':
+            result = proto_write_register(tokenizer);
+            break;
+        case 'q':
+            result = proto_general_query(tokenizer);
+            break;
+        case 'Q':
+            result = proto_general_set(tokenizer);
+            break;
+        case 's':
+            result = proto_single_step(tokenizer);
+            break;
+        case 'T':
+            result = proto_thread_alive(tokenizer);
+            break;
+        case 'v':
+            result = proto_multi_letter_command(tokenizer);
+            break;
+        case 'z':
+            result = proto_remove_breakpoint(tokenizer);
+            break;
+        case 'X':
+            result = proto_write_memory_binary(tokenizer);
+            break;
+        case 'Z':
+            result = proto_insert_breakpoint(tokenizer);
+            break;
+        default:
+            GDBS_LOG("Unrecognized command prefix: '%c'\n", token[0]);
+            result = proto_send_empty();
+            break;
+    }
 
+    if (result < 0)
+    {
+        GDBS_LOG("Command '%c' failed: %s\n", token[0], gdbs_error_to_string(-result));
+        proto_send_error(result);
+        result = 0;
+    }
+    return result;
+}
 
 /**
  * Enter the packet receive and process loop.
@@ -93,33 +146,51 @@ void proto_process
 
     if (send_stop_reply)
     {
+        // Console output produced before the stop must reach GDB first.
+        proto_console_flush();
+
         // Send information regarding the signal that caused control to pass the stub.
         proto_send_stop_reply();
     }
 
     for (;;)
     {
-        // Wait for the next packet to arrive.
+        // Wait for the next packet to arrive, unless gdbs_comm_poll() has already seen it start.
         length = GDBS_PACKET_BUFFER_LENGTH;
-        result = packet_receive(buffer, &length, PT_MESSAGE, env.comm);
-        if (result == 0)
+        if (env->packet_started)
+        {
+            env->packet_started = 0;
+            result = packet_receive_remainder(env->packet_buffer, &length, PT_MESSAGE, env->comm);
+        }
+        else
         {
-            proto_send_ack(1);
+            result = packet_receive(env->packet_buffer, &length, PT_MESSAGE, env->comm);
         }
+        if (result < 0)
         {
-            GDBS_LOG("Receive error: %s", gdbs_error_to_string(-result));
-            proto_send_ack(0);
+            GDBS_LOG("Receive error: %s\n", gdbs_error_to_string(-result));
+            proto_nack();
             continue;
         }
+        proto_ack();
 
         // Begin parsing the packet.
-        packet_tokenizer_init(&tokenizer, buffer, length);
+        packet_tokenizer_init(&tokenizer, env->packet_buffer, length);
 
         // Try to dispatch the packet to a handler.
-        if (proto_receive_packet(&tokenizer))
+        GDBS_STATS_UPDATE(stats_dispatch_start(env->packet_buffer[1], length));
+        result = proto_receive_packet(&tokenizer);
+        GDBS_STATS_UPDATE(stats_dispatch_end());
+        if (result == PROTO_RESUME)
         {
             // Exit from the processing handler, if requested.
             break;
         }
+
+        // In non-stop mode, GDB keeps talking to a running target one polled packet at a time.
+        if (env->non_stop && env->running)
+        {
+            break;
+        }
     }
 }
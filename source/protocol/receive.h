@@ -10,6 +10,9 @@
 #ifndef RECEIVE_H_
 #define RECEIVE_H_
 
+/// Command handler result indicating that the target should resume.
+#define PROTO_RESUME 1
+
 /**
  * Enter the packet receive and process loop.
  */
@@ -0,0 +1,350 @@
+/**
+ *  @file       registers.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Register access commands for the GDB protocol.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "registers.h"
+
+#include "auxiliary/endian.h"
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/response.h"
+#include "protocol/threads.h"
+#include "stdc/assert.h"
+#include "stdc/memset.h"
+#include "stdc/null.h"
+
+/**
+ * Look up a register by its GDB register number.
+ *
+ * @return The register table entry, or NULL if the register is not present.
+ */
+static const struct gdbs_register *find_register
+(
+    const struct environment    *env,   ///< Stub environment.
+    gdbs_address_t               regnum ///< GDB register number.
+)
+{
+    unsigned int index;
+
+    if (regnum >= GDBS_REGISTER_NUMBER_LIMIT)
+    {
+        return NULL;
+    }
+
+    index = env->register_index[regnum];
+    return (index == 0 ? NULL : &env->registers[index - 1]);
+}
+
+/**
+ * Build the lookup table which maps GDB register numbers to entries in the register table.  This
+ * must be called whenever the register table is (re)loaded.
+ */
+void proto_index_registers(void)
+{
+    struct environment  *env = core_get_environment();
+    unsigned int         i;
+
+    memset(env->register_index, 0, sizeof(env->register_index));
+    env->pc_register = NULL;
+    env->register_frame_length = 0;
+
+    for (i = 0; i < env->register_count; ++i)
+    {
+        if (env->registers[i].offset + env->registers[i].size > env->register_frame_length)
+        {
+            env->register_frame_length = env->registers[i].offset + env->registers[i].size;
+        }
+        if (env->registers[i].flags & GDBS_REGISTER_PC)
+        {
+            env->pc_register = &env->registers[i];
+        }
+        if (env->registers[i].regnum >= GDBS_REGISTER_NUMBER_LIMIT)
+        {
+            GDBS_LOG("Register %u exceeds GDBS_REGISTER_NUMBER_LIMIT\n", env->registers[i].regnum);
+            continue;
+        }
+        env->register_index[env->registers[i].regnum] = (unsigned short) (i + 1);
+    }
+}
+
+/**
+ * Handle the 'g' command, which reads all general registers of the thread selected with "Hg".  The
+ * register values are streamed straight from its register frame.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_general_registers
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    const struct gdbs_register  *reg;
+    int                          result;
+    struct environment          *env = core_get_environment();
+    struct packet_writer         packet;
+    unsigned int                 i;
+
+    (void) tokenizer;
+
+    if (env->general_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    // Register files are typically dominated by zeroed registers, so compress runs as they are
+    // streamed out.
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_set_rle(&packet, 1);
+
+    for (i = 0; i < env->register_count && result == GDBS_ERROR_OK; ++i)
+    {
+        reg = &env->registers[i];
+        result = packet_writer_push_hex(&packet, &env->general_frame[reg->offset], reg->size);
+    }
+
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'G' command, which writes all general registers of the thread selected with "Hg".  The
+ * register values are decoded straight into its register frame.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_general_registers
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    const struct gdbs_register  *reg;
+    const unsigned char         *token;
+    size_t                       length;
+    size_t                       expected = 0;
+    size_t                       offset;
+    unsigned char                scratch;
+    int                          result;
+    struct environment          *env = core_get_environment();
+    unsigned int                 i;
+
+    if (env->general_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    result = packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length);
+    if (result != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Check the overall length and every digit before touching the frame, so that a truncated or
+    // corrupt packet does not leave the registers partially updated.
+    for (i = 0; i < env->register_count; ++i)
+    {
+        expected += (size_t) env->registers[i].size * 2;
+    }
+    if (length != expected)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    for (offset = 0; offset < length; offset += 2)
+    {
+        if (hex_octet_to_byte((const char *) &token[offset], &scratch) != GDBS_ERROR_OK)
+        {
+            return -GDBS_ERROR_INVALID;
+        }
+    }
+
+    for (i = 0; i < env->register_count; ++i)
+    {
+        reg = &env->registers[i];
+        result = hex_string_to_bytes((const char *) token, (size_t) reg->size * 2,
+                                     &env->general_frame[reg->offset]);
+        if (result != GDBS_ERROR_OK)
+        {
+            return result;
+        }
+        token += reg->size * 2;
+    }
+
+    proto_mark_thread_registers(NULL);
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'p' command, which reads a single register of the thread selected with "Hg".
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_register
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    const struct gdbs_register  *reg;
+    gdbs_address_t               regnum;
+    int                          result;
+    struct environment          *env = core_get_environment();
+    struct packet_writer         packet;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &regnum) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    reg = find_register(env, regnum);
+    if (reg == NULL || env->general_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_hex(&packet, &env->general_frame[reg->offset], reg->size);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'P' command, which writes a single register of the thread selected with "Hg".
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_register
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    const struct gdbs_register  *reg;
+    const unsigned char         *token;
+    size_t                       length;
+    gdbs_address_t               regnum;
+    int                          result;
+    struct environment          *env = core_get_environment();
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, '=', &regnum) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    reg = find_register(env, regnum);
+    if (reg == NULL || env->general_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+    if (length != (size_t) reg->size * 2)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    result = hex_string_to_bytes((const char *) token, length, &env->general_frame[reg->offset]);
+    if (result == GDBS_ERROR_OK)
+    {
+        proto_mark_thread_registers(reg);
+    }
+    return (result == GDBS_ERROR_OK ? proto_send_ok() : result);
+}
+
+/**
+ * Locate the saved value of a register in the register frame.  The value is held in target byte
+ * order.
+ *
+ * @retval 0                        Register found.
+ * @retval -GDBS_ERROR_NOT_FOUND    The register is not present, or no register frame is available.
+ */
+int proto_get_register_bytes
+(
+    gdbs_address_t           regnum, ///< [in]  GDB register number.
+    const unsigned char    **bytes,  ///< [out] Location of the register value.
+    unsigned int            *size    ///< [out] Size of the register, in bytes.
+)
+{
+    const struct gdbs_register  *reg;
+    struct environment          *env = core_get_environment();
+
+    reg = find_register(env, regnum);
+    if (reg == NULL || env->register_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    *bytes = &env->register_frame[reg->offset];
+    *size = reg->size;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Read the program counter from the saved register frame.
+ *
+ * @retval 0                        Program counter read.
+ * @retval -GDBS_ERROR_NOT_FOUND    No program counter register or register frame is available.
+ */
+int proto_get_pc
+(
+    gdbs_address_t *pc ///< [out] Program counter value.
+)
+{
+    const struct gdbs_register  *reg;
+    const unsigned char         *bytes;
+    struct environment          *env = core_get_environment();
+
+    reg = env->pc_register;
+    if (reg == NULL || env->register_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    bytes = &env->register_frame[reg->offset];
+    *pc = (gdbs_address_t) bytes_to_value(bytes, reg->size, is_little_endian());
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Write the program counter in the saved register frame.  The target resumes from the new value.
+ *
+ * @retval 0                        Program counter written.
+ * @retval -GDBS_ERROR_NOT_FOUND    No program counter register or register frame is available.
+ */
+int proto_set_pc
+(
+    gdbs_address_t pc ///< [in] New program counter value.
+)
+{
+    const struct gdbs_register  *reg;
+    unsigned char               *bytes;
+    struct environment          *env = core_get_environment();
+
+    reg = env->pc_register;
+    if (reg == NULL || env->register_frame == NULL)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    bytes = &env->register_frame[reg->offset];
+    value_to_bytes(bytes, pc, reg->size, is_little_endian());
+    return GDBS_ERROR_OK;
+}
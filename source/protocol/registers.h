@@ -0,0 +1,107 @@
+/**
+ *  @file       registers.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Register access commands for the GDB protocol.
+ */
+#ifndef REGISTERS_H_
+#define REGISTERS_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'g' command, which reads all general registers.  The register values are streamed
+ * straight from the saved register frame.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_general_registers
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'G' command, which writes all general registers.  The register values are decoded
+ * straight into the saved register frame.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_general_registers
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Build the lookup table which maps GDB register numbers to entries in the register table.  This
+ * must be called whenever the register table is (re)loaded.
+ */
+void proto_index_registers(void);
+
+/**
+ * Handle the 'p' command, which reads a single register.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_read_register
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'P' command, which writes a single register.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_write_register
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Locate the saved value of a register in the register frame.  The value is held in target byte
+ * order.
+ *
+ * @retval 0                        Register found.
+ * @retval -GDBS_ERROR_NOT_FOUND    The register is not present, or no register frame is available.
+ */
+int proto_get_register_bytes
+(
+    gdbs_address_t           regnum, ///< [in]  GDB register number.
+    const unsigned char    **bytes,  ///< [out] Location of the register value.
+    unsigned int            *size    ///< [out] Size of the register, in bytes.
+);
+
+/**
+ * Read the program counter from the saved register frame.
+ *
+ * @retval 0                        Program counter read.
+ * @retval -GDBS_ERROR_NOT_FOUND    No program counter register or register frame is available.
+ */
+int proto_get_pc
+(
+    gdbs_address_t *pc ///< [out] Program counter value.
+);
+
+/**
+ * Write the program counter in the saved register frame.  The target resumes from the new value.
+ *
+ * @retval 0                        Program counter written.
+ * @retval -GDBS_ERROR_NOT_FOUND    No program counter register or register frame is available.
+ */
+int proto_set_pc
+(
+    gdbs_address_t pc ///< [in] New program counter value.
+);
+
+#endif /* end REGISTERS_H_ */
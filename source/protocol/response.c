@@ -0,0 +1,94 @@
+/**
+ *  @file       response.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Common responses to GDB commands.
+ */
+#include "gdbsconfig.h"
+#include "gdbstub.h"
+
+#include "response.h"
+
+#include "auxiliary/hex.h"
+#include "auxiliary/packet.h"
+#include "core.h"
+#include "stdc/assert.h"
+#include "stdc/null.h"
+
+/**
+ * Send a short response packet.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+static int send
+(
+    const unsigned char *payload, ///< Response payload.
+    size_t               length   ///< Length of the payload.
+)
+{
+    int                     result;
+    struct packet_writer    packet;
+
+    packet_writer_init(&packet, PT_MESSAGE, core_get_environment()->comm);
+
+    result = packet_writer_push_buffer(&packet, payload, length);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to send response: %s\n", gdbs_error_to_string(-result));
+    }
+    return result;
+}
+
+/**
+ * Send an "OK" response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_ok(void)
+{
+    return send((const unsigned char *) "OK", 2);
+}
+
+/**
+ * Send an empty response, which indicates to GDB that a command is not supported.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_empty(void)
+{
+    return send(NULL, 0);
+}
+
+/**
+ * Send an error response of the form "Exx", where xx is the hexadecimal error number.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_error
+(
+    int error ///< Error to report, as a negative enum gdbs_error entry.
+)
+{
+    unsigned char payload[3];
+
+    assert(error < 0);
+
+    payload[0] = 'E';
+    byte_to_hex_octet((unsigned char) -error, (char *) &payload[1]);
+    return send(payload, sizeof(payload));
+}
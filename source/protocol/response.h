@@ -0,0 +1,43 @@
+/**
+ *  @file       response.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Common responses to GDB commands.
+ */
+#ifndef RESPONSE_H_
+#define RESPONSE_H_
+
+/**
+ * Send an "OK" response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_ok(void);
+
+/**
+ * Send an empty response, which indicates to GDB that a command is not supported.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_empty(void);
+
+/**
+ * Send an error response of the form "Exx", where xx is the hexadecimal error number.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_error
+(
+    int error ///< Error to report, as a negative enum gdbs_error entry.
+);
+
+#endif /* end RESPONSE_H_ */
@@ -0,0 +1,393 @@
+/**
+ *  @file       resume.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Execution control commands for the GDB protocol.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "resume.h"
+
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/breakpoint.h"
+#include "protocol/memory.h"
+#include "protocol/nonstop.h"
+#include "protocol/receive.h"
+#include "protocol/registers.h"
+#include "protocol/response.h"
+
+/**
+ * Prepare the target to resume execution.  Memory writes held back and pending breakpoint changes
+ * are applied to target memory, and the instruction cache is flushed once, if code may have
+ * changed.
+ *
+ * @retval PROTO_RESUME The target is ready to resume.
+ * @retval <0           The target cannot resume.  The exact value will be a negative
+ *                      enum gdbs_error entry indicating what went wrong.
+ */
+int proto_resume
+(
+    int step ///< Boolean indicating whether to stop after a single instruction.
+)
+{
+    struct environment  *env = core_get_environment();
+    int                  result;
+
+    result = proto_commit_writes();
+    if (result < 0)
+    {
+        return result;
+    }
+
+    result = gdbs_set_single_step(step);
+    if (result < 0)
+    {
+        return result;
+    }
+    env->stepping = step;
+
+    if (proto_commit_breakpoints() > 0 || env->icache_dirty)
+    {
+        gdbs_flush_icache();
+        env->icache_dirty = 0;
+    }
+
+    return PROTO_RESUME;
+}
+
+/**
+ * Resume the target, after moving the program counter if the command supplies an address.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong.
+ */
+static int resume_from
+(
+    struct packet_tokenizer *tokenizer, ///< Tokenizer positioned after the command character.
+    int                      step       ///< Boolean indicating whether to single step.
+)
+{
+    gdbs_address_t  address;
+    int             result;
+
+    result = packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &address);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = proto_set_pc(address);
+        if (result < 0)
+        {
+            return result;
+        }
+    }
+    else if (result != -GDBS_ERROR_EOB)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    return proto_resume(step);
+}
+
+/**
+ * Handle the 'c' command, which continues execution, optionally from a new address.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_continue
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    return resume_from(tokenizer, 0);
+}
+
+/**
+ * Handle the 's' command, which executes a single instruction, optionally from a new address.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_single_step
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    return resume_from(tokenizer, 1);
+}
+
+/**
+ * Handle the 'vCont?' command, which lists the supported 'vCont' actions.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_vcont_query
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    static const char        actions[] = "vCont;c;C;s;S;r;t";
+    struct packet_writer     packet;
+    int                      result;
+
+    (void) tokenizer;
+
+    packet_writer_init(&packet, PT_MESSAGE, core_get_environment()->comm);
+    result = packet_writer_push_buffer(&packet, (const unsigned char *) actions,
+                                       sizeof(actions) - 1);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Decode the 'start,end' arguments of a 'vCont' range stepping action.
+ *
+ * @retval 0                    Range decoded.
+ * @retval -GDBS_ERROR_INVALID  The arguments are malformed.
+ */
+static int parse_range
+(
+    const unsigned char *text,   ///< [in]  Arguments, following the action character.
+    size_t               length, ///< [in]  Length of the arguments.
+    gdbs_address_t      *start,  ///< [out] First address of the range.
+    gdbs_address_t      *end     ///< [out] Address after the end of the range.
+)
+{
+    size_t i;
+
+    for (i = 0; i < length && text[i] != ','; ++i)
+    {
+    }
+    if (i == length ||
+        hex_string_to_unsigned((const char *) text, i, start) < 0 ||
+        hex_string_to_unsigned((const char *) &text[i + 1], length - i - 1, end) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Stop the target in non-stop mode.  When the target is running, the stub keeps control and a stop
+ * event is queued for GDB.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int stop_running
+(
+    enum gdbs_signal signal ///< Signal to report with the stop.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct gdbs_stop_event   event;
+    int                      result;
+
+    if (!env->running)
+    {
+        return proto_send_ok();
+    }
+
+    event.signal = signal;
+    event.reason = GDBS_STOP_SIGNAL;
+    event.unit = -1;
+    event.address = 0;
+    event.thread = gdbs_get_current_thread();
+    result = proto_queue_stop(&event, env->register_frame);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    env->running = 0;
+    result = proto_send_ok();
+    if (result == GDBS_ERROR_OK)
+    {
+        result = proto_notify_stop();
+    }
+    return result;
+}
+
+/**
+ * Handle the 'vCont' command, which resumes the target with an action for each thread.  The stub
+ * controls the target as a single thread, so the first action applies and any thread IDs are
+ * ignored.  Signals given with 'C' and 'S' cannot be delivered to the target and are discarded.
+ * The 'r' action steps for as long as the program counter stays within a range, without stopping
+ * to report each instruction to GDB.
+ *
+ * In non-stop mode, resuming actions are acknowledged with "OK" straight away, and the eventual
+ * stop is reported with a notification.  The 't' action stops a running target, again reported
+ * with a notification.
+ *
+ * @retval 0            Response sent, and the target remains stopped.
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_vcont
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    const unsigned char *token;
+    size_t               length;
+    gdbs_address_t       signo;
+    gdbs_address_t       start = 0;
+    gdbs_address_t       end = 0;
+    size_t               i;
+    int                  step;
+    int                  result;
+
+    if (packet_tokenizer_advance(tokenizer, ';', &token, &length) == -GDBS_ERROR_EOB ||
+        length == 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Drop the thread ID.
+    for (i = 0; i < length && token[i] != ':'; ++i)
+    {
+    }
+    length = i;
+
+    switch (length > 0 ? token[0] : 0)
+    {
+        case 'c':
+        case 's':
+            step = (token[0] == 's');
+            result = (length == 1 ? GDBS_ERROR_OK : -GDBS_ERROR_INVALID);
+            break;
+        case 'C':
+        case 'S':
+            step = (token[0] == 'S');
+            result = hex_string_to_unsigned((const char *) &token[1], length - 1, &signo);
+            if (result == GDBS_ERROR_OK)
+            {
+                GDBS_LOG("Discarding signal %lu\n", (unsigned long) signo);
+            }
+            break;
+        case 'r':
+            step = 1;
+            result = parse_range(&token[1], length - 1, &start, &end);
+            break;
+        case 't':
+            if (!env->non_stop || length != 1)
+            {
+                return -GDBS_ERROR_INVALID;
+            }
+            return stop_running(GDBS_SIGNAL_NONE);
+        default:
+            return -GDBS_ERROR_INVALID;
+    }
+    if (result < 0)
+    {
+        return result;
+    }
+
+    result = proto_resume(step);
+    if (result == PROTO_RESUME && start < end)
+    {
+        env->range_stepping = 1;
+        env->range_start = start;
+        env->range_end = end;
+    }
+    if (result == PROTO_RESUME && env->non_stop)
+    {
+        // The target resumes regardless of whether GDB receives the reply.
+        proto_send_ok();
+        env->running = 1;
+    }
+    return result;
+}
+
+/**
+ * Handle the 'vCtrlC' command, which GDB sends in place of the interrupt character in non-stop
+ * mode.  A running target is stopped as for the 'vCont' 't' action, but the stop is reported as
+ * GDBS_SIGNAL_INT.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_ctrl_c
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    (void) tokenizer;
+    return stop_running(GDBS_SIGNAL_INT);
+}
+
+/**
+ * Handle a stop during a range step, before anything is reported to GDB.  If the program counter is
+ * still within the range, and has not reached a breakpoint, the target takes another step.
+ *
+ * @return Boolean indicating that the stub has arranged for the target to continue, and the stop
+ *         must not be reported to GDB.
+ */
+int proto_range_step(void)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       pc;
+
+    if (!env->range_stepping)
+    {
+        return 0;
+    }
+
+    if (env->stop.signal == GDBS_SIGNAL_TRAP && env->stop.reason == GDBS_STOP_SIGNAL &&
+        proto_get_pc(&pc) == GDBS_ERROR_OK && pc >= env->range_start && pc < env->range_end &&
+        !proto_breakpoint_at(pc) && proto_resume(1) == PROTO_RESUME)
+    {
+        return 1;
+    }
+
+    env->range_stepping = 0;
+    return 0;
+}
+
+/**
+ * Handle the 'D' command, which detaches the debugger.  All breakpoints are removed and the target
+ * resumes.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_detach
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    int result;
+
+    (void) tokenizer;
+
+    proto_clear_breakpoints();
+    result = proto_resume(0);
+    if (result == PROTO_RESUME)
+    {
+        // The target resumes regardless of whether GDB receives the reply.
+        proto_send_ok();
+    }
+    return result;
+}
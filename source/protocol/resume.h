@@ -0,0 +1,120 @@
+/**
+ *  @file       resume.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Execution control commands for the GDB protocol.
+ */
+#ifndef RESUME_H_
+#define RESUME_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Prepare the target to resume execution.  Pending breakpoint changes are applied to target memory
+ * and the instruction cache is flushed once, if anything may have changed.
+ *
+ * @retval PROTO_RESUME The target is ready to resume.
+ * @retval <0           The target cannot resume.  The exact value will be a negative
+ *                      enum gdbs_error entry indicating what went wrong.
+ */
+int proto_resume
+(
+    int step ///< Boolean indicating whether to stop after a single instruction.
+);
+
+/**
+ * Handle the 'c' command, which continues execution, optionally from a new address.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_continue
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 's' command, which executes a single instruction, optionally from a new address.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_single_step
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'vCont?' command, which lists the supported 'vCont' actions.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_vcont_query
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'vCont' command, which resumes the target with an action for each thread.  The stub
+ * controls the target as a single thread, so the first action applies and any thread IDs are
+ * ignored.  Signals given with 'C' and 'S' cannot be delivered to the target and are discarded.
+ * The 'r' action steps for as long as the program counter stays within a range, without stopping
+ * to report each instruction to GDB.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_vcont
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'vCtrlC' command, which GDB sends in place of the interrupt character in non-stop
+ * mode.  A running target is stopped as for the 'vCont' 't' action, but the stop is reported as
+ * GDBS_SIGNAL_INT.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_ctrl_c
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle a stop during a range step, before anything is reported to GDB.  If the program counter is
+ * still within the range, and has not reached a breakpoint, the target takes another step.
+ *
+ * @return Boolean indicating that the stub has arranged for the target to continue, and the stop
+ *         must not be reported to GDB.
+ */
+int proto_range_step(void);
+
+/**
+ * Handle the 'D' command, which detaches the debugger.  All breakpoints are removed and the target
+ * resumes.
+ *
+ * @retval PROTO_RESUME The target should resume.
+ * @retval <0           Command failed.  The exact value will be a negative enum gdbs_error entry
+ *                      indicating what went wrong, and should be reported to GDB as an error
+ *                      response.
+ */
+int proto_detach
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+#endif /* end RESUME_H_ */
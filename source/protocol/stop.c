@@ -0,0 +1,211 @@
+/**
+ *  @file       stop.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Stop reply handling for the GDB protocol.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "stop.h"
+
+#include "core.h"
+#include "protocol/nonstop.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/// Boolean indicating that stop replies identify the thread which stopped.  This is left out when
+/// the whole target is presented as a single thread.
+#define REPORT_THREAD (!GDBS_GENERIC_THREADS)
+
+/**
+ * Determine the name under which a stop reason is reported, if GDB is able to accept it.
+ *
+ * @return Stop reason name, or NULL if the reason is not reported.
+ */
+static const char *reason_name
+(
+    const struct environment        *env,  ///< Stub environment.
+    const struct gdbs_stop_event    *event ///< Stop event.
+)
+{
+    switch (event->reason)
+    {
+        case GDBS_STOP_SWBREAK:
+            return (env->swbreak_enabled ? "swbreak" : NULL);
+        case GDBS_STOP_HWBREAK:
+            return (env->hwbreak_enabled ? "hwbreak" : NULL);
+        case GDBS_STOP_WATCH:
+            return "watch";
+        case GDBS_STOP_RWATCH:
+            return "rwatch";
+        case GDBS_STOP_AWATCH:
+            return "awatch";
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Write out the expedited registers as "n:r;" pairs.
+ *
+ * @retval 0    Registers written.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+static int push_expedited_registers
+(
+    struct packet_writer        *packet, ///< Packet writer instance.
+    const struct environment    *env,    ///< Stub environment.
+    const unsigned char         *frame   ///< Register frame of the stopped context.
+)
+{
+    const struct gdbs_register  *reg;
+    int                          result = GDBS_ERROR_OK;
+    unsigned int                 i;
+
+    for (i = 0; i < env->register_count && result == GDBS_ERROR_OK; ++i)
+    {
+        reg = &env->registers[i];
+        if ((reg->flags & GDBS_REGISTER_EXPEDITE) == 0)
+        {
+            continue;
+        }
+
+        result = packet_writer_push_unsigned(packet, reg->regnum);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(packet, ':');
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_hex(packet, &frame[reg->offset], reg->size);
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(packet, ';');
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Send a stop reply describing a stop event.  A 'T' reply is sent with the expedited registers and
+ * stop reason when any are available, otherwise a plain 'S' reply is sent.  As a notification, the
+ * reply is sent as a "%Stop" notification.
+ *
+ * @retval 0    Reply sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_stop
+(
+    enum packet_type                 type,  ///< PT_MESSAGE for a reply, or PT_NOTIFICATION.
+    const struct gdbs_stop_event    *event, ///< Stop event.
+    const unsigned char             *frame  ///< Register frame of the stopped context, or NULL.
+)
+{
+    struct environment      *env = core_get_environment();
+    const char              *reason = reason_name(env, event);
+    int                      expedite = (frame != NULL);
+    int                      result = GDBS_ERROR_OK;
+    unsigned char            signal = (unsigned char) event->signal;
+    struct packet_writer     packet;
+
+    packet_writer_init(&packet, type, env->comm);
+
+    if (type == PT_NOTIFICATION)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) "Stop:", 5);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push(&packet,
+                                    (expedite || reason != NULL || REPORT_THREAD ? 'T' : 'S'));
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(&packet, &signal, 1);
+    }
+    if (result == GDBS_ERROR_OK && expedite)
+    {
+        result = push_expedited_registers(&packet, env, frame);
+    }
+    if (result == GDBS_ERROR_OK && REPORT_THREAD)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) "thread:", 7);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, event->thread);
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(&packet, ';');
+        }
+    }
+    if (result == GDBS_ERROR_OK && reason != NULL)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) reason, strlen(reason));
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(&packet, ':');
+        }
+
+        // Watchpoint reasons carry the data address that triggered them.
+        if (result == GDBS_ERROR_OK &&
+            (event->reason != GDBS_STOP_SWBREAK && event->reason != GDBS_STOP_HWBREAK))
+        {
+            result = packet_writer_push_unsigned(&packet, event->address);
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(&packet, ';');
+        }
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+
+    if (result < 0)
+    {
+        GDBS_LOG("Failed to send stop reply: %s\n", gdbs_error_to_string(-result));
+    }
+    return result;
+}
+
+/**
+ * Send a stop reply describing the event which caused the current stop.
+ *
+ * @retval 0    Reply sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_stop_reply(void)
+{
+    struct environment *env = core_get_environment();
+
+    return proto_send_stop(PT_MESSAGE, &env->stop, env->register_frame);
+}
+
+/**
+ * Handle the '?' command, which requests the reason for the current stop.  In non-stop mode, the
+ * reply describes the oldest stop event waiting to be reported instead.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_stop_reply
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    (void) tokenizer;
+    return (core_get_environment()->non_stop ? proto_report_stopped() : proto_send_stop_reply());
+}
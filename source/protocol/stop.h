@@ -0,0 +1,55 @@
+/**
+ *  @file       stop.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Stop reply handling for the GDB protocol.
+ */
+#ifndef STOP_H_
+#define STOP_H_
+
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Send a stop reply describing a stop event.  A 'T' reply is sent with the expedited registers and
+ * stop reason when any are available, otherwise a plain 'S' reply is sent.  As a notification, the
+ * reply is sent as a "%Stop" notification.
+ *
+ * @retval 0    Reply sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_stop
+(
+    enum packet_type                 type,  ///< PT_MESSAGE for a reply, or PT_NOTIFICATION.
+    const struct gdbs_stop_event    *event, ///< Stop event.
+    const unsigned char             *frame  ///< Register frame of the stopped context, or NULL.
+);
+
+/**
+ * Send a stop reply describing the event which caused the current stop.
+ *
+ * @retval 0    Reply sent.
+ * @retval <0   Sending failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong.
+ */
+int proto_send_stop_reply(void);
+
+/**
+ * Handle the '?' command, which requests the reason for the current stop.  In non-stop mode, the
+ * reply describes the oldest stop event waiting to be reported instead.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_stop_reply
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+#endif /* end STOP_H_ */
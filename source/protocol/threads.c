@@ -0,0 +1,698 @@
+/**
+ *  @file       threads.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Thread commands for the GDB protocol.
+ *
+ *  Threads are supplied by the thread hooks in gdbsdevice.h.  The thread list is sent to GDB in
+ *  batches which fill each reply packet, rather than one thread at a time.  The XML thread list
+ *  document is never held in memory; each element is generated when a read reaches it.
+ *
+ *  The registers of other threads are cached while the stub is active, so that GDB can switch
+ *  between threads without fetching their contexts again.  Changes are written back only when the
+ *  target resumes.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "threads.h"
+
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/response.h"
+#include "stdc/memcpy.h"
+#include "stdc/memset.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+/// Number of thread IDs requested from gdbs_get_threads() at once.
+#define THREAD_BATCH 16
+
+/// Longest reply payload, matching the packet size reported to GDB.
+#define REPLY_LIMIT (GDBS_PACKET_BUFFER_LENGTH - 4)
+
+/// Thread ID meaning any thread.
+#define THREAD_ANY 0
+
+/// Thread ID meaning all threads.
+#define THREAD_ALL (~(gdbs_address_t) 0)
+
+/// Longest element of the thread list document.  Longer thread names are cut short.
+#define ELEMENT_LENGTH 128
+
+/// Start of the thread list document.
+#define DOCUMENT_HEADER "<?xml version=\"1.0\"?>\n<threads>\n"
+
+/// End of the thread list document.
+#define DOCUMENT_FOOTER "</threads>\n"
+
+/**
+ * Count the hexadecimal digits needed to write a value without leading zeros.
+ *
+ * @return Number of digits.
+ */
+static unsigned int hex_digits
+(
+    gdbs_address_t value ///< Value to measure.
+)
+{
+    unsigned int digits = 1;
+
+    while ((value >>= 4) != 0)
+    {
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * Send the next batch of the thread list, continuing from the thread list cursor.  As many thread
+ * IDs are sent as fit within the reply packet.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int send_thread_list(void)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    gdbs_address_t           ids[THREAD_BATCH];
+    unsigned int             count;
+    unsigned int             i;
+    size_t                   used = 0;
+    int                      result = GDBS_ERROR_OK;
+    int                      full = 0;
+    int                      first = 1;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    while (!full && result == GDBS_ERROR_OK)
+    {
+        count = gdbs_get_threads(env->thread_cursor, ids, THREAD_BATCH);
+        for (i = 0; i < count && result == GDBS_ERROR_OK; ++i)
+        {
+            // Each ID is preceded by 'm' for the first, or a comma.
+            used += hex_digits(ids[i]) + 1;
+            if (used > REPLY_LIMIT)
+            {
+                full = 1;
+                break;
+            }
+
+            result = packet_writer_push(&packet, (unsigned char) (first ? 'm' : ','));
+            if (result == GDBS_ERROR_OK)
+            {
+                result = packet_writer_push_unsigned(&packet, ids[i]);
+            }
+            ++env->thread_cursor;
+            first = 0;
+        }
+        if (count < THREAD_BATCH)
+        {
+            break;
+        }
+    }
+
+    // Nothing left to send marks the end of the list.
+    if (result == GDBS_ERROR_OK && first)
+    {
+        result = packet_writer_push(&packet, 'l');
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qfThreadInfo' query, which starts listing the target's threads.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_list_first
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    (void) tokenizer;
+
+    core_get_environment()->thread_cursor = 0;
+    return send_thread_list();
+}
+
+/**
+ * Handle the 'qsThreadInfo' query, which continues listing the target's threads.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_list_next
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    (void) tokenizer;
+
+    return send_thread_list();
+}
+
+/**
+ * Handle the 'qC' query, which identifies the thread which stopped.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_current_thread
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    int                      result;
+
+    (void) tokenizer;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_buffer(&packet, (const unsigned char *) "QC", 2);
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_unsigned(&packet, env->stop.thread);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qThreadExtraInfo' query, which describes a thread for display by GDB.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_extra_info
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    gdbs_address_t           thread;
+    const char              *name;
+    int                      result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &thread) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (!gdbs_thread_alive(thread))
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    name = gdbs_get_thread_name(thread);
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_hex(&packet, (const unsigned char *) name,
+                                    (name != NULL ? strlen(name) : 0));
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Append a string to an element, provided that it fits.
+ *
+ * @return Boolean indicating that the string was appended.
+ */
+static int append
+(
+    char        *element, ///< [in,out] Element text.
+    size_t      *used,    ///< [in,out] Length of the element text.
+    const char  *text,    ///< [in]     String to append.
+    size_t       length   ///< [in]     Length of the string.
+)
+{
+    if (*used + length > ELEMENT_LENGTH)
+    {
+        return 0;
+    }
+    memcpy(&element[*used], text, length);
+    *used += length;
+    return 1;
+}
+
+/**
+ * Append a number to an element, without leading zeros.
+ *
+ * @return Boolean indicating that the number was appended.
+ */
+static int append_number
+(
+    char            *element, ///< [in,out] Element text.
+    size_t          *used,    ///< [in,out] Length of the element text.
+    gdbs_address_t   value,   ///< [in]     Number to append.
+    unsigned int     base     ///< [in]     Base of the number, up to 16.
+)
+{
+    char            digits[sizeof(gdbs_address_t) * 8];
+    unsigned int    i = sizeof(digits);
+
+    do
+    {
+        digits[--i] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value != 0);
+    return append(element, used, &digits[i], sizeof(digits) - i);
+}
+
+/**
+ * Append a thread name to an element as an XML attribute value.  The name is cut short rather
+ * than split within an escape sequence if it does not fit, leaving room for the end of the element.
+ */
+static void append_name
+(
+    char        *element, ///< [in,out] Element text.
+    size_t      *used,    ///< [in,out] Length of the element text.
+    const char  *name,    ///< [in]     Thread name.
+    size_t       reserve  ///< [in]     Length to leave free after the name.
+)
+{
+    const char  *text;
+    size_t       length;
+    size_t       limit = *used + reserve;
+
+    for (; *name != '\0'; ++name)
+    {
+        switch (*name)
+        {
+            case '&':
+                text = "&amp;";
+                break;
+            case '<':
+                text = "&lt;";
+                break;
+            case '>':
+                text = "&gt;";
+                break;
+            case '"':
+                text = "&quot;";
+                break;
+            default:
+                text = name;
+                break;
+        }
+        length = (text == name ? 1 : strlen(text));
+        if (limit + length > ELEMENT_LENGTH)
+        {
+            break;
+        }
+        memcpy(&element[*used], text, length);
+        *used += length;
+        limit += length;
+    }
+}
+
+/**
+ * Generate an element of the thread list document.  The first element is the document header,
+ * followed by an element for each thread, and then the document footer.
+ *
+ * @return Length of the element, or zero beyond the end of the document.
+ */
+static size_t generate_element
+(
+    unsigned int     position, ///< [in]  Position of the element within the document.
+    char            *element   ///< [out] Element text, of up to ELEMENT_LENGTH characters.
+)
+{
+    gdbs_address_t   thread;
+    const char      *name;
+    int              core;
+    size_t           used = 0;
+
+    if (position == 0)
+    {
+        append(element, &used, DOCUMENT_HEADER, sizeof(DOCUMENT_HEADER) - 1);
+        return used;
+    }
+    if (gdbs_get_threads(position - 1, &thread, 1) == 0)
+    {
+        // The footer follows the last thread, which may also be the header.
+        if (position == 1 || gdbs_get_threads(position - 2, &thread, 1) != 0)
+        {
+            append(element, &used, DOCUMENT_FOOTER, sizeof(DOCUMENT_FOOTER) - 1);
+        }
+        return used;
+    }
+
+    // The fixed parts of the element fit whatever the values, leaving the rest for the name.
+    append(element, &used, "<thread id=\"", 12);
+    append_number(element, &used, thread, 16);
+    core = gdbs_get_thread_core(thread);
+    if (core >= 0)
+    {
+        append(element, &used, "\" core=\"", 8);
+        append_number(element, &used, (gdbs_address_t) core, 10);
+    }
+    name = gdbs_get_thread_name(thread);
+    if (name != NULL)
+    {
+        append(element, &used, "\" name=\"", 8);
+        append_name(element, &used, name, 4);
+    }
+    append(element, &used, "\"/>\n", 4);
+    return used;
+}
+
+/**
+ * Read a window of the thread list document for 'qXfer:threads:read'.  The document is generated
+ * as it is read, continuing from the element reached by the previous read, so reading it in order
+ * only costs the length of each window.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given.
+ */
+int proto_xfer_threads
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+)
+{
+    struct environment  *env = core_get_environment();
+    char                 element[ELEMENT_LENGTH];
+    size_t               element_length;
+    size_t               copied = 0;
+    size_t               skip;
+    size_t               count;
+
+    (void) annex;
+    if (annex_length != 0)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    // Reading from the start lists the threads afresh, in case they have changed.
+    if (offset == 0 || offset < env->thread_xfer_offset)
+    {
+        env->thread_xfer_element = 0;
+        env->thread_xfer_offset = 0;
+    }
+
+    while (copied < length)
+    {
+        element_length = generate_element(env->thread_xfer_element, element);
+        if (element_length == 0)
+        {
+            break;
+        }
+
+        // Elements wholly before the window are skipped; the cursor stays on a partly read one.
+        skip = (size_t) (offset + copied - env->thread_xfer_offset);
+        if (skip < element_length)
+        {
+            count = element_length - skip;
+            if (count > length - copied)
+            {
+                count = length - copied;
+            }
+            memcpy(&data[copied], &element[skip], count);
+            copied += count;
+            if (skip + count < element_length)
+            {
+                break;
+            }
+        }
+        env->thread_xfer_offset += element_length;
+        ++env->thread_xfer_element;
+    }
+    return (int) copied;
+}
+
+/**
+ * Decode a thread ID argument, which may be -1 for all threads or 0 for any thread.
+ *
+ * @retval 0                    Thread ID decoded.
+ * @retval -GDBS_ERROR_INVALID  The thread ID is malformed.
+ */
+static int parse_thread
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer positioned before the thread ID.
+    gdbs_address_t          *thread     ///< [out] Thread ID.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+
+    if (packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) != GDBS_ERROR_OK ||
+        length == 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (length == 2 && token[0] == '-' && token[1] == '1')
+    {
+        *thread = THREAD_ALL;
+        return GDBS_ERROR_OK;
+    }
+    return hex_string_to_unsigned((const char *) token, length, thread);
+}
+
+/**
+ * Pass the changed registers of a cached thread context on to the thread.
+ *
+ * @retval 0    Registers written, or nothing had changed.
+ * @retval <0   Writing failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int write_back
+(
+    struct thread_context *context ///< Cached thread context.
+)
+{
+    size_t  i;
+    int     result = GDBS_ERROR_OK;
+
+    for (i = 0; i < sizeof(context->dirty) && context->dirty[i] == 0; ++i)
+    {
+    }
+    if (i < sizeof(context->dirty))
+    {
+        result = gdbs_set_thread_context(context->thread, context->frame, context->dirty);
+        memset(context->dirty, 0, sizeof(context->dirty));
+    }
+    return result;
+}
+
+/**
+ * Select a thread other than the one which stopped for register access.  Its registers are taken
+ * from the thread context cache if present, and otherwise fetched into the least recently used
+ * cache entry.
+ *
+ * @retval 0    Thread selected.
+ * @retval <0   Selection failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+static int select_context
+(
+    struct environment  *env,   ///< Stub environment.
+    gdbs_address_t       thread ///< Thread ID.
+)
+{
+    struct thread_context   *context = &env->thread_contexts[0];
+    unsigned int             i;
+    int                      result;
+
+    for (i = 0; i < GDBS_THREAD_CONTEXT_COUNT && env->thread_contexts[i].thread != thread; ++i)
+    {
+        if (env->thread_contexts[i].used < context->used)
+        {
+            context = &env->thread_contexts[i];
+        }
+    }
+
+    if (i < GDBS_THREAD_CONTEXT_COUNT)
+    {
+        context = &env->thread_contexts[i];
+    }
+    else
+    {
+        // Unused entries are never selected, so they are replaced first.
+        if (context->thread != THREAD_ANY)
+        {
+            result = write_back(context);
+            context->thread = THREAD_ANY;
+            context->used = 0;
+            if (result < 0)
+            {
+                return result;
+            }
+        }
+        result = gdbs_get_thread_context(thread, context->frame);
+        if (result < 0)
+        {
+            return result;
+        }
+        context->thread = thread;
+    }
+
+    context->used = ++env->thread_selections;
+    env->general_thread = thread;
+    env->general_frame = context->frame;
+    env->general_context = context;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Handle the 'H' command, which selects the thread for later register access with "Hg", or for
+ * resuming with "Hc".  The stub resumes every thread together, so a thread selected with "Hc" only
+ * needs to exist.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_set_thread
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    struct environment  *env = core_get_environment();
+    const unsigned char *token;
+    size_t               length;
+    gdbs_address_t       thread;
+    int                  result;
+
+    if (packet_tokenizer_advance(tokenizer, TOKEN_SINGLE_CHAR, &token, &length) != GDBS_ERROR_OK ||
+        (token[0] != 'g' && token[0] != 'c') || parse_thread(tokenizer, &thread) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    if (thread != THREAD_ANY && thread != THREAD_ALL && thread != env->stop.thread &&
+        !gdbs_thread_alive(thread))
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+    if (token[0] == 'c')
+    {
+        return proto_send_ok();
+    }
+
+    if (thread == THREAD_ANY || thread == THREAD_ALL || thread == env->stop.thread)
+    {
+        env->general_thread = env->stop.thread;
+        env->general_frame = env->register_frame;
+        env->general_context = NULL;
+        return proto_send_ok();
+    }
+
+    if (env->register_frame_length > GDBS_REGISTER_FRAME_LENGTH)
+    {
+        GDBS_LOG("Register frame exceeds GDBS_REGISTER_FRAME_LENGTH\n");
+        return -GDBS_ERROR_RESOURCES;
+    }
+    result = select_context(env, thread);
+    return (result == GDBS_ERROR_OK ? proto_send_ok() : result);
+}
+
+/**
+ * Handle the 'T' command, which asks whether a thread is still alive.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_alive
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+)
+{
+    gdbs_address_t thread;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &thread) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    return (gdbs_thread_alive(thread) ? proto_send_ok() : -GDBS_ERROR_NOT_FOUND);
+}
+
+/**
+ * Record that registers in the frame selected with "Hg" have been changed, so that they are
+ * written back to the selected thread before the target resumes.  Nothing needs to be done for
+ * the thread which stopped, as its frame is written in place.
+ */
+void proto_mark_thread_registers
+(
+    const struct gdbs_register *reg ///< Register changed, or NULL if every register changed.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct thread_context   *context = env->general_context;
+    unsigned int             i;
+
+    if (context == NULL)
+    {
+        return;
+    }
+    if (reg != NULL)
+    {
+        context->dirty[reg->regnum / 8] |= (unsigned char) (1 << (reg->regnum % 8));
+        return;
+    }
+    for (i = 0; i < env->register_count; ++i)
+    {
+        reg = &env->registers[i];
+        context->dirty[reg->regnum / 8] |= (unsigned char) (1 << (reg->regnum % 8));
+    }
+}
+
+/**
+ * Write back every changed thread context, and empty the thread context cache.  This must be
+ * called before the target resumes, as the saved registers of each thread change as it runs.
+ *
+ * @retval 0    Contexts written.
+ * @retval <0   Writing a context failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+int proto_flush_thread_contexts(void)
+{
+    struct environment      *env = core_get_environment();
+    struct thread_context   *context;
+    unsigned int             i;
+    int                      result = GDBS_ERROR_OK;
+    int                      written;
+
+    for (i = 0; i < GDBS_THREAD_CONTEXT_COUNT; ++i)
+    {
+        context = &env->thread_contexts[i];
+        if (context->thread != THREAD_ANY)
+        {
+            // Carry on after a failure, so that every other thread still gets its changes.
+            written = write_back(context);
+            if (written < 0 && result == GDBS_ERROR_OK)
+            {
+                result = written;
+            }
+        }
+        context->thread = THREAD_ANY;
+        context->used = 0;
+    }
+    env->thread_selections = 0;
+    env->general_context = NULL;
+    return result;
+}
@@ -0,0 +1,128 @@
+/**
+ *  @file       threads.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Thread commands for the GDB protocol.
+ */
+#ifndef THREADS_H_
+#define THREADS_H_
+
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'qfThreadInfo' query, which starts listing the target's threads.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_list_first
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qsThreadInfo' query, which continues listing the target's threads.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_list_next
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qC' query, which identifies the thread which stopped.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_current_thread
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qThreadExtraInfo' query, which describes a thread for display by GDB.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_extra_info
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Read a window of the thread list document for 'qXfer:threads:read'.  The document is generated
+ * as it is read, continuing from the element reached by the previous read, so reading it in order
+ * only costs the length of each window.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the document.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given.
+ */
+int proto_xfer_threads
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the document of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+);
+
+/**
+ * Handle the 'H' command, which selects the thread for later register access with "Hg", or for
+ * resuming with "Hc".  The stub resumes every thread together, so a thread selected with "Hc" only
+ * needs to exist.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_set_thread
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Handle the 'T' command, which asks whether a thread is still alive.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_thread_alive
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer for the received command.
+);
+
+/**
+ * Record that registers in the frame selected with "Hg" have been changed, so that they are
+ * written back to the selected thread before the target resumes.  Nothing needs to be done for
+ * the thread which stopped, as its frame is written in place.
+ */
+void proto_mark_thread_registers
+(
+    const struct gdbs_register *reg ///< Register changed, or NULL if every register changed.
+);
+
+/**
+ * Write back every changed thread context, and empty the thread context cache.  This must be
+ * called before the target resumes, as the saved registers of each thread change as it runs.
+ *
+ * @retval 0    Contexts written.
+ * @retval <0   Writing a context failed.  The exact value will be a negative enum gdbs_error entry
+ *              indicating what went wrong.
+ */
+int proto_flush_thread_contexts(void);
+
+#endif /* end THREADS_H_ */
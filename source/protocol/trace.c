@@ -0,0 +1,2096 @@
+/**
+ *  @file       trace.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Tracepoint commands for the GDB protocol.
+ *
+ *  Each tracepoint is served by a software breakpoint, placed through the breakpoint module while
+ *  tracing runs.  When one is hit, the stub collects a trace frame and lets the target continue,
+ *  without involving GDB.  Collection actions are decoded once, when GDB defines the tracepoint,
+ *  into compact records in the trace action pool: registers, memory ranges, and agent expressions
+ *  which collect memory with the trace opcodes.
+ *
+ *  Trace frames are stored in a circular buffer, in the layout used by GDB trace files, so that
+ *  'qTBuffer' can hand out the raw buffer contents.  Each frame starts with the tracepoint number
+ *  and the frame data length, followed by register and memory blocks, all in target byte order.
+ *  Memory blocks are only added to a frame once their data has been read completely.  In circular
+ *  mode the oldest frames are discarded to make room, otherwise tracing stops when the buffer
+ *  fills.
+ *
+ *  The buffer is statically allocated, and GDBS_TRACE_BUFFER_DECL can place it in a dedicated
+ *  memory region.
+ *
+ *  Static tracepoints are served by the markers which GDBS_TRACE_MARKER() places in the
+ *  gdbs_markers linker section, instead of by breakpoints.  Tracing enables the marker at the
+ *  tracepoint's address, and the code which reaches it adds a frame holding a static trace data
+ *  block with the marker arguments, as the stub is not entered.
+ */
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+#include "gdbstub.h"
+
+#include "trace.h"
+
+#include "auxiliary/endian.h"
+#include "auxiliary/hex.h"
+#include "core.h"
+#include "protocol/agent.h"
+#include "protocol/breakpoint.h"
+#include "protocol/registers.h"
+#include "protocol/response.h"
+#include "stdc/assert.h"
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/memset.h"
+#include "stdc/null.h"
+#include "stdc/strlen.h"
+
+#include <stdarg.h>
+
+/// Determine whether a token matches a string literal exactly.
+#define TOKEN_IS(t, l, s) ((l) == sizeof(s) - 1 && memcmp((t), (s), sizeof(s) - 1) == 0)
+
+/// Length of the header preceding each trace frame: the tracepoint number as a 16-bit value, then
+/// the length of the frame data as a 32-bit value.
+#define FRAME_HEADER_LENGTH 6
+/// Trace frame block tag for the register frame.
+#define BLOCK_REGISTERS 'R'
+/// Trace frame block tag for a range of memory.
+#define BLOCK_MEMORY    'M'
+/// Trace frame block tag for static trace data, which holds the arguments of a marker.  The tag is
+/// followed by the data length as a 16-bit value.
+#define BLOCK_MARKER    'S'
+/// Length of the header preceding the data of a static trace data block.
+#define MARKER_HEADER_LENGTH 3
+/// Length of the header preceding the data of a memory block: the block tag, then the address as a
+/// 64-bit value and the data length as a 16-bit value.
+#define MEMORY_HEADER_LENGTH 11
+/// Longest memory block.
+#define MEMORY_BLOCK_LIMIT 0xFFFF
+
+/// Trace action pool record tag for a tracepoint condition.
+#define ACTION_CONDITION 'X'
+/// Trace action pool record tag for collecting the register frame.
+#define ACTION_REGISTERS 'R'
+/// Trace action pool record tag for collecting a memory range.  The record holds the base register
+/// as a 32-bit value, the offset as a 64-bit value, and the length as a 32-bit value, big-endian.
+#define ACTION_MEMORY    'M'
+/// Trace action pool record tag for an agent expression to evaluate.
+#define ACTION_EVALUATE  'E'
+/// Length of the header preceding each trace action pool record: the record tag, then the record
+/// length as a big-endian 16-bit value.
+#define ACTION_HEADER_LENGTH 3
+/// Length of a memory range record.
+#define MEMORY_ACTION_LENGTH 16
+/// Base register number of a memory range at an absolute address.
+#define ABSOLUTE_BASE 0xFFFFFFFFUL
+
+/// Largest number of bytes returned by 'qTBuffer'.  The data is staged in the back half of the
+/// packet buffer, as for memory reads.
+#define READ_LIMIT ((GDBS_PACKET_BUFFER_LENGTH - 4) / 2)
+/// Size of the chunks in which memory is collected.
+#define CHUNK_LENGTH 64
+/// Longest reply payload, matching the packet size reported to GDB.
+#define REPLY_LIMIT (GDBS_PACKET_BUFFER_LENGTH - 4)
+
+/// First and one past the last static tracepoint marker.  The linker defines these symbols for the
+/// gdbs_markers section, if any marker was placed in it.
+#if defined(__GNUC__)
+extern struct gdbs_marker __start_gdbs_markers[] __attribute__((weak));
+extern struct gdbs_marker __stop_gdbs_markers[] __attribute__((weak));
+#   define MARKERS_START __start_gdbs_markers
+#   define MARKERS_END   __stop_gdbs_markers
+#else
+#   define MARKERS_START ((struct gdbs_marker *) NULL)
+#   define MARKERS_END   ((struct gdbs_marker *) NULL)
+#endif
+
+/// Reasons that tracing stopped.
+enum trace_stop_reason
+{
+    TS_NOT_RUN,  ///< Tracing has not been started.
+    TS_STOP,     ///< GDB stopped tracing.
+    TS_FULL,     ///< The trace buffer filled.
+    TS_PASSCOUNT ///< A tracepoint reached its pass count.
+};
+
+/// Length modifiers of a marker format conversion.
+enum format_length
+{
+    FL_NONE,      ///< No modifier.
+    FL_CHAR,      ///< "hh"
+    FL_SHORT,     ///< "h"
+    FL_LONG,      ///< "l"
+    FL_LONG_LONG, ///< "ll"
+    FL_SIZE,      ///< "z"
+    FL_DOUBLE     ///< "L"
+};
+
+/// Kinds of trace frame search made with 'QTFrame'.
+enum frame_search
+{
+    FS_NUMBER,     ///< Frame with a given number.
+    FS_TRACEPOINT, ///< Next frame collected by a given tracepoint.
+    FS_INSIDE,     ///< Next frame collected within an address range.
+    FS_OUTSIDE     ///< Next frame collected outside an address range.
+};
+
+/// Trace frame buffer.
+static GDBS_TRACE_BUFFER_DECL unsigned char trace_buffer[GDBS_TRACE_BUFFER_LENGTH];
+
+/**
+ * Copy data into the trace buffer, wrapping around its end.
+ */
+static void ring_write
+(
+    const struct environment    *env,    ///< Stub environment.
+    unsigned int                 offset, ///< Position from the start of the oldest frame.
+    const unsigned char         *data,   ///< Data to copy.
+    unsigned int                 length  ///< Length of the data.
+)
+{
+    unsigned int position = (env->trace_head + offset) % GDBS_TRACE_BUFFER_LENGTH;
+    unsigned int chunk;
+
+    for (; length > 0; length -= chunk, data += chunk, position = 0)
+    {
+        chunk = GDBS_TRACE_BUFFER_LENGTH - position;
+        chunk = (chunk < length ? chunk : length);
+        memcpy(&trace_buffer[position], data, chunk);
+    }
+}
+
+/**
+ * Copy data out of the trace buffer, wrapping around its end.
+ */
+static void ring_read
+(
+    const struct environment    *env,    ///< [in]  Stub environment.
+    unsigned int                 offset, ///< [in]  Position from the start of the oldest frame.
+    unsigned char               *data,   ///< [out] Data copied.
+    unsigned int                 length  ///< [in]  Length of the data.
+)
+{
+    unsigned int position = (env->trace_head + offset) % GDBS_TRACE_BUFFER_LENGTH;
+    unsigned int chunk;
+
+    for (; length > 0; length -= chunk, data += chunk, position = 0)
+    {
+        chunk = GDBS_TRACE_BUFFER_LENGTH - position;
+        chunk = (chunk < length ? chunk : length);
+        memcpy(data, &trace_buffer[position], chunk);
+    }
+}
+
+/**
+ * Read the header of a trace frame.
+ *
+ * @return Length of the frame, including its header.
+ */
+static unsigned int frame_header
+(
+    const struct environment    *env,    ///< [in]  Stub environment.
+    unsigned int                 offset, ///< [in]  Position of the frame.
+    gdbs_address_t              *number  ///< [out] Number of the tracepoint which collected the
+                                         ///<       frame.
+)
+{
+    unsigned char header[FRAME_HEADER_LENGTH];
+
+    ring_read(env, offset, header, FRAME_HEADER_LENGTH);
+    *number = bytes_to_value(header, 2, is_little_endian());
+    return FRAME_HEADER_LENGTH + (unsigned int) bytes_to_value(&header[2], 4, is_little_endian());
+}
+
+/**
+ * Determine the length of a register block, which holds every register in the order of the
+ * register table.
+ *
+ * @return Length of the block, including its tag.
+ */
+static unsigned int register_block_length
+(
+    const struct environment *env ///< Stub environment.
+)
+{
+    unsigned int length = 1;
+    unsigned int i;
+
+    for (i = 0; i < env->register_count; ++i)
+    {
+        length += env->registers[i].size;
+    }
+    return length;
+}
+
+/**
+ * Read the header of a block within a trace frame.
+ *
+ * @return Length of the block, including its header.
+ */
+static unsigned int block_header
+(
+    const struct environment    *env,      ///< [in]  Stub environment.
+    unsigned int                 position, ///< [in]  Position of the block.
+    unsigned char               *tag,      ///< [out] Block tag.
+    gdbs_address_t              *address,  ///< [out] Address of a memory block.
+    gdbs_address_t              *length    ///< [out] Data length of a memory block.
+)
+{
+    unsigned char header[MEMORY_HEADER_LENGTH];
+
+    ring_read(env, position, header, 1);
+    *tag = header[0];
+    *address = 0;
+    *length = 0;
+    if (*tag == BLOCK_MARKER)
+    {
+        ring_read(env, position, header, MARKER_HEADER_LENGTH);
+        return MARKER_HEADER_LENGTH +
+               (unsigned int) bytes_to_value(&header[1], 2, is_little_endian());
+    }
+    if (*tag != BLOCK_MEMORY)
+    {
+        return register_block_length(env);
+    }
+
+    ring_read(env, position, header, MEMORY_HEADER_LENGTH);
+    *address = bytes_to_value(&header[1], 8, is_little_endian());
+    *length = bytes_to_value(&header[9], 2, is_little_endian());
+    return MEMORY_HEADER_LENGTH + (unsigned int) *length;
+}
+
+/**
+ * Find the register block of a trace frame.
+ *
+ * @return Position of the register data, after the block tag, or zero if the frame has none.
+ */
+static unsigned int find_registers
+(
+    const struct environment    *env,   ///< Stub environment.
+    unsigned int                 offset ///< Position of the frame.
+)
+{
+    gdbs_address_t   number;
+    gdbs_address_t   address;
+    gdbs_address_t   size;
+    unsigned char    tag;
+    unsigned int     end = offset + frame_header(env, offset, &number);
+    unsigned int     position;
+    unsigned int     length;
+
+    for (position = offset + FRAME_HEADER_LENGTH; position < end; position += length)
+    {
+        length = block_header(env, position, &tag, &address, &size);
+        if (tag == BLOCK_REGISTERS)
+        {
+            return position + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Determine the address at which a trace frame was collected.  This is the program counter in the
+ * frame's register block if it has one, or else the address of the tracepoint.
+ *
+ * @return Address of the frame.
+ */
+static gdbs_address_t frame_address
+(
+    const struct environment    *env,   ///< Stub environment.
+    unsigned int                 offset ///< Position of the frame.
+)
+{
+    const struct gdbs_register  *reg = env->pc_register;
+    unsigned char                bytes[sizeof(gdbs_address_t)];
+    gdbs_address_t               number;
+    unsigned int                 position = find_registers(env, offset);
+    unsigned int                 i;
+
+    if (position != 0 && reg != NULL && reg->size <= sizeof(bytes))
+    {
+        for (i = 0; &env->registers[i] != reg; ++i)
+        {
+            position += env->registers[i].size;
+        }
+        ring_read(env, position, bytes, reg->size);
+        return bytes_to_value(bytes, reg->size, is_little_endian());
+    }
+
+    frame_header(env, offset, &number);
+    for (i = 0; i < env->tracepoint_count; ++i)
+    {
+        if (env->tracepoints[i].number == number)
+        {
+            return env->tracepoints[i].address;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Stop reading registers and memory from the selected trace frame, if any.
+ */
+static void deselect_frame
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    if (env->trace_selected)
+    {
+        env->trace_selected = 0;
+        env->general_thread = env->stop.thread;
+        env->general_frame = env->register_frame;
+        env->general_context = NULL;
+    }
+}
+
+/**
+ * Discard the oldest trace frame.
+ */
+static void drop_oldest
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    gdbs_address_t  number;
+    unsigned int    length = frame_header(env, 0, &number);
+
+    env->trace_head = (env->trace_head + length) % GDBS_TRACE_BUFFER_LENGTH;
+    env->trace_used -= length;
+    --env->trace_frame_count;
+
+    // Frames are numbered from the oldest, so the selection moves down with them.
+    if (env->trace_selected && env->trace_selected_frame == 0)
+    {
+        deselect_frame(env);
+    }
+    else if (env->trace_selected)
+    {
+        --env->trace_selected_frame;
+        env->trace_selected_offset -= length;
+    }
+}
+
+/**
+ * Make room in the trace buffer for more data in the frame being collected.  In circular mode the
+ * oldest frames are discarded as necessary.  If there is no room, the frame is abandoned.
+ *
+ * @retval 0                        Room available.
+ * @retval -GDBS_ERROR_RESOURCES    The trace buffer is full.
+ */
+static int reserve
+(
+    struct environment  *env,   ///< Stub environment.
+    unsigned int         length ///< Number of bytes needed beyond the frame collected so far.
+)
+{
+    while (GDBS_TRACE_BUFFER_LENGTH - env->trace_used - env->trace_frame_length < length)
+    {
+        if (!env->trace_circular || env->trace_frame_count == 0)
+        {
+            env->trace_frame_length = 0;
+            return -GDBS_ERROR_RESOURCES;
+        }
+        drop_oldest(env);
+    }
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Add the register frame to the trace frame being collected.
+ *
+ * @retval 0                        Registers collected.
+ * @retval -GDBS_ERROR_RESOURCES    The trace buffer is full.
+ */
+static int collect_registers
+(
+    struct environment *env ///< Stub environment.
+)
+{
+    const unsigned char  tag = BLOCK_REGISTERS;
+    unsigned int         length = register_block_length(env);
+    unsigned int         position;
+    unsigned int         i;
+    int                  result;
+
+    if (env->register_frame == NULL)
+    {
+        return GDBS_ERROR_OK;
+    }
+
+    result = reserve(env, length);
+    if (result < 0)
+    {
+        return result;
+    }
+
+    position = env->trace_used + env->trace_frame_length;
+    ring_write(env, position++, &tag, 1);
+    for (i = 0; i < env->register_count; ++i)
+    {
+        ring_write(env, position, &env->register_frame[env->registers[i].offset],
+                   env->registers[i].size);
+        position += env->registers[i].size;
+    }
+    env->trace_frame_length += length;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Record a block of target memory in the trace frame being collected.  The block is only added to
+ * the frame once it has been read completely.  Nothing is recorded when no frame is being
+ * collected.
+ *
+ * @retval 0                        Memory recorded, or no frame is being collected.
+ * @retval -GDBS_ERROR_RESOURCES    The trace buffer is full.
+ * @retval <0                       The memory could not be read.  The exact value will be a
+ *                                  negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_trace_collect_memory
+(
+    gdbs_address_t   address,   ///< First address of the block.
+    gdbs_address_t   length,    ///< Length of the block.  Limited to 65535 bytes.
+    int              until_zero ///< Boolean indicating that the block ends early after the first
+                                ///< zero byte.
+)
+{
+    struct environment  *env = core_get_environment();
+    unsigned char        header[MEMORY_HEADER_LENGTH];
+    unsigned char        chunk[CHUNK_LENGTH];
+    gdbs_address_t       done;
+    gdbs_address_t       size;
+    gdbs_address_t       i;
+    int                  result;
+
+    if (env->trace_frame_length == 0 || length == 0)
+    {
+        return GDBS_ERROR_OK;
+    }
+    if (length > MEMORY_BLOCK_LIMIT)
+    {
+        length = MEMORY_BLOCK_LIMIT;
+    }
+
+    // The data is written ahead of its header, which is only written once every chunk is read.
+    for (done = 0; done < length; done += size)
+    {
+        size = (length - done < CHUNK_LENGTH ? length - done : CHUNK_LENGTH);
+        result = gdbs_memory_read(env->comm, address + done, chunk, size);
+        if (result < 0)
+        {
+            return result;
+        }
+        proto_breakpoint_filter_read(address + done, chunk, size);
+
+        if (until_zero)
+        {
+            for (i = 0; i < size && chunk[i] != 0; ++i)
+            {
+            }
+            if (i < size)
+            {
+                size = i + 1;
+                length = done + size;
+            }
+        }
+
+        // Earlier frames may be discarded to make room, which moves the frame being collected.
+        result = reserve(env, (unsigned int) (MEMORY_HEADER_LENGTH + done + size));
+        if (result < 0)
+        {
+            return result;
+        }
+        ring_write(env, (unsigned int) (env->trace_used + env->trace_frame_length +
+                                        MEMORY_HEADER_LENGTH + done),
+                   chunk, (unsigned int) size);
+    }
+
+    header[0] = BLOCK_MEMORY;
+    value_to_bytes(&header[1], address, 8, is_little_endian());
+    value_to_bytes(&header[9], length, 2, is_little_endian());
+    ring_write(env, env->trace_used + env->trace_frame_length, header, MEMORY_HEADER_LENGTH);
+    env->trace_frame_length += MEMORY_HEADER_LENGTH + (unsigned int) length;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Find the static tracepoint marker at an address.
+ *
+ * @return The marker, or NULL if there is none.
+ */
+static struct gdbs_marker *find_marker
+(
+    gdbs_address_t address ///< Address of the marker.
+)
+{
+    struct gdbs_marker *marker;
+
+    for (marker = MARKERS_START; marker < MARKERS_END; ++marker)
+    {
+        if ((gdbs_address_t) marker == address)
+        {
+            return marker;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Disable every static tracepoint marker.
+ */
+static void disable_markers(void)
+{
+    struct gdbs_marker *marker;
+
+    for (marker = MARKERS_START; marker < MARKERS_END; ++marker)
+    {
+        marker->enabled = 0;
+    }
+}
+
+/**
+ * Stop tracing.  The breakpoints for the tracepoints are removed when the target next resumes,
+ * or as they are hit.  Markers are disabled immediately.
+ */
+static void stop_tracing
+(
+    struct environment  *env,    ///< Stub environment.
+    unsigned int         reason, ///< Reason for stopping, as an enum trace_stop_reason value.
+    unsigned int         number  ///< Tracepoint which reached its pass count, if applicable.
+)
+{
+    env->tracing = 0;
+    env->trace_stop_reason = reason;
+    env->trace_stop_tracepoint = number;
+    proto_clear_trace_breakpoints();
+    disable_markers();
+}
+
+/**
+ * Evaluate the condition of a tracepoint.  A condition which cannot be evaluated is treated as
+ * false, since GDB never sees the hit.
+ *
+ * @return Boolean indicating that the tracepoint has no condition, or that it is true.
+ */
+static int condition_true
+(
+    const struct environment    *env, ///< Stub environment.
+    const struct tracepoint     *tp   ///< Tracepoint which was hit.
+)
+{
+    const unsigned char *record = &env->trace_actions[tp->actions];
+    const unsigned char *end = record + tp->actions_length;
+    unsigned int         length;
+    int                  result;
+    agent_value_t        value;
+
+    for (; record < end; record += ACTION_HEADER_LENGTH + length)
+    {
+        length = ((unsigned int) record[1] << 8) | record[2];
+        if (record[0] == ACTION_CONDITION)
+        {
+            result = proto_agent_evaluate(&record[ACTION_HEADER_LENGTH], &value);
+            if (result < 0)
+            {
+                GDBS_LOG("Failed to evaluate condition at 0x%lx: %s\n",
+                         (unsigned long) tp->address, gdbs_error_to_string(-result));
+            }
+            return (result == GDBS_ERROR_OK && value != 0);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Run the collection actions of a tracepoint into the trace frame being collected.  Actions which
+ * fail are skipped.  If the trace buffer fills, the frame is abandoned.
+ */
+static void run_actions
+(
+    struct environment          *env, ///< Stub environment.
+    const struct tracepoint     *tp   ///< Tracepoint which was hit.
+)
+{
+    const unsigned char *record = &env->trace_actions[tp->actions];
+    const unsigned char *end = record + tp->actions_length;
+    const unsigned char *payload;
+    const unsigned char *bytes;
+    gdbs_address_t       base;
+    gdbs_address_t       address;
+    unsigned int         length;
+    unsigned int         size;
+    int                  result;
+    agent_value_t        value;
+
+    for (; record < end && env->trace_frame_length > 0; record += ACTION_HEADER_LENGTH + length)
+    {
+        length = ((unsigned int) record[1] << 8) | record[2];
+        payload = &record[ACTION_HEADER_LENGTH];
+        switch (record[0])
+        {
+            case ACTION_REGISTERS:
+                result = collect_registers(env);
+                break;
+            case ACTION_MEMORY:
+                base = bytes_to_value(payload, 4, 0);
+                address = bytes_to_value(&payload[4], 8, 0);
+                result = GDBS_ERROR_OK;
+                if (base != ABSOLUTE_BASE)
+                {
+                    result = proto_get_register_bytes(base, &bytes, &size);
+                    address += (result == GDBS_ERROR_OK ?
+                                bytes_to_value(bytes, size, is_little_endian()) : 0);
+                }
+                if (result == GDBS_ERROR_OK)
+                {
+                    result = proto_trace_collect_memory(address,
+                                                        bytes_to_value(&payload[12], 4, 0), 0);
+                }
+                break;
+            case ACTION_EVALUATE:
+                result = proto_agent_evaluate(payload, &value);
+                break;
+            default:
+                result = GDBS_ERROR_OK;
+                break;
+        }
+
+        if (result < 0 && env->trace_frame_length > 0)
+        {
+            GDBS_LOG("Failed to collect trace data at 0x%lx: %s\n",
+                     (unsigned long) tp->address, gdbs_error_to_string(-result));
+        }
+    }
+}
+
+/**
+ * Collect a trace frame for a tracepoint, after its condition has been checked.  Tracing stops if
+ * the trace buffer fills, or the tracepoint reaches its pass count.
+ */
+static void collect_frame
+(
+    struct environment  *env,    ///< Stub environment.
+    struct tracepoint   *tp,     ///< Tracepoint which was hit.
+    const unsigned char *data,   ///< Static trace data for the frame, or NULL if there is none.
+    unsigned int         length  ///< Length of the static trace data.
+)
+{
+    unsigned char header[FRAME_HEADER_LENGTH];
+
+    ++tp->hits;
+    env->trace_frame_length = 0;
+    if (reserve(env, FRAME_HEADER_LENGTH) == GDBS_ERROR_OK)
+    {
+        env->trace_frame_length = FRAME_HEADER_LENGTH;
+        if (data != NULL && reserve(env, MARKER_HEADER_LENGTH + length) == GDBS_ERROR_OK)
+        {
+            header[0] = BLOCK_MARKER;
+            value_to_bytes(&header[1], length, 2, is_little_endian());
+            ring_write(env, env->trace_used + env->trace_frame_length, header,
+                       MARKER_HEADER_LENGTH);
+            ring_write(env, env->trace_used + env->trace_frame_length + MARKER_HEADER_LENGTH,
+                       data, length);
+            env->trace_frame_length += MARKER_HEADER_LENGTH + length;
+        }
+        run_actions(env, tp);
+    }
+    if (env->trace_frame_length == 0)
+    {
+        stop_tracing(env, TS_FULL, 0);
+        return;
+    }
+
+    value_to_bytes(header, tp->number, 2, is_little_endian());
+    value_to_bytes(&header[2], env->trace_frame_length - FRAME_HEADER_LENGTH, 4,
+                   is_little_endian());
+    ring_write(env, env->trace_used, header, FRAME_HEADER_LENGTH);
+    env->trace_used += env->trace_frame_length;
+    env->trace_frame_length = 0;
+    ++env->trace_frame_count;
+    ++env->trace_frames_created;
+
+    if (tp->pass_count != 0 && tp->hits >= tp->pass_count)
+    {
+        stop_tracing(env, TS_PASSCOUNT, tp->number);
+    }
+}
+
+/**
+ * Collect a trace frame for each enabled tracepoint at an address whose condition holds.  Tracing
+ * stops if the trace buffer fills, or a tracepoint reaches its pass count.  The hit is dropped if
+ * it preempts the recording of a marker.
+ */
+void proto_trace_hit
+(
+    gdbs_address_t address ///< Address of the breakpoint which was hit.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct tracepoint   *tp;
+    unsigned int         i;
+
+    // The trace buffer is shared with markers, which may be recording in the interrupted context.
+    if (!GDBS_ATOMIC_CAS(&env->trace_marker_busy, 0, 1))
+    {
+        GDBS_LOG("Tracepoint hit at 0x%lx dropped\n", (unsigned long) address);
+        return;
+    }
+
+    for (i = 0; i < env->tracepoint_count && env->tracing; ++i)
+    {
+        tp = &env->tracepoints[i];
+        if (tp->address == address && tp->enabled && !tp->marker && condition_true(env, tp))
+        {
+            collect_frame(env, tp, NULL, 0);
+        }
+    }
+
+    env->trace_marker_busy = 0;
+}
+
+/**
+ * Determine whether a character of a format conversion only affects the layout of the output: a
+ * flag, the width, or the precision.
+ *
+ * @return Boolean indicating a layout character.
+ */
+static int is_layout
+(
+    char c ///< Character to check.
+)
+{
+    return ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' ||
+            c == '*');
+}
+
+/**
+ * Record the arguments of a marker, as described by its format string.  Each argument is stored in
+ * target byte order at the size it was passed with, except for strings, whose characters are
+ * stored up to and including the terminating zero.
+ *
+ * @return Length of the record.
+ */
+static unsigned int marker_record
+(
+    const char      *format, ///< [in]     Format of the arguments.
+    va_list         *args,   ///< [in,out] Arguments.
+    unsigned char   *record, ///< [out]    Record.
+    unsigned int     limit   ///< [in]     Length of the record buffer.
+)
+{
+    union
+    {
+        unsigned char    c;
+        unsigned short   h;
+        unsigned int     i;
+        unsigned long    l;
+        long long        ll;
+        size_t           z;
+        void            *p;
+        double           d;
+        long double      ld;
+    }                    value;
+    enum format_length   modifier;
+    const char          *string;
+    unsigned int         used = 0;
+    unsigned int         size;
+
+    for (; *format != '\0'; ++format)
+    {
+        if (*format != '%')
+        {
+            continue;
+        }
+
+        // Flags, width, and precision only affect the layout of the output.
+        for (++format; *format != '\0' && is_layout(*format); ++format)
+        {
+            if (*format == '*')
+            {
+                (void) va_arg(*args, int);
+            }
+        }
+
+        modifier = FL_NONE;
+        switch (*format)
+        {
+            case 'h':
+                modifier = (format[1] == 'h' ? FL_CHAR : FL_SHORT);
+                format += (modifier == FL_CHAR ? 2 : 1);
+                break;
+            case 'l':
+                modifier = (format[1] == 'l' ? FL_LONG_LONG : FL_LONG);
+                format += (modifier == FL_LONG_LONG ? 2 : 1);
+                break;
+            case 'z':
+                modifier = FL_SIZE;
+                ++format;
+                break;
+            case 'L':
+                modifier = FL_DOUBLE;
+                ++format;
+                break;
+            default:
+                break;
+        }
+
+        switch (*format)
+        {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+            case 'c':
+                switch (modifier)
+                {
+                    case FL_LONG:
+                        value.l = va_arg(*args, unsigned long);
+                        size = sizeof(value.l);
+                        break;
+                    case FL_LONG_LONG:
+                        value.ll = va_arg(*args, long long);
+                        size = sizeof(value.ll);
+                        break;
+                    case FL_SIZE:
+                        value.z = va_arg(*args, size_t);
+                        size = sizeof(value.z);
+                        break;
+                    default:
+                        value.i = va_arg(*args, unsigned int);
+                        size = sizeof(value.i);
+                        break;
+                }
+                if (*format == 'c' || modifier == FL_CHAR)
+                {
+                    value.c = (unsigned char) value.i;
+                    size = sizeof(value.c);
+                }
+                else if (modifier == FL_SHORT)
+                {
+                    value.h = (unsigned short) value.i;
+                    size = sizeof(value.h);
+                }
+                break;
+            case 'p':
+                value.p = va_arg(*args, void *);
+                size = sizeof(value.p);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (modifier == FL_DOUBLE)
+                {
+                    value.ld = va_arg(*args, long double);
+                    size = sizeof(value.ld);
+                }
+                else
+                {
+                    value.d = va_arg(*args, double);
+                    size = sizeof(value.d);
+                }
+                break;
+            case 's':
+                // Strings are cut short to fit, keeping the terminating zero.
+                string = va_arg(*args, const char *);
+                if (used == limit)
+                {
+                    return used;
+                }
+                size = (unsigned int) strlen(string);
+                size = (size < limit - used - 1 ? size : limit - used - 1);
+                memcpy(&record[used], string, size);
+                record[used + size] = '\0';
+                used += size + 1;
+                continue;
+            case '%':
+                continue;
+            default:
+                // The remaining arguments cannot be located.
+                return used;
+        }
+
+        if (size > limit - used)
+        {
+            return used;
+        }
+        memcpy(&record[used], &value, size);
+        used += size;
+    }
+
+    return used;
+}
+
+/**
+ * Record the arguments of an enabled static tracepoint marker.  Use GDBS_TRACE_MARKER() rather than
+ * calling this directly.  Records are dropped while the stub is active, or while another marker is
+ * being recorded.
+ */
+void gdbs_trace_marker
+(
+    struct gdbs_marker  *marker, ///< Marker which was reached.
+    const char          *format, ///< Format of the arguments, as for the marker.
+    ...                          ///< Marker arguments.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct tracepoint   *tp;
+    unsigned char        record[GDBS_TRACE_MARKER_RECORD_LENGTH];
+    unsigned int         length;
+    unsigned int         i;
+    va_list              args;
+
+    // The stub owns the trace buffer while it is active, and markers reached from contexts which
+    // preempt each other take turns, dropping the records which would collide.
+    if (env->packet_buffer != NULL || !GDBS_ATOMIC_CAS(&env->trace_marker_busy, 0, 1))
+    {
+        return;
+    }
+
+    va_start(args, format);
+    length = marker_record(format, &args, record, sizeof(record));
+    va_end(args);
+
+    for (i = 0; i < env->tracepoint_count && env->tracing; ++i)
+    {
+        tp = &env->tracepoints[i];
+        if (tp->address == (gdbs_address_t) marker && tp->enabled && tp->marker &&
+            condition_true(env, tp))
+        {
+            collect_frame(env, tp, record, length);
+        }
+    }
+
+    env->trace_marker_busy = 0;
+}
+
+/**
+ * Read memory recorded in the selected trace frame.  The read stops short at the first byte which
+ * the frame does not hold.
+ *
+ * @return Number of bytes read.
+ * @retval -GDBS_ERROR_NOT_FOUND    The frame does not hold the first byte.
+ */
+int proto_trace_read_memory
+(
+    gdbs_address_t   address, ///< [in]  First address to read.
+    unsigned char   *data,    ///< [out] Memory contents.
+    gdbs_address_t   length   ///< [in]  Number of bytes to read.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       number;
+    gdbs_address_t       block_address;
+    gdbs_address_t       block_length;
+    gdbs_address_t       done = 0;
+    gdbs_address_t       skip;
+    gdbs_address_t       size;
+    unsigned int         start = env->trace_selected_offset + FRAME_HEADER_LENGTH;
+    unsigned int         end;
+    unsigned int         position;
+    unsigned char        tag;
+
+    if (!env->trace_selected)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    // Blocks may cover the range piecemeal, so search again from the first byte not yet found.
+    end = env->trace_selected_offset + frame_header(env, env->trace_selected_offset, &number);
+    for (position = start; position < end && done < length;)
+    {
+        position += block_header(env, position, &tag, &block_address, &block_length);
+        skip = address + done - block_address;
+        if (tag == BLOCK_MEMORY && skip < block_length)
+        {
+            size = block_length - skip;
+            size = (size < length - done ? size : length - done);
+            ring_read(env, (unsigned int) (position - block_length + skip), &data[done],
+                      (unsigned int) size);
+            done += size;
+            position = start;
+        }
+    }
+
+    return (done > 0 ? (int) done : -GDBS_ERROR_NOT_FOUND);
+}
+
+/**
+ * Handle the 'QTinit' command, which stops any tracing and discards every tracepoint.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_init
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment *env = core_get_environment();
+
+    (void) tokenizer;
+
+    if (env->tracing)
+    {
+        stop_tracing(env, TS_STOP, 0);
+    }
+    env->tracepoint_count = 0;
+    env->trace_actions_used = 0;
+    return proto_send_ok();
+}
+
+/**
+ * Advance to the next colon separated field of a 'QTDP' command.  The hyphen which ends a command
+ * with more to follow is stripped from the last field.
+ *
+ * @retval 0                        Field available.
+ * @retval -GDBS_ERROR_NOT_FOUND    Field available, and it is the last.
+ * @retval -GDBS_ERROR_EOB          No fields remain.
+ */
+static int next_field
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer for the command.
+    const unsigned char    **token,     ///< [out] Start of the field.
+    size_t                  *length     ///< [out] Length of the field.
+)
+{
+    int result = packet_tokenizer_advance(tokenizer, ':', token, length);
+
+    if (result == -GDBS_ERROR_NOT_FOUND && *length > 0 && (*token)[*length - 1] == '-')
+    {
+        --*length;
+    }
+    return result;
+}
+
+/**
+ * Advance to the next field of a 'QTDP' command, and convert it from hexadecimal.
+ *
+ * @retval 0                        Value converted.
+ * @retval -GDBS_ERROR_NOT_FOUND    Value converted, and it is the last field.
+ * @retval -GDBS_ERROR_INVALID      No fields remain, or the field is not a valid value.
+ */
+static int next_unsigned
+(
+    struct packet_tokenizer *tokenizer, ///< [in]  Tokenizer for the command.
+    gdbs_address_t          *value      ///< [out] Converted value.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    int                  result = next_field(tokenizer, &token, &length);
+
+    if (result == -GDBS_ERROR_EOB || length == 0 ||
+        hex_string_to_unsigned((const char *) token, length, value) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    return result;
+}
+
+/**
+ * Determine whether a character is a hexadecimal digit.
+ *
+ * @return Boolean indicating a hexadecimal digit.
+ */
+static int is_hex_digit
+(
+    unsigned char c ///< Character to check.
+)
+{
+    return ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'));
+}
+
+/**
+ * Convert a run of hexadecimal digits within an action list.  Values wider than gdbs_address_t
+ * are truncated, so that offsets given as large unsigned values wrap around as intended.
+ *
+ * @retval 0                    Value converted.
+ * @retval -GDBS_ERROR_INVALID  There are no digits.
+ */
+static int scan_hex
+(
+    const unsigned char *text,   ///< [in]     Action list.
+    size_t               length, ///< [in]     Length of the list.
+    size_t              *i,      ///< [in,out] Position of the digits, advanced past them.
+    gdbs_address_t      *value   ///< [out]    Converted value.
+)
+{
+    size_t start = *i;
+
+    for (; *i < length && is_hex_digit(text[*i]); ++*i)
+    {
+    }
+    if (*i == start)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (*i - start > sizeof(*value) * 2)
+    {
+        start = *i - sizeof(*value) * 2;
+    }
+    return hex_string_to_unsigned((const char *) &text[start], *i - start, value);
+}
+
+/**
+ * Add a record to the free space at the end of the trace action pool.  Staged records only become
+ * part of the pool once the command which defines them has been fully decoded.
+ *
+ * @return Location for the record contents, or NULL if the pool is full.
+ */
+static unsigned char *stage_record
+(
+    struct environment  *env,    ///< [in]     Stub environment.
+    unsigned char        tag,    ///< [in]     Record tag.
+    size_t               size,   ///< [in]     Length of the record contents.
+    size_t              *staged  ///< [in,out] Number of bytes staged beyond the used part of the
+                                 ///<          pool.
+)
+{
+    unsigned char *record = &env->trace_actions[env->trace_actions_used + *staged];
+
+    if (GDBS_TRACE_ACTION_LENGTH - env->trace_actions_used - *staged < ACTION_HEADER_LENGTH + size)
+    {
+        return NULL;
+    }
+
+    record[0] = tag;
+    record[1] = (unsigned char) (size >> 8);
+    record[2] = (unsigned char) size;
+    *staged += ACTION_HEADER_LENGTH + size;
+    return &record[ACTION_HEADER_LENGTH];
+}
+
+/**
+ * Decode an agent expression, given as "X<length>,<bytecode>", into the trace action pool.
+ *
+ * @retval 0                        Expression staged.
+ * @retval -GDBS_ERROR_INVALID      The expression is malformed, or failed validation.
+ * @retval -GDBS_ERROR_RESOURCES    The trace action pool is full.
+ */
+static int stage_expression
+(
+    struct environment  *env,    ///< [in]     Stub environment.
+    unsigned char        tag,    ///< [in]     Record tag for the expression.
+    const unsigned char *text,   ///< [in]     Action list.
+    size_t               length, ///< [in]     Length of the list.
+    size_t              *i,      ///< [in,out] Position of the expression, advanced past it.
+    size_t              *staged  ///< [in,out] Number of bytes staged beyond the used part of the
+                                 ///<          pool.
+)
+{
+    unsigned char   *record;
+    gdbs_address_t   size;
+
+    ++*i;
+    if (scan_hex(text, length, i, &size) < 0 || *i == length || text[(*i)++] != ',' ||
+        size == 0 || size > GDBS_AGENT_BYTECODE_LENGTH || (length - *i) / 2 < size)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    record = stage_record(env, tag, (size_t) size, staged);
+    if (record == NULL)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+    if (hex_string_to_bytes((const char *) &text[*i], (size_t) size * 2, record) < 0 ||
+        proto_agent_validate(record, (size_t) size) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    *i += (size_t) size * 2;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Decode a memory range, given as "M<base register>,<offset>,<length>", into the trace action
+ * pool.  The base register is -1 for an absolute address.
+ *
+ * @retval 0                        Range staged.
+ * @retval -GDBS_ERROR_INVALID      The range is malformed.
+ * @retval -GDBS_ERROR_RESOURCES    The trace action pool is full.
+ */
+static int stage_memory
+(
+    struct environment  *env,    ///< [in]     Stub environment.
+    const unsigned char *text,   ///< [in]     Action list.
+    size_t               length, ///< [in]     Length of the list.
+    size_t              *i,      ///< [in,out] Position of the range, advanced past it.
+    size_t              *staged  ///< [in,out] Number of bytes staged beyond the used part of the
+                                 ///<          pool.
+)
+{
+    unsigned char   *record;
+    gdbs_address_t   base = ABSOLUTE_BASE;
+    gdbs_address_t   offset;
+    gdbs_address_t   size;
+
+    ++*i;
+    if (length - *i >= 2 && text[*i] == '-' && text[*i + 1] == '1')
+    {
+        *i += 2;
+    }
+    else if (scan_hex(text, length, i, &base) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    if (*i == length || text[(*i)++] != ',' || scan_hex(text, length, i, &offset) < 0 ||
+        *i == length || text[(*i)++] != ',' || scan_hex(text, length, i, &size) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    record = stage_record(env, ACTION_MEMORY, MEMORY_ACTION_LENGTH, staged);
+    if (record == NULL)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+    value_to_bytes(record, base, 4, 0);
+    value_to_bytes(&record[4], offset, 8, 0);
+    value_to_bytes(&record[12], size, 4, 0);
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Decode a list of collection actions into the trace action pool.  While-stepping actions, which
+ * are not supported, are skipped along with every action after them.
+ *
+ * @retval 0                        Actions staged.
+ * @retval -GDBS_ERROR_INVALID      The list is malformed.
+ * @retval -GDBS_ERROR_RESOURCES    The trace action pool is full.
+ */
+static int stage_actions
+(
+    struct environment  *env,    ///< [in]     Stub environment.
+    struct tracepoint   *tp,     ///< [in,out] Tracepoint receiving the actions.
+    const unsigned char *text,   ///< [in]     Action list.
+    size_t               length, ///< [in]     Length of the list.
+    size_t              *staged  ///< [out]    Number of bytes staged beyond the used part of the
+                                 ///<          pool.
+)
+{
+    gdbs_address_t   mask;
+    size_t           i = 0;
+    int              result = GDBS_ERROR_OK;
+
+    *staged = 0;
+    while (i < length && !tp->stepping && result == GDBS_ERROR_OK)
+    {
+        switch (text[i])
+        {
+            case 'R':
+                // The register mask is ignored, as the whole register frame is collected.
+                ++i;
+                result = scan_hex(text, length, &i, &mask);
+                if (result == GDBS_ERROR_OK &&
+                    stage_record(env, ACTION_REGISTERS, 0, staged) == NULL)
+                {
+                    result = -GDBS_ERROR_RESOURCES;
+                }
+                break;
+            case 'M':
+                result = stage_memory(env, text, length, &i, staged);
+                break;
+            case 'X':
+                result = stage_expression(env, ACTION_EVALUATE, text, length, &i, staged);
+                break;
+            case 'S':
+                tp->stepping = 1;
+                break;
+            default:
+                result = -GDBS_ERROR_INVALID;
+                break;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Add collection actions from a 'QTDP' continuation command to the tracepoint defined last.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int define_actions
+(
+    struct environment      *env,      ///< Stub environment.
+    struct packet_tokenizer *tokenizer, ///< Tokenizer positioned after the tracepoint number.
+    gdbs_address_t           number    ///< Tracepoint number.
+)
+{
+    struct tracepoint   *tp;
+    const unsigned char *token;
+    size_t               length;
+    size_t               staged = 0;
+    gdbs_address_t       address;
+    int                  result;
+
+    if (next_unsigned(tokenizer, &address) != GDBS_ERROR_OK || env->tracepoint_count == 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    tp = &env->tracepoints[env->tracepoint_count - 1];
+    if (tp->number != number || tp->address != address)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    if (next_field(tokenizer, &token, &length) != -GDBS_ERROR_EOB)
+    {
+        result = stage_actions(env, tp, token, length, &staged);
+        if (result < 0)
+        {
+            return result;
+        }
+    }
+
+    // The tracepoint defined last owns the end of the pool, so its actions simply grow.
+    tp->actions_length = (unsigned short) (tp->actions_length + staged);
+    env->trace_actions_used += (unsigned int) staged;
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'QTDP' command, which defines a tracepoint, or adds collection actions to the
+ * tracepoint defined last.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_define
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct tracepoint   *tp = &env->tracepoints[env->tracepoint_count];
+    const unsigned char *token;
+    size_t               length;
+    size_t               staged = 0;
+    size_t               i;
+    gdbs_address_t       number;
+    gdbs_address_t       address;
+    gdbs_address_t       step;
+    gdbs_address_t       pass;
+    unsigned char        enabled;
+    size_t               continued;
+    int                  result;
+
+    // A leading hyphen on the number marks a command which continues the last definition.
+    result = next_field(tokenizer, &token, &length);
+    continued = (result == GDBS_ERROR_OK && length > 0 && token[0] == '-');
+    if (result != GDBS_ERROR_OK || length == continued ||
+        hex_string_to_unsigned((const char *) &token[continued], length - continued,
+                               &number) < 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (continued)
+    {
+        return define_actions(env, tokenizer, number);
+    }
+
+    if (next_unsigned(tokenizer, &address) != GDBS_ERROR_OK ||
+        next_field(tokenizer, &token, &length) != GDBS_ERROR_OK || length != 1 ||
+        (token[0] != 'E' && token[0] != 'D') ||
+        next_unsigned(tokenizer, &step) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    enabled = (token[0] == 'E');
+    result = next_unsigned(tokenizer, &pass);
+    if (result == -GDBS_ERROR_INVALID)
+    {
+        return result;
+    }
+    if (env->tracepoint_count >= GDBS_TRACEPOINT_COUNT)
+    {
+        return -GDBS_ERROR_RESOURCES;
+    }
+
+    // Only the condition and the static tracepoint flag matter here.  Fast tracepoints are served
+    // by breakpoints instead.
+    tp->marker = 0;
+    while (result == GDBS_ERROR_OK)
+    {
+        result = next_field(tokenizer, &token, &length);
+        if (result != -GDBS_ERROR_EOB && length == 1 && token[0] == 'S')
+        {
+            tp->marker = 1;
+        }
+        else if (result != -GDBS_ERROR_EOB && length > 0 && token[0] == 'X')
+        {
+            i = 0;
+            if (stage_expression(env, ACTION_CONDITION, token, length, &i, &staged) < 0 ||
+                i != length)
+            {
+                return -GDBS_ERROR_INVALID;
+            }
+        }
+    }
+
+    tp->address = address;
+    tp->pass_count = pass;
+    tp->hits = 0;
+    tp->number = (unsigned short) number;
+    tp->actions = (unsigned short) env->trace_actions_used;
+    tp->actions_length = (unsigned short) staged;
+    tp->enabled = enabled;
+    tp->stepping = 0;
+    env->trace_actions_used += (unsigned int) staged;
+    ++env->tracepoint_count;
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'QTStart' command, which empties the trace buffer and starts tracing.  The breakpoints
+ * for the enabled tracepoints are inserted when the target resumes, and the markers for enabled
+ * static tracepoints are enabled.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_start
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct tracepoint   *tp;
+    struct gdbs_marker  *marker;
+    unsigned int         i;
+    int                  result = GDBS_ERROR_OK;
+
+    (void) tokenizer;
+
+    proto_clear_trace_breakpoints();
+    disable_markers();
+    deselect_frame(env);
+    env->trace_head = 0;
+    env->trace_used = 0;
+    env->trace_frame_count = 0;
+    env->trace_frames_created = 0;
+    env->trace_frame_length = 0;
+
+    for (i = 0; i < env->tracepoint_count && result == GDBS_ERROR_OK; ++i)
+    {
+        tp = &env->tracepoints[i];
+        tp->hits = 0;
+        if (tp->enabled && tp->marker)
+        {
+            marker = find_marker(tp->address);
+            result = (marker != NULL ? GDBS_ERROR_OK : -GDBS_ERROR_NOT_FOUND);
+            if (marker != NULL)
+            {
+                marker->enabled = 1;
+            }
+        }
+        else if (tp->enabled)
+        {
+            result = proto_insert_trace_breakpoint(tp->address);
+        }
+    }
+    if (result < 0)
+    {
+        proto_clear_trace_breakpoints();
+        disable_markers();
+        return result;
+    }
+
+    env->tracing = 1;
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'QTStop' command, which stops tracing.  The trace frames collected are kept.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_stop
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment *env = core_get_environment();
+
+    (void) tokenizer;
+
+    if (env->tracing)
+    {
+        stop_tracing(env, TS_STOP, 0);
+    }
+    return proto_send_ok();
+}
+
+/**
+ * Handle the 'qTStatus' query, which reports whether tracing is running and how full the trace
+ * buffer is.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_status
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    static const char *const reasons[] = { ";tnotrun:", ";tstop:", ";tfull:", ";tpasscount:" };
+    static const char *const names[] =
+    {
+        ";tframes:", ";tcreated:", ";tfree:", ";tsize:", ";circular:", ";disconn:"
+    };
+    struct environment  *env = core_get_environment();
+    struct packet_writer packet;
+    gdbs_address_t       values[sizeof(names) / sizeof(names[0])];
+    unsigned int         i;
+    int                  result;
+
+    (void) tokenizer;
+
+    values[0] = env->trace_frame_count;
+    values[1] = env->trace_frames_created;
+    values[2] = GDBS_TRACE_BUFFER_LENGTH - env->trace_used;
+    values[3] = GDBS_TRACE_BUFFER_LENGTH;
+    values[4] = (env->trace_circular != 0);
+    values[5] = 0;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push_buffer(&packet,
+                                       (const unsigned char *) (env->tracing ? "T1" : "T0"), 2);
+    if (result == GDBS_ERROR_OK && !env->tracing)
+    {
+        result = packet_writer_push_buffer(&packet,
+                                           (const unsigned char *) reasons[env->trace_stop_reason],
+                                           strlen(reasons[env->trace_stop_reason]));
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, env->trace_stop_tracepoint);
+        }
+    }
+    for (i = 0; i < sizeof(names) / sizeof(names[0]) && result == GDBS_ERROR_OK; ++i)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) names[i],
+                                           strlen(names[i]));
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, values[i]);
+        }
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Select a trace frame, loading its registers.  Registers which the frame does not hold read as
+ * zero, apart from the program counter, which is the address of the tracepoint.
+ *
+ * @retval 0                        Frame selected.
+ * @retval -GDBS_ERROR_RESOURCES    The register frame does not fit GDBS_REGISTER_FRAME_LENGTH.
+ */
+static int select_frame
+(
+    struct environment  *env,    ///< Stub environment.
+    unsigned int         frame,  ///< Frame number.
+    unsigned int         offset  ///< Position of the frame.
+)
+{
+    const struct gdbs_register  *reg;
+    unsigned int                 position = find_registers(env, offset);
+    unsigned int                 i;
+
+    if (env->register_frame_length > GDBS_REGISTER_FRAME_LENGTH)
+    {
+        GDBS_LOG("Register frame exceeds GDBS_REGISTER_FRAME_LENGTH\n");
+        return -GDBS_ERROR_RESOURCES;
+    }
+
+    memset(env->trace_registers, 0, sizeof(env->trace_registers));
+    if (position != 0)
+    {
+        for (i = 0; i < env->register_count; ++i)
+        {
+            reg = &env->registers[i];
+            ring_read(env, position, &env->trace_registers[reg->offset], reg->size);
+            position += reg->size;
+        }
+    }
+    else if (env->pc_register != NULL)
+    {
+        reg = env->pc_register;
+        value_to_bytes(&env->trace_registers[reg->offset], frame_address(env, offset), reg->size,
+                       is_little_endian());
+    }
+
+    env->trace_selected = 1;
+    env->trace_selected_frame = frame;
+    env->trace_selected_offset = offset;
+    env->general_thread = env->stop.thread;
+    env->general_frame = env->trace_registers;
+    env->general_context = NULL;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Handle the 'QTFrame' command, which selects a trace frame for inspection.  While a frame is
+ * selected, registers and memory are read from the frame instead of the target.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_select_frame
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    const unsigned char     *token;
+    size_t                   length;
+    enum frame_search        search;
+    gdbs_address_t           low = 0;
+    gdbs_address_t           high = 0;
+    gdbs_address_t           number;
+    gdbs_address_t           address;
+    unsigned int             first;
+    unsigned int             frame;
+    unsigned int             offset;
+    unsigned int             frame_length;
+    int                      match = 0;
+    int                      result;
+
+    result = packet_tokenizer_advance(tokenizer, ':', &token, &length);
+    if (result == -GDBS_ERROR_NOT_FOUND)
+    {
+        search = FS_NUMBER;
+        result = (length > 0 ? hex_string_to_unsigned((const char *) token, length, &low) :
+                  -GDBS_ERROR_INVALID);
+    }
+    else if (result == GDBS_ERROR_OK && (TOKEN_IS(token, length, "pc") ||
+                                         TOKEN_IS(token, length, "tdp")))
+    {
+        search = (token[0] == 'p' ? FS_INSIDE : FS_TRACEPOINT);
+        result = packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &low);
+        high = low;
+    }
+    else if (result == GDBS_ERROR_OK && (TOKEN_IS(token, length, "range") ||
+                                         TOKEN_IS(token, length, "outside")))
+    {
+        search = (token[0] == 'r' ? FS_INSIDE : FS_OUTSIDE);
+        result = packet_tokenizer_advance_unsigned(tokenizer, ':', &low);
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &high);
+        }
+    }
+    else
+    {
+        result = -GDBS_ERROR_INVALID;
+    }
+    if (result != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    // Searches carry on from the selected frame.
+    first = (search != FS_NUMBER && env->trace_selected ? env->trace_selected_frame + 1 : 0);
+    for (frame = 0, offset = 0; frame < env->trace_frame_count; ++frame, offset += frame_length)
+    {
+        frame_length = frame_header(env, offset, &number);
+        if (frame < first)
+        {
+            continue;
+        }
+        switch (search)
+        {
+            case FS_NUMBER:
+                match = (frame == low);
+                break;
+            case FS_TRACEPOINT:
+                match = (number == low);
+                break;
+            default:
+                address = frame_address(env, offset);
+                match = ((address >= low && address <= high) == (search == FS_INSIDE));
+                break;
+        }
+        if (match)
+        {
+            break;
+        }
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    if (!match)
+    {
+        deselect_frame(env);
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) "F-1", 3);
+    }
+    else
+    {
+        result = select_frame(env, frame, offset);
+        if (result < 0)
+        {
+            return result;
+        }
+        result = packet_writer_push(&packet, 'F');
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, frame);
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push(&packet, 'T');
+        }
+        if (result == GDBS_ERROR_OK)
+        {
+            result = packet_writer_push_unsigned(&packet, number);
+        }
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qTBuffer' query, which reads the raw contents of the trace buffer, from the oldest
+ * frame onwards.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_read_buffer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    gdbs_address_t           offset;
+    gdbs_address_t           length;
+    unsigned char           *data;
+    int                      result;
+
+    assert(env->packet_buffer != NULL);
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, ',', &offset) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    if (offset >= env->trace_used || length == 0)
+    {
+        result = packet_writer_push(&packet, 'l');
+    }
+    else
+    {
+        length = (length < env->trace_used - offset ? length : env->trace_used - offset);
+        length = (length < READ_LIMIT ? length : READ_LIMIT);
+        data = &env->packet_buffer[GDBS_PACKET_BUFFER_LENGTH - READ_LIMIT];
+        ring_read(env, (unsigned int) offset, data, (unsigned int) length);
+        result = packet_writer_push_hex(&packet, data, (size_t) length);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'QTBuffer' command, which configures the trace buffer.  Only the circular setting is
+ * supported, as the buffer is statically allocated.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_set_buffer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+)
+{
+    const unsigned char *token;
+    size_t               length;
+    gdbs_address_t       circular;
+
+    if (packet_tokenizer_advance(tokenizer, ':', &token, &length) != GDBS_ERROR_OK ||
+        !TOKEN_IS(token, length, "circular"))
+    {
+        return proto_send_empty();
+    }
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &circular) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    core_get_environment()->trace_circular = (circular != 0);
+    return proto_send_ok();
+}
+
+/**
+ * Count the hexadecimal digits needed to write a value without leading zeros.
+ *
+ * @return Number of digits.
+ */
+static unsigned int hex_digits
+(
+    gdbs_address_t value ///< Value to measure.
+)
+{
+    unsigned int digits = 1;
+
+    while ((value >>= 4) != 0)
+    {
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * Add the definition of a marker to a reply, as its address, then its name and format as
+ * hexadecimal encoded strings, separated by colons.
+ *
+ * @retval 0    Definition added.
+ * @retval <0   The definition could not be added.  The exact value will be a negative
+ *              enum gdbs_error entry indicating what went wrong.
+ */
+static int push_marker
+(
+    struct packet_writer        *packet, ///< Reply being written.
+    const struct gdbs_marker    *marker  ///< Marker to describe.
+)
+{
+    int result = packet_writer_push_unsigned(packet, (gdbs_address_t) marker);
+
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push(packet, ':');
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(packet, (const unsigned char *) marker->id,
+                                        strlen(marker->id));
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push(packet, ':');
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_push_hex(packet, (const unsigned char *) marker->format,
+                                        strlen(marker->format));
+    }
+    return result;
+}
+
+/**
+ * Send the next part of the marker list, continuing from the marker list cursor.  As many marker
+ * definitions are sent as fit within the reply packet.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int send_marker_list(void)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    const struct gdbs_marker *marker;
+    size_t                   used = 0;
+    size_t                   length;
+    int                      result = GDBS_ERROR_OK;
+    int                      first = 1;
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    for (marker = MARKERS_START + env->trace_marker_cursor;
+         marker < MARKERS_END && result == GDBS_ERROR_OK; ++marker)
+    {
+        // Each definition is preceded by 'm' for the first, or a comma.
+        length = hex_digits((gdbs_address_t) marker) + 3 +
+                 (strlen(marker->id) + strlen(marker->format)) * 2;
+        if (length > REPLY_LIMIT)
+        {
+            GDBS_LOG("Marker %s cannot be listed\n", marker->id);
+            ++env->trace_marker_cursor;
+            continue;
+        }
+        used += length;
+        if (used > REPLY_LIMIT)
+        {
+            break;
+        }
+
+        result = packet_writer_push(&packet, (unsigned char) (first ? 'm' : ','));
+        if (result == GDBS_ERROR_OK)
+        {
+            result = push_marker(&packet, marker);
+        }
+        ++env->trace_marker_cursor;
+        first = 0;
+    }
+
+    // Nothing left to send marks the end of the list.
+    if (result == GDBS_ERROR_OK && first)
+    {
+        result = packet_writer_push(&packet, 'l');
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qTfSTM' query, which starts listing the static tracepoint markers.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_list_first
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    (void) tokenizer;
+
+    core_get_environment()->trace_marker_cursor = 0;
+    return send_marker_list();
+}
+
+/**
+ * Handle the 'qTsSTM' query, which continues listing the static tracepoint markers.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_list_next
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    (void) tokenizer;
+
+    return send_marker_list();
+}
+
+/**
+ * Handle the 'qTSTMat' query, which describes the static tracepoint marker at an address.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_at
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    struct environment  *env = core_get_environment();
+    struct packet_writer packet;
+    struct gdbs_marker  *marker;
+    gdbs_address_t       address;
+    int                  result;
+
+    if (packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &address) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+
+    marker = find_marker(address);
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push(&packet, (unsigned char) (marker != NULL ? 'm' : 'l'));
+    if (result == GDBS_ERROR_OK && marker != NULL)
+    {
+        result = push_marker(&packet, marker);
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Read a window of the static trace data of the selected trace frame for
+ * 'qXfer:statictrace:read'.  The data holds the arguments of the marker which collected the frame.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the data.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given, or no trace frame is selected.
+ */
+int proto_xfer_static_trace
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the data of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+)
+{
+    struct environment  *env = core_get_environment();
+    gdbs_address_t       number;
+    gdbs_address_t       block_address;
+    gdbs_address_t       block_length;
+    gdbs_address_t       size;
+    unsigned int         end;
+    unsigned int         position;
+    unsigned int         skip;
+    unsigned char        tag;
+
+    (void) annex;
+
+    if (annex_length != 0 || !env->trace_selected)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    end = env->trace_selected_offset + frame_header(env, env->trace_selected_offset, &number);
+    for (position = env->trace_selected_offset + FRAME_HEADER_LENGTH; position < end;
+         position += skip)
+    {
+        skip = block_header(env, position, &tag, &block_address, &block_length);
+        if (tag == BLOCK_MARKER)
+        {
+            size = skip - MARKER_HEADER_LENGTH;
+            size = (offset < size ? size - offset : 0);
+            size = (size < length ? size : length);
+            ring_read(env, (unsigned int) (position + MARKER_HEADER_LENGTH + offset), data,
+                      (unsigned int) size);
+            return (int) size;
+        }
+    }
+    return 0;
+}
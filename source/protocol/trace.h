@@ -0,0 +1,214 @@
+/**
+ *  @file       trace.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Tracepoint commands for the GDB protocol.
+ */
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "gdbsconfig.h"
+#include "gdbsdevice.h"
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'QTinit' command, which stops any tracing and discards every tracepoint.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_init
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'QTDP' command, which defines a tracepoint, or adds collection actions to the
+ * tracepoint defined last.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_define
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'QTStart' command, which empties the trace buffer and starts tracing.  The breakpoints
+ * for the enabled tracepoints are inserted when the target resumes.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_start
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'QTStop' command, which stops tracing.  The trace frames collected are kept.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_stop
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'qTStatus' query, which reports whether tracing is running and how full the trace
+ * buffer is.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_status
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'QTFrame' command, which selects a trace frame for inspection.  While a frame is
+ * selected, registers and memory are read from the frame instead of the target.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_select_frame
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Handle the 'qTBuffer' query, which reads the raw contents of the trace buffer, from the oldest
+ * frame onwards.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_read_buffer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'QTBuffer' command, which configures the trace buffer.  Only the circular setting is
+ * supported, as the buffer is statically allocated.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_set_buffer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the command name.
+);
+
+/**
+ * Collect a trace frame for each enabled tracepoint at an address whose condition holds.  Tracing
+ * stops if the trace buffer fills, or a tracepoint reaches its pass count.  The hit is dropped if
+ * it preempts the recording of a marker.
+ */
+void proto_trace_hit
+(
+    gdbs_address_t address ///< Address of the breakpoint which was hit.
+);
+
+/**
+ * Record a block of target memory in the trace frame being collected.  The block is only added to
+ * the frame once it has been read completely.  Nothing is recorded when no frame is being
+ * collected.
+ *
+ * @retval 0                        Memory recorded, or no frame is being collected.
+ * @retval -GDBS_ERROR_RESOURCES    The trace buffer is full.
+ * @retval <0                       The memory could not be read.  The exact value will be a
+ *                                  negative enum gdbs_error entry indicating what went wrong.
+ */
+int proto_trace_collect_memory
+(
+    gdbs_address_t   address,   ///< First address of the block.
+    gdbs_address_t   length,    ///< Length of the block.  Limited to 65535 bytes.
+    int              until_zero ///< Boolean indicating that the block ends early after the first
+                                ///< zero byte.
+);
+
+/**
+ * Read memory recorded in the selected trace frame.  The read stops short at the first byte which
+ * the frame does not hold.
+ *
+ * @return Number of bytes read.
+ * @retval -GDBS_ERROR_NOT_FOUND    The frame does not hold the first byte.
+ */
+int proto_trace_read_memory
+(
+    gdbs_address_t   address, ///< [in]  First address to read.
+    unsigned char   *data,    ///< [out] Memory contents.
+    gdbs_address_t   length   ///< [in]  Number of bytes to read.
+);
+
+/**
+ * Handle the 'qTfSTM' query, which starts listing the static tracepoint markers.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_list_first
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qTsSTM' query, which continues listing the static tracepoint markers.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_list_next
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Handle the 'qTSTMat' query, which describes the static tracepoint marker at an address.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_trace_marker_at
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+/**
+ * Read a window of the static trace data of the selected trace frame for
+ * 'qXfer:statictrace:read'.  The data holds the arguments of the marker which collected the frame.
+ *
+ * @return Number of bytes read, which is less than requested only at the end of the data.
+ * @retval -GDBS_ERROR_NOT_FOUND An annex was given, or no trace frame is selected.
+ */
+int proto_xfer_static_trace
+(
+    const unsigned char *annex,        ///< [in]  Annex naming a part of the object.
+    size_t               annex_length, ///< [in]  Length of the annex.
+    gdbs_address_t       offset,       ///< [in]  Offset within the data of the window.
+    unsigned char       *data,         ///< [out] Window data.
+    size_t               length        ///< [in]  Length of the window.
+);
+
+#endif /* end TRACE_H_ */
@@ -0,0 +1,179 @@
+/**
+ *  @file       xfer.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Object transfers for the GDB protocol.
+ *
+ *  Each object is produced by a read function which fills a window of the object on demand, so
+ *  objects never need to be held in memory as a whole.  The window is staged in the packet buffer
+ *  and sent with binary encoding.
+ */
+#include "gdbsconfig.h"
+#include "gdbstub.h"
+
+#include "xfer.h"
+
+#include "auxiliary/binary.h"
+#include "core.h"
+#include "protocol/features.h"
+#include "protocol/flash.h"
+#include "protocol/response.h"
+#include "protocol/threads.h"
+#include "protocol/trace.h"
+#include "stdc/assert.h"
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+
+/// Longest reply payload, matching the packet size reported to GDB.
+#define REPLY_LIMIT (GDBS_PACKET_BUFFER_LENGTH - 4)
+
+/// Longest annex accepted.
+#define ANNEX_LENGTH 32
+
+/// Description of an object which can be read with 'qXfer'.
+struct xfer_object
+{
+    const char  *name;                                   ///< Object name.
+    size_t       length;                                 ///< Length of the name.
+    int        (*read)(const unsigned char *, size_t,
+                       gdbs_address_t, unsigned char *,
+                       size_t);                          ///< Read function, as for
+                                                         ///< proto_xfer_threads().
+};
+
+/// Define an object table entry.
+#define XFER_OBJECT(n, r) { (n), sizeof(n) - 1, (r) }
+
+/// Objects which can be read.
+static const struct xfer_object objects[] =
+{
+    XFER_OBJECT("features", proto_xfer_features),
+    XFER_OBJECT("memory-map", proto_xfer_memory_map),
+    XFER_OBJECT("statictrace", proto_xfer_static_trace),
+    XFER_OBJECT("threads", proto_xfer_threads),
+};
+
+/**
+ * Send a window of object data, binary encoded.  The window is cut short if its encoding would not
+ * fit within the reply packet.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+static int send_window
+(
+    const unsigned char *data,   ///< Object data.
+    size_t               length, ///< Length of the object data.
+    int                  last    ///< Boolean indicating that the data reaches the end of the
+                                 ///< object.
+)
+{
+    struct environment      *env = core_get_environment();
+    struct packet_writer     packet;
+    char                     encoded[2];
+    size_t                   used = 1;
+    size_t                   count;
+    size_t                   i;
+    int                      result;
+
+    // Measure the encoded window first, as the prefix says whether it reaches the end.
+    for (count = 0; count < length; ++count)
+    {
+        used += binary_encode(encoded, data[count]);
+        if (used > REPLY_LIMIT)
+        {
+            last = 0;
+            break;
+        }
+    }
+
+    packet_writer_init(&packet, PT_MESSAGE, env->comm);
+    result = packet_writer_push(&packet, (unsigned char) (last ? 'l' : 'm'));
+    for (i = 0; i < count && result == GDBS_ERROR_OK; ++i)
+    {
+        result = packet_writer_push_buffer(&packet, (const unsigned char *) encoded,
+                                           binary_encode(encoded, data[i]));
+    }
+    if (result == GDBS_ERROR_OK)
+    {
+        result = packet_writer_finish(&packet);
+    }
+    return result;
+}
+
+/**
+ * Handle the 'qXfer' query, which reads a window of a named object such as the thread list.
+ * Objects and operations which are not recognized are answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_xfer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+)
+{
+    struct environment          *env = core_get_environment();
+    const struct xfer_object    *object = NULL;
+    const unsigned char         *name;
+    size_t                       name_length;
+    const unsigned char         *token;
+    size_t                       length;
+    unsigned char                annex[ANNEX_LENGTH];
+    size_t                       annex_length;
+    gdbs_address_t               offset;
+    gdbs_address_t               window;
+    size_t                       i;
+    int                          result;
+
+    assert(env->packet_buffer != NULL);
+
+    if (packet_tokenizer_advance(tokenizer, ':', &name, &name_length) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance(tokenizer, ':', &token, &length) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    for (i = 0; i < sizeof(objects) / sizeof(objects[0]); ++i)
+    {
+        if (name_length == objects[i].length && memcmp(name, objects[i].name, name_length) == 0)
+        {
+            object = &objects[i];
+        }
+    }
+    if (object == NULL || length != 4 || memcmp(token, "read", 4) != 0)
+    {
+        GDBS_LOG("Unsupported transfer: '%.*s'\n", (int) name_length, (const char *) name);
+        return proto_send_empty();
+    }
+
+    if (packet_tokenizer_advance(tokenizer, ':', &token, &length) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, ',', &offset) != GDBS_ERROR_OK ||
+        packet_tokenizer_advance_unsigned(tokenizer, TOKEN_EOB, &window) != GDBS_ERROR_OK)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    if (length > sizeof(annex))
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+
+    // The annex is copied out, as the window is staged over the command in the packet buffer.
+    annex_length = length;
+    memcpy(annex, token, annex_length);
+    if (window > REPLY_LIMIT - 1)
+    {
+        window = REPLY_LIMIT - 1;
+    }
+
+    result = object->read(annex, annex_length, offset, env->packet_buffer, (size_t) window);
+    if (result < 0)
+    {
+        return result;
+    }
+    return send_window(env->packet_buffer, (size_t) result, (gdbs_address_t) result < window);
+}
@@ -0,0 +1,28 @@
+/**
+ *  @file       xfer.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Object transfers for the GDB protocol.
+ */
+#ifndef XFER_H_
+#define XFER_H_
+
+#include "auxiliary/packet.h"
+
+/**
+ * Handle the 'qXfer' query, which reads a window of a named object such as the thread list.
+ * Objects and operations which are not recognized are answered with an empty response.
+ *
+ * @retval 0    Response sent.
+ * @retval <0   Command failed.  The exact value will be a negative enum gdbs_error entry indicating
+ *              what went wrong, and should be reported to GDB as an error response.
+ */
+int proto_xfer
+(
+    struct packet_tokenizer *tokenizer ///< Tokenizer positioned after the query name.
+);
+
+#endif /* end XFER_H_ */
@@ -0,0 +1,30 @@
+/**
+ *  @file       memchr.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Implementation of memchr() function.
+ */
+#ifndef MEMCHR_H_
+#define MEMCHR_H_
+
+#if HAVE_MEMCHR
+#   include <string.h>
+#else
+#   include "size.h"
+/**
+ * Locate the first occurrence of a byte within a memory region.
+ *
+ * @return Pointer to the matching byte, or NULL if the byte does not occur within the region.
+ */
+void *memchr
+(
+    const void  *s, ///< Memory region to search.
+    int          c, ///< Byte to search for.
+    size_t       n  ///< Number of bytes to search.
+);
+#endif
+
+#endif /* end MEMCHR_H_ */
@@ -0,0 +1,31 @@
+/**
+ *  @file       memcmp.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Implementation of memcmp() function.
+ */
+#ifndef MEMCMP_H_
+#define MEMCMP_H_
+
+#if HAVE_MEMCMP
+#   include <string.h>
+#else
+#   include "size.h"
+/**
+ * Compare two memory regions byte by byte.
+ *
+ * @return Zero if the regions are equal, otherwise the difference between the first pair of bytes
+ *         that differ.
+ */
+int memcmp
+(
+    const void  *s1, ///< First memory region.
+    const void  *s2, ///< Second memory region.
+    size_t       n   ///< Number of bytes to compare.
+);
+#endif
+
+#endif /* end MEMCMP_H_ */
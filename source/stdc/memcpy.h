@@ -0,0 +1,30 @@
+/**
+ *  @file       memcpy.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Implementation of memcpy() function.
+ */
+#ifndef MEMCPY_H_
+#define MEMCPY_H_
+
+#if HAVE_MEMCPY
+#   include <string.h>
+#else
+#   include "size.h"
+/**
+ * Copy a memory region to a non-overlapping destination.
+ *
+ * @return The parameter dest.
+ */
+void *memcpy
+(
+    void        *dest, ///< Memory region to copy to.
+    const void  *src,  ///< Memory region to copy from.
+    size_t       n     ///< Number of bytes to copy.
+);
+#endif
+
+#endif /* end MEMCPY_H_ */
@@ -0,0 +1,28 @@
+/**
+ *  @file       strlen.h
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Implementation of strlen() function.
+ */
+#ifndef STRLEN_H_
+#define STRLEN_H_
+
+#if HAVE_STRLEN
+#   include <string.h>
+#else
+#   include "size.h"
+/**
+ * Determine the length of a NUL-terminated string.
+ *
+ * @return Number of characters preceding the terminating NUL.
+ */
+size_t strlen
+(
+    const char *s ///< String to measure.
+);
+#endif
+
+#endif /* end STRLEN_H_ */
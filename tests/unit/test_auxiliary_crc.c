@@ -0,0 +1,74 @@
+/**
+ *  @file       test_auxiliary_crc.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for CRC implementation.
+ */
+#include "auxiliary/crc.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+static const unsigned long TEST_COUNT = 4 + 3;
+
+static void test_crc_update(void)
+{
+    unsigned char   data[256];
+    size_t          i;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (unsigned char) i;
+    }
+
+    TAP_OK(crc_update(CRC_INITIAL, "", 0) == 0xFFFFFFFFUL, "Empty buffer");
+    TAP_OK(crc_update(CRC_INITIAL, "123456789", 9) == 0x0376E6E7UL, "Check value");
+    TAP_OK(crc_update(CRC_INITIAL, data, sizeof(data)) == 0x494A116AUL, "All byte values");
+    TAP_OK(crc_update(CRC_INITIAL, "\0", 1) == 0x4E08BFB4UL, "Single zero byte");
+}
+
+static void test_crc_split(void)
+{
+    unsigned char   data[256];
+    unsigned long   crc;
+    size_t          i;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (unsigned char) (i * 7 + 3);
+    }
+
+    // Results must not depend on how the buffer is split, or on its alignment.
+    crc = crc_update(CRC_INITIAL, "1234", 4);
+    crc = crc_update(crc, "56789", 5);
+    TAP_OK(crc == 0x0376E6E7UL, "Split at word boundary");
+
+    crc = crc_update(CRC_INITIAL, "1", 1);
+    crc = crc_update(crc, "234567", 6);
+    crc = crc_update(crc, "89", 2);
+    TAP_OK(crc == 0x0376E6E7UL, "Split at odd boundaries");
+
+    crc = CRC_INITIAL;
+    for (i = 0; i < sizeof(data); i += 37)
+    {
+        crc = crc_update(crc, &data[i], sizeof(data) - i < 37 ? sizeof(data) - i : 37);
+    }
+    TAP_OK(crc == crc_update(CRC_INITIAL, data, sizeof(data)), "Uneven chunks");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_crc_update();
+    test_crc_split();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,70 @@
+/**
+ *  @file       test_auxiliary_endian.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for byte order conversions.
+ */
+#include "auxiliary/endian.h"
+
+#include "stdc/memcmp.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TILE TVTB TBTV
+static const unsigned long TEST_COUNT =    1 +  3 +  3;
+
+// Assertion count: 1
+static void test_is_little_endian(void)
+{
+    const unsigned int probe = 0x01020304;
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(is_little_endian() == (*(const unsigned char *) &probe == 0x04), "Byte order");
+}
+
+// Assertion count: 3
+static void test_value_to_bytes(void)
+{
+    unsigned char bytes[12];
+
+    TAP_DIAG("In %s", __func__);
+
+    value_to_bytes(bytes, 0x1234, 4, 1);
+    TAP_OK(memcmp(bytes, "\x34\x12\x00\x00", 4) == 0, "Little-endian");
+
+    value_to_bytes(bytes, 0x1234, 4, 0);
+    TAP_OK(memcmp(bytes, "\x00\x00\x12\x34", 4) == 0, "Big-endian");
+
+    // Bytes beyond the width of the value are zero.
+    value_to_bytes(bytes, 0x0102030405060708ULL, 12, 0);
+    TAP_OK(memcmp(bytes, "\x00\x00\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08", 12) == 0, "Wide");
+}
+
+// Assertion count: 3
+static void test_bytes_to_value(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(bytes_to_value((const unsigned char *) "\x34\x12", 2, 1) == 0x1234, "Little-endian");
+    TAP_OK(bytes_to_value((const unsigned char *) "\x12\x34", 2, 0) == 0x1234, "Big-endian");
+
+    // Bytes beyond the width of the value are truncated.
+    TAP_OK(bytes_to_value((const unsigned char *) "\xFF\x01\x02\x03\x04\x05\x06\x07\x08", 9, 0) ==
+           0x0102030405060708ULL, "Wide");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_is_little_endian();
+    test_value_to_bytes();
+    test_bytes_to_value();
+
+    TAP_END_PLAN();
+}
@@ -12,7 +12,7 @@
 /*********************************** Begin Test Implementation ************************************/
 #include "tap.h"
 
-static const unsigned long TEST_COUNT = 256 + 22 + 16 + 256;
+static const unsigned long TEST_COUNT = 256 + 22 + 16 + 256 + 9 + 6;
 
 static void test_hex_digit_to_byte(void)
 {
@@ -614,6 +614,49 @@ static void test_byte_to_hex_octet(void)
     TBTHO(0xFF, "FF", "Test 0xFF");
 }
 
+static void test_hex_string_to_unsigned(void)
+{
+    gdbs_address_t value;
+
+#define THSTU(s, v, r)                                                                      \
+    do                                                                                      \
+    {                                                                                       \
+        int result;                                                                         \
+        value = 0;                                                                          \
+        result = hex_string_to_unsigned((s), strlen(s), &value);                            \
+        TAP_OK(result == (r) && (result != 0 || value == (v)), "Convert '%s': %d -> 0x%lx", \
+               (s), result, (unsigned long) value);                                         \
+    } while (0)
+
+    TAP_DIAG("In %s", __func__);
+
+    THSTU("",           0,          -GDBS_ERROR_INVALID);
+    THSTU("g",          0,          -GDBS_ERROR_INVALID);
+    THSTU("12,4",       0,          -GDBS_ERROR_INVALID);
+    THSTU("0",          0x0,        0);
+    THSTU("f",          0xF,        0);
+    THSTU("10",         0x10,       0);
+    THSTU("2000fF00",   0x2000FF00, 0);
+    THSTU("0000000001", 0x1,        sizeof(gdbs_address_t) >= 5 ? 0 : -GDBS_ERROR_INVALID);
+    TAP_OK(hex_string_to_unsigned("123", 2, &value) == 0 && value == 0x12, "Partial string");
+}
+
+static void test_hex_string_to_bytes(void)
+{
+    unsigned char bytes[4];
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(bytes, 0, sizeof(bytes));
+    TAP_OK(hex_string_to_bytes("", 0, bytes) == 0,                      "Empty string");
+    TAP_OK(hex_string_to_bytes("123", 3, bytes) == -GDBS_ERROR_INVALID, "Odd length");
+    TAP_OK(hex_string_to_bytes("12x4", 4, bytes) == -GDBS_ERROR_INVALID, "Invalid digit");
+    TAP_OK(hex_string_to_bytes("00a5Ff7e", 8, bytes) == 0,              "Valid string");
+    TAP_OK(memcmp(bytes, "\x00\xA5\xFF\x7E", 4) == 0,                  "Converted bytes");
+    TAP_OK(hex_string_to_bytes("1234", 2, bytes) == 0 && bytes[0] == 0x12 && bytes[1] == 0xA5,
+           "Partial string");
+}
+
 int main(void)
 {
     TAP_PLAN(TEST_COUNT);
@@ -622,6 +665,8 @@ int main(void)
     test_hex_octet_to_byte();
     test_nibble_to_hex_digit();
     test_byte_to_hex_octet();
+    test_hex_string_to_unsigned();
+    test_hex_string_to_bytes();
 
     TAP_END_PLAN();
 }
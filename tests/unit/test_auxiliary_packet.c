@@ -12,8 +12,8 @@
 /*********************************** Begin Test Implementation ************************************/
 #include "tap.h"
 
-//                                      TTT TEPC   TV  TPT TPWPA TPWP  TPR
-static const unsigned long TEST_COUNT = 256 +  7 + 17 + 69 +   6 + 90 + 36;
+//                                      TTT TEPC   TV  TPT TPTAU TPWPA TPWP TPWPH TPWPU TPWSR  TPR
+static const unsigned long TEST_COUNT = 256 +  7 + 17 + 69 +  14 +   6 + 90 +   6 +   8 +   9 + 46;
 
 static void test_to_type(void)
 {
@@ -416,6 +416,45 @@ void test_packet_tokenizer(void)
     TPT(&tokenizer, TOKEN_EOB,          "",                 -GDBS_ERROR_EOB);
 }
 
+static void test_packet_tokenizer_advance_unsigned(void)
+{
+    const char              *packet;
+    struct packet_tokenizer  tokenizer;
+    const unsigned char     *token;
+    size_t                   length;
+
+#define TPTAU(z, d, v, r)                                                       \
+    do                                                                          \
+    {                                                                           \
+        gdbs_address_t  value = 0;                                              \
+        int             result = packet_tokenizer_advance_unsigned((z), (d), &value); \
+        TAP_OK(result == (r), "Advance result: %d", result);                    \
+        TAP_OK(result == -GDBS_ERROR_EOB || result == -GDBS_ERROR_INVALID ||    \
+               value == (v), "Value: 0x%lx", (unsigned long) value);            \
+    } while (0)
+
+    TAP_DIAG("In %s", __func__);
+
+    packet = "$m2000fF00,10#00";
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) packet, strlen(packet));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    TPTAU(&tokenizer, ',',          0x2000FF00, 0);
+    TPTAU(&tokenizer, TOKEN_EOB,    0x10,       0);
+    TPTAU(&tokenizer, TOKEN_EOB,    0,          -GDBS_ERROR_EOB);
+
+    packet = "$Z1,1234,x#00";
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) packet, strlen(packet));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    TPTAU(&tokenizer, ',',          0x1,        0);
+    TPTAU(&tokenizer, ',',          0x1234,     0);
+    TPTAU(&tokenizer, ';',          0,          -GDBS_ERROR_INVALID);
+
+    packet = "$p1f#00";
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) packet, strlen(packet));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    TPTAU(&tokenizer, '=',          0x1F,       -GDBS_ERROR_NOT_FOUND);
+}
+
 struct testbuf
 {
     size_t           i;
@@ -580,6 +619,80 @@ static void test_packet_writer_push(void)
                                                                     packet);
 }
 
+static void test_packet_writer_push_hex(void)
+{
+    char                    packet[128];
+    struct packet_writer    writer;
+    struct testbuf          buf = TB_INIT(packet);
+
+    TAP_DIAG("In %s", __func__);
+
+    packet_writer_init(&writer, PT_MESSAGE, &buf);
+    TAP_OK(packet_writer_push_hex(&writer, (const unsigned char *) "\x00\x7F\xA5", 3) == 0,
+           "Push hex");
+    TAP_OK(packet_writer_finish(&writer) == 0, "Complete packet");
+    TAP_OK(strncmp(packet, "$007FA5#53", sizeof(packet)) == 0, "Composed packet: '%s'", packet);
+
+    buf = TB_INIT(packet);
+    packet_writer_init(&writer, PT_MESSAGE, &buf);
+    TAP_OK(packet_writer_push_hex(&writer, NULL, 0) == 0,   "Push empty hex");
+    TAP_OK(packet_writer_finish(&writer) == 0,              "Complete packet");
+    TAP_OK(strncmp(packet, "$#00", sizeof(packet)) == 0,    "Composed packet: '%s'", packet);
+}
+
+static void test_packet_writer_push_unsigned(void)
+{
+#define TPWPU(v, e)                                                                         \
+    do                                                                                      \
+    {                                                                                       \
+        char                    packet[64];                                                 \
+        struct packet_writer    writer;                                                     \
+        struct testbuf          buf = TB_INIT(packet);                                      \
+        packet_writer_init(&writer, PT_MESSAGE, &buf);                                      \
+        TAP_OK(packet_writer_push_unsigned(&writer, (v)) == 0 &&                            \
+               packet_writer_finish(&writer) == 0 &&                                        \
+               strncmp(packet, (e), sizeof(packet)) == 0, "Composed packet: '%s'", packet); \
+    } while (0)
+
+    TAP_DIAG("In %s", __func__);
+
+    TPWPU(0x0,          "$0#30");
+    TPWPU(0x5,          "$5#35");
+    TPWPU(0x10,         "$10#61");
+    TPWPU(0xA5,         "$A5#76");
+    TPWPU(0x100,        "$100#91");
+    TPWPU(0x8000,       "$8000#C8");
+    TPWPU(0x12345678,   "$12345678#A4");
+    TPWPU((gdbs_address_t) -1 >> 4 << 4, (sizeof(gdbs_address_t) == 8 ?
+                                          "$FFFFFFFFFFFFFFF0#4A" : "$FFFFFFF0#1A"));
+}
+
+static void test_packet_writer_set_rle(void)
+{
+    char                    packet[128];
+    struct packet_writer    writer;
+    struct testbuf          buf = TB_INIT(packet);
+
+    TAP_DIAG("In %s", __func__);
+
+    packet_writer_init(&writer, PT_MESSAGE, &buf);
+    TAP_OK(packet_writer_set_rle(&writer, 1) == 0, "Enable RLE");
+    TAP_OK(packet_writer_push_hex(&writer,
+                                  (const unsigned char *) "\x12\x00\x00\x00\x00\x00\x34", 7) == 0,
+           "Push hex");
+    TAP_OK(packet_writer_finish(&writer) == 0, "Complete packet");
+    TAP_OK(strncmp(packet, "$120*&34#4A", sizeof(packet)) == 0, "Composed packet: '%s'", packet);
+
+    buf = TB_INIT(packet);
+    packet_writer_init(&writer, PT_MESSAGE, &buf);
+    TAP_OK(packet_writer_set_rle(&writer, 1) == 0, "Enable RLE");
+    TAP_OK(packet_writer_push_buffer(&writer, (const unsigned char *) "aaaaa", 5) == 0, "Push");
+    TAP_OK(packet_writer_set_rle(&writer, 0) == 0, "Disable RLE");
+    TAP_OK(packet_writer_push_buffer(&writer, (const unsigned char *) "aaaa", 4) == 0, "Push");
+    TAP_OK(packet_writer_finish(&writer) == 0 &&
+           strncmp(packet, "$a*!aaaa#30", sizeof(packet)) == 0, "Composed packet: '%s'", packet);
+}
+
 int gdbs_receive
 (
     void *comm
@@ -631,6 +744,61 @@ static void test_packet_receive(void)
         -GDBS_ERROR_EOB);
     TPR("%bar#35",  PT_NOTIFICATION, 0);
     TPR("",         PT_NOTIFICATION, -GDBS_ERROR_EOB);
+
+    // Leading data is discarded.
+    {
+        char            buffer[] = "+-\x03$?#3F";
+        int             result;
+        struct testbuf  buf = TB_INIT(buffer);
+        unsigned char   packet[64];
+        size_t          length = sizeof(packet);
+
+        result = packet_receive(packet, &length, PT_MESSAGE, &buf);
+        TAP_OK(result == 0, "Receive result: %d", result);
+        TAP_OK(length == 5 && memcmp(packet, "$?#3F", length) == 0, "Packet match");
+
+        buf = TB_INIT(buffer);
+        length = sizeof(packet);
+        result = packet_receive(packet, &length, PT_NOTIFICATION, &buf);
+        TAP_OK(result == -GDBS_ERROR_EOB, "Receive result: %d", result);
+
+        buf = TB_INIT(buffer);
+        buf.i = 1;
+        length = sizeof(packet);
+        result = packet_receive(packet, &length, PT_ACK, &buf);
+        TAP_OK(result == 0 && length == 1 && packet[0] == '-', "Ack match: %d", result);
+    }
+
+    // A packet which overflows the buffer is reported.
+    {
+        char            buffer[] = "$0123456789#00";
+        int             result;
+        struct testbuf  buf = TB_INIT(buffer);
+        unsigned char   packet[8];
+        size_t          length = sizeof(packet);
+
+        result = packet_receive(packet, &length, PT_MESSAGE, &buf);
+        TAP_OK(result == -GDBS_ERROR_EOB, "Receive result: %d", result);
+        TAP_OK(buf.i == sizeof(packet), "Consumed: %zu", buf.i);
+        TAP_OK(length == sizeof(packet), "Length untouched: %zu", length);
+    }
+
+    // The remainder of a packet whose lead character was read elsewhere.
+    {
+        char            buffer[] = "?#3F?#00";
+        int             result;
+        struct testbuf  buf = TB_INIT(buffer);
+        unsigned char   packet[64];
+        size_t          length = sizeof(packet);
+
+        result = packet_receive_remainder(packet, &length, PT_MESSAGE, &buf);
+        TAP_OK(result == 0, "Receive result: %d", result);
+        TAP_OK(length == 5 && memcmp(packet, "$?#3F", length) == 0, "Packet match");
+
+        length = sizeof(packet);
+        result = packet_receive_remainder(packet, &length, PT_MESSAGE, &buf);
+        TAP_OK(result == -GDBS_ERROR_CHECKSUM, "Receive result: %d", result);
+    }
 }
 
 int main(void)
@@ -641,8 +809,12 @@ int main(void)
     test_extract_packet_checksum();
     test_verify();
     test_packet_tokenizer();
+    test_packet_tokenizer_advance_unsigned();
     test_packet_writer_push_ack();
     test_packet_writer_push();
+    test_packet_writer_push_hex();
+    test_packet_writer_push_unsigned();
+    test_packet_writer_set_rle();
     test_packet_receive();
 
     TAP_END_PLAN();
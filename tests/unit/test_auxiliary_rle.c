@@ -16,7 +16,7 @@
 #   pragma warning(disable : 4996)  // Turn off strcpy deprecation warning.
 #endif
 
-static const unsigned long TEST_COUNT = 93 + 216 + 8;
+static const unsigned long TEST_COUNT = 93 + 216 + 8 + 6;
 
 static void test_format_rle(void)
 {
@@ -400,6 +400,29 @@ static void test_run_length_encode(void)
          "Sample command");
 }
 
+static void test_run_length_encode_run(void)
+{
+    char    buffer[RLE_MAX_ENCODED_LENGTH + 1];
+    size_t  length;
+
+#define TRLER(c, n, e, d)                                                           \
+    do                                                                              \
+    {                                                                               \
+        memset(buffer, 0, sizeof(buffer));                                          \
+        length = run_length_encode_run(buffer, (c), (n));                           \
+        TAP_OK(length == strlen(e) && strcmp(buffer, (e)) == 0, d ": '%s'", buffer); \
+    } while (0)
+
+    TAP_DIAG("In %s", __func__);
+
+    TRLER('0', 1,           "0",        "Single character");
+    TRLER('0', 3,           "000",      "Short run");
+    TRLER('0', 4,           "0* ",      "Shortest encoded run");
+    TRLER('0', 8,           "0*\"00",   "Run avoiding '$'");
+    TRLER('0', 9,           "0*\"000",  "Longest encoding");
+    TRLER('0', RLE_MAX_RUN, "0*~",      "Longest run");
+}
+
 int main(void)
 {
     TAP_PLAN(TEST_COUNT);
@@ -407,6 +430,7 @@ int main(void)
     test_format_rle();
     test_encode();
     test_run_length_encode();
+    test_run_length_encode_run();
 
     TAP_END_PLAN();
 }
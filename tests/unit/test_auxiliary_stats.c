@@ -0,0 +1,153 @@
+/**
+ *  @file       test_auxiliary_stats.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the statistics of the communication with GDB.  Built with
+ *              GDBS_STATS and GDBS_STATS_TIMING set.
+ */
+#include "auxiliary/stats.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TASC TAST TASR
+static const unsigned long TEST_COUNT =    6 +  4 +  2;
+
+/// Time reported by gdbs_timestamp().
+static unsigned long now;
+
+unsigned long gdbs_timestamp(void)
+{
+    return now;
+}
+
+// Assertion count: 2 + 2 + 2 = 6
+static void test_stats_counters(void)
+{
+    struct gdbs_stats result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Stray data before a packet counts as a single resync; acks are counted on their own.
+    stats_discarded(ACK_CHAR);
+    stats_discarded('x');
+    stats_discarded('y');
+    stats_receive_start();
+    stats_received(10, GDBS_ERROR_OK);
+    stats_discarded('z');
+    gdbs_get_stats(&result);
+    TAP_OK(result.acks_received == 1 && result.resyncs == 2, "Acks: %lu, resyncs: %lu",
+           result.acks_received, result.resyncs);
+    TAP_OK(result.packets_received == 1 && result.bytes_received == 14,
+           "Packets: %lu, bytes: %lu", result.packets_received, result.bytes_received);
+
+    // A good packet after a NACK is GDB retransmitting it.
+    stats_receive_start();
+    stats_received(8, -GDBS_ERROR_CHECKSUM);
+    stats_packet_sent(PT_ACK, 0);
+    stats_receive_start();
+    stats_received(8, GDBS_ERROR_OK);
+    stats_packet_sent(PT_ACK, 1);
+    stats_receive_start();
+    stats_received(8, GDBS_ERROR_OK);
+    gdbs_get_stats(&result);
+    TAP_OK(result.checksum_failures == 1 && result.retransmits == 1,
+           "Checksum failures: %lu, retransmits: %lu", result.checksum_failures,
+           result.retransmits);
+    TAP_OK(result.nacks_sent == 1 && result.acks_sent == 1 && result.packets_received == 3,
+           "NACKs: %lu, ACKs: %lu", result.nacks_sent, result.acks_sent);
+
+    stats_packet_sent(PT_MESSAGE, 0);
+    stats_packet_sent(PT_NOTIFICATION, 0);
+    stats_transmit_start();
+    stats_transmitted(GDBS_ERROR_OK);
+    stats_transmit_start();
+    stats_transmitted(-GDBS_ERROR_FAULT);
+    gdbs_get_stats(&result);
+    TAP_OK(result.packets_sent == 1 && result.notifications_sent == 1,
+           "Packets sent: %lu, notifications: %lu", result.packets_sent,
+           result.notifications_sent);
+    TAP_OK(result.bytes_sent == 1, "Failed sends are not counted: %lu", result.bytes_sent);
+}
+
+// Assertion count: 1 + 2 + 1 = 4
+static void test_stats_timing(void)
+{
+    const struct gdbs_stats *stats;
+
+    TAP_DIAG("In %s", __func__);
+
+    gdbs_reset_stats();
+    now = 100;
+    stats_receive_start();
+    now = 130;
+    stats_received(12, GDBS_ERROR_OK);
+    stats = stats_read();
+    TAP_OK(stats->receive_time == 30, "Receive time: %lu", stats->receive_time);
+
+    // Time spent sending the reply is taken out of the time spent handling the command.
+    now = 200;
+    stats_dispatch_start('m', 12);
+    now = 210;
+    stats_transmit_start();
+    now = 215;
+    stats_transmitted(GDBS_ERROR_OK);
+    stats_transmit_start();
+    now = 220;
+    stats_transmitted(GDBS_ERROR_OK);
+    now = 250;
+    stats_dispatch_end();
+    stats = stats_read();
+    TAP_OK(stats->commands[7].command == 'm' && stats->commands[7].time == 40 &&
+           stats->dispatch_time == 40 && stats->transmit_time == 10,
+           "Dispatch time: %lu, transmit time: %lu", stats->dispatch_time, stats->transmit_time);
+    TAP_OK(stats->commands[7].packets == 1 && stats->commands[7].bytes_in == 12 &&
+           stats->commands[7].bytes_out == 2, "Command bytes: %lu in, %lu out",
+           stats->commands[7].bytes_in, stats->commands[7].bytes_out);
+
+    // Commands without an entry of their own share the last one.
+    stats_dispatch_start('k', 5);
+    stats_dispatch_end();
+    stats = stats_read();
+    TAP_OK(stats->commands[GDBS_STATS_COMMAND_COUNT - 1].command == '\0' &&
+           stats->commands[GDBS_STATS_COMMAND_COUNT - 1].bytes_in == 5, "Other commands");
+}
+
+// Assertion count: 2
+static void test_stats_reset(void)
+{
+    struct gdbs_stats   result;
+    unsigned long       total = 0;
+    unsigned int        i;
+
+    TAP_DIAG("In %s", __func__);
+
+    stats_packet_sent(PT_ACK, 0);
+    gdbs_reset_stats();
+    stats_receive_start();
+    stats_received(4, GDBS_ERROR_OK);
+    gdbs_get_stats(&result);
+    for (i = 0; i < GDBS_STATS_COMMAND_COUNT; ++i)
+    {
+        total += result.commands[i].packets + result.commands[i].bytes_in +
+                 result.commands[i].bytes_out + result.commands[i].time;
+    }
+    TAP_OK(total == 0 && result.dispatch_time == 0 && result.transmit_time == 0,
+           "Command statistics reset");
+    TAP_OK(result.nacks_sent == 0 && result.retransmits == 0 && result.packets_received == 1,
+           "Pending NACK forgotten: %lu", result.retransmits);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_stats_counters();
+    test_stats_timing();
+    test_stats_reset();
+
+    TAP_END_PLAN();
+}
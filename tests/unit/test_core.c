@@ -12,8 +12,8 @@
 /*********************************** Begin Test Implementation ************************************/
 #include "tap.h"
 
-//                                      TGETS TGIC TCGE TGE
-static const unsigned long TEST_COUNT =    10 + 16 +  1 + 2;
+//                                      TGETS TGIC TCGE TGE TGCP TGNS
+static const unsigned long TEST_COUNT =    12 + 17 +  1 + 6 +  6 +  6;
 
 void test_gdbs_error_to_string(void)
 {
@@ -30,8 +30,12 @@ void test_gdbs_error_to_string(void)
     TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_EOB)) > 0, "GDBS_ERROR_EOB: '%s'", str);
     TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_NOT_FOUND)) > 0,
         "GDBS_ERROR_NOT_FOUND: '%s'", str);
-    TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_NOT_FOUND + 1)) == 0,
-        "GDBS_ERROR_NOT_FOUND + 1: '%s'", str);
+    TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_FAULT)) > 0,
+        "GDBS_ERROR_FAULT: '%s'", str);
+    TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_RESOURCES)) > 0,
+        "GDBS_ERROR_RESOURCES: '%s'", str);
+    TAP_OK(strlen(str = gdbs_error_to_string(GDBS_ERROR_COUNT)) == 0,
+        "GDBS_ERROR_COUNT: '%s'", str);
     TAP_OK(strlen(str = gdbs_error_to_string(-1)) == 0, "-1: '%s'", str);
     TAP_OK(strlen(str = gdbs_error_to_string(7000)) == 0, "7000: '%s'", str);
     TAP_OK(strlen(str = gdbs_error_to_string(-9999999)) == 0, "-9999999: '%s'", str);
@@ -88,6 +92,140 @@ void gdbs_close_comm
     TAP_OK(comm == data, "Comm data: %p", comm);
 }
 
+const struct gdbs_register *gdbs_get_register_table
+(
+    unsigned int *count
+)
+{
+    *count = 0;
+    return NULL;
+}
+
+void *gdbs_get_register_frame(void)
+{
+    return NULL;
+}
+
+void proto_index_registers(void)
+{
+}
+
+void proto_init_comparators(void)
+{
+}
+
+void proto_init_stop_queue(void)
+{
+}
+
+/// Number of stop events queued, and notifications sent.
+static int queued;
+static int notified;
+
+int proto_queue_stop
+(
+    const struct gdbs_stop_event    *event,
+    unsigned char                   *frame
+)
+{
+    (void) event;
+    (void) frame;
+    ++queued;
+    return GDBS_ERROR_OK;
+}
+
+int proto_notify_stop(void)
+{
+    ++notified;
+    return GDBS_ERROR_OK;
+}
+
+/// Number of host call requests sent.
+static int host_requests;
+
+int proto_send_host_call(void)
+{
+    ++host_requests;
+    return GDBS_ERROR_OK;
+}
+
+/// Number of calls to proto_console_flush().
+static int console_flushes;
+
+int proto_console_flush(void)
+{
+    ++console_flushes;
+    return GDBS_ERROR_OK;
+}
+
+void proto_resolve_watchpoint
+(
+    struct gdbs_stop_event *event
+)
+{
+    (void) event;
+}
+
+/// Number of breakpoint changes staged, and written to target memory.
+static unsigned int breakpoints;
+static unsigned int breakpoints_written;
+
+void proto_clear_breakpoints(void)
+{
+}
+
+int proto_breakpoint_hit(void)
+{
+    return 0;
+}
+
+int proto_range_step(void)
+{
+    return 0;
+}
+
+unsigned int proto_commit_breakpoints(void)
+{
+    unsigned int changed = breakpoints;
+
+    breakpoints_written += changed;
+    breakpoints = 0;
+    return changed;
+}
+
+/// Number of instruction cache flushes.
+static int flushes;
+
+void gdbs_flush_icache(void)
+{
+    ++flushes;
+}
+
+gdbs_address_t gdbs_get_current_thread(void)
+{
+    return 1;
+}
+
+/// Number of thread context cache flushes.
+static int context_flushes;
+
+int proto_flush_thread_contexts(void)
+{
+    ++context_flushes;
+    return 0;
+}
+
+void gdbs_get_stop_event
+(
+    struct gdbs_stop_event *event
+)
+{
+    TAP_OK(event->signal == GDBS_SIGNAL_TRAP && event->reason == GDBS_STOP_SIGNAL &&
+           event->unit == -1 && event->thread == 1,
+           "Default stop event: %d %d %d", event->signal, event->reason, event->unit);
+    event->signal = GDBS_SIGNAL_SEGV;
+}
+
 static void test_gdbs_initialize_cleanup(void)
 {
     int result;
@@ -101,7 +239,10 @@ static void test_gdbs_initialize_cleanup(void)
     test_data.error = GDBS_ERROR_OK;
     result = gdbs_initialize(&test_data);
     TAP_OK(result == GDBS_ERROR_OK, "Valid result: %d", result);
+    breakpoints = 2;
+    flushes = 0;
     gdbs_cleanup();
+    TAP_OK(breakpoints == 0 && flushes == 1, "Breakpoints removed on cleanup: %d", flushes);
 
     test_data.error = GDBS_ERROR_OK;
     data = NULL;
@@ -116,19 +257,163 @@ void test_core_get_environment(void)
     TAP_OK(core_get_environment() == &env, "Get environment");
 }
 
+/// Arguments and state seen by the last call to proto_process().
+static int                  processed;
+static int                  processed_stop_reply;
+static enum gdbs_signal     processed_signal;
+static int                  processed_buffer;
+
+/// Breakpoint changes staged by the next call to proto_process(), as a 'Z' or 'z' command would.
+static unsigned int         process_breakpoints;
+
+/// Boolean indicating that the next call to proto_process() writes code, as an 'M' command may.
+static int                  process_code_write;
+
 void proto_process
 (
     int send_stop_reply
 )
 {
-    TAP_OK(send_stop_reply == 1, "Send stop reply: %d", send_stop_reply);
-    TAP_OK(env.packet_buffer != NULL, "Packet buffer: %p", env.packet_buffer);
+    ++processed;
+    processed_stop_reply = send_stop_reply;
+    processed_signal = env.stop.signal;
+    processed_buffer = (env.packet_buffer != NULL);
+    breakpoints += process_breakpoints;
+    process_breakpoints = 0;
+    env.icache_dirty |= process_code_write;
+    process_code_write = 0;
 }
 
+// Assertion count: 1 + 4 + 1 = 6
 void test_gdbs_enter(void)
 {
     TAP_DIAG("In %s", __func__);
+    context_flushes = 0;
+    gdbs_enter();
+    TAP_OK(processed_stop_reply == 1, "Send stop reply: %d", processed_stop_reply);
+    TAP_OK(processed_signal == GDBS_SIGNAL_SEGV, "Stop signal: %d", processed_signal);
+    TAP_OK(processed_buffer, "Packet buffer");
+    TAP_OK(context_flushes == 1, "Thread contexts flushed: %d", context_flushes);
+
+    // A host call sends its request in place of the stop reply.
+    env.host_call = "write";
+    gdbs_enter();
+    TAP_OK(host_requests == 1 && processed_stop_reply == 0, "Host call: %d", host_requests);
+    env.host_call = NULL;
+}
+
+/// Characters waiting to be read by gdbs_receive_poll().
+static const char   *waiting;
+static size_t        waiting_length;
+
+int gdbs_receive_poll
+(
+    void *comm
+)
+{
+    (void) comm;
+    if (waiting_length == 0)
+    {
+        return -GDBS_ERROR_EOB;
+    }
+    --waiting_length;
+    return (unsigned char) *waiting++;
+}
+
+void gdbs_breakpoint(void)
+{
+    gdbs_enter();
+}
+
+/**
+ * Poll for an interrupt with a set of waiting characters.
+ *
+ * @return Result of gdbs_comm_poll().
+ */
+static int poll_with
+(
+    const char  *characters,
+    size_t       length
+)
+{
+    waiting = characters;
+    waiting_length = length;
+    processed = 0;
+    return gdbs_comm_poll();
+}
+
+// Assertion count: 1 + 1 + 1 + 1 + 2 = 6
+void test_gdbs_comm_poll(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    console_flushes = 0;
+    result = poll_with("+-x", 3);
+    TAP_OK(result == 0 && processed == 0 && waiting_length == 0, "No interrupt: %d", result);
+    TAP_OK(console_flushes == 1, "Console output sent: %d", console_flushes);
+
+    // An interrupt character inside a packet is ignored, even across calls.
+    result = poll_with("$X0,1:", 6);
+    result |= poll_with("\x03#", 2);
+    result |= poll_with("00", 2);
+    TAP_OK(result == 0 && processed == 0, "Interrupt in packet: %d", result);
+
+    // The stub entry triggered by the interrupt also checks the stop event.
+    result = poll_with("$c#63+\x03+", 8);
+    TAP_OK(result == 1 && processed == 1 && processed_signal == GDBS_SIGNAL_INT &&
+           waiting_length == 1, "Interrupt: %d %d", processed, processed_signal);
+    TAP_OK(env.interrupted == 0, "Interrupt consumed");
+}
+
+// Assertion count: 1 + 2 + 1 + 1 + 1 = 6
+void test_gdbs_non_stop(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.non_stop = 1;
+    env.running = 1;
+
+    // A stop is queued and notified, rather than sent as a reply.
+    queued = 0;
+    notified = 0;
     gdbs_enter();
+    TAP_OK(queued == 1 && notified == 1 && processed_stop_reply == 0 && env.running == 0,
+           "Stop notified: %d %d %d", queued, notified, processed_stop_reply);
+
+    // A packet from GDB enters the stub without a stop.
+    queued = 0;
+    result = poll_with("+$vStopped#55", 13);
+    TAP_OK(result == 1 && processed == 1 && processed_stop_reply == 0 && queued == 0 &&
+           waiting_length == 11, "Packet entry: %d %d", result, processed);
+    TAP_OK(env.packet_started == 1, "Packet started");
+
+    // Console output is never sent unprompted in non-stop mode.
+    console_flushes = 0;
+    poll_with("+", 1);
+    TAP_OK(console_flushes == 0, "Console output held: %d", console_flushes);
+
+    // A breakpoint set while the target runs is written to memory before the target carries on.
+    env.packet_started = 0;
+    breakpoints_written = 0;
+    flushes = 0;
+    process_breakpoints = 1;
+    result = poll_with("$Z0,100,4#8d", 12);
+    TAP_OK(result == 1 && breakpoints == 0 && breakpoints_written == 1 && flushes == 1,
+           "Breakpoint committed: %u %d", breakpoints_written, flushes);
+
+    // Code written while the target runs is flushed from the instruction cache.
+    env.packet_started = 0;
+    flushes = 0;
+    process_code_write = 1;
+    poll_with("$M100,1:00#8e", 13);
+    TAP_OK(flushes == 1 && !env.icache_dirty, "Code write flushed: %d", flushes);
+
+    env.non_stop = 0;
+    env.packet_started = 0;
 }
 
 int main(void)
@@ -139,6 +424,8 @@ int main(void)
     test_gdbs_initialize_cleanup();
     test_core_get_environment();
     test_gdbs_enter();
+    test_gdbs_comm_poll();
+    test_gdbs_non_stop();
 
     TAP_END_PLAN();
 }
@@ -0,0 +1,38 @@
+/**
+ *  @file       test_generic_flash.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the generic flash hooks.
+ */
+#include "generic/flash.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+static const unsigned long TEST_COUNT = 3;
+
+// Assertion count: 3
+static void test_gdbs_flash(void)
+{
+    unsigned int    count = 1;
+    unsigned char   page[4] = { 0 };
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(gdbs_get_memory_map(&count) == NULL && count == 0, "No memory map");
+    TAP_OK(gdbs_flash_erase(0, 0x400) == -GDBS_ERROR_INVALID &&
+           gdbs_flash_program(0, page, sizeof(page)) == -GDBS_ERROR_INVALID, "No flash");
+    TAP_OK(gdbs_flash_wait() == 0, "Nothing to wait for");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_gdbs_flash();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,112 @@
+/**
+ *  @file       test_generic_memory.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the generic memory access hooks.
+ */
+#include "generic/memory.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TGMF TGMR TGMW
+static const unsigned long TEST_COUNT =    3 + 64 + 64;
+
+/// Length of the test memory regions.  Long enough for a head, several words, and a tail.
+#define REGION_LENGTH (sizeof(word_t) * 4)
+
+static void test_gdbs_memory_fault(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(gdbs_memory_fault() == 0 && state == ACCESS_IDLE, "Fault while idle");
+
+    state = ACCESS_ACTIVE;
+    TAP_OK(gdbs_memory_fault() == 1 && state == ACCESS_FAULTED, "Fault while active");
+    TAP_OK(finish_access() == -GDBS_ERROR_FAULT && state == ACCESS_IDLE, "Faulted access");
+}
+
+static void test_gdbs_memory_read(void)
+{
+    word_t          source_words[REGION_LENGTH / sizeof(word_t) + 1];
+    unsigned char  *source = (unsigned char *) source_words;
+    unsigned char   destination[REGION_LENGTH + 1];
+    size_t          offset;
+    size_t          length;
+    size_t          i;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(source_words); ++i)
+    {
+        source[i] = (unsigned char) (i * 7 + 1);
+    }
+
+    // Exercise every combination of target and buffer misalignment, with lengths that leave both
+    // a partial head and tail.
+    for (offset = 0; offset < 8; ++offset)
+    {
+        for (length = REGION_LENGTH - 8; length < REGION_LENGTH; length += 2)
+        {
+            memset(destination, 0, sizeof(destination));
+            result = gdbs_memory_read(NULL,
+                                      (gdbs_address_t) &source[offset % sizeof(word_t)],
+                                      &destination[offset % 2],
+                                      length);
+            TAP_OK(result == 0 &&
+                   memcmp(&destination[offset % 2], &source[offset % sizeof(word_t)], length) == 0,
+                   "Read %zu bytes at offset %zu: %d", length, offset, result);
+            TAP_OK(state == ACCESS_IDLE, "Access state: %d", state);
+        }
+    }
+}
+
+static void test_gdbs_memory_write(void)
+{
+    word_t          destination_words[REGION_LENGTH / sizeof(word_t) + 1];
+    unsigned char  *destination = (unsigned char *) destination_words;
+    unsigned char   source[REGION_LENGTH + 1];
+    size_t          offset;
+    size_t          length;
+    size_t          i;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(source); ++i)
+    {
+        source[i] = (unsigned char) (i * 5 + 3);
+    }
+
+    for (offset = 0; offset < 8; ++offset)
+    {
+        for (length = REGION_LENGTH - 8; length < REGION_LENGTH; length += 2)
+        {
+            memset(destination_words, 0, sizeof(destination_words));
+            result = gdbs_memory_write(NULL,
+                                       (gdbs_address_t) &destination[offset % sizeof(word_t)],
+                                       &source[offset % 2],
+                                       length);
+            TAP_OK(result == 0 &&
+                   memcmp(&destination[offset % sizeof(word_t)], &source[offset % 2], length) == 0,
+                   "Write %zu bytes at offset %zu: %d", length, offset, result);
+            TAP_OK(destination[offset % sizeof(word_t) + length] == 0,
+                   "Untouched byte after write");
+        }
+    }
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_gdbs_memory_fault();
+    test_gdbs_memory_read();
+    test_gdbs_memory_write();
+
+    TAP_END_PLAN();
+}
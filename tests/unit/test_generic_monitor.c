@@ -0,0 +1,34 @@
+/**
+ *  @file       test_generic_monitor.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the generic monitor command hook.
+ */
+#include "generic/monitor.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+static const unsigned long TEST_COUNT = 1;
+
+// Assertion count: 1
+static void test_gdbs_get_monitor_commands(void)
+{
+    unsigned int count = 1;
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(gdbs_get_monitor_commands(&count) == NULL && count == 0, "No target commands");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_gdbs_get_monitor_commands();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,64 @@
+/**
+ *  @file       test_generic_threads.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the generic thread hooks.
+ */
+#include "generic/threads.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TGGT TGTI TGTC
+static const unsigned long TEST_COUNT =    3 +  4 +  2;
+
+// Assertion count: 3
+static void test_gdbs_get_threads(void)
+{
+    gdbs_address_t   ids[4] = { 0 };
+    unsigned int     count;
+
+    TAP_DIAG("In %s", __func__);
+
+    count = gdbs_get_threads(0, ids, 4);
+    TAP_OK(count == 1 && ids[0] == THREAD_ID, "Single thread: %u", count);
+    TAP_OK(gdbs_get_threads(1, ids, 4) == 0, "End of list");
+    TAP_OK(gdbs_get_threads(0, ids, 0) == 0, "No room");
+}
+
+// Assertion count: 4
+static void test_gdbs_thread_info(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(gdbs_get_current_thread() == THREAD_ID, "Current thread");
+    TAP_OK(gdbs_thread_alive(THREAD_ID) && !gdbs_thread_alive(THREAD_ID + 1), "Alive");
+    TAP_OK(gdbs_get_thread_name(THREAD_ID) == NULL, "No name");
+    TAP_OK(gdbs_get_thread_core(THREAD_ID) == -1, "No core");
+}
+
+// Assertion count: 2
+static void test_gdbs_thread_context(void)
+{
+    unsigned char frame[4];
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(gdbs_get_thread_context(THREAD_ID + 1, frame) == -GDBS_ERROR_NOT_FOUND, "Get context");
+    TAP_OK(gdbs_set_thread_context(THREAD_ID + 1, frame, frame) == -GDBS_ERROR_NOT_FOUND,
+           "Set context");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_gdbs_get_threads();
+    test_gdbs_thread_info();
+    test_gdbs_thread_context();
+
+    TAP_END_PLAN();
+}
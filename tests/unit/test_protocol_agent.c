@@ -0,0 +1,325 @@
+/**
+ *  @file       test_protocol_agent.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the agent expression interpreter.
+ */
+#include "protocol/agent.c"
+
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/memset.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPAV TPAE TPAF TPAP TPAT
+static const unsigned long TEST_COUNT =    9 + 18 +  6 +  4 +  6;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+/// Simulated target memory.  Accesses outside of this region fault.
+static unsigned char target[16];
+
+int gdbs_memory_read
+(
+    void            *comm,
+    gdbs_address_t   address,
+    void            *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(buffer, &target[address], length);
+    return 0;
+}
+
+void proto_breakpoint_filter_read
+(
+    gdbs_address_t   address,
+    unsigned char   *data,
+    gdbs_address_t   length
+)
+{
+    (void) address;
+    (void) data;
+    (void) length;
+}
+
+/// Simulated register 3, in target byte order.
+static unsigned short register3;
+
+int proto_get_register_bytes
+(
+    gdbs_address_t           regnum,
+    const unsigned char    **bytes,
+    unsigned int            *size
+)
+{
+    if (regnum != 3)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+    *bytes = (const unsigned char *) &register3;
+    *size = sizeof(register3);
+    return 0;
+}
+
+/// Last formatted output request.
+static const unsigned char  *formatted;
+static size_t                formatted_length;
+static agent_value_t         formatted_args[4];
+static unsigned int          formatted_count;
+
+void proto_console_format
+(
+    const unsigned char *format,
+    size_t               length,
+    const agent_value_t *args,
+    unsigned int         count
+)
+{
+    formatted = format;
+    formatted_length = length;
+    memcpy(formatted_args, args, count * sizeof(args[0]));
+    formatted_count = count;
+}
+
+/// Last trace collection request.
+static gdbs_address_t   collected_address;
+static gdbs_address_t   collected_length;
+static int              collected_until_zero;
+
+int proto_trace_collect_memory
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length,
+    int              until_zero
+)
+{
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    collected_address = address;
+    collected_length = length;
+    collected_until_zero = until_zero;
+    return 0;
+}
+
+/// Validate and evaluate a string literal expression.
+#define EVALUATE(s, v) evaluate((const unsigned char *) (s), sizeof(s) - 1, (v))
+
+/**
+ * Validate and evaluate an expression.
+ *
+ * @return Result of validation if it failed, otherwise the result of evaluation.
+ */
+static int evaluate
+(
+    const unsigned char *code,
+    size_t               length,
+    agent_value_t       *value
+)
+{
+    int result = proto_agent_validate(code, length);
+
+    *value = 0xDEAD;
+    return (result < 0 ? result : proto_agent_evaluate(code, value));
+}
+
+// Assertion count: 9
+static void test_proto_agent_validate(void)
+{
+    unsigned char long_code[GDBS_AGENT_BYTECODE_LENGTH + 1];
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x27", 1) == 0, "End only");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x22\x01\x20\x00\x00\x27", 6) == 0,
+           "Backward jump");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x01\x27", 2) < 0, "Unsupported opcode");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x40\x27", 2) < 0, "Unknown opcode");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x24\x00\x00\x27", 4) < 0,
+           "Truncated operand");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x22\x01", 2) < 0, "No end");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x21\x00\x02\x27", 4) < 0,
+           "Jump into operand");
+    TAP_OK(proto_agent_validate((const unsigned char *) "\x21\x00\x09\x27", 4) < 0,
+           "Jump out of range");
+
+    memset(long_code, 0x28, sizeof(long_code));
+    long_code[sizeof(long_code) - 1] = 0x27;
+    TAP_OK(proto_agent_validate(long_code, sizeof(long_code)) < 0, "Too long");
+}
+
+// Assertion count: 18
+static void test_proto_agent_evaluate(void)
+{
+    agent_value_t   value;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = EVALUATE("\x22\x02\x22\x03\x02\x27", &value);
+    TAP_OK(result == 0 && value == 5, "2 + 3: %d", result);
+
+    // 0 - 7, then signed division and remainder by 2.
+    result = EVALUATE("\x22\x00\x22\x07\x03\x22\x02\x05\x27", &value);
+    TAP_OK(result == 0 && value == (agent_value_t) -3, "-7 / 2");
+    result = EVALUATE("\x22\x00\x22\x07\x03\x22\x02\x07\x27", &value);
+    TAP_OK(result == 0 && value == (agent_value_t) -1, "-7 %% 2");
+    result = EVALUATE("\x22\x07\x22\x02\x06\x27", &value);
+    TAP_OK(result == 0 && value == 3, "7 / 2 unsigned");
+
+    // Signed and unsigned comparisons of -1 and 1.
+    result = EVALUATE("\x22\xFF\x16\x08\x22\x01\x14\x27", &value);
+    TAP_OK(result == 0 && value == 1, "-1 < 1 signed");
+    result = EVALUATE("\x22\xFF\x16\x08\x22\x01\x15\x27", &value);
+    TAP_OK(result == 0 && value == 0, "-1 < 1 unsigned");
+
+    // Shifts and extensions.
+    result = EVALUATE("\x22\xF8\x16\x08\x22\x01\x0A\x27", &value);
+    TAP_OK(result == 0 && value == (agent_value_t) -4, "-8 >> 1 signed");
+    result = EVALUATE("\x22\x01\x22\x04\x09\x22\x00\x13\x0E\x27", &value);
+    TAP_OK(result == 0 && value == 1, "1 << 4 != 0");
+    result = EVALUATE("\x22\xFF\x16\x08\x2A\x0C\x27", &value);
+    TAP_OK(result == 0 && value == 0xFFF, "Zero extend");
+
+    // Conditional branch over a constant.
+    result = EVALUATE("\x22\x01\x20\x00\x08\x22\x05\x27\x22\x06\x27", &value);
+    TAP_OK(result == 0 && value == 6, "Branch taken: %d", (int) value);
+    result = EVALUATE("\x22\x00\x20\x00\x08\x22\x05\x27\x22\x06\x27", &value);
+    TAP_OK(result == 0 && value == 5, "Branch not taken: %d", (int) value);
+
+    // Stack manipulation: 1 2 3 rot => 3 1 2, checked one slot at a time, then swap => 3 2 1 and
+    // sub => 3 1.
+    result = EVALUATE("\x22\x01\x22\x02\x22\x03\x33\x27", &value);
+    TAP_OK(result == 0 && value == 2, "Rot top: %d", (int) value);
+    result = EVALUATE("\x22\x01\x22\x02\x22\x03\x33\x29\x27", &value);
+    TAP_OK(result == 0 && value == 1, "Rot second: %d", (int) value);
+    result = EVALUATE("\x22\x01\x22\x02\x22\x03\x33\x29\x29\x27", &value);
+    TAP_OK(result == 0 && value == 3, "Rot third: %d", (int) value);
+    result = EVALUATE("\x22\x01\x22\x02\x22\x03\x33\x2B\x03\x27", &value);
+    TAP_OK(result == 0 && value == 1, "Rot and swap: %d", (int) value);
+    result = EVALUATE("\x22\x04\x22\x05\x32\x01\x04\x02\x27", &value);
+    TAP_OK(result == 0 && value == 24, "Pick: %d", (int) value);
+
+    // Memory and register references.
+    memcpy(&target[4], "\x11\x22\x33\x44", 4);
+    result = EVALUATE("\x22\x04\x19\x27", &value);
+    TAP_OK(result == 0 && value == (is_little_endian() ? 0x44332211 : 0x11223344),
+           "Memory reference");
+    register3 = 0x1234;
+    result = EVALUATE("\x26\x00\x03\x27", &value);
+    TAP_OK(result == 0 && value == 0x1234, "Register");
+
+    result = EVALUATE("\x22\x01\x29\x27", &value);
+    TAP_OK(result == 0 && value == 0, "Empty stack");
+}
+
+// Assertion count: 6
+static void test_proto_agent_failures(void)
+{
+    unsigned char   code[GDBS_AGENT_STACK_DEPTH + 3];
+    agent_value_t   value;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = EVALUATE("\x02\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Underflow: %d", result);
+    result = EVALUATE("\x22\x01\x22\x00\x05\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Division by zero: %d", result);
+    result = EVALUATE("\x22\x0E\x19\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_FAULT, "Memory fault: %d", result);
+    result = EVALUATE("\x26\x00\x04\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Missing register: %d", result);
+
+    // One dup too many.
+    memset(code, 0x28, sizeof(code));
+    code[0] = 0x22;
+    code[1] = 0x01;
+    code[sizeof(code) - 1] = 0x27;
+    result = evaluate(code, sizeof(code), &value);
+    TAP_OK(result == -GDBS_ERROR_RESOURCES, "Overflow: %d", result);
+    code[sizeof(code) - 2] = 0x27;
+    result = evaluate(code, sizeof(code) - 1, &value);
+    TAP_OK(result == 0 && value == 1, "Full stack: %d", result);
+}
+
+// Assertion count: 4
+static void test_proto_agent_printf(void)
+{
+    agent_value_t   value;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // 7, then the arguments last first, the channel and the function.
+    result = EVALUATE("\x22\x07\x22\x02\x22\x01\x22\x00\x22\x00"
+                      "\x34\x02\x00\x06%d %d\0\x27", &value);
+    TAP_OK(result == 0 && value == 7, "Printf: %d", result);
+    TAP_OK(formatted_length == 5 && memcmp(formatted, "%d %d", 5) == 0 && formatted_count == 2 &&
+           formatted_args[0] == 1 && formatted_args[1] == 2, "Formatted");
+
+    result = EVALUATE("\x22\x00\x22\x00\x34\x00\x00\x02%d\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Unterminated format: %d", result);
+    result = EVALUATE("\x22\x00\x22\x00\x34\x00\x00\x10%d\0\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Truncated format: %d", result);
+}
+
+// Assertion count: 6
+static void test_proto_agent_trace(void)
+{
+    agent_value_t   value;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // trace consumes the address and length, leaving the stack empty.
+    result = EVALUATE("\x22\x04\x22\x03\x0C\x22\x07\x27", &value);
+    TAP_OK(result == 0 && value == 7 && collected_address == 4 && collected_length == 3 &&
+           collected_until_zero == 0, "trace: %d", result);
+    result = EVALUATE("\x22\x02\x22\x08\x2F\x22\x07\x27", &value);
+    TAP_OK(result == 0 && collected_address == 2 && collected_length == 8 &&
+           collected_until_zero == 1, "tracenz: %d", result);
+
+    // trace_quick and trace16 leave the address in place.
+    result = EVALUATE("\x22\x06\x0D\x02\x27", &value);
+    TAP_OK(result == 0 && value == 6 && collected_address == 6 && collected_length == 2,
+           "trace_quick: %d", result);
+    result = EVALUATE("\x22\x00\x30\x00\x10\x27", &value);
+    TAP_OK(result == 0 && value == 0 && collected_length == 16, "trace16: %d", result);
+
+    // Collection failures end the evaluation.
+    result = EVALUATE("\x22\x0F\x0D\x02\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_FAULT, "Fault: %d", result);
+    result = EVALUATE("\x22\x04\x0C\x27", &value);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Underflow: %d", result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_agent_validate();
+    test_proto_agent_evaluate();
+    test_proto_agent_failures();
+    test_proto_agent_printf();
+    test_proto_agent_trace();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,684 @@
+/**
+ *  @file       test_protocol_breakpoint.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol breakpoint commands.
+ */
+#include "protocol/breakpoint.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPIB TPCB TPBF TPBE TPHB TPCO TPBC TPTB
+static const unsigned long TEST_COUNT =   11 +  9 +  6 + 10 + 13 + 16 +  6 +  6;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Simulated target memory.  Accesses outside of this region fault.
+static unsigned char    target[256];
+/// Number of memory writes made.
+static int              writes;
+
+int gdbs_memory_read
+(
+    void            *comm,
+    gdbs_address_t   address,
+    void            *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(buffer, &target[address], length);
+    return 0;
+}
+
+int gdbs_memory_write
+(
+    void            *comm,
+    gdbs_address_t   address,
+    const void      *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    ++writes;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(&target[address], buffer, length);
+    return 0;
+}
+
+const unsigned char *gdbs_get_breakpoint_instruction
+(
+    gdbs_address_t   kind,
+    unsigned int    *length
+)
+{
+    switch (kind)
+    {
+        case 0:
+        case 2:
+            *length = 2;
+            return (const unsigned char *) "\xBE\xBE";
+        case 4:
+            *length = 4;
+            return (const unsigned char *) "\xDE\xAD\xBE\xEF";
+        default:
+            return NULL;
+    }
+}
+
+unsigned int gdbs_get_comparator_count
+(
+    enum gdbs_comparator_type type
+)
+{
+    return (type == GDBS_COMPARATOR_BREAK ? 2 : 3);
+}
+
+/// Programmed comparator types, plus one, for each pool.  Zero for an unused unit.
+static int comparators[2][4];
+
+int gdbs_set_comparator
+(
+    unsigned int                unit,
+    enum gdbs_comparator_type   type,
+    gdbs_address_t              address,
+    gdbs_address_t              length
+)
+{
+    int *slot = &comparators[type != GDBS_COMPARATOR_BREAK][unit];
+
+    (void) address;
+    assert(*slot == 0);
+
+    // Only power of two lengths can be matched.
+    if (length == 0 || (length & (length - 1)) != 0)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    *slot = (int) type + 1;
+    return 0;
+}
+
+void gdbs_clear_comparator
+(
+    unsigned int                unit,
+    enum gdbs_comparator_type   type
+)
+{
+    int *slot = &comparators[type != GDBS_COMPARATOR_BREAK][unit];
+
+    assert(*slot == (int) type + 1);
+    *slot = 0;
+}
+
+/// Simulated program counter.
+static gdbs_address_t   pc;
+/// Number of instruction cache flushes.
+static int              flushes;
+/// Single step state.
+static int              single_step;
+
+int proto_get_pc
+(
+    gdbs_address_t *value
+)
+{
+    *value = pc;
+    return 0;
+}
+
+int proto_get_register_bytes
+(
+    gdbs_address_t           regnum,
+    const unsigned char    **bytes,
+    unsigned int            *size
+)
+{
+    (void) regnum;
+    (void) bytes;
+    (void) size;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+void gdbs_flush_icache(void)
+{
+    ++flushes;
+}
+
+int gdbs_set_single_step
+(
+    int enable
+)
+{
+    single_step = enable;
+    return 0;
+}
+
+/// Range of the last memory read which held back writes were synchronized with.
+static gdbs_address_t   synced[2];
+
+int proto_sync_writes
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length
+)
+{
+    synced[0] = address;
+    synced[1] = length;
+    return 0;
+}
+
+/// Number of tracepoint hits, and the address of the last one.
+static int              trace_hits;
+static gdbs_address_t   trace_address;
+
+void proto_trace_hit
+(
+    gdbs_address_t address
+)
+{
+    ++trace_hits;
+    trace_address = address;
+}
+
+int proto_trace_collect_memory
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length,
+    int              until_zero
+)
+{
+    (void) address;
+    (void) length;
+    (void) until_zero;
+    return 0;
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+/**
+ * Reset the target and breakpoint table.
+ */
+static void reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(target); ++i)
+    {
+        target[i] = (unsigned char) i;
+    }
+    env.breakpoint_count = 0;
+    env.agent_pool_used = 0;
+    writes = 0;
+}
+
+/**
+ * Simulate entry to the stub with a stop event.
+ *
+ * @return Result of proto_breakpoint_hit().
+ */
+static int hit
+(
+    gdbs_address_t          address,
+    enum gdbs_stop_reason   reason
+)
+{
+    pc = address;
+    env.stop.signal = GDBS_SIGNAL_TRAP;
+    env.stop.reason = reason;
+    env.stop.address = 0;
+    env.stop.unit = -1;
+    return proto_breakpoint_hit();
+}
+
+// Assertion count: 5 + 2 + 4 = 11
+static void test_proto_insert_breakpoint(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+
+    result = run(proto_insert_breakpoint, "$Z0,40,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Insert: '%s'", reply);
+    TAP_OK(env.breakpoint_count == 1 && env.breakpoints[0].flags == BREAKPOINT_REQUESTED,
+           "Breakpoint recorded");
+    TAP_OK(writes == 0 && target[0x40] == 0x40, "Memory untouched until resume");
+    TAP_OK(memcmp(env.breakpoints[0].saved, "\x40\x41", 2) == 0, "Original saved");
+    TAP_OK(synced[0] == 0x40 && synced[1] == 2, "Held back writes synchronized");
+
+    // Entries are kept sorted by address, and may carry conditions.
+    run(proto_insert_breakpoint, "$Z0,20,4#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z0,30,2;X3,220127#00", reply, sizeof(reply));
+    TAP_OK(env.breakpoint_count == 3, "Count: %u", env.breakpoint_count);
+    TAP_OK(env.breakpoints[0].address == 0x20 && env.breakpoints[1].address == 0x30 &&
+           env.breakpoints[2].address == 0x40, "Sorted");
+
+    result = run(proto_insert_breakpoint, "$Z0,fffe,2#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT && env.breakpoint_count == 3, "Fault: %d", result);
+
+    result = run(proto_insert_breakpoint, "$Z0,50,3#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Unsupported kind: %d", result);
+
+    result = run(proto_insert_breakpoint, "$Z0,50#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed: %d", result);
+
+    result = run(proto_insert_breakpoint, "$Z9,50,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Unsupported type: '%s'", reply);
+}
+
+// Assertion count: 3 + 2 + 2 + 2 = 9
+static void test_proto_commit_breakpoints(void)
+{
+    char            reply[32];
+    unsigned int    changed;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+
+    run(proto_insert_breakpoint, "$Z0,10,2#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z0,20,4#00", reply, sizeof(reply));
+    changed = proto_commit_breakpoints();
+    TAP_OK(changed == 2, "Changed: %u", changed);
+    TAP_OK(memcmp(&target[0x10], "\xBE\xBE\x12", 3) == 0, "Breakpoint inserted");
+    TAP_OK(memcmp(&target[0x20], "\xDE\xAD\xBE\xEF\x24", 5) == 0, "Breakpoint inserted");
+
+    // Removing and reinserting while stopped does not touch memory.
+    writes = 0;
+    run(proto_remove_breakpoint, "$z0,10,2#00", reply, sizeof(reply));
+    run(proto_remove_breakpoint, "$z0,20,4#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z0,10,2#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z0,20,4#00", reply, sizeof(reply));
+    changed = proto_commit_breakpoints();
+    TAP_OK(changed == 0 && writes == 0, "Changed: %u, writes: %d", changed, writes);
+    TAP_OK(target[0x10] == 0xBE && env.breakpoint_count == 2, "Breakpoints still in place");
+
+    // Removal restores the original instruction.
+    run(proto_remove_breakpoint, "$z0,10,2#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$OK#9A") == 0, "Remove: '%s'", reply);
+    changed = proto_commit_breakpoints();
+    TAP_OK(changed == 1 && memcmp(&target[0x10], "\x10\x11", 2) == 0, "Breakpoint removed");
+
+    proto_clear_breakpoints();
+    changed = proto_commit_breakpoints();
+    TAP_OK(changed == 1 && env.breakpoint_count == 0, "Cleared: %u", changed);
+    TAP_OK(memcmp(&target[0x20], "\x20\x21\x22\x23", 4) == 0, "Original restored");
+}
+
+// Assertion count: 2 + 4 = 6
+static void test_proto_breakpoint_filter(void)
+{
+    char            reply[32];
+    unsigned char   data[8];
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+
+    run(proto_insert_breakpoint, "$Z0,10,4#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z0,16,2#00", reply, sizeof(reply));
+    proto_commit_breakpoints();
+
+    // Reads see the original instructions.
+    memcpy(data, &target[0x0E], 8);
+    proto_breakpoint_filter_read(0x0E, data, 8);
+    TAP_OK(memcmp(data, "\x0E\x0F\x10\x11\x12\x13\x14\x15", 8) == 0, "Filtered read");
+    memcpy(data, &target[0x12], 1);
+    proto_breakpoint_filter_read(0x12, data, 1);
+    TAP_OK(data[0] == 0x12, "Filtered partial read: %02X", data[0]);
+
+    // Writes update the saved instructions, but leave the breakpoints in place.
+    memcpy(data, "\xA0\xA1\xA2\xA3", 4);
+    proto_breakpoint_filter_write(0x0F, data, 4);
+    TAP_OK(memcmp(data, "\xA0\xDE\xAD\xBE", 4) == 0, "Filtered write");
+    TAP_OK(memcmp(env.breakpoints[0].saved, "\xA1\xA2\xA3\x13", 4) == 0, "Saved updated");
+
+    memcpy(data, "\xB0\xB1", 2);
+    proto_breakpoint_filter_write(0x20, data, 2);
+    TAP_OK(memcmp(data, "\xB0\xB1", 2) == 0, "Unrelated write");
+
+    proto_clear_breakpoints();
+    proto_commit_breakpoints();
+    TAP_OK(memcmp(&target[0x10], "\xA1\xA2\xA3\x13", 4) == 0, "Written data restored");
+}
+
+// Assertion count: 2 + 2 + 2 + 2 + 2 = 10
+static void test_proto_breakpoint_edge_cases(void)
+{
+    char            reply[32];
+    char            command[32];
+    int             result;
+    unsigned int    i;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+
+    // Fill the table.
+    for (i = 0; i < GDBS_BREAKPOINT_COUNT; ++i)
+    {
+        sprintf(command, "$Z0,%x,2#00", i * 2);
+        run(proto_insert_breakpoint, command, reply, sizeof(reply));
+    }
+    TAP_OK(env.breakpoint_count == GDBS_BREAKPOINT_COUNT, "Full: %u", env.breakpoint_count);
+    result = run(proto_insert_breakpoint, "$Z0,f0,2#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_RESOURCES, "Out of resources: %d", result);
+
+    // An existing breakpoint can still be requested.
+    run(proto_remove_breakpoint, "$z0,0,2#00", reply, sizeof(reply));
+    result = run(proto_insert_breakpoint, "$Z0,0,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Reinsert when full: %d", result);
+
+    // Removal of a breakpoint which was never inserted frees its entry without writing memory.
+    run(proto_remove_breakpoint, "$z0,2,2#00", reply, sizeof(reply));
+    writes = 0;
+    proto_commit_breakpoints();
+    TAP_OK(env.breakpoint_count == GDBS_BREAKPOINT_COUNT - 1 && writes == GDBS_BREAKPOINT_COUNT - 1,
+           "Count: %u, writes: %d", env.breakpoint_count, writes);
+
+    // Unknown breakpoints can be removed, unsupported types cannot.
+    result = run(proto_remove_breakpoint, "$z0,ff,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Remove unknown: '%s'", reply);
+    result = run(proto_remove_breakpoint, "$z9,ff,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Remove unsupported: '%s'", reply);
+
+    result = run(proto_remove_breakpoint, "$z0,ff#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed remove: %d", result);
+    result = run(proto_insert_breakpoint, "$Z0#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed insert: %d", result);
+
+    proto_clear_breakpoints();
+    proto_commit_breakpoints();
+    TAP_OK(env.breakpoint_count == 0, "Cleared");
+    for (i = 0; i < sizeof(target) && target[i] == (unsigned char) i; ++i)
+    {
+    }
+    TAP_OK(i == sizeof(target), "Memory restored");
+}
+
+// Assertion count: 4 + 4 + 3 + 2 = 13
+static void test_proto_hardware_breakpoint(void)
+{
+    char                    reply[32];
+    struct gdbs_stop_event  event;
+    int                     result;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+    proto_init_comparators();
+    TAP_OK(env.hw_breakpoint_count == 2 && env.watchpoint_count == 3,
+           "Counts: %u %u", env.hw_breakpoint_count, env.watchpoint_count);
+
+    // Hardware breakpoints are programmed immediately and leave memory untouched.
+    result = run(proto_insert_breakpoint, "$Z1,40,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Insert: '%s'", reply);
+    TAP_OK(comparators[0][0] == GDBS_COMPARATOR_BREAK + 1 && writes == 0, "Programmed");
+    run(proto_insert_breakpoint, "$Z1,40,2#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z1,50,2#00", reply, sizeof(reply));
+    result = run(proto_insert_breakpoint, "$Z1,60,2#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_RESOURCES, "Out of resources: %d", result);
+
+    // Watchpoints come from their own pool.
+    result = run(proto_insert_breakpoint, "$Z2,80,4#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && comparators[1][0] == GDBS_COMPARATOR_WATCH + 1, "Write watch");
+    run(proto_insert_breakpoint, "$Z3,90,1#00", reply, sizeof(reply));
+    run(proto_insert_breakpoint, "$Z4,a0,8#00", reply, sizeof(reply));
+    TAP_OK(comparators[1][1] == GDBS_COMPARATOR_RWATCH + 1 &&
+           comparators[1][2] == GDBS_COMPARATOR_AWATCH + 1, "Read and access watch");
+    run(proto_remove_breakpoint, "$z3,90,1#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$OK#9A") == 0 && comparators[1][1] == 0, "Remove: '%s'", reply);
+    result = run(proto_insert_breakpoint, "$Z3,90,3#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID && !env.watchpoints[1].used, "Rejected: %d", result);
+
+    // A triggered unit identifies the watchpoint.
+    event.signal = GDBS_SIGNAL_TRAP;
+    event.reason = GDBS_STOP_SIGNAL;
+    event.address = 0;
+    event.unit = 2;
+    proto_resolve_watchpoint(&event);
+    TAP_OK(event.reason == GDBS_STOP_AWATCH && event.address == 0xA0,
+           "Resolved: %d %lx", event.reason, (unsigned long) event.address);
+    event.reason = GDBS_STOP_SIGNAL;
+    event.unit = 1;
+    proto_resolve_watchpoint(&event);
+    TAP_OK(event.reason == GDBS_STOP_SIGNAL, "Unused unit: %d", event.reason);
+    event.unit = 7;
+    proto_resolve_watchpoint(&event);
+    TAP_OK(event.reason == GDBS_STOP_SIGNAL, "Invalid unit: %d", event.reason);
+
+    // Clearing releases every comparator.
+    proto_clear_breakpoints();
+    TAP_OK(comparators[0][0] == 0 && comparators[0][1] == 0 && comparators[1][0] == 0 &&
+           comparators[1][2] == 0, "Comparators cleared");
+    TAP_OK(!env.hw_breakpoints[0].used && !env.watchpoints[2].used, "Records released");
+}
+
+// Assertion count: 3 + 3 + 2 + 3 + 2 + 3 = 16
+static void test_proto_conditional_breakpoint(void)
+{
+    char    reply[32];
+    char    command[600];
+    int     result;
+    int     i;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+
+    // A false condition is stored with the breakpoint.
+    result = run(proto_insert_breakpoint, "$Z0,10,2;X3,220027#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Insert: '%s'", reply);
+    TAP_OK(env.agent_pool_used == 6 && env.breakpoints[0].actions_length == 6,
+           "Pool: %u", env.agent_pool_used);
+    proto_commit_breakpoints();
+    TAP_OK(target[0x10] == 0xBE, "Inserted");
+
+    // The hit is absorbed by stepping over the original instruction.
+    flushes = 0;
+    TAP_OK(hit(0x10, GDBS_STOP_SWBREAK) == 1, "Hit absorbed");
+    TAP_OK(target[0x10] == 0x10 && single_step == 1 && flushes == 1, "Stepping over");
+    TAP_OK(hit(0x12, GDBS_STOP_SIGNAL) == 1 && target[0x10] == 0xBE && single_step == 0,
+           "Step absorbed and breakpoint restored");
+
+    // Reinsertion replaces the conditions.  Any true condition stops.
+    run(proto_insert_breakpoint, "$Z0,10,2;X3,220027X3,220127#00", reply, sizeof(reply));
+    TAP_OK(env.agent_pool_used == 12, "Replaced: %u", env.agent_pool_used);
+    TAP_OK(hit(0x10, GDBS_STOP_SWBREAK) == 0, "True condition reported");
+
+    // Stops which are not hits of a conditional breakpoint are always reported.
+    run(proto_insert_breakpoint, "$Z0,20,2#00", reply, sizeof(reply));
+    proto_commit_breakpoints();
+    env.stepping = 1;
+    TAP_OK(hit(0x10, GDBS_STOP_SIGNAL) == 0, "Single step reported");
+    env.stepping = 0;
+    TAP_OK(hit(0x20, GDBS_STOP_SWBREAK) == 0, "Unconditional breakpoint reported");
+    TAP_OK(hit(0x10, GDBS_STOP_HWBREAK) == 0, "Other reason reported");
+
+    // Malformed and unsupported expressions are rejected.
+    result = run(proto_insert_breakpoint, "$Z0,30,2;X1,01#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Unsupported opcode: %d", result);
+    result = run(proto_insert_breakpoint, "$Z0,30,2;X3,22#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Truncated: %d", result);
+
+    // The pool is bounded, and entries which are dropped release their expressions.
+    strcpy(command, "$Z0,30,2;Xff,");
+    for (i = 0; i < 254; ++i)
+    {
+        strcat(command, "29");
+    }
+    strcat(command, "27#00");
+    result = run(proto_insert_breakpoint, command, reply, sizeof(reply));
+    TAP_OK(result == 0 && env.agent_pool_used == 270, "Long expression: %d", result);
+    command[4] = '4';
+    result = run(proto_insert_breakpoint, command, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_RESOURCES && env.breakpoint_count == 3, "Pool full: %d", result);
+    run(proto_remove_breakpoint, "$z0,10,2#00", reply, sizeof(reply));
+    proto_commit_breakpoints();
+    TAP_OK(env.agent_pool_used == 258 && env.breakpoints[1].actions == 0 &&
+           env.agent_pool[0] == 'X' && env.agent_pool[3] == 0x29,
+           "Released: %u", env.agent_pool_used);
+
+    proto_clear_breakpoints();
+    proto_commit_breakpoints();
+}
+
+// Assertion count: 6
+static void test_proto_breakpoint_commands(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+    env.console_claimed = 0;
+    env.console_sent = 0;
+
+    // dprintf "x=%d\n", 5
+    result = run(proto_insert_breakpoint,
+                 "$Z0,10,2;cmds:0,X12,22052200220034010007783d25645c6e0027#00",
+                 reply, sizeof(reply));
+    TAP_OK(result == 0 && env.agent_pool_used == 21, "Insert: %d", result);
+    proto_commit_breakpoints();
+
+    // The output is queued and the hit is absorbed.
+    TAP_OK(hit(0x10, GDBS_STOP_SWBREAK) == 1 && single_step == 1, "Hit absorbed");
+    TAP_OK(proto_console_pending() == 4 && memcmp(env.console, "x=5\n", 4) == 0, "Output queued");
+    TAP_OK(hit(0x12, GDBS_STOP_SIGNAL) == 1 && single_step == 0, "Step absorbed");
+
+    // Output past the threshold is still held in non-stop mode, where GDB does not accept it.
+    env.non_stop = 1;
+    env.console_claimed = env.console_sent + GDBS_CONSOLE_FLUSH_THRESHOLD;
+    hit(0x10, GDBS_STOP_SWBREAK);
+    TAP_OK(proto_console_pending() == GDBS_CONSOLE_FLUSH_THRESHOLD + 4, "Output held: %u",
+           proto_console_pending());
+    hit(0x12, GDBS_STOP_SIGNAL);
+    env.non_stop = 0;
+
+    result = run(proto_insert_breakpoint, "$Z0,10,2;cmds:0,X3,22#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed commands: %d", result);
+
+    env.console_sent = env.console_claimed;
+    proto_clear_breakpoints();
+    proto_commit_breakpoints();
+}
+
+// Assertion count: 6
+static void test_proto_trace_breakpoint(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+    reset();
+    trace_hits = 0;
+
+    result = proto_insert_trace_breakpoint(0x10);
+    proto_commit_breakpoints();
+    TAP_OK(result == 0 && target[0x10] == 0xBE && target[0x11] == 0xBE, "Inserted: %d", result);
+
+    // The hit is handed to the trace module and absorbed.
+    TAP_OK(hit(0x10, GDBS_STOP_SWBREAK) == 1 && trace_hits == 1 && trace_address == 0x10,
+           "Hit traced");
+    TAP_OK(hit(0x12, GDBS_STOP_SIGNAL) == 1 && target[0x10] == 0xBE, "Step absorbed");
+
+    // A breakpoint GDB also asked for is reported after the trace frame is collected.
+    run(proto_insert_breakpoint, "$Z0,10,2#00", reply, sizeof(reply));
+    proto_commit_breakpoints();
+    TAP_OK(hit(0x10, GDBS_STOP_SWBREAK) == 0 && trace_hits == 2, "Shared breakpoint reported");
+
+    // Clearing the tracepoints leaves GDB's breakpoint in place.
+    proto_clear_trace_breakpoints();
+    proto_commit_breakpoints();
+    TAP_OK(target[0x10] == 0xBE && hit(0x10, GDBS_STOP_SWBREAK) == 0 && trace_hits == 2,
+           "GDB breakpoint kept");
+    run(proto_remove_breakpoint, "$z0,10,2#00", reply, sizeof(reply));
+    proto_commit_breakpoints();
+    TAP_OK(target[0x10] == 0x10 && env.breakpoint_count == 0, "Removed");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_insert_breakpoint();
+    test_proto_commit_breakpoints();
+    test_proto_breakpoint_filter();
+    test_proto_breakpoint_edge_cases();
+    test_proto_hardware_breakpoint();
+    test_proto_conditional_breakpoint();
+    test_proto_breakpoint_commands();
+    test_proto_trace_breakpoint();
+
+    TAP_END_PLAN();
+}
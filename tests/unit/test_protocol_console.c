@@ -0,0 +1,216 @@
+/**
+ *  @file       test_protocol_console.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol console output.
+ */
+#include "protocol/console.c"
+
+#include "stdc/assert.h"
+#include "stdc/memcmp.h"
+#include "stdc/memcpy.h"
+#include "stdc/strlen.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPCF TPCW TGCW
+static const unsigned long TEST_COUNT =   11 +  4 +  8;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Simulated target memory holding a string.  Accesses outside of this region fault.
+static const char target[] = "hello";
+
+int gdbs_memory_read
+(
+    void            *comm,
+    gdbs_address_t   address,
+    void            *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(buffer, &target[address], length);
+    return 0;
+}
+
+/**
+ * Format a string and compare the queued output.
+ *
+ * @return Boolean indicating that the output matched.
+ */
+static int check
+(
+    const char          *format,
+    const agent_value_t *args,
+    unsigned int         count,
+    const char          *expected
+)
+{
+    env.console_claimed = 0;
+    env.console_sent = 0;
+    proto_console_format((const unsigned char *) format, strlen(format), args, count);
+    TAP_DIAG("'%.*s'", (int) proto_console_pending(), (const char *) env.console);
+    return (proto_console_pending() == strlen(expected) &&
+            memcmp(env.console, expected, proto_console_pending()) == 0);
+}
+
+// Assertion count: 11
+static void test_proto_console_format(void)
+{
+    agent_value_t negative5[] = { (agent_value_t) -5 };
+    agent_value_t widths[] = { 42, 42, (agent_value_t) -42 };
+    agent_value_t hex[] = { 255, 255, 255, 0x1234 };
+    agent_value_t all_ones[] = { (agent_value_t) -1 };
+    agent_value_t narrow[] = { 0x1FF, 0x12345 };
+    agent_value_t strings[] = { 0, 0, 0, 4 };
+    agent_value_t chars[] = { 'o', 'k', 1 };
+    agent_value_t wide[] = { (agent_value_t) 0 - ((agent_value_t) 1 << 40) };
+    agent_value_t seven[] = { 7 };
+    agent_value_t signs[] = { 0, 3, 3 };
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(check("a=%d\\n", negative5, 1, "a=-5\n"), "Escapes and negative");
+    TAP_OK(check("%5d|%-5d|%05d", widths, 3, "   42|42   |-0042"), "Widths");
+    TAP_OK(check("%x %X %#x %lx", hex, 4, "ff FF 0xff 1234"), "Hexadecimal");
+    TAP_OK(check("%u", all_ones, 1, "4294967295"), "Unsigned int");
+    TAP_OK(check("%hhd %hu", narrow, 2, "-1 9029"), "Narrow types");
+    TAP_OK(check("%s|%.3s|%6s|%s", strings, 4, "hello|hel| hello|o"), "Strings");
+    TAP_OK(check("%c%c %% %f", chars, 3, "ok % ?"), "Characters and unsupported");
+    TAP_OK(check("%lld", wide, 1, "-1099511627776"), "Long long");
+    TAP_OK(check("%d %d", seven, 1, "7 "), "Missing argument");
+    TAP_OK(check("%.0d|%+d|% d", signs, 3, "|+3| 3"), "Signs and precision");
+    TAP_OK(check("%#o %3c", seven, 1, "07 "), "Octal");
+}
+
+// Assertion count: 4
+static void test_proto_console_write(void)
+{
+    unsigned char   data[GDBS_CONSOLE_BUFFER_LENGTH + 1];
+    char            reply[GDBS_CONSOLE_BUFFER_LENGTH * 2 + 8];
+    struct testbuf  buf = { 0, sizeof(reply), (unsigned char *) reply };
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.comm = &buf;
+    env.console_claimed = 0;
+    env.console_sent = 0;
+    reply[0] = '\0';
+
+    result = proto_console_flush();
+    TAP_OK(result == 0 && buf.i == 0, "Nothing to flush");
+
+    proto_console_write((const unsigned char *) "hi", 2);
+    TAP_OK(buf.i == 0 && proto_console_pending() == 2, "Queued");
+    result = proto_console_flush();
+    TAP_OK(result == 0 && strcmp(reply, "$O6869#2C") == 0, "Flushed: '%s'", reply);
+
+    // Output which does not fit is sent a buffer at a time.
+    buf.i = 0;
+    memset(data, 'a', sizeof(data));
+    proto_console_write(data, sizeof(data));
+    TAP_OK(buf.i == GDBS_CONSOLE_BUFFER_LENGTH * 2 + 5 && proto_console_pending() == 1,
+           "Full buffer sent: %u", (unsigned int) buf.i);
+}
+
+// Assertion count: 2 + 1 + 2 + 1 + 2 = 8
+static void test_gdbs_console_write(void)
+{
+    unsigned char   data[GDBS_CONSOLE_BUFFER_LENGTH];
+    char            reply[GDBS_CONSOLE_BUFFER_LENGTH * 2 + 8];
+    struct testbuf  buf = { 0, sizeof(reply), (unsigned char *) reply };
+    unsigned int    count;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.comm = &buf;
+    reply[0] = '\0';
+
+    // Output which wraps around the end of the ring is sent in one packet.
+    env.console_claimed = GDBS_CONSOLE_BUFFER_LENGTH - 2;
+    env.console_sent = env.console_claimed;
+    count = gdbs_console_write("abcd", 4);
+    TAP_OK(count == 4 && proto_console_pending() == 4, "Queued: %u", count);
+    TAP_OK(env.console[0] == 'c' && env.console[GDBS_CONSOLE_BUFFER_LENGTH - 2] == 'a',
+           "Wrapped");
+    result = proto_console_flush();
+    TAP_OK(result == 0 && strcmp(reply, "$O61626364#F1") == 0, "Flushed: '%s'", reply);
+
+    // Output which does not fit is discarded, rather than sent from the writer's context.
+    buf.i = 0;
+    memset(data, 'b', sizeof(data));
+    count = gdbs_console_write(data, 10);
+    count += gdbs_console_write(data, sizeof(data));
+    TAP_OK(count == GDBS_CONSOLE_BUFFER_LENGTH && buf.i == 0, "Filled: %u", count);
+    TAP_OK(gdbs_console_write("c", 1) == 0, "Full");
+
+    // Nothing is sent while another context is still writing.
+    env.console_writers = 1;
+    result = proto_console_flush();
+    TAP_OK(result == 0 && buf.i == 0 && proto_console_pending() == GDBS_CONSOLE_BUFFER_LENGTH,
+           "Writer active");
+    env.console_writers = 0;
+
+    result = proto_console_flush();
+    TAP_OK(result == 0 && buf.i == GDBS_CONSOLE_BUFFER_LENGTH * 2 + 5, "Sent: %u",
+           (unsigned int) buf.i);
+    TAP_OK(proto_console_pending() == 0 && env.console_flushing == 0, "Ring empty");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_console_format();
+    test_proto_console_write();
+    test_gdbs_console_write();
+
+    TAP_END_PLAN();
+}
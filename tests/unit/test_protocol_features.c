@@ -0,0 +1,144 @@
+/**
+ *  @file       test_protocol_features.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol target description transfers.  Built once against the
+ *              plain documents generated from tests/unit/features, and once against the compressed
+ *              documents.
+ */
+#include "protocol/features.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPFM TPXF
+static const unsigned long TEST_COUNT =    4 +  8;
+
+/// Documents expected after minification, in the order embedded.
+static const char *const expected[] =
+{
+    "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\"><target version=\"1.0\">"
+    "<architecture>arm</architecture><xi:include href=\"fpu.xml\"/>"
+    "<xi:include href=\"long.xml\"/></target>",
+
+    "<?xml version=\"1.0\"?><!DOCTYPE feature SYSTEM \"gdb-target.dtd\">"
+    "<feature name=\"org.gnu.gdb.arm.vfp\">"
+    "<reg name=\"d0\" bitsize=\"64\" type=\"ieee_double\" regnum=\"26\"/>"
+    "<reg name=\"d1\" bitsize=\"64\" type=\"ieee_double\"/>"
+    "<reg name=\"d2\" bitsize=\"64\" type=\"ieee_double\"/>"
+    "<reg name=\"d3\" bitsize=\"64\" type=\"ieee_double\"/>"
+    "<reg name=\"fpscr\" bitsize=\"32\" type=\"int\" group=\"float\"/></feature>",
+
+    "<?xml version=\"1.0\"?><!DOCTYPE feature SYSTEM \"gdb-target.dtd\">"
+    "<feature name=\"org.example.long\"><reg name=\"r"
+    "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+    "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+    "xxxxxxxxxxxxxxxx\" bitsize=\"32\"/></feature>",
+};
+
+/// Number of expected documents.
+#define EXPECTED_COUNT (sizeof(expected) / sizeof(expected[0]))
+
+/**
+ * Read a window of a document by name.
+ *
+ * @return Result of proto_xfer_features().
+ */
+static int read_document
+(
+    const char      *name,
+    gdbs_address_t   offset,
+    unsigned char   *data,
+    size_t           length
+)
+{
+    return proto_xfer_features((const unsigned char *) name, strlen(name), offset, data, length);
+}
+
+// Assertion count: 1 + 1 + 1 + 1 = 4
+static void test_proto_features_minified(void)
+{
+    unsigned int    i;
+    int             minified = 1;
+    int             compressed = 1;
+
+    TAP_DIAG("In %s", __func__);
+
+    TAP_OK(proto_features_available(), "Available");
+    TAP_OK(features_file_count == EXPECTED_COUNT, "Document count: %u", features_file_count);
+    assert(features_file_count == EXPECTED_COUNT);
+
+    for (i = 0; i < features_file_count; ++i)
+    {
+        minified &= (features_files[i].length == strlen(expected[i]));
+        compressed &= ((features_files[i].index != NULL) == (features_files[i].block_length != 0));
+    }
+    TAP_OK(minified, "Minified lengths");
+    TAP_OK(compressed, "Index present for compressed documents");
+}
+
+// Assertion count: 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 = 8
+static void test_proto_xfer_features(void)
+{
+    static const size_t  windows[] = { 1, 2, 7, 64, 100, 1000 };
+    unsigned char        data[1000];
+    const char          *text;
+    size_t               length;
+    size_t               offset;
+    size_t               expect;
+    unsigned int         i;
+    unsigned int         w;
+    int                  result;
+    int                  matched;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Every window of every document matches, wherever it starts and however long it is.
+    for (i = 0; i < EXPECTED_COUNT; ++i)
+    {
+        text = expected[i];
+        length = strlen(text);
+        matched = 1;
+        for (w = 0; w < sizeof(windows) / sizeof(windows[0]); ++w)
+        {
+            for (offset = 0; offset <= length; ++offset)
+            {
+                expect = (length - offset < windows[w] ? length - offset : windows[w]);
+                result = read_document(features_files[i].name, offset, data, windows[w]);
+                matched &= (result == (int) expect && memcmp(data, &text[offset], expect) == 0);
+            }
+        }
+        TAP_OK(matched, "Windows of %s", features_files[i].name);
+    }
+
+    // The whole document fits a large window.
+    result = read_document("target.xml", 0, data, sizeof(data));
+    TAP_OK(result == (int) strlen(expected[0]), "Whole document: %d", result);
+
+    result = read_document("target.xml", 5000, data, sizeof(data));
+    TAP_OK(result == 0, "Past the end: %d", result);
+
+    result = read_document("target.xm", 0, data, sizeof(data));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Partial name: %d", result);
+
+    result = read_document("", 0, data, sizeof(data));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No annex: %d", result);
+
+    result = read_document("long.xml", 0, data, 0);
+    TAP_OK(result == 0, "Empty window: %d", result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_features_minified();
+    test_proto_xfer_features();
+
+    TAP_END_PLAN();
+}
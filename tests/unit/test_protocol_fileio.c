@@ -0,0 +1,221 @@
+/**
+ *  @file       test_protocol_fileio.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol File-I/O host calls.
+ */
+#include "protocol/fileio.c"
+
+#include "protocol/receive.h"
+#include "stdc/assert.h"
+#include "stdc/memcpy.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TGHC TPHR
+static const unsigned long TEST_COUNT =   11 +  5;
+
+static struct environment   env;
+static unsigned char        packet_buffer[GDBS_PACKET_BUFFER_LENGTH];
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+#define TB_INIT(p) ((struct testbuf) { 0, sizeof(p), (unsigned char *) (p) })
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Number of times the target was resumed.
+static unsigned int resumes;
+
+int proto_resume
+(
+    int step
+)
+{
+    (void) step;
+    ++resumes;
+    return PROTO_RESUME;
+}
+
+/// Number of stop replies sent.
+static unsigned int stops;
+
+int proto_send_stop_reply(void)
+{
+    ++stops;
+    return 0;
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    // Commands are placed in the packet buffer, as they would be on reception.
+    length = strlen(command);
+    memcpy(packet_buffer, command, length);
+    packet_tokenizer_init(&tokenizer, packet_buffer, length);
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+/// Reply GDB gives to the next host call.
+static const char      *gdb_reply;
+/// Request sent to GDB for the most recent host call.
+static char             request[64];
+/// Arguments of the most recent host call.
+static gdbs_address_t   request_args[4];
+/// Result of handling GDB's reply to the most recent host call.
+static int              reply_result;
+/// Number of times the stub was entered.
+static unsigned int     entries;
+
+/**
+ * Simulate entry into the stub for a host call, sending the request and handling GDB's reply.
+ */
+void gdbs_breakpoint(void)
+{
+    struct testbuf   buf = TB_INIT(request);
+    char             reply[16];
+
+    ++entries;
+    memcpy(request_args, env.host_args, sizeof(request_args));
+    env.comm = &buf;
+    env.packet_buffer = packet_buffer;
+    proto_send_host_call();
+    reply_result = run(proto_host_reply, gdb_reply, reply, sizeof(reply));
+    env.packet_buffer = NULL;
+}
+
+// Assertion count: 3 + 3 + 3 + 1 + 1 = 11
+static void test_gdbs_host_calls(void)
+{
+    static const char    path[] = "log.txt";
+    unsigned char        data[16];
+    int                  result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // A successful call resumes the target once GDB has replied.
+    gdb_reply = "$Fa#00";
+    result = gdbs_host_write(1, data, 10);
+    TAP_OK(result == 10 && resumes == 1, "Write result: %d", result);
+    TAP_OK(strncmp(request, "$Fwrite,1,", 10) == 0 && strstr(request, ",A#") != NULL,
+           "Write request: %s", request);
+    TAP_OK(request_args[1] == (gdbs_address_t) data, "Buffer passed by address");
+
+    // The path is passed as a pointer/length pair, including its terminator.
+    gdb_reply = "$F-1,2#00";
+    result = gdbs_host_open(path, GDBS_HOST_O_WRONLY | GDBS_HOST_O_CREAT, 0644);
+    TAP_OK(result == -GDBS_HOST_ENOENT, "Open result: %d", result);
+    TAP_OK(strncmp(request, "$Fopen,", 7) == 0 && strstr(request, "/8,201,1A4#") != NULL,
+           "Open request: %s", request);
+    TAP_OK(request_args[0] == (gdbs_address_t) path, "Path passed by address");
+
+    // An interrupted call is reported as a stop rather than resuming.
+    gdb_reply = "$F-1,4,C#00";
+    result = gdbs_host_read(0, data, sizeof(data));
+    TAP_OK(result == -GDBS_HOST_EINTR, "Read result: %d", result);
+    TAP_OK(stops == 1 && resumes == 2, "Stopped: %u stops, %u resumes", stops, resumes);
+    TAP_OK(env.stop.signal == GDBS_SIGNAL_INT, "Stop signal: %d", (int) env.stop.signal);
+
+    gdb_reply = "$F0#00";
+    result = gdbs_host_close(3);
+    TAP_OK(result == 0 && env.host_call == NULL && env.host_call_pending == 0,
+           "Close result: %d", result);
+
+    // In non-stop mode the stub is never entered.
+    env.non_stop = 1;
+    result = gdbs_host_close(3);
+    TAP_OK(result == -GDBS_HOST_EBUSY && entries == 4, "Non-stop result: %d", result);
+    env.non_stop = 0;
+}
+
+// Assertion count: 1 + 1 + 1 + 1 + 1 = 5
+static void test_proto_host_reply(void)
+{
+    char    reply[16];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // A reply without a call is not understood.
+    result = run(proto_host_reply, "$F0#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "No call: %s", reply);
+
+    env.host_call = "close";
+    result = run(proto_host_reply, "$Fz#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid return code: %d", result);
+
+    result = run(proto_host_reply, "$F-#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing return code: %d", result);
+
+    result = run(proto_host_reply, "$F-1,#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing error number: %d", result);
+
+    // An unknown error is reported when GDB gives no error number.
+    result = run(proto_host_reply, "$F-1#00", reply, sizeof(reply));
+    TAP_OK(result == PROTO_RESUME && env.host_result == -GDBS_HOST_EUNKNOWN,
+           "Unknown error: %d", env.host_result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_gdbs_host_calls();
+    test_proto_host_reply();
+
+    TAP_END_PLAN();
+}
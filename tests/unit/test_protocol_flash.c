@@ -0,0 +1,373 @@
+/**
+ *  @file       test_protocol_flash.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol memory map and flash programming commands.
+ */
+#include "protocol/flash.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPMM TPME TPFE TPFW TPFF
+static const unsigned long TEST_COUNT =    5 +  3 +  4 +  7 +  4;
+
+static struct environment   env;
+static unsigned char        packet_buffer[GDBS_PACKET_BUFFER_LENGTH];
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Address of the simulated flash.
+#define FLASH_ADDRESS 0x1000
+/// Length of the simulated flash, which is eight pages.
+#define FLASH_LENGTH (8 * GDBS_FLASH_PAGE_LENGTH)
+
+/// Memory map reported to the stub.
+static const struct gdbs_memory_region regions[] =
+{
+    { GDBS_MEMORY_ROM, 0x0, FLASH_ADDRESS, 0, 0 },
+    { GDBS_MEMORY_FLASH, FLASH_ADDRESS, FLASH_LENGTH, 0x400, 0 },
+    { GDBS_MEMORY_RAM, 0x20000000, 0x8000, 0, 1 },
+};
+/// Number of regions reported to the stub.
+static unsigned int region_count;
+
+const struct gdbs_memory_region *gdbs_get_memory_map
+(
+    unsigned int *count
+)
+{
+    *count = region_count;
+    return regions;
+}
+
+/// Simulated flash.
+static unsigned char    flash[FLASH_LENGTH];
+/// Number of times each page of the simulated flash was programmed.
+static unsigned int     programmed[FLASH_LENGTH / GDBS_FLASH_PAGE_LENGTH];
+/// Range passed to the last erase.
+static gdbs_address_t   erased[2];
+/// Page being programmed, which completes when the stub waits.
+static const unsigned char *program_data;
+/// Address of the page being programmed.
+static gdbs_address_t   program_address;
+/// Copy of the page being programmed, to detect changes before programming completes.
+static unsigned char    program_copy[GDBS_FLASH_PAGE_LENGTH];
+/// Boolean indicating that programming was started while busy, or data changed while in progress.
+static int              program_misused;
+/// Result to return from the next wait.
+static int              wait_result;
+
+int gdbs_flash_erase
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length
+)
+{
+    if (address < FLASH_ADDRESS || address + length > FLASH_ADDRESS + FLASH_LENGTH)
+    {
+        return -GDBS_ERROR_INVALID;
+    }
+    erased[0] = address;
+    erased[1] = length;
+    memset(&flash[address - FLASH_ADDRESS], 0xFF, length);
+    return 0;
+}
+
+int gdbs_flash_program
+(
+    gdbs_address_t           address,
+    const unsigned char     *data,
+    gdbs_address_t           length
+)
+{
+    if (address < FLASH_ADDRESS || address + length > FLASH_ADDRESS + FLASH_LENGTH)
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    program_misused |= (program_data != NULL || length != GDBS_FLASH_PAGE_LENGTH ||
+                        address % GDBS_FLASH_PAGE_LENGTH != 0);
+    program_data = data;
+    program_address = address;
+    memcpy(program_copy, data, GDBS_FLASH_PAGE_LENGTH);
+    return 0;
+}
+
+int gdbs_flash_wait(void)
+{
+    int result = wait_result;
+
+    if (program_data != NULL)
+    {
+        program_misused |= (memcmp(program_copy, program_data, GDBS_FLASH_PAGE_LENGTH) != 0);
+        memcpy(&flash[program_address - FLASH_ADDRESS], program_data, GDBS_FLASH_PAGE_LENGTH);
+        ++programmed[(program_address - FLASH_ADDRESS) / GDBS_FLASH_PAGE_LENGTH];
+        program_data = NULL;
+    }
+    wait_result = 0;
+    return result;
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    size_t       command_length,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    memcpy(packet_buffer, command, command_length);
+    packet_tokenizer_init(&tokenizer, packet_buffer, command_length);
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+/// Flash contents written by the test at an address, in one of two versions.
+#define PATTERN(a, v) ((unsigned char) ((a) * 13 + (v)))
+
+/**
+ * Send a 'vFlashWrite' command holding the test pattern for a range of addresses.  The command
+ * character is followed directly by the arguments, as the command name is consumed by the
+ * dispatcher.
+ *
+ * @return Handler result.
+ */
+static int write_pattern
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length,
+    unsigned int     version,
+    char            *reply,
+    size_t           reply_length
+)
+{
+    static char     command[GDBS_PACKET_BUFFER_LENGTH];
+    size_t          used;
+    gdbs_address_t  i;
+
+    used = (size_t) sprintf(command, "$v%lx:", (unsigned long) address);
+    for (i = 0; i < length; ++i)
+    {
+        used += binary_encode(&command[used], PATTERN(address + i, version));
+    }
+    memcpy(&command[used], "#00", 3);
+    return run(proto_flash_write, command, used + 3, reply, reply_length);
+}
+
+// Assertion count: 1 + 1 + 1 + 2 = 5
+static void test_proto_xfer_memory_map(void)
+{
+    static const char expected[] =
+        DOCUMENT_HEADER
+        "<memory type=\"rom\" start=\"0x0\" length=\"0x1000\"/>\n"
+        "<memory type=\"flash\" start=\"0x1000\" length=\"0x800\">\n"
+        "<property name=\"blocksize\">0x400</property>\n</memory>\n"
+        "<memory type=\"ram\" start=\"0x20000000\" length=\"0x8000\"/>\n"
+        DOCUMENT_FOOTER;
+    char            document[sizeof(expected) + 64];
+    size_t          offset = 0;
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    region_count = sizeof(regions) / sizeof(regions[0]);
+    TAP_OK(proto_memory_map_available(), "Map available");
+
+    // Read the whole document in windows which split elements.
+    do
+    {
+        result = proto_xfer_memory_map(NULL, 0, offset, (unsigned char *) &document[offset], 50);
+        offset += (size_t) (result > 0 ? result : 0);
+    } while (result == 50);
+    document[offset] = '\0';
+    TAP_OK(strcmp(document, expected) == 0, "Document: '%s'", document);
+
+    result = proto_xfer_memory_map(NULL, 0, 200, (unsigned char *) document, 8);
+    TAP_OK(result == 8 && memcmp(document, &expected[200], 8) == 0, "Window: %d", result);
+
+    result = proto_xfer_memory_map((const unsigned char *) "x", 1, 0, (unsigned char *) document,
+                                   8);
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Annex: %d", result);
+
+    region_count = 0;
+    result = proto_xfer_memory_map(NULL, 0, 0, (unsigned char *) document, 8);
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND && !proto_memory_map_available(), "No map: %d", result);
+}
+
+// Assertion count: 1 + 1 + 1 = 3
+static void test_proto_memory_executable(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    region_count = sizeof(regions) / sizeof(regions[0]);
+    TAP_OK(proto_memory_executable(0x1000, 0x10) && proto_memory_executable(0x20007FFF, 2),
+           "Code regions");
+    TAP_OK(!proto_memory_executable(0x20000000, 0x8000) &&
+           !proto_memory_executable(0x20007FFF, 1), "Data region");
+
+    region_count = 0;
+    TAP_OK(proto_memory_executable(0x20000000, 4), "No map");
+}
+
+// Assertion count: 2 + 1 + 1 = 4
+static void test_proto_flash_erase(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(flash, 0, sizeof(flash));
+    env.icache_dirty = 0;
+    result = run(proto_flash_erase, "$v1000,800#00", 13, reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Erase result: %d", result);
+    TAP_OK(erased[0] == 0x1000 && erased[1] == 0x800 && flash[0x7FF] == 0xFF && env.icache_dirty,
+           "Erased: %lx,%lx", (unsigned long) erased[0], (unsigned long) erased[1]);
+
+    result = run(proto_flash_erase, "$v1000,1000#00", 14, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID && reply[0] == '\0', "Erase failed: %d", result);
+
+    result = run(proto_flash_erase, "$v1000#00", 9, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing length: %d", result);
+}
+
+// Assertion count: 2 + 1 + 1 + 1 + 1 + 1 = 7
+static void test_proto_flash_write(void)
+{
+    char            reply[32];
+    int             result;
+    int             matched = 1;
+    unsigned int    i;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(flash, 0xFF, sizeof(flash));
+    memset(programmed, 0, sizeof(programmed));
+    program_misused = 0;
+
+    // The first page is programmed once the writes move on, while the second is received.
+    result = write_pattern(0x1010, 0x100, 0, reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Write result: %d", result);
+    TAP_OK(program_data != NULL && program_address == 0x1000 && programmed[0] == 0,
+           "Programming: %lx", (unsigned long) program_address);
+
+    // Writes which overlap within the page being collected are merged.
+    result = write_pattern(0x1100, 0x20, 1, reply, sizeof(reply));
+    TAP_OK(result == 0 && program_address == 0x1000, "Overlapping write: %d", result);
+
+    result = write_pattern(0x1120, 0x1F0, 0, reply, sizeof(reply));
+    TAP_OK(result == 0 && program_address == 0x1200 && programmed[0] == 1 && programmed[1] == 1,
+           "Pipelined: %lx", (unsigned long) program_address);
+
+    result = run(proto_flash_done, "$v#00", 5, reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0 && program_data == NULL,
+           "Done result: %d", result);
+
+    for (i = 0; i < FLASH_LENGTH; ++i)
+    {
+        if (i < 0x10 || i >= 0x310)
+        {
+            matched &= (flash[i] == 0xFF);
+        }
+        else
+        {
+            matched &= (flash[i] == PATTERN(FLASH_ADDRESS + i, (i >= 0x100 && i < 0x120)));
+        }
+    }
+    TAP_OK(matched, "Flash contents");
+
+    for (i = 0; i < 4 && programmed[i] == 1; ++i)
+    {
+    }
+    TAP_OK(i == 4 && programmed[4] == 0 && !program_misused, "Each page programmed once: %u", i);
+}
+
+// Assertion count: 1 + 1 + 1 + 1 = 4
+static void test_proto_flash_failures(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Programming errors are reported when the stub waits for them.
+    result = write_pattern(0x1400, 0x101, 0, reply, sizeof(reply));
+    wait_result = -GDBS_ERROR_FAULT;
+    result = run(proto_flash_done, "$v#00", 5, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT && reply[0] == '\0', "Failed programming: %d", result);
+    result = run(proto_flash_done, "$v#00", 5, reply, sizeof(reply));
+    TAP_OK(result == 0 && program_data == NULL, "Recovered: %d", result);
+
+    // Pages outside the flash fail to start programming.
+    result = write_pattern(0x800, 0x101, 0, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT && reply[0] == '\0', "Outside flash: %d", result);
+    env.flash_page_open = 0;
+
+    result = run(proto_flash_write, "$v1000:}#00", 11, reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Truncated escape: %d", result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    env.packet_buffer = packet_buffer;
+    test_proto_xfer_memory_map();
+    test_proto_memory_executable();
+    test_proto_flash_erase();
+    test_proto_flash_write();
+    test_proto_flash_failures();
+
+    TAP_END_PLAN();
+}
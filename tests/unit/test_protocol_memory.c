@@ -0,0 +1,565 @@
+/**
+ *  @file       test_protocol_memory.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol memory access commands.
+ */
+#include "protocol/memory.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPRM TPWM TPWB TPWC TPMC TPSM
+static const unsigned long TEST_COUNT =   15 + 17 +  8 + 12 +  8 + 13;
+
+static struct environment   env;
+static unsigned char        packet_buffer[GDBS_PACKET_BUFFER_LENGTH];
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+#define TB_INIT(p) ((struct testbuf) { 0, sizeof(p), (unsigned char *) (p) })
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Simulated target memory.  Accesses outside of this region fault.
+static unsigned char    target[256];
+/// Number of bytes transferred by the most recent memory hook call.
+static gdbs_address_t   last_length;
+/// Number of memory writes made.
+static unsigned int     writes;
+
+/// Base of a large read-only region, whose contents are generated rather than stored.  It spans
+/// several packet buffers, and holds a single copy of the magic value.
+#define LARGE_ADDRESS 0x10000
+/// Length of the large region.
+#define LARGE_LENGTH 0x10000
+/// Offset of the magic value within the large region, which straddles a search window boundary.
+#define LARGE_MAGIC_OFFSET 0x3FE
+/// Magic value held by the large region.  No other byte in the region has the top bit set.
+static const unsigned char large_magic[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+
+int gdbs_memory_read
+(
+    void            *comm,
+    gdbs_address_t   address,
+    void            *buffer,
+    gdbs_address_t   length
+)
+{
+    gdbs_address_t   offset;
+    gdbs_address_t   i;
+
+    (void) comm;
+    last_length = length;
+    if (address >= LARGE_ADDRESS)
+    {
+        if (address + length > LARGE_ADDRESS + LARGE_LENGTH)
+        {
+            return -GDBS_ERROR_FAULT;
+        }
+        for (i = 0; i < length; ++i)
+        {
+            offset = address + i - LARGE_ADDRESS;
+            ((unsigned char *) buffer)[i] = (unsigned char) ((offset * 7) & 0x7F);
+            if (offset >= LARGE_MAGIC_OFFSET && offset < LARGE_MAGIC_OFFSET + sizeof(large_magic))
+            {
+                ((unsigned char *) buffer)[i] = large_magic[offset - LARGE_MAGIC_OFFSET];
+            }
+        }
+        return 0;
+    }
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(buffer, &target[address], length);
+    return 0;
+}
+
+int gdbs_memory_write
+(
+    void            *comm,
+    gdbs_address_t   address,
+    const void      *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    last_length = length;
+    ++writes;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(&target[address], buffer, length);
+    return 0;
+}
+
+/// Number of bytes passed through the breakpoint filters.
+static gdbs_address_t   filtered;
+
+void proto_breakpoint_filter_read
+(
+    gdbs_address_t   address,
+    unsigned char   *data,
+    gdbs_address_t   length
+)
+{
+    (void) address;
+    (void) data;
+    filtered += length;
+}
+
+void proto_breakpoint_filter_write
+(
+    gdbs_address_t   address,
+    unsigned char   *data,
+    gdbs_address_t   length
+)
+{
+    (void) address;
+    (void) data;
+    filtered += length;
+}
+
+/// Simulated memory from this address on never holds code.
+#define DATA_ADDRESS 0x80
+
+int proto_memory_executable
+(
+    gdbs_address_t   address,
+    gdbs_address_t   length
+)
+{
+    (void) length;
+    return (address < DATA_ADDRESS);
+}
+
+/// Address of the memory held by the simulated trace frame, which holds two bytes.
+#define TRACE_ADDRESS 0x40
+
+int proto_trace_read_memory
+(
+    gdbs_address_t   address,
+    unsigned char   *data,
+    gdbs_address_t   length
+)
+{
+    if (address != TRACE_ADDRESS)
+    {
+        return -GDBS_ERROR_NOT_FOUND;
+    }
+    memset(data, 0x5A, length < 2 ? length : 2);
+    return (length < 2 ? (int) length : 2);
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    // Commands are placed in the packet buffer, as they would be on reception.
+    length = strlen(command);
+    memcpy(packet_buffer, command, length);
+    packet_tokenizer_init(&tokenizer, packet_buffer, length);
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+// Assertion count: 3 + 2 + 2 + 1 + 1 + 1 + 3 + 2 = 15
+static void test_proto_read_memory(void)
+{
+    char    reply[GDBS_PACKET_BUFFER_LENGTH * 2];
+    int     result;
+    size_t  i;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.packet_buffer = packet_buffer;
+    for (i = 0; i < sizeof(target); ++i)
+    {
+        target[i] = (unsigned char) i;
+    }
+
+    filtered = 0;
+    result = run(proto_read_memory, "$m10,4#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$10111213#8A") == 0, "Reply: '%s'", reply);
+    TAP_OK(filtered == 4, "Filtered: %lu", (unsigned long) filtered);
+
+    result = run(proto_read_memory, "$mfe,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$FEFF#17") == 0, "Reply: '%s'", reply);
+
+    result = run(proto_read_memory, "$mfe,4#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT, "Faulting read result: %d", result);
+    TAP_OK(reply[0] == '\0', "No reply: '%s'", reply);
+
+    result = run(proto_read_memory, "$m10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing length: %d", result);
+
+    result = run(proto_read_memory, "$mxyz,4#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid address: %d", result);
+
+    result = run(proto_read_memory, "$m0,ff#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strlen(reply) == 0xFF * 2 + 4, "Full length read: %d", result);
+
+    result = run(proto_read_memory, "$m0,100000#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT || result == 0, "Oversized read: %d", result);
+    TAP_OK(last_length == READ_LIMIT, "Clamped read length: %lu", (unsigned long) last_length);
+    TAP_OK(memcmp(packet_buffer, "$m0,100000#00", 13) == 0, "Command left intact");
+
+    // With a trace frame selected, reads are served from the frame, and may come up short.
+    env.trace_selected = 1;
+    result = run(proto_read_memory, "$m40,4#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$5A5A#EC") == 0, "Trace frame read: '%s'", reply);
+    result = run(proto_read_memory, "$m10,4#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Not in trace frame: %d", result);
+    env.trace_selected = 0;
+}
+
+// Assertion count: 5 + 3 + 2 + 1 + 1 + 1 + 1 + 2 + 1 = 17
+static void test_proto_write_memory(void)
+{
+    char    reply[64];
+    char    command[WRITE_CHUNK_LENGTH * 4 + 16];
+    int     result;
+    size_t  i;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(target, 0, sizeof(target));
+
+    filtered = 0;
+    env.icache_dirty = 0;
+    result = run(proto_write_memory, "$M10,4:a1B2c3D4#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Write result: %d", result);
+    TAP_OK(strcmp(reply, "$OK#9A") == 0, "Reply: '%s'", reply);
+    TAP_OK(target[0x10] == 0 && filtered == 4, "Held back: %lu", (unsigned long) filtered);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && memcmp(&target[0x10], "\xA1\xB2\xC3\xD4", 4) == 0, "Memory written");
+    TAP_OK(env.icache_dirty && env.pending_write_count == 0, "Committed");
+
+    result = run(proto_write_memory, "$M20,0:#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Empty write result: %d", result);
+    TAP_OK(strcmp(reply, "$OK#9A") == 0, "Reply: '%s'", reply);
+    TAP_OK(target[0x20] == 0 && env.pending_write_count == 0, "Memory untouched");
+
+    // A faulting write is only reported once it is committed.
+    result = run(proto_write_memory, "$Mff,2:1234#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Held back write: %d", result);
+    result = proto_commit_writes();
+    TAP_OK(result == -GDBS_ERROR_FAULT && env.pending_write_count == 0,
+           "Faulting commit: %d", result);
+
+    result = run(proto_write_memory, "$M10,4:a1b2c3#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Short data: %d", result);
+
+    result = run(proto_write_memory, "$M10,1:zz#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid data: %d", result);
+
+    result = run(proto_write_memory, "$M10:12#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing length: %d", result);
+
+    result = run(proto_write_memory, "$M10,1,12#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing data: %d", result);
+
+    // Unaligned write spanning several chunks, which are combined again.
+    strcpy(command, "$M3,82:");
+    for (i = 0; i < 0x82; ++i)
+    {
+        sprintf(&command[strlen(command)], "%02X", (unsigned) (i + 1) & 0xFF);
+    }
+    strcat(command, "#00");
+    result = run(proto_write_memory, command, reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Multi-chunk write: %d", result);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && target[3] == 1 && target[3 + 0x81] == 0x82 && last_length == 0x82,
+           "Chunked data written: %lu", (unsigned long) last_length);
+
+    run(proto_write_memory, "$M0,1:ab#00", reply, sizeof(reply));
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && target[0] == 0xAB, "Single byte write: %d", result);
+}
+
+// Assertion count: 3 + 1 + 1 + 1 + 1 + 1 = 8
+static void test_proto_write_memory_binary(void)
+{
+    char    reply[64];
+    char    command[160];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(target, 0, sizeof(target));
+
+    // Escaped bytes are decoded, including the packet framing characters.
+    filtered = 0;
+    result = run(proto_write_memory_binary, "$X10,4:}]}\x03" "A}\x0a#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Write result: %d", result);
+    TAP_OK(filtered == 4 && target[0x10] == 0, "Held back: %lu", (unsigned long) filtered);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && memcmp(&target[0x10], "\x7D\x23\x41\x2A", 4) == 0, "Memory written");
+
+    // GDB probes for support with an empty write.
+    result = run(proto_write_memory_binary, "$X10,0:#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Empty write: %d", result);
+
+    result = run(proto_write_memory_binary, "$X10,4:ab#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Short data: %d", result);
+
+    result = run(proto_write_memory_binary, "$X10,1:ab#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Excess data: %d", result);
+
+    result = run(proto_write_memory_binary, "$X10,1:}#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Truncated escape: %d", result);
+
+    // Chunks of a long write are combined again.
+    strcpy(command, "$X3,64:");
+    memset(&command[7], 'b', 100);
+    strcpy(&command[107], "#00");
+    writes = 0;
+    run(proto_write_memory_binary, command, reply, sizeof(reply));
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && writes == 1 && last_length == 100 && target[3 + 99] == 'b',
+           "Long write: %u writes", writes);
+}
+
+// Assertion count: 1 + 1 + 2 + 2 + 2 + 2 + 2 = 12
+static void test_proto_write_combining(void)
+{
+    char    reply[64];
+    char    command[32];
+    int     result;
+    int     i;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(target, 0, sizeof(target));
+
+    // Adjacent writes reach memory as one access.
+    writes = 0;
+    run(proto_write_memory, "$M10,2:0102#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M12,2:0304#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M14,4:05060708#00", reply, sizeof(reply));
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && writes == 1 && last_length == 8 &&
+           memcmp(&target[0x10], "\x01\x02\x03\x04\x05\x06\x07\x08", 8) == 0,
+           "Combined: %u writes", writes);
+
+    // A write within a held range replaces its data.
+    writes = 0;
+    run(proto_write_memory, "$M20,4:11223344#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M21,2:aabb#00", reply, sizeof(reply));
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && writes == 1 && memcmp(&target[0x20], "\x11\xAA\xBB\x44", 4) == 0,
+           "Replaced: %u writes", writes);
+
+    // Reads observe held writes they overlap, and leave the others held.
+    writes = 0;
+    run(proto_write_memory, "$M30,2:5566#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M50,1:77#00", reply, sizeof(reply));
+    result = run(proto_read_memory, "$m40,1#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && writes == 0 && env.pending_write_count == 2, "Unrelated read");
+    result = run(proto_read_memory, "$m31,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && writes == 2 && strcmp(reply, "$6600#CC") == 0, "Read: '%s'", reply);
+
+    // Overlapping writes are made in order.
+    writes = 0;
+    run(proto_write_memory, "$M60,4:01020304#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M5e,4:0a0b0c0d#00", reply, sizeof(reply));
+    TAP_OK(writes == 1, "Overlap committed: %u writes", writes);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && memcmp(&target[0x5E], "\x0A\x0B\x0C\x0D\x03\x04", 6) == 0,
+           "Later write wins");
+
+    // Extending a range over another one commits both first.
+    writes = 0;
+    run(proto_write_memory, "$M28,2:eeee#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M24,2:1111#00", reply, sizeof(reply));
+    run(proto_write_memory, "$M26,4:22222222#00", reply, sizeof(reply));
+    TAP_OK(writes == 2, "Extension committed: %u writes", writes);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && target[0x28] == 0x22 && target[0x2A] == 0, "Extended write wins");
+
+    // Filling the list commits it, and only code ranges flush the instruction cache.
+    writes = 0;
+    env.icache_dirty = 0;
+    for (i = 0; i <= GDBS_WRITE_COMBINE_COUNT; ++i)
+    {
+        sprintf(command, "$M%x,1:ff#00", 0x80 + i * 2);
+        run(proto_write_memory, command, reply, sizeof(reply));
+    }
+    TAP_OK(writes == GDBS_WRITE_COMBINE_COUNT && env.pending_write_count == 1,
+           "List full: %u writes", writes);
+    result = proto_commit_writes();
+    TAP_OK(result == 0 && !env.icache_dirty, "Data writes need no flush");
+
+    // A running non-stop target sees writes at once, and failures are reported with the command.
+    writes = 0;
+    env.non_stop = 1;
+    env.running = 1;
+    result = run(proto_write_memory, "$M90,1:5a#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && writes == 1 && target[0x90] == 0x5A && env.pending_write_count == 0 &&
+           strcmp(reply, "$OK#9A") == 0, "Running target written: %u writes", writes);
+    result = run(proto_write_memory, "$Mff,2:5a5a#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT, "Running target write fault: %d", result);
+    env.non_stop = 0;
+    env.running = 0;
+}
+
+// Assertion count: 3 + 1 + 1 + 1 + 1 + 1 = 8
+static void test_proto_memory_crc(void)
+{
+    char    reply[64];
+    int     result;
+    size_t  i;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(target); ++i)
+    {
+        target[i] = (unsigned char) i;
+    }
+
+    // The query name is consumed by the dispatcher, so only the command character precedes the
+    // arguments here.
+    filtered = 0;
+    result = run(proto_memory_crc, "$q0,100#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "CRC result: %d", result);
+    TAP_OK(strcmp(reply, "$C494A116A#FE") == 0, "Reply: '%s'", reply);
+    TAP_OK(filtered == 0x100, "Filtered: %lu", (unsigned long) filtered);
+
+    memcpy(&target[0x10], "123456789", 9);
+    result = run(proto_memory_crc, "$q10,9#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$C0376E6E7#0A") == 0, "Check value: '%s'", reply);
+
+    result = run(proto_memory_crc, "$q10,0#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$CFFFFFFFF#73") == 0, "Empty block: '%s'", reply);
+
+    result = run(proto_memory_crc, "$qf0,20#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT && reply[0] == '\0', "Faulting CRC: %d", result);
+
+    result = run(proto_memory_crc, "$q10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing length: %d", result);
+
+    result = run(proto_memory_crc, "$qxyz,4#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid address: %d", result);
+}
+
+// Assertion count: 3 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 = 13
+static void test_proto_search_memory(void)
+{
+    char    reply[64];
+    int     result;
+    size_t  i;
+
+    TAP_DIAG("In %s", __func__);
+
+    for (i = 0; i < sizeof(target); ++i)
+    {
+        target[i] = (unsigned char) i;
+    }
+
+    // As for 'qCRC', only the command character precedes the search kind here.
+    filtered = 0;
+    result = run(proto_search_memory, "$qmemory:0;100;@AB#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Search result: %d", result);
+    TAP_OK(strcmp(reply, "$1,40#C1") == 0, "Reply: '%s'", reply);
+    TAP_OK(filtered == 0x100, "Filtered: %lu", (unsigned long) filtered);
+
+    result = run(proto_search_memory, "$qmemory:0;100;A#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$1,41#C2") == 0, "Single byte: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:0;100;}]~#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$1,7D#D8") == 0, "Escaped pattern: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:0;41;@AB#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$0#30") == 0, "Match past the end: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:10000;10000;\xDE\xAD\xBE\xEF#00",
+                 reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$1,103FE#7C") == 0, "Across windows: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:10000;10000;\xEF#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$1,10401#53") == 0, "Single byte window: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:10000;10000;\xEF\xDE#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$0#30") == 0, "Not found: '%s'", reply);
+
+    result = run(proto_search_memory, "$qmemory:f0;20;@#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_FAULT && reply[0] == '\0', "Faulting search: %d", result);
+
+    result = run(proto_search_memory, "$qmemory:0;100#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing pattern: %d", result);
+
+    result = run(proto_search_memory, "$qmemory:0;100;#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID && reply[0] == '\0', "Empty pattern: %d", result);
+
+    result = run(proto_search_memory, "$qregisters:0;100;@#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Unsupported kind: '%s'", reply);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_read_memory();
+    test_proto_write_memory();
+    test_proto_write_memory_binary();
+    test_proto_write_combining();
+    test_proto_memory_crc();
+    test_proto_search_memory();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,310 @@
+/**
+ *  @file       test_protocol_monitor.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol monitor commands.
+ */
+#include "protocol/monitor.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+#if GDBS_STATS
+//                                      TPMN TPMB TPMS
+static const unsigned long TEST_COUNT =    9 +  5 +  3;
+#else
+//                                      TPMN TPMB
+static const unsigned long TEST_COUNT =    9 +  5;
+#endif
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Amount of console output reported as waiting to be sent.
+static unsigned int console_pending;
+
+unsigned int proto_console_pending(void)
+{
+    return console_pending;
+}
+
+/// Arguments passed to the last target command run.
+static char arguments[32];
+
+/// Boolean indicating that the target's "stats" command was run.
+static int target_stats;
+
+static int command_echo
+(
+    const char      *args,
+    unsigned int     length
+)
+{
+    memcpy(arguments, args, length);
+    arguments[length] = '\0';
+    return gdbs_monitor_write(args, length);
+}
+
+static int command_fail
+(
+    const char      *args,
+    unsigned int     length
+)
+{
+    (void) args;
+    (void) length;
+    return -GDBS_ERROR_FAULT;
+}
+
+static int command_stats
+(
+    const char      *args,
+    unsigned int     length
+)
+{
+    (void) args;
+    (void) length;
+    target_stats = 1;
+    return 0;
+}
+
+/// Monitor commands provided by the simulated target.
+static const struct gdbs_monitor_command target_commands[] =
+{
+    { "echo", "Echo the arguments", command_echo },
+    { "fail", "Fail with a fault", command_fail },
+    { "stats", "Never run, as a built-in command has the name", command_stats },
+};
+
+const struct gdbs_monitor_command *gdbs_get_monitor_commands
+(
+    unsigned int *count
+)
+{
+    *count = sizeof(target_commands) / sizeof(target_commands[0]);
+    return target_commands;
+}
+
+/// Console output sent by the last command, decoded from its 'O' packets.
+static char output[1024];
+
+/// Final reply to the last command.
+static char final[16];
+
+/**
+ * Run a monitor command line, as sent by GDB's "monitor" command, capturing the output and the
+ * final reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    const char *line
+)
+{
+    static const char        digits[] = "0123456789abcdef";
+    static char              reply[4096];
+    char                     command[512];
+    const unsigned char     *token;
+    size_t                   length;
+    size_t                   i;
+    size_t                   n = 0;
+    char                    *packet;
+    char                    *end;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, sizeof(reply), (unsigned char *) reply };
+    int                      result;
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    // The command line is hex encoded.
+    strcpy(command, "$qRcmd,");
+    length = strlen(command);
+    for (i = 0; line[i] != '\0'; ++i)
+    {
+        command[length++] = digits[(unsigned char) line[i] >> 4];
+        command[length++] = digits[(unsigned char) line[i] & 0xF];
+    }
+    strcpy(&command[length], "#00");
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, ',', &token, &length);
+    result = proto_monitor(&tokenizer);
+
+    // Decode the output packets, up to the final reply.
+    output[0] = '\0';
+    final[0] = '\0';
+    for (packet = reply; *packet == '$'; packet = end + 3)
+    {
+        end = strchr(packet, '#');
+        assert(end != NULL);
+        if (packet[1] == 'O' && end - packet > 2 && (end - packet) % 2 == 0)
+        {
+            for (i = 2; &packet[i] < end; i += 2)
+            {
+                hex_octet_to_byte(&packet[i], (unsigned char *) &output[n++]);
+            }
+            output[n] = '\0';
+        }
+        else
+        {
+            memcpy(final, packet, (size_t) (end - packet + 3));
+            final[end - packet + 3] = '\0';
+        }
+    }
+    return result;
+}
+
+// Assertion count: 2 + 1 + 2 + 1 + 1 + 1 + 1 = 9
+static void test_proto_monitor(void)
+{
+    char    line[GDBS_MONITOR_LINE_LENGTH + 2];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Built-in commands are listed before the target's own.
+    result = run("help");
+    TAP_OK(result == 0 && strcmp(final, "$OK#9A") == 0, "Help result: %d, %s", result, final);
+    TAP_OK(strstr(output, "buffers") != NULL && strstr(output, "help") != NULL &&
+           strstr(output, "stats") < strstr(output, "echo") &&
+           strstr(output, "Echo the arguments\n") != NULL, "Help output: '%s'", output);
+
+    run("");
+    TAP_OK(strncmp(output, "buffers", 7) == 0, "Bare monitor lists commands: '%s'", output);
+
+    // Arguments follow the spaces after the command name.
+    result = run("echo  one two");
+    TAP_OK(result == 0 && strcmp(output, "one two") == 0, "Echo output: '%s'", output);
+    TAP_OK(strcmp(arguments, "one two") == 0 && strcmp(final, "$OK#9A") == 0,
+           "Echo arguments: '%s'", arguments);
+
+    result = run("nope");
+    TAP_OK(result == 0 && strstr(output, "Unknown monitor command") != NULL,
+           "Unknown command: '%s'", output);
+
+    result = run("fail");
+    TAP_OK(result == -GDBS_ERROR_FAULT, "Failing command: %d", result);
+
+    run("stats");
+    TAP_OK(!target_stats && strstr(output, "Software breakpoints") != NULL,
+           "Built-in command takes precedence");
+
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    result = run(line);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Long command line: %d", result);
+}
+
+// Assertion count: 3 + 2 = 5
+static void test_proto_monitor_builtins(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(&env, 0, sizeof(env));
+    env.breakpoint_count = 3;
+    env.hw_breakpoint_count = 2;
+    env.hw_breakpoints[1].used = 1;
+    env.watchpoint_count = 4;
+    env.tracepoint_count = 1;
+
+    result = run("stats");
+    TAP_OK(result == 0 && strcmp(final, "$OK#9A") == 0, "Stats result: %d", result);
+    TAP_OK(strstr(output, "Software breakpoints    3 / 32\n") != NULL &&
+           strstr(output, "Hardware breakpoints    1 / 2\n") != NULL,
+           "Breakpoints: '%s'", output);
+    TAP_OK(strstr(output, "Watchpoints             0 / 4\n") != NULL &&
+           strstr(output, "Tracepoints             1 / 8\n") != NULL,
+           "Watchpoints and tracepoints: '%s'", output);
+
+    console_pending = 100;
+    env.pending_data_used = 12;
+    env.stop_enqueue = 7;
+    env.stop_dequeue = 5;
+    result = run("buffers");
+    TAP_OK(strstr(output, "Console output          100 / 256\n") != NULL &&
+           strstr(output, "Held writes             12 / 256\n") != NULL,
+           "Buffers: '%s'", output);
+    TAP_OK(strstr(output, "Stop queue              2 / 8\n") != NULL, "Stop queue: '%s'", output);
+}
+
+#if GDBS_STATS
+// Assertion count: 2 + 1 = 3
+static void test_proto_monitor_stats(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    gdbs_reset_stats();
+    stats_dispatch_start('m', 10);
+    stats_dispatch_end();
+    stats_receive_start();
+    stats_received(10, GDBS_ERROR_OK);
+
+    run("stats");
+    TAP_OK(strstr(output, "Packets received        1\n") != NULL &&
+           strstr(output, "Checksum failures       0\n") != NULL, "Counters: '%s'", output);
+    TAP_OK(strstr(output, "Command m               1 packets, 10 bytes in, 0 bytes out\n") !=
+           NULL &&
+           strstr(output, "Command g") == NULL, "Commands: '%s'", output);
+
+    run("stats reset");
+    TAP_OK(strcmp(output, "Statistics reset\n") == 0 && stats_read()->packets_received == 0,
+           "Reset: '%s'", output);
+}
+#endif
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_monitor();
+    test_proto_monitor_builtins();
+#if GDBS_STATS
+    test_proto_monitor_stats();
+#endif
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,261 @@
+/**
+ *  @file       test_protocol_nonstop.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for the non-stop mode stop event queue.
+ */
+#include "protocol/nonstop.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPQS TPNS TPS TPRS TPSNS
+static const unsigned long TEST_COUNT =    3 +  3 +  4 +  2 +   3;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    (void) comm;
+    (void) c;
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Number of console flushes.
+static int flushes;
+
+int proto_console_flush(void)
+{
+    ++flushes;
+    return 0;
+}
+
+/// Number of "OK" responses sent.
+static int oks;
+
+int proto_send_ok(void)
+{
+    ++oks;
+    return 0;
+}
+
+/// Stop replies sent, with the type and signal of the last.
+static int                  stops;
+static enum packet_type     stop_type;
+static enum gdbs_signal     stop_signal;
+
+int proto_send_stop
+(
+    enum packet_type                 type,
+    const struct gdbs_stop_event    *event,
+    const unsigned char             *frame
+)
+{
+    (void) frame;
+    ++stops;
+    stop_type = type;
+    stop_signal = event->signal;
+    return 0;
+}
+
+/**
+ * Reset the stub call records.
+ */
+static void reset(void)
+{
+    flushes = 0;
+    oks = 0;
+    stops = 0;
+    stop_type = PT_ACK;
+    stop_signal = GDBS_SIGNAL_NONE;
+}
+
+/**
+ * Queue a stop event with a signal.
+ *
+ * @return Result of proto_queue_stop().
+ */
+static int queue
+(
+    int signo
+)
+{
+    struct gdbs_stop_event event = { (enum gdbs_signal) signo, GDBS_STOP_SIGNAL, 0, -1, 1 };
+
+    return proto_queue_stop(&event, NULL);
+}
+
+/**
+ * Run a command handler against a command string.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    packet_tokenizer_advance(&tokenizer, ':', &token, &length);
+    return handler(&tokenizer);
+}
+
+// Assertion count: 1 + 1 + 1 = 3
+static void test_proto_queue_stop(void)
+{
+    int             result = 0;
+    unsigned int    i;
+
+    TAP_DIAG("In %s", __func__);
+
+    proto_init_stop_queue();
+    for (i = 0; i < GDBS_STOP_QUEUE_LENGTH; ++i)
+    {
+        result |= queue(1);
+    }
+    TAP_OK(result == GDBS_ERROR_OK, "Queue filled: %d", result);
+    result = queue(1);
+    TAP_OK(result == -GDBS_ERROR_RESOURCES, "Queue full: %d", result);
+
+    // Slots are reused as the queue wraps around.
+    proto_init_stop_queue();
+    result = 0;
+    for (i = 0; i < GDBS_STOP_QUEUE_LENGTH * 3; ++i)
+    {
+        result |= queue(1);
+        remove_oldest(&env);
+    }
+    TAP_OK(result == GDBS_ERROR_OK && oldest(&env) == NULL, "Wrapped: %d", result);
+}
+
+// Assertion count: 1 + 1 + 1 = 3
+static void test_proto_notify_stop(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    proto_init_stop_queue();
+    queue(GDBS_SIGNAL_TRAP);
+    queue(GDBS_SIGNAL_SEGV);
+
+    // Nothing is sent in all-stop mode.
+    reset();
+    env.non_stop = 0;
+    proto_notify_stop();
+    TAP_OK(stops == 0, "All-stop: %d", stops);
+
+    env.non_stop = 1;
+    proto_notify_stop();
+    TAP_OK(stops == 1 && stop_type == PT_NOTIFICATION && stop_signal == GDBS_SIGNAL_TRAP &&
+           flushes == 0, "Notified: %d %d %d", stops, stop_type, stop_signal);
+
+    // Only one notification may be outstanding.
+    proto_notify_stop();
+    TAP_OK(stops == 1, "Outstanding: %d", stops);
+}
+
+// Assertion count: 1 + 1 + 2 = 4
+static void test_proto_stopped(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Continues from the notification sent in test_proto_notify_stop().
+    reset();
+    result = run(proto_stopped, "$vStopped#55");
+    TAP_OK(result == 0 && stops == 1 && stop_type == PT_MESSAGE &&
+           stop_signal == GDBS_SIGNAL_SEGV, "Next stop: %d %d", stop_type, stop_signal);
+
+    reset();
+    result = run(proto_stopped, "$vStopped#55");
+    TAP_OK(result == 0 && stops == 0 && oks == 1 && env.stop_notified == 0, "Drained: %d", oks);
+
+    // New events are notified again once the queue is drained.
+    reset();
+    queue(GDBS_SIGNAL_INT);
+    proto_notify_stop();
+    TAP_OK(stops == 1 && stop_type == PT_NOTIFICATION && stop_signal == GDBS_SIGNAL_INT,
+           "Notified again: %d", stops);
+    run(proto_stopped, "$vStopped#55");
+    TAP_OK(oks == 1 && oldest(&env) == NULL, "Drained again: %d", oks);
+}
+
+// Assertion count: 1 + 1 = 2
+static void test_proto_report_stopped(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    proto_init_stop_queue();
+    reset();
+    result = proto_report_stopped();
+    TAP_OK(result == 0 && oks == 1 && stops == 0, "Nothing stopped: %d", result);
+
+    reset();
+    queue(GDBS_SIGNAL_ABRT);
+    result = proto_report_stopped();
+    TAP_OK(result == 0 && stops == 1 && stop_type == PT_MESSAGE && env.stop_notified == 1,
+           "Stopped: %d %d", stops, stop_type);
+}
+
+// Assertion count: 1 + 1 + 1 = 3
+static void test_proto_set_non_stop(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    env.running = 1;
+    result = run(proto_set_non_stop, "$QNonStop:0#00");
+    TAP_OK(result == 0 && oks == 1 && env.non_stop == 0 && env.running == 0 &&
+           oldest(&env) == NULL && env.stop_notified == 0, "All-stop: %d", result);
+
+    // The stub cannot keep threads running while it serves packets, so non-stop mode is refused.
+    result = run(proto_set_non_stop, "$QNonStop:1#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID && oks == 1 && env.non_stop == 0, "Non-stop: %d", result);
+
+    result = run(proto_set_non_stop, "$QNonStop:2#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID && env.non_stop == 0, "Invalid: %d", result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_queue_stop();
+    test_proto_notify_stop();
+    test_proto_stopped();
+    test_proto_report_stopped();
+    test_proto_set_non_stop();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,409 @@
+/**
+ *  @file       test_protocol_query.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol general queries.
+ */
+#include "protocol/query.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TD TPGQ TPMC TPGS
+static const unsigned long TEST_COUNT = 15 + 16 +  6 +  4;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+/// Name of the last test query called.
+static const char *called;
+
+/// Arguments passed to the last test query.
+static char arguments[32];
+
+static int query_test
+(
+    struct packet_tokenizer *tokenizer,
+    const char              *name
+)
+{
+    const unsigned char *token;
+    size_t               length;
+
+    called = name;
+    arguments[0] = '\0';
+    if (packet_tokenizer_advance(tokenizer, TOKEN_EOB, &token, &length) == GDBS_ERROR_OK)
+    {
+        memcpy(arguments, token, length);
+        arguments[length] = '\0';
+    }
+    return proto_send_ok();
+}
+
+int proto_vcont(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "vCont"); }
+int proto_vcont_query(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "vCont?");
+}
+
+int proto_ctrl_c(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "vCtrlC"); }
+int proto_stopped(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "vStopped"); }
+int proto_set_non_stop(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "QNonStop");
+}
+
+int proto_current_thread(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "qC"); }
+int proto_memory_crc(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "qCRC"); }
+int proto_monitor(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "qRcmd"); }
+int proto_search_memory(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qSearch");
+}
+int proto_flash_erase(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "vFlashErase");
+}
+int proto_flash_write(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "vFlashWrite");
+}
+int proto_flash_done(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "vFlashDone");
+}
+
+/// Boolean indicating that the target offers a memory map.
+static int memory_map;
+
+int proto_memory_map_available(void)
+{
+    return memory_map;
+}
+
+/// Boolean indicating that the target offers target descriptions.
+static int features;
+
+int proto_features_available(void)
+{
+    return features;
+}
+
+int proto_thread_extra_info(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qThreadExtraInfo");
+}
+int proto_thread_list_first(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qfThreadInfo");
+}
+int proto_thread_list_next(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qsThreadInfo");
+}
+int proto_xfer(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "qXfer"); }
+int proto_trace_init(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "QTinit"); }
+int proto_trace_define(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "QTDP"); }
+int proto_trace_start(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "QTStart");
+}
+int proto_trace_stop(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "QTStop"); }
+int proto_trace_status(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qTStatus");
+}
+int proto_trace_select_frame(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "QTFrame");
+}
+int proto_trace_read_buffer(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qTBuffer");
+}
+int proto_trace_set_buffer(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "QTBuffer");
+}
+int proto_trace_marker_list_first(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qTfSTM");
+}
+int proto_trace_marker_list_next(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qTsSTM");
+}
+int proto_trace_marker_at(struct packet_tokenizer *tokenizer)
+{
+    return query_test(tokenizer, "qTSTMat");
+}
+
+static int query_a(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "A"); }
+static int query_ab(struct packet_tokenizer *tokenizer) { return query_test(tokenizer, "AB"); }
+
+static int run_table(struct packet_tokenizer *tokenizer)
+{
+    static const struct query table[] =
+    {
+        QUERY("A",  query_a),
+        QUERY("AB", query_ab),
+    };
+
+    called = NULL;
+    return dispatch(tokenizer, table, sizeof(table) / sizeof(table[0]));
+}
+
+// Assertion count: 3 + 3 + 3 + 3 + 2 + 1 = 15
+static void test_dispatch(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = run(run_table, "$qA#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(called != NULL && strcmp(called, "A") == 0, "Called: %s", called);
+    TAP_OK(arguments[0] == '\0', "Arguments: '%s'", arguments);
+
+    result = run(run_table, "$qAB:x,y;z#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(called != NULL && strcmp(called, "AB") == 0, "Called: %s", called);
+    TAP_OK(strcmp(arguments, "x,y;z") == 0, "Arguments: '%s'", arguments);
+
+    result = run(run_table, "$qA,1:2#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(called != NULL && strcmp(called, "A") == 0, "Called: %s", called);
+    TAP_OK(strcmp(arguments, "1:2") == 0, "Arguments: '%s'", arguments);
+
+    result = run(run_table, "$qAB;x:y#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(called != NULL && strcmp(called, "AB") == 0, "Called: %s", called);
+    TAP_OK(strcmp(arguments, "x:y") == 0, "Arguments: '%s'", arguments);
+
+    result = run(run_table, "$qABC#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && called == NULL, "Unknown result: %d", result);
+    TAP_OK(strcmp(reply, "$#00") == 0, "Reply: '%s'", reply);
+
+    result = run(run_table, "$q#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && called == NULL && strcmp(reply, "$#00") == 0, "Empty: '%s'", reply);
+}
+
+// Assertion count: 4 + 4 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 = 16
+static void test_proto_general_query(void)
+{
+    char    reply[256];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = run(proto_general_query,
+                 "$qSupported:multiprocess+;swbreak+;hwbreak+;qRelocInsn+;xmlRegisters=i386#00",
+                 reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(strcmp(reply, "$PacketSize=3FC;swbreak+;hwbreak+;ConditionalBreakpoints+;"
+                         "BreakpointCommands+;qXfer:threads:read+;"
+                         "ConditionalTracepoints+;StaticTracepoints+;"
+                         "qXfer:statictrace:read+#C8") == 0,
+           "Reply: '%s'", reply);
+    TAP_OK(env.swbreak_enabled == 1, "swbreak enabled");
+    TAP_OK(env.hwbreak_enabled == 1, "hwbreak enabled");
+
+    result = run(proto_general_query, "$qSupported#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Result: %d", result);
+    TAP_OK(strcmp(reply, "$PacketSize=3FC;swbreak+;hwbreak+;ConditionalBreakpoints+;"
+                         "BreakpointCommands+;qXfer:threads:read+;"
+                         "ConditionalTracepoints+;StaticTracepoints+;"
+                         "qXfer:statictrace:read+#C8") == 0,
+           "Reply: '%s'", reply);
+    TAP_OK(env.swbreak_enabled == 0, "swbreak disabled");
+    TAP_OK(env.hwbreak_enabled == 0, "hwbreak disabled");
+
+    called = NULL;
+    run(proto_general_query, "$qXfer:threads:read::0,3fb#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qXfer") == 0 &&
+           strcmp(arguments, "threads:read::0,3fb") == 0, "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_query, "$qTBuffer:0,10#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qTBuffer") == 0 && strcmp(arguments, "0,10") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_query, "$qTSTMat:1000#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qTSTMat") == 0 && strcmp(arguments, "1000") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_query, "$qCRC:1000,40#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qCRC") == 0 && strcmp(arguments, "1000,40") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_query, "$qRcmd,68656c70#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qRcmd") == 0 && strcmp(arguments, "68656c70") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_query, "$qSearch:memory:1000;40;ab#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "qSearch") == 0 &&
+           strcmp(arguments, "memory:1000;40;ab") == 0, "Arguments: '%s'", arguments);
+
+    // The memory map is only offered when the target has one.
+    memory_map = 1;
+    run(proto_general_query, "$qSupported#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$PacketSize=3FC;swbreak+;hwbreak+;ConditionalBreakpoints+;"
+                         "BreakpointCommands+;qXfer:threads:read+;"
+                         "ConditionalTracepoints+;StaticTracepoints+;"
+                         "qXfer:statictrace:read+;qXfer:memory-map:read+#48") == 0,
+           "Reply: '%s'", reply);
+    memory_map = 0;
+
+    // As are target descriptions.
+    features = 1;
+    run(proto_general_query, "$qSupported#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$PacketSize=3FC;swbreak+;hwbreak+;ConditionalBreakpoints+;"
+                         "BreakpointCommands+;qXfer:threads:read+;"
+                         "ConditionalTracepoints+;StaticTracepoints+;"
+                         "qXfer:statictrace:read+;qXfer:features:read+#A3") == 0,
+           "Reply: '%s'", reply);
+    features = 0;
+}
+
+// Assertion count: 6
+static void test_proto_multi_letter_command(void)
+{
+    char    reply[32];
+
+    TAP_DIAG("In %s", __func__);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vCont?#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "vCont?") == 0, "Called: %s", called);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vCont;r10,20:1;c#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "vCont") == 0 && strcmp(arguments, "r10,20:1;c") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vCtrlC#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "vCtrlC") == 0, "Called: %s", called);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vStopped#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "vStopped") == 0, "Called: %s", called);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vFlashWrite:1000:a,b;c#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "vFlashWrite") == 0 &&
+           strcmp(arguments, "1000:a,b;c") == 0, "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_multi_letter_command, "$vMustReplyEmpty#00", reply, sizeof(reply));
+    TAP_OK(called == NULL && strcmp(reply, "$#00") == 0, "Unknown: '%s'", reply);
+}
+
+// Assertion count: 4
+static void test_proto_general_set(void)
+{
+    char    reply[32];
+
+    TAP_DIAG("In %s", __func__);
+
+    called = NULL;
+    run(proto_general_set, "$QNonStop:1#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "QNonStop") == 0 && strcmp(arguments, "1") == 0,
+           "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_set, "$QTinit#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "QTinit") == 0, "Called: %s", called);
+
+    called = NULL;
+    run(proto_general_set, "$QTBuffer:circular:1#00", reply, sizeof(reply));
+    TAP_OK(called != NULL && strcmp(called, "QTBuffer") == 0 &&
+           strcmp(arguments, "circular:1") == 0, "Arguments: '%s'", arguments);
+
+    called = NULL;
+    run(proto_general_set, "$QStartNoAckMode#00", reply, sizeof(reply));
+    TAP_OK(called == NULL && strcmp(reply, "$#00") == 0, "Unknown: '%s'", reply);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_dispatch();
+    test_proto_general_query();
+    test_proto_multi_letter_command();
+    test_proto_general_set();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,241 @@
+/**
+ *  @file       test_protocol_receive.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol packet reception and dispatch.
+ */
+#include "protocol/receive.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPRP TPP
+static const unsigned long TEST_COUNT =   45 +  6;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    (void) comm;
+    (void) c;
+    return 0;
+}
+
+/// Data to be received, followed by the end of the stream.
+static const char *stream = "";
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return (*stream == '\0' ? -GDBS_ERROR_EOB : *stream++);
+}
+
+/// Name of the last handler called.
+static const char *called;
+
+/// Result to be returned by the handlers.
+static int handler_result;
+
+/// Last error response sent.
+static int error_sent;
+
+/// Number of commands handled.
+static int handled;
+
+#define HANDLER(f, r)                                       \
+    int f(struct packet_tokenizer *tokenizer)               \
+    {                                                       \
+        (void) tokenizer;                                   \
+        called = #f;                                        \
+        ++handled;                                          \
+        return (handler_result < 0 ? handler_result : (r)); \
+    }
+
+HANDLER(proto_stop_reply, 0)
+HANDLER(proto_read_general_registers, 0)
+HANDLER(proto_write_general_registers, 0)
+HANDLER(proto_read_memory, 0)
+HANDLER(proto_write_memory, 0)
+HANDLER(proto_read_register, 0)
+HANDLER(proto_write_register, 0)
+HANDLER(proto_general_query, 0)
+HANDLER(proto_general_set, 0)
+HANDLER(proto_set_thread, 0)
+HANDLER(proto_thread_alive, 0)
+HANDLER(proto_multi_letter_command, 0)
+HANDLER(proto_remove_breakpoint, 0)
+HANDLER(proto_insert_breakpoint, 0)
+HANDLER(proto_continue, PROTO_RESUME)
+HANDLER(proto_single_step, PROTO_RESUME)
+HANDLER(proto_detach, PROTO_RESUME)
+HANDLER(proto_host_reply, PROTO_RESUME)
+HANDLER(proto_write_memory_binary, 0)
+
+/// Number of stop replies sent.
+static int stop_replies;
+/// Number of stop replies sent before console output was flushed.
+static int unflushed_stop_replies;
+
+int proto_send_stop_reply(void)
+{
+    ++stop_replies;
+    return 0;
+}
+
+int proto_console_flush(void)
+{
+    unflushed_stop_replies = stop_replies;
+    return 0;
+}
+
+int proto_send_empty(void)
+{
+    called = "proto_send_empty";
+    return 0;
+}
+
+int proto_send_error
+(
+    int error
+)
+{
+    error_sent = error;
+    return 0;
+}
+
+/// Number of acks and nacks sent.
+static int acks;
+static int nacks;
+
+void proto_ack(void)
+{
+    ++acks;
+}
+
+void proto_nack(void)
+{
+    ++nacks;
+}
+
+/**
+ * Dispatch a packet and check the handler which was called.
+ */
+#define TPRP(p, h, r)                                                                   \
+    do                                                                                  \
+    {                                                                                   \
+        struct packet_tokenizer tokenizer;                                              \
+        int                     result;                                                 \
+        called = NULL;                                                                  \
+        packet_tokenizer_init(&tokenizer, (const unsigned char *) (p), strlen(p));      \
+        result = proto_receive_packet(&tokenizer);                                      \
+        TAP_OK(result == (r), "Dispatch result: %d", result);                           \
+        TAP_OK(called != NULL && strcmp(called, (h)) == 0, "%s: %s", (p), called);      \
+    } while (0)
+
+// Assertion count: 20 * 2 + 1 + 2 + 1 + 1 = 45
+static void test_proto_receive_packet(void)
+{
+    struct packet_tokenizer tokenizer;
+    int                     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    handler_result = 0;
+    error_sent = 0;
+    TPRP("$?#3F",               "proto_stop_reply", 0);
+    TPRP("$g#67",               "proto_read_general_registers", 0);
+    TPRP("$G00#00",             "proto_write_general_registers", 0);
+    TPRP("$m0,4#00",            "proto_read_memory", 0);
+    TPRP("$M0,1:00#00",         "proto_write_memory", 0);
+    TPRP("$X0,1:}]#00",         "proto_write_memory_binary", 0);
+    TPRP("$p1#00",              "proto_read_register", 0);
+    TPRP("$P1=00#00",           "proto_write_register", 0);
+    TPRP("$qSupported#00",      "proto_general_query", 0);
+    TPRP("$QNonStop:1#00",      "proto_general_set", 0);
+    TPRP("$Hg1#00",             "proto_set_thread", 0);
+    TPRP("$T1#00",              "proto_thread_alive", 0);
+    TPRP("$z0,1000,2#00",       "proto_remove_breakpoint", 0);
+    TPRP("$Z0,1000,2#00",       "proto_insert_breakpoint", 0);
+    TPRP("$c#63",               "proto_continue", PROTO_RESUME);
+    TPRP("$s#73",               "proto_single_step", PROTO_RESUME);
+    TPRP("$D#44",               "proto_detach", PROTO_RESUME);
+    TPRP("$F10#00",             "proto_host_reply", PROTO_RESUME);
+    TPRP("$!#00",               "proto_send_empty", 0);
+    TPRP("$vMustReplyEmpty#00", "proto_multi_letter_command", 0);
+    TAP_OK(error_sent == 0, "No error sent");
+
+    // Handler failures are reported as error responses.
+    handler_result = -GDBS_ERROR_FAULT;
+    TPRP("$m0,4#00", "proto_read_memory", 0);
+    TAP_OK(error_sent == -GDBS_ERROR_FAULT, "Error sent: %d", error_sent);
+
+    // Empty packets are ignored.
+    called = NULL;
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) "$#00", 4);
+    result = proto_receive_packet(&tokenizer);
+    TAP_OK(result == 0 && called == NULL, "Empty packet: %d", result);
+}
+
+// Assertion count: 4 + 2 = 6
+static void test_proto_process(void)
+{
+    unsigned char packet_buffer[GDBS_PACKET_BUFFER_LENGTH];
+
+    TAP_DIAG("In %s", __func__);
+
+    env.packet_buffer = packet_buffer;
+    env.comm = NULL;
+    handler_result = 0;
+    handled = 0;
+    stop_replies = 0;
+    unflushed_stop_replies = -1;
+    acks = 0;
+    nacks = 0;
+
+    // Corrupted packets are nacked, and processing ends once the target resumes.
+    stream = "+$g#67$g#00$m0,4#FD$c#63$g#67";
+    proto_process(1);
+
+    TAP_OK(stop_replies == 1 && unflushed_stop_replies == 0, "Stop replies: %d", stop_replies);
+    TAP_OK(handled == 3, "Handled: %d", handled);
+    TAP_OK(acks == 3 && nacks == 1, "Acks: %d, nacks: %d", acks, nacks);
+    TAP_OK(strcmp(stream, "$g#67") == 0, "Remaining: '%s'", stream);
+
+    // In non-stop mode, a running target gets a single packet served, which may already have
+    // started arriving.
+    env.non_stop = 1;
+    env.running = 1;
+    env.packet_started = 1;
+    handled = 0;
+    stream = "g#67$g#67";
+    proto_process(0);
+    TAP_OK(handled == 1 && env.packet_started == 0, "Handled while running: %d", handled);
+    TAP_OK(strcmp(stream, "$g#67") == 0, "Remaining: '%s'", stream);
+    env.non_stop = 0;
+    env.running = 0;
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_receive_packet();
+    test_proto_process();
+
+    TAP_END_PLAN();
+}
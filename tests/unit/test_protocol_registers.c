@@ -0,0 +1,352 @@
+/**
+ *  @file       test_protocol_registers.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol register access commands.
+ */
+#include "protocol/registers.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPRGR TPWGR TPIR TPRR TPWR TPGSP
+static const unsigned long TEST_COUNT =     5 +  12 +   6 +   8 +  10 +    7;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Number of times register changes were recorded for the selected thread, and the last register
+/// recorded.
+static int                          stores;
+static const struct gdbs_register  *marked;
+
+void proto_mark_thread_registers
+(
+    const struct gdbs_register *reg
+)
+{
+    ++stores;
+    marked = reg;
+}
+
+/// Register file resembling a small 32-bit core, with registers out of order in the frame.
+static const struct gdbs_register registers[] =
+{
+    { 0, 4,  4, 0 },
+    { 1, 0,  4, 0 },
+    { 2, 8,  8, 0 },
+    { 3, 16, 2, 0 },
+};
+
+/// Saved register frame.
+static unsigned char frame[18];
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+// Assertion count: 2 + 2 + 1 = 5
+static void test_proto_read_general_registers(void)
+{
+    char    reply[128];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.general_frame = frame;
+
+    memcpy(frame, "\x11\x22\x33\x44\x55\x66\x77\x88\x00\x00\x00\x00\x00\x00\x00\x00\xAB\xCD", 18);
+    result = run(proto_read_general_registers, "$g#67", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$55667788112233440*,ABCD#D8") == 0, "Reply: '%s'", reply);
+
+    memset(frame, 0, sizeof(frame));
+    result = run(proto_read_general_registers, "$g#67", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$0*@#9A") == 0, "Reply: '%s'", reply);
+
+    env.general_frame = NULL;
+    result = run(proto_read_general_registers, "$g#67", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND && reply[0] == '\0', "No frame: %d", result);
+}
+
+// Assertion count: 4 + 2 + 2 + 2 + 1 + 1 = 12
+static void test_proto_write_general_registers(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.general_frame = frame;
+
+    memset(frame, 0, sizeof(frame));
+    stores = 0;
+    result = run(proto_write_general_registers,
+                 "$G55667788112233440102030405060708abcd#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Write result: %d", result);
+    TAP_OK(stores == 1 && marked == NULL, "Registers marked: %d", stores);
+    TAP_OK(strcmp(reply, "$OK#9A") == 0, "Reply: '%s'", reply);
+    TAP_OK(memcmp(frame,
+                  "\x11\x22\x33\x44\x55\x66\x77\x88\x01\x02\x03\x04\x05\x06\x07\x08\xAB\xCD",
+                  18) == 0,
+           "Frame written");
+
+    memset(frame, 0, sizeof(frame));
+    result = run(proto_write_general_registers,
+                 "$G55667788112233440102030405060708ab#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Short write: %d", result);
+    TAP_OK(frame[0] == 0 && frame[4] == 0, "Frame untouched");
+
+    result = run(proto_write_general_registers,
+                 "$G55667788112233440102030405060708abcdef#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Long write: %d", result);
+    TAP_OK(frame[0] == 0 && frame[4] == 0, "Frame untouched");
+
+    // A bad digit in the last register leaves the earlier ones alone.
+    result = run(proto_write_general_registers,
+                 "$G55667788112233440102030405060708abcx#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Bad digit: %d", result);
+    TAP_OK(frame[0] == 0 && frame[4] == 0 && frame[8] == 0, "Frame untouched");
+
+    result = run(proto_write_general_registers, "$G#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Empty write: %d", result);
+
+    env.general_frame = NULL;
+    result = run(proto_write_general_registers,
+                 "$G55667788112233440102030405060708abcd#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No frame: %d", result);
+}
+
+// Assertion count: 6
+static void test_proto_index_registers(void)
+{
+    static const struct gdbs_register sparse[] =
+    {
+        { 7,                          0, 4, 0 },
+        { 2,                          4, 4, 0 },
+        { GDBS_REGISTER_NUMBER_LIMIT, 8, 4, 0 },
+    };
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = sparse;
+    env.register_count = sizeof(sparse) / sizeof(sparse[0]);
+    proto_index_registers();
+
+    TAP_OK(find_register(&env, 7) == &sparse[0], "Register 7");
+    TAP_OK(find_register(&env, 2) == &sparse[1], "Register 2");
+    TAP_OK(find_register(&env, 0) == NULL, "Register 0 absent");
+    TAP_OK(find_register(&env, GDBS_REGISTER_NUMBER_LIMIT) == NULL, "Register over limit");
+    TAP_OK(find_register(&env, (gdbs_address_t) -1) == NULL, "Huge register number");
+    TAP_OK(env.register_frame_length == 12, "Frame length: %u", env.register_frame_length);
+}
+
+// Assertion count: 2 + 2 + 1 + 1 + 1 + 1 = 8
+static void test_proto_read_register(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.general_frame = frame;
+    proto_index_registers();
+
+    memcpy(frame, "\x11\x22\x33\x44\x55\x66\x77\x88\x01\x02\x03\x04\x05\x06\x07\x08\xAB\xCD", 18);
+    result = run(proto_read_register, "$p1#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$11223344#94") == 0, "Reply: '%s'", reply);
+
+    result = run(proto_read_register, "$p3#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Read result: %d", result);
+    TAP_OK(strcmp(reply, "$ABCD#0A") == 0, "Reply: '%s'", reply);
+
+    result = run(proto_read_register, "$p4#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND && reply[0] == '\0', "Absent register: %d", result);
+
+    result = run(proto_read_register, "$p#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing register: %d", result);
+
+    result = run(proto_read_register, "$pzz#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Bad register: %d", result);
+
+    env.general_frame = NULL;
+    result = run(proto_read_register, "$p1#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No frame: %d", result);
+}
+
+// Assertion count: 3 + 2 + 1 + 1 + 1 + 1 + 1 = 10
+static void test_proto_write_register(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.general_frame = frame;
+    proto_index_registers();
+
+    memset(frame, 0, sizeof(frame));
+    result = run(proto_write_register, "$P2=0102030405060708#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && marked == &registers[2], "Write result: %d", result);
+    TAP_OK(strcmp(reply, "$OK#9A") == 0, "Reply: '%s'", reply);
+    TAP_OK(memcmp(&frame[8], "\x01\x02\x03\x04\x05\x06\x07\x08", 8) == 0 && frame[7] == 0 &&
+           frame[16] == 0,
+           "Frame written");
+
+    result = run(proto_write_register, "$P3=abcd#00", reply, sizeof(reply));
+    TAP_OK(result == 0, "Write result: %d", result);
+    TAP_OK(frame[16] == 0xAB && frame[17] == 0xCD, "Frame written");
+
+    result = run(proto_write_register, "$P3=ab#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Short write: %d", result);
+
+    result = run(proto_write_register, "$P3=#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Empty write: %d", result);
+
+    result = run(proto_write_register, "$P3#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Missing value: %d", result);
+
+    result = run(proto_write_register, "$P9=abcd#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Absent register: %d", result);
+
+    env.general_frame = NULL;
+    result = run(proto_write_register, "$P3=abcd#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No frame: %d", result);
+}
+
+// Assertion count: 1 + 2 + 2 + 2 = 7
+static void test_proto_get_set_pc(void)
+{
+    static const struct gdbs_register pc_registers[] =
+    {
+        { 0,  0, 4, 0                },
+        { 15, 4, 4, GDBS_REGISTER_PC },
+        { 16, 8, 8, 0                },
+    };
+
+    static const struct gdbs_register wide_registers[] =
+    {
+        { 0, 0, 8, GDBS_REGISTER_PC },
+    };
+
+    const unsigned short    probe = 1;
+    gdbs_address_t          pc;
+    int                     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.register_frame = frame;
+    proto_index_registers();
+    TAP_OK(proto_get_pc(&pc) == -GDBS_ERROR_NOT_FOUND, "No PC register");
+
+    env.registers = pc_registers;
+    env.register_count = sizeof(pc_registers) / sizeof(pc_registers[0]);
+    proto_index_registers();
+    memset(frame, 0, sizeof(frame));
+    result = proto_set_pc(0x12345678);
+    TAP_OK(result == 0 && proto_get_pc(&pc) == 0 && pc == 0x12345678, "PC: 0x%lx",
+           (unsigned long) pc);
+    TAP_OK(memcmp(&frame[4], (*(const unsigned char *) &probe ? "\x78\x56\x34\x12" :
+                                                                "\x12\x34\x56\x78"), 4) == 0 &&
+           frame[3] == 0 && frame[8] == 0,
+           "PC stored in target byte order");
+
+    env.registers = wide_registers;
+    env.register_count = 1;
+    proto_index_registers();
+    memset(frame, 0xFF, sizeof(frame));
+    result = proto_set_pc(0x1000);
+    TAP_OK(result == 0 && proto_get_pc(&pc) == 0 && pc == 0x1000, "Wide PC: 0x%lx",
+           (unsigned long) pc);
+    TAP_OK(frame[8] == 0xFF, "Frame bounds respected");
+
+    env.register_frame = NULL;
+    TAP_OK(proto_get_pc(&pc) == -GDBS_ERROR_NOT_FOUND, "No frame");
+    TAP_OK(proto_set_pc(0) == -GDBS_ERROR_NOT_FOUND, "No frame");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_read_general_registers();
+    test_proto_write_general_registers();
+    test_proto_index_registers();
+    test_proto_read_register();
+    test_proto_write_register();
+    test_proto_get_set_pc();
+
+    TAP_END_PLAN();
+}
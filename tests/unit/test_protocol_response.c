@@ -0,0 +1,110 @@
+/**
+ *  @file       test_protocol_response.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for common protocol responses.
+ */
+#include "protocol/response.c"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPSO TPSEM TPSE
+static const unsigned long TEST_COUNT =    2 +   2 +  4;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+#define TB_INIT(p) ((struct testbuf) { 0, sizeof(p), (unsigned char *) (p) })
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+// Assertion count: 1 + 1 = 2
+static void test_proto_send_ok(void)
+{
+    char            packet[16] = "";
+    struct testbuf  buf = TB_INIT(packet);
+
+    TAP_DIAG("In %s", __func__);
+    env.comm = &buf;
+
+    TAP_OK(proto_send_ok() == 0, "Send OK");
+    TAP_OK(strcmp(packet, "$OK#9A") == 0, "Composed packet: '%s'", packet);
+}
+
+// Assertion count: 1 + 1 = 2
+static void test_proto_send_empty(void)
+{
+    char            packet[16] = "";
+    struct testbuf  buf = TB_INIT(packet);
+
+    TAP_DIAG("In %s", __func__);
+    env.comm = &buf;
+
+    TAP_OK(proto_send_empty() == 0, "Send empty");
+    TAP_OK(strcmp(packet, "$#00") == 0, "Composed packet: '%s'", packet);
+}
+
+// Assertion count: 2 + 2 = 4
+static void test_proto_send_error(void)
+{
+    char            packet[16] = "";
+    struct testbuf  buf;
+
+    TAP_DIAG("In %s", __func__);
+    env.comm = &buf;
+
+    buf = TB_INIT(packet);
+    TAP_OK(proto_send_error(-GDBS_ERROR_INVALID) == 0, "Send error");
+    TAP_OK(strcmp(packet, "$E01#A6") == 0, "Composed packet: '%s'", packet);
+
+    buf = TB_INIT(packet);
+    TAP_OK(proto_send_error(-GDBS_ERROR_FAULT) == 0, "Send error");
+    TAP_OK(strcmp(packet, "$E05#AA") == 0, "Composed packet: '%s'", packet);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_send_ok();
+    test_proto_send_empty();
+    test_proto_send_error();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,459 @@
+/**
+ *  @file       test_protocol_resume.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol execution control commands.
+ */
+#include "protocol/resume.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPR TPC TPSS TPD TPVC TPVN TPRS
+static const unsigned long TEST_COUNT =  11 + 8 +  2 + 3 + 10 +  6 +  6;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Result to be returned by gdbs_set_single_step().
+static int step_result;
+/// Last single step setting.
+static int stepping = -1;
+/// Number of changes to be reported by proto_commit_breakpoints().
+static unsigned int changes;
+/// Number of calls made to each stubbed function.
+static int commits;
+static int flushes;
+static int clears;
+static int oks;
+/// Result to be returned by proto_set_pc().
+static int pc_result;
+/// Last program counter set, and the value reported by proto_get_pc().
+static gdbs_address_t pc;
+/// Address reported as having a breakpoint by proto_breakpoint_at().
+static gdbs_address_t breakpoint_address;
+
+int gdbs_set_single_step
+(
+    int enable
+)
+{
+    stepping = enable;
+    return step_result;
+}
+
+void gdbs_flush_icache(void)
+{
+    ++flushes;
+}
+
+unsigned int proto_commit_breakpoints(void)
+{
+    ++commits;
+    return changes;
+}
+
+void proto_clear_breakpoints(void)
+{
+    ++clears;
+}
+
+/// Number of times held back memory writes were committed.
+static int                      write_commits;
+/// Result of committing held back memory writes.
+static int                      write_result;
+
+int proto_commit_writes(void)
+{
+    ++write_commits;
+    return write_result;
+}
+
+int proto_set_pc
+(
+    gdbs_address_t value
+)
+{
+    pc = value;
+    return pc_result;
+}
+
+int proto_get_pc
+(
+    gdbs_address_t *value
+)
+{
+    *value = pc;
+    return pc_result;
+}
+
+int proto_breakpoint_at
+(
+    gdbs_address_t address
+)
+{
+    return (address == breakpoint_address);
+}
+
+gdbs_address_t gdbs_get_current_thread(void)
+{
+    return 1;
+}
+
+int proto_send_ok(void)
+{
+    ++oks;
+    return 0;
+}
+
+/// Stop events queued, and notifications sent.
+static int                      queued;
+static struct gdbs_stop_event   queued_event;
+static int                      notified;
+
+int proto_queue_stop
+(
+    const struct gdbs_stop_event    *event,
+    unsigned char                   *frame
+)
+{
+    (void) frame;
+    ++queued;
+    queued_event = *event;
+    return GDBS_ERROR_OK;
+}
+
+int proto_notify_stop(void)
+{
+    ++notified;
+    return GDBS_ERROR_OK;
+}
+
+/**
+ * Reset the stub call records.
+ */
+static void reset(void)
+{
+    step_result = 0;
+    stepping = -1;
+    changes = 0;
+    commits = 0;
+    write_commits = 0;
+    write_result = 0;
+    flushes = 0;
+    clears = 0;
+    oks = 0;
+    queued = 0;
+    notified = 0;
+    pc_result = 0;
+    pc = 0;
+    breakpoint_address = ~(gdbs_address_t) 0;
+    env.icache_dirty = 0;
+    env.range_stepping = 0;
+}
+
+/**
+ * Run a command handler against a command string.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    return handler(&tokenizer);
+}
+
+// Assertion count: 2 + 2 + 3 + 2 + 2 = 11
+static void test_proto_resume(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    result = proto_resume(0);
+    TAP_OK(result == PROTO_RESUME && stepping == 0, "Resume: %d", result);
+    TAP_OK(commits == 1 && write_commits == 1 && flushes == 0, "No flush without changes");
+
+    reset();
+    changes = 3;
+    result = proto_resume(1);
+    TAP_OK(result == PROTO_RESUME && stepping == 1, "Step: %d", result);
+    TAP_OK(flushes == 1, "One flush for all breakpoints: %d", flushes);
+
+    reset();
+    env.icache_dirty = 1;
+    changes = 2;
+    result = proto_resume(0);
+    TAP_OK(result == PROTO_RESUME, "Resume: %d", result);
+    TAP_OK(flushes == 1, "One flush for all changes: %d", flushes);
+    TAP_OK(env.icache_dirty == 0, "Flush recorded");
+
+    reset();
+    step_result = -GDBS_ERROR_INVALID;
+    result = proto_resume(1);
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Step failure: %d", result);
+    TAP_OK(commits == 0 && flushes == 0, "Nothing committed");
+
+    // A held back memory write which fails stops the target from resuming.
+    reset();
+    write_result = -GDBS_ERROR_FAULT;
+    result = proto_resume(0);
+    TAP_OK(result == -GDBS_ERROR_FAULT && write_commits == 1, "Write failure: %d", result);
+    TAP_OK(commits == 0 && stepping == -1, "Not resumed");
+}
+
+// Assertion count: 2 + 2 + 2 + 2 = 8
+static void test_proto_continue(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    pc = 0xFFFF;
+    result = run(proto_continue, "$c#63");
+    TAP_OK(result == PROTO_RESUME && stepping == 0, "Continue: %d", result);
+    TAP_OK(pc == 0xFFFF && commits == 1, "PC unchanged");
+
+    reset();
+    result = run(proto_continue, "$c1234abcd#00");
+    TAP_OK(result == PROTO_RESUME, "Continue from address: %d", result);
+    TAP_OK(pc == 0x1234ABCD, "PC: 0x%lx", (unsigned long) pc);
+
+    reset();
+    pc_result = -GDBS_ERROR_NOT_FOUND;
+    result = run(proto_continue, "$c1234#00");
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No PC: %d", result);
+    TAP_OK(commits == 0 && stepping == -1, "Not resumed");
+
+    reset();
+    result = run(proto_continue, "$cxyz#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid address: %d", result);
+    TAP_OK(commits == 0 && stepping == -1, "Not resumed");
+}
+
+// Assertion count: 2
+static void test_proto_single_step(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    result = run(proto_single_step, "$s100#00");
+    TAP_OK(result == PROTO_RESUME && stepping == 1, "Step: %d", result);
+    TAP_OK(pc == 0x100 && commits == 1, "PC: 0x%lx", (unsigned long) pc);
+}
+
+// Assertion count: 3
+static void test_proto_detach(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    result = run(proto_detach, "$D#44");
+    TAP_OK(result == PROTO_RESUME && stepping == 0, "Detach: %d", result);
+    TAP_OK(clears == 1 && commits == 1, "Breakpoints removed");
+    TAP_OK(oks == 1, "Reply sent");
+}
+
+/**
+ * Skip the 'vCont' command name, as the multi-letter command dispatcher would.
+ *
+ * @return Result of proto_vcont().
+ */
+static int vcont
+(
+    struct packet_tokenizer *tokenizer
+)
+{
+    const unsigned char *token;
+    size_t               length;
+
+    packet_tokenizer_advance(tokenizer, ';', &token, &length);
+    return proto_vcont(tokenizer);
+}
+
+// Assertion count: 1 + 2 + 2 + 2 + 3 = 10
+static void test_proto_vcont(void)
+{
+    char            reply[32];
+    struct testbuf  buf = { 0, sizeof(reply), (unsigned char *) reply };
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    env.comm = &buf;
+    run(proto_vcont_query, "$vCont?#00");
+    TAP_OK(strcmp(reply, "$vCont;c;C;s;S;r;t#BE") == 0, "Actions: '%s'", reply);
+
+    // Only the first action applies, and thread IDs are ignored.
+    reset();
+    result = run(vcont, "$vCont;s:1;c#00");
+    TAP_OK(result == PROTO_RESUME && stepping == 1, "Step: %d", result);
+    TAP_OK(env.range_stepping == 0, "Not range stepping");
+
+    reset();
+    result = run(vcont, "$vCont;C0b#00");
+    TAP_OK(result == PROTO_RESUME && stepping == 0, "Continue with signal: %d", result);
+    result = run(vcont, "$vCont;Sxy#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid signal: %d", result);
+
+    reset();
+    result = run(vcont, "$vCont;r1000,1020:p1.1;c#00");
+    TAP_OK(result == PROTO_RESUME && stepping == 1, "Range step: %d", result);
+    TAP_OK(env.range_stepping == 1 && env.range_start == 0x1000 && env.range_end == 0x1020,
+           "Range: 0x%lx-0x%lx", (unsigned long) env.range_start, (unsigned long) env.range_end);
+
+    reset();
+    result = run(vcont, "$vCont;r1000#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID && stepping == -1, "Malformed range: %d", result);
+    result = run(vcont, "$vCont;x#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Unknown action: %d", result);
+    result = run(vcont, "$vCont#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID, "No action: %d", result);
+}
+
+// Assertion count: 1 + 2 + 1 + 1 + 1 = 6
+static void test_proto_vcont_non_stop(void)
+{
+    int result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Resuming is acknowledged straight away.
+    reset();
+    env.non_stop = 1;
+    env.running = 0;
+    result = run(vcont, "$vCont;c:p1.-1#00");
+    TAP_OK(result == PROTO_RESUME && oks == 1 && env.running == 1, "Continue: %d", result);
+
+    // Stopping a running target queues a stop without a signal.
+    reset();
+    result = run(vcont, "$vCont;t:p1.-1#00");
+    TAP_OK(result == 0 && oks == 1 && queued == 1 && notified == 1 && env.running == 0,
+           "Stop: %d", result);
+    TAP_OK(queued_event.signal == GDBS_SIGNAL_NONE && queued_event.reason == GDBS_STOP_SIGNAL,
+           "Stop event: %d %d", queued_event.signal, queued_event.reason);
+
+    // Stopping a stopped target has nothing to report.
+    reset();
+    result = run(vcont, "$vCont;t#00");
+    TAP_OK(result == 0 && oks == 1 && queued == 0 && notified == 0, "Already stopped: %d", result);
+
+    // GDB interrupts a running target with 'vCtrlC', which stops it with SIGINT.
+    reset();
+    env.running = 1;
+    result = run(proto_ctrl_c, "$vCtrlC#00");
+    TAP_OK(result == 0 && oks == 1 && queued == 1 && notified == 1 && env.running == 0 &&
+           queued_event.signal == GDBS_SIGNAL_INT, "Ctrl-C: %d %d", result, queued_event.signal);
+
+    env.non_stop = 0;
+    result = run(vcont, "$vCont;t#00");
+    TAP_OK(result == -GDBS_ERROR_INVALID, "All-stop: %d", result);
+}
+
+// Assertion count: 2 + 1 + 1 + 1 + 1 = 6
+static void test_proto_range_step(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    reset();
+    TAP_OK(proto_range_step() == 0, "Not range stepping");
+
+    // Steps within the range are absorbed.
+    run(vcont, "$vCont;r1000,1020#00");
+    env.stop.signal = GDBS_SIGNAL_TRAP;
+    env.stop.reason = GDBS_STOP_SIGNAL;
+    stepping = -1;
+    pc = 0x101C;
+    TAP_OK(proto_range_step() == 1 && stepping == 1 && env.range_stepping == 1, "In range");
+
+    // Reaching a breakpoint ends the range step.
+    breakpoint_address = 0x1004;
+    pc = 0x1004;
+    TAP_OK(proto_range_step() == 0 && env.range_stepping == 0, "Breakpoint in range");
+
+    // So does leaving the range, or any other kind of stop.
+    run(vcont, "$vCont;r1000,1020#00");
+    pc = 0x1020;
+    TAP_OK(proto_range_step() == 0 && env.range_stepping == 0, "Left range");
+
+    run(vcont, "$vCont;r1000,1020#00");
+    pc = 0x1010;
+    env.stop.reason = GDBS_STOP_WATCH;
+    TAP_OK(proto_range_step() == 0 && env.range_stepping == 0, "Watchpoint");
+
+    run(vcont, "$vCont;r1000,1020#00");
+    env.stop.reason = GDBS_STOP_SIGNAL;
+    pc_result = -GDBS_ERROR_NOT_FOUND;
+    TAP_OK(proto_range_step() == 0 && env.range_stepping == 0, "No PC");
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_resume();
+    test_proto_continue();
+    test_proto_single_step();
+    test_proto_detach();
+    test_proto_vcont();
+    test_proto_vcont_non_stop();
+    test_proto_range_step();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,189 @@
+/**
+ *  @file       test_protocol_stop.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol stop replies.
+ */
+#include "protocol/stop.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPSSR TPSS TPSR
+static const unsigned long TEST_COUNT =    16 +  4 +   3;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+#define TB_INIT(p) ((struct testbuf) { 0, sizeof(p), (unsigned char *) (p) })
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Number of calls to proto_report_stopped().
+static int reported;
+
+int proto_report_stopped(void)
+{
+    ++reported;
+    return GDBS_ERROR_OK;
+}
+
+/// Register file with the stack pointer and program counter expedited.
+static const struct gdbs_register registers[] =
+{
+    { 0,  0, 4, 0                      },
+    { 13, 4, 4, GDBS_REGISTER_EXPEDITE },
+    { 14, 8, 4, 0                      },
+    { 15, 0, 4, GDBS_REGISTER_EXPEDITE },
+};
+
+/// Saved register frame.
+static unsigned char frame[12] = { 0x10, 0x20, 0x00, 0x08, 0xF0, 0xFF, 0x00, 0x20 };
+
+/**
+ * Send a stop reply for an event and check the result.
+ */
+#define TPSSR(sig, why, addr, f, e)                                                         \
+    do                                                                                      \
+    {                                                                                       \
+        char            packet[128] = "";                                                   \
+        struct testbuf  buf = TB_INIT(packet);                                              \
+        int             result;                                                             \
+        env.comm = &buf;                                                                    \
+        env.register_frame = (f);                                                           \
+        env.stop.signal = (sig);                                                            \
+        env.stop.reason = (why);                                                            \
+        env.stop.address = (addr);                                                          \
+        result = proto_send_stop_reply();                                                   \
+        TAP_OK(result == 0, "Stop reply result: %d", result);                               \
+        TAP_OK(strcmp(packet, (e)) == 0, "Composed packet: '%s'", packet);                  \
+    } while (0)
+
+// Assertion count: 8 * 2 = 16
+static void test_proto_send_stop_reply(void)
+{
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.swbreak_enabled = 0;
+    env.hwbreak_enabled = 0;
+
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_SIGNAL,  0,      NULL,  "$S05#B8");
+    TPSSR(GDBS_SIGNAL_SEGV, GDBS_STOP_SIGNAL,  0,      NULL,  "$S0B#C5");
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_SIGNAL,  0,      frame, "$T05D:F0FF0020;F:10200008;#7C");
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_SWBREAK, 0,      NULL,  "$S05#B8");
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_HWBREAK, 0,      NULL,  "$S05#B8");
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_WATCH,   0x2000, NULL,  "$T05watch:2000;#07");
+
+    env.swbreak_enabled = 1;
+    env.hwbreak_enabled = 1;
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_SWBREAK, 0,      frame,
+          "$T05D:F0FF0020;F:10200008;swbreak:;#E0");
+    TPSSR(GDBS_SIGNAL_TRAP, GDBS_STOP_AWATCH,  0x1C,   NULL,  "$T05awatch:1C;#1A");
+}
+
+// Assertion count: 2 + 2 = 4
+static void test_proto_send_stop(void)
+{
+    char                    packet[64] = "";
+    struct testbuf          buf = TB_INIT(packet);
+    struct gdbs_stop_event  event = { GDBS_SIGNAL_TRAP, GDBS_STOP_SIGNAL, 0, -1, 1 };
+    int                     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.comm = &buf;
+    env.swbreak_enabled = 0;
+    env.hwbreak_enabled = 0;
+
+    // The event and frame given are reported, not the current stop.
+    env.register_frame = NULL;
+    env.stop.signal = GDBS_SIGNAL_INT;
+    result = proto_send_stop(PT_NOTIFICATION, &event, frame);
+    TAP_OK(result == 0, "Notification result: %d", result);
+    TAP_OK(strcmp(packet, "%Stop:T05D:F0FF0020;F:10200008;#5C") == 0,
+           "Notification: '%s'", packet);
+
+    buf = TB_INIT(packet);
+    event.signal = GDBS_SIGNAL_INT;
+    result = proto_send_stop(PT_MESSAGE, &event, NULL);
+    TAP_OK(result == 0, "Reply result: %d", result);
+    TAP_OK(strcmp(packet, "$S02#B5") == 0, "Reply: '%s'", packet);
+}
+
+// Assertion count: 2 + 1 = 3
+static void test_proto_stop_reply(void)
+{
+    char                     packet[32] = "";
+    struct testbuf           buf = TB_INIT(packet);
+    struct packet_tokenizer  tokenizer;
+    int                      result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.comm = &buf;
+    env.register_frame = NULL;
+    env.stop.signal = GDBS_SIGNAL_INT;
+    env.stop.reason = GDBS_STOP_SIGNAL;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) "$?#3F", 5);
+    result = proto_stop_reply(&tokenizer);
+    TAP_OK(result == 0, "Stop reply result: %d", result);
+    TAP_OK(strcmp(packet, "$S02#B5") == 0, "Composed packet: '%s'", packet);
+
+    // In non-stop mode, the queued stop events are reported instead.
+    env.non_stop = 1;
+    reported = 0;
+    proto_stop_reply(&tokenizer);
+    TAP_OK(reported == 1, "Queued stops reported: %d", reported);
+    env.non_stop = 0;
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_send_stop_reply();
+    test_proto_send_stop();
+    test_proto_stop_reply();
+
+    TAP_END_PLAN();
+}
@@ -0,0 +1,458 @@
+/**
+ *  @file       test_protocol_threads.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol thread commands.
+ */
+#include "protocol/threads.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPTL TPCT TPTEI TPXT TPST TPTA TPTCC
+static const unsigned long TEST_COUNT =    4 +  1 +   2 +  9 +  7 +  2 +    5;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Number of threads on the test target, with IDs counting up from FIRST_THREAD.
+#define THREAD_COUNT 300
+#define FIRST_THREAD 0x1000
+
+/// Thread whose context was last written, the first byte written and the first byte of the
+/// changed register bitmap, and the number of contexts fetched and written.
+static gdbs_address_t   stored_thread;
+static unsigned char    stored_byte;
+static unsigned char    stored_changed;
+static unsigned int     fetches;
+static unsigned int     stores;
+
+/// Number of calls to gdbs_get_threads().
+static unsigned int     list_calls;
+
+/// Thread names which need escaping, or cutting short, in the thread list document.
+static const char       escaped_name[] = "a<b>&\"c\"";
+static char             long_name[200];
+static char             entity_name[100];
+
+unsigned int gdbs_get_threads
+(
+    unsigned int     first,
+    gdbs_address_t  *ids,
+    unsigned int     count
+)
+{
+    unsigned int i;
+
+    ++list_calls;
+    for (i = 0; i < count && first + i < THREAD_COUNT; ++i)
+    {
+        ids[i] = FIRST_THREAD + first + i;
+    }
+    return i;
+}
+
+int gdbs_thread_alive
+(
+    gdbs_address_t thread
+)
+{
+    return (thread >= FIRST_THREAD && thread < FIRST_THREAD + THREAD_COUNT);
+}
+
+const char *gdbs_get_thread_name
+(
+    gdbs_address_t thread
+)
+{
+    switch (thread - FIRST_THREAD)
+    {
+        case 0:
+            return "idle";
+        case 1:
+            return escaped_name;
+        case 2:
+            return long_name;
+        case 3:
+            return entity_name;
+        default:
+            return NULL;
+    }
+}
+
+int gdbs_get_thread_core
+(
+    gdbs_address_t thread
+)
+{
+    return (thread == FIRST_THREAD + 1 ? -1 : (int) ((thread - FIRST_THREAD) % 4));
+}
+
+int gdbs_get_thread_context
+(
+    gdbs_address_t   thread,
+    unsigned char   *frame
+)
+{
+    ++fetches;
+    frame[0] = (unsigned char) thread;
+    return 0;
+}
+
+int gdbs_set_thread_context
+(
+    gdbs_address_t           thread,
+    const unsigned char     *frame,
+    const unsigned char     *changed
+)
+{
+    ++stores;
+    stored_thread = thread;
+    stored_byte = frame[0];
+    stored_changed = changed[0];
+    return 0;
+}
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    static struct testbuf    buf;
+
+    buf.i = 0;
+    buf.length = reply_length;
+    buf.data = (unsigned char *) reply;
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    if (command[1] == 'q')
+    {
+        packet_tokenizer_advance(&tokenizer, ',', &token, &length);
+    }
+    return handler(&tokenizer);
+}
+
+// Assertion count: 4
+static void test_proto_thread_list(void)
+{
+    static char      reply[GDBS_PACKET_BUFFER_LENGTH + 8];
+    char            *id;
+    unsigned int     threads = 0;
+    unsigned int     packets = 0;
+    int              ordered = 1;
+    int              sized = 1;
+    int              result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Collect every thread ID, checking that each reply fits within the packet size.
+    result = run(proto_thread_list_first, "$qfThreadInfo#00", reply, sizeof(reply));
+    while (result == 0 && reply[1] == 'm')
+    {
+        ++packets;
+        sized &= (strlen(reply) - 4 <= REPLY_LIMIT);
+        *strchr(reply, '#') = '\0';
+        for (id = strtok(&reply[2], ","); id != NULL; id = strtok(NULL, ","))
+        {
+            ordered &= (strtoul(id, NULL, 16) == FIRST_THREAD + threads++);
+        }
+        result = run(proto_thread_list_next, "$qsThreadInfo#00", reply, sizeof(reply));
+    }
+
+    TAP_OK(result == 0 && strcmp(reply, "$l#6C") == 0, "End of list: '%s'", reply);
+    TAP_OK(threads == THREAD_COUNT && ordered, "Threads listed: %u", threads);
+    TAP_OK(packets == 2 && sized, "Packets: %u", packets);
+
+    // Starting again restarts the list.
+    run(proto_thread_list_next, "$qsThreadInfo#00", reply, sizeof(reply));
+    run(proto_thread_list_first, "$qfThreadInfo#00", reply, sizeof(reply));
+    TAP_OK(strncmp(reply, "$m1000,1001,", 12) == 0, "Restarted");
+}
+
+// Assertion count: 1
+static void test_proto_current_thread(void)
+{
+    char reply[32];
+
+    TAP_DIAG("In %s", __func__);
+
+    env.stop.thread = 0x1002;
+    run(proto_current_thread, "$qC#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$QC1002#57") == 0, "Current thread: '%s'", reply);
+}
+
+// Assertion count: 1 + 1 = 2
+static void test_proto_thread_extra_info(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = run(proto_thread_extra_info, "$qThreadExtraInfo,1000#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$69646C65#BD") == 0, "Name: '%s'", reply);
+
+    result = run(proto_thread_extra_info, "$qThreadExtraInfo,1#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Dead thread: %d", result);
+}
+
+/**
+ * Find the element of the thread list document for a thread.
+ *
+ * @return Length of the element, or zero if it was not found.
+ */
+static size_t find_element
+(
+    const char      *document,
+    gdbs_address_t   thread,
+    const char     **element
+)
+{
+    char id[32];
+
+    sprintf(id, "<thread id=\"%lx\"", (unsigned long) thread);
+    *element = strstr(document, id);
+    return (*element != NULL ? (size_t) (strchr(*element, '\n') + 1 - *element) : 0);
+}
+
+// Assertion count: 1 + 1 + 3 + 2 + 2 = 9
+static void test_proto_xfer_threads(void)
+{
+    static char      document[THREAD_COUNT * 64 + 4096];
+    char             window[8];
+    const char      *element;
+    size_t           offset = 0;
+    unsigned int     windows = 0;
+    unsigned int     elements = 0;
+    size_t           length;
+    int              result;
+
+    TAP_DIAG("In %s", __func__);
+
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    memset(entity_name, '&', sizeof(entity_name) - 1);
+
+    // Read the whole document in windows which split elements.
+    list_calls = 0;
+    do
+    {
+        result = proto_xfer_threads(NULL, 0, offset, (unsigned char *) &document[offset], 100);
+        offset += (size_t) (result > 0 ? result : 0);
+        ++windows;
+    } while (result == 100);
+    document[offset] = '\0';
+    for (element = document; (element = strstr(element, "<thread ")) != NULL; ++element)
+    {
+        ++elements;
+    }
+
+    TAP_OK(strncmp(document, DOCUMENT_HEADER, sizeof(DOCUMENT_HEADER) - 1) == 0 &&
+           strcmp(&document[offset - sizeof(DOCUMENT_FOOTER) + 1], DOCUMENT_FOOTER) == 0 &&
+           elements == THREAD_COUNT, "Document: %u threads", elements);
+
+    // Each window only generates the elements it covers.
+    TAP_OK(list_calls <= THREAD_COUNT + windows + 2, "List calls: %u for %u windows",
+           list_calls, windows);
+
+    length = find_element(document, FIRST_THREAD, &element);
+    TAP_OK(strncmp(element, "<thread id=\"1000\" core=\"0\" name=\"idle\"/>\n", length) == 0,
+           "Named: '%.*s'", (int) length, element);
+    length = find_element(document, FIRST_THREAD + 1, &element);
+    TAP_OK(strncmp(element, "<thread id=\"1001\" name=\"a&lt;b&gt;&amp;&quot;c&quot;\"/>\n",
+                   length) == 0, "Escaped: '%.*s'", (int) length, element);
+    length = find_element(document, FIRST_THREAD + 4, &element);
+    TAP_OK(strncmp(element, "<thread id=\"1004\" core=\"0\"/>\n", length) == 0,
+           "Unnamed: '%.*s'", (int) length, element);
+
+    // Names are cut short to fit, without splitting an escape sequence.
+    length = find_element(document, FIRST_THREAD + 2, &element);
+    TAP_OK(length == ELEMENT_LENGTH && strncmp(&element[length - 5], "x\"/>\n", 5) == 0,
+           "Long name: %lu", (unsigned long) length);
+    length = find_element(document, FIRST_THREAD + 3, &element);
+    TAP_OK(length == ELEMENT_LENGTH - 1 && strncmp(&element[length - 9], "&amp;\"/>\n", 9) == 0,
+           "Long escaped name: %lu", (unsigned long) length);
+
+    // Reading from an earlier offset starts the document again.
+    result = proto_xfer_threads(NULL, 0, 10, (unsigned char *) window, 8);
+    TAP_OK(result == 8 && memcmp(window, &document[10], 8) == 0, "Rewound: %d", result);
+
+    result = proto_xfer_threads((const unsigned char *) "x", 1, 0, (unsigned char *) window, 8);
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Annex: %d", result);
+}
+
+// Assertion count: 2 + 1 + 1 + 1 + 2 = 7
+static void test_proto_set_thread(void)
+{
+    static unsigned char     frame[8];
+    char                     reply[32];
+    int                      result;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.register_frame = frame;
+    env.register_frame_length = sizeof(frame);
+    env.stop.thread = 0x1002;
+
+    // Another thread's registers are fetched when it is selected.
+    result = run(proto_set_thread, "$Hg1005#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Select result: %d", result);
+    TAP_OK(env.general_thread == 0x1005 && env.general_context != NULL &&
+           env.general_frame == env.general_context->frame && env.general_frame[0] == 0x05,
+           "Selected thread: %lx", (unsigned long) env.general_thread);
+
+    // The thread which stopped uses its own frame.
+    result = run(proto_set_thread, "$Hg0#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && env.general_thread == 0x1002 && env.general_frame == frame &&
+           env.general_context == NULL, "Any thread: %d", result);
+
+    result = run(proto_set_thread, "$Hc-1#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && env.general_frame == frame, "Continue all: %d", result);
+
+    result = run(proto_set_thread, "$Hg2#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Dead thread: %d", result);
+
+    result = run(proto_set_thread, "$Hx1000#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Invalid operation: %d", result);
+
+    env.register_frame_length = GDBS_REGISTER_FRAME_LENGTH + 1;
+    result = run(proto_set_thread, "$Hg1005#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_RESOURCES, "Frame too long: %d", result);
+    env.register_frame_length = sizeof(frame);
+}
+
+// Assertion count: 2
+static void test_proto_thread_alive(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = run(proto_thread_alive, "$T112B#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Alive: %d", result);
+
+    result = run(proto_thread_alive, "$T112C#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Dead: %d", result);
+}
+
+// Assertion count: 1 + 1 + 1 + 1 + 1 = 5
+static void test_proto_thread_context_cache(void)
+{
+    static const struct gdbs_register    registers[] = { { 0, 0, 4, 0 }, { 9, 4, 4, 0 } };
+    char                                 command[32];
+    char                                 reply[32];
+    unsigned int                         i;
+
+    TAP_DIAG("In %s", __func__);
+
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    proto_flush_thread_contexts();
+
+    // Switching back to a thread uses its cached registers.
+    fetches = 0;
+    stores = 0;
+    run(proto_set_thread, "$Hg1005#00", reply, sizeof(reply));
+    run(proto_set_thread, "$Hg1006#00", reply, sizeof(reply));
+    run(proto_set_thread, "$Hg1005#00", reply, sizeof(reply));
+    TAP_OK(fetches == 2 && env.general_frame[0] == 0x05, "Fetches: %u", fetches);
+
+    // Changes are held until the target resumes.
+    env.general_frame[0] = 0xAA;
+    proto_mark_thread_registers(&registers[0]);
+    TAP_OK(stores == 0, "Not yet stored: %u", stores);
+
+    // The least recently used context makes way for another thread, writing back its changes.
+    for (i = 0; i < GDBS_THREAD_CONTEXT_COUNT; ++i)
+    {
+        sprintf(command, "$Hg%x#00", 0x1010 + i);
+        run(proto_set_thread, command, reply, sizeof(reply));
+    }
+    TAP_OK(stores == 1 && stored_thread == 0x1005 && stored_byte == 0xAA && stored_changed == 0x01,
+           "Evicted: %u %lx", stores, (unsigned long) stored_thread);
+
+    // Every changed context is written once, with the registers changed, when the target resumes.
+    stores = 0;
+    run(proto_set_thread, "$Hg1011#00", reply, sizeof(reply));
+    proto_mark_thread_registers(NULL);
+    proto_mark_thread_registers(NULL);
+    run(proto_set_thread, "$Hg0#00", reply, sizeof(reply));
+    proto_mark_thread_registers(&registers[1]);
+    TAP_OK(proto_flush_thread_contexts() == 0 && stores == 1 && stored_thread == 0x1011 &&
+           stored_changed == 0x01, "Flushed: %u %lx", stores, (unsigned long) stored_thread);
+
+    // Nothing is cached across a resume.
+    fetches = 0;
+    run(proto_set_thread, "$Hg1011#00", reply, sizeof(reply));
+    TAP_OK(fetches == 1 && proto_flush_thread_contexts() == 0 && stores == 1,
+           "Refetched: %u", fetches);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_thread_list();
+    test_proto_current_thread();
+    test_proto_thread_extra_info();
+    test_proto_xfer_threads();
+    test_proto_set_thread();
+    test_proto_thread_alive();
+    test_proto_thread_context_cache();
+
+    TAP_END_PLAN();
+}
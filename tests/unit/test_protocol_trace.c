@@ -0,0 +1,591 @@
+/**
+ *  @file       test_protocol_trace.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol tracepoint commands.
+ */
+#include "protocol/trace.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPTD TPTC TPTF TPTB TPSM TPMR
+static const unsigned long TEST_COUNT =   11 + 11 + 14 +  9 + 12 +  3;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Simulated target memory.  Accesses outside of this region fault.
+static unsigned char target[256];
+
+int gdbs_memory_read
+(
+    void            *comm,
+    gdbs_address_t   address,
+    void            *buffer,
+    gdbs_address_t   length
+)
+{
+    (void) comm;
+    if (address + length > sizeof(target))
+    {
+        return -GDBS_ERROR_FAULT;
+    }
+    memcpy(buffer, &target[address], length);
+    return 0;
+}
+
+void proto_breakpoint_filter_read
+(
+    gdbs_address_t   address,
+    unsigned char   *data,
+    gdbs_address_t   length
+)
+{
+    (void) address;
+    (void) data;
+    (void) length;
+}
+
+/// Number of tracepoint breakpoints requested, and of requests to clear them.
+static int inserted;
+static int cleared;
+
+int proto_insert_trace_breakpoint
+(
+    gdbs_address_t address
+)
+{
+    (void) address;
+    ++inserted;
+    return 0;
+}
+
+void proto_clear_trace_breakpoints(void)
+{
+    ++cleared;
+}
+
+int proto_get_register_bytes
+(
+    gdbs_address_t           regnum,
+    const unsigned char    **bytes,
+    unsigned int            *size
+)
+{
+    (void) regnum;
+    (void) bytes;
+    (void) size;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+void proto_console_format
+(
+    const unsigned char *format,
+    size_t               length,
+    const agent_value_t *args,
+    unsigned int         count
+)
+{
+    (void) format;
+    (void) length;
+    (void) args;
+    (void) count;
+}
+
+/// Register file: a 4 byte program counter, then a 2 byte general register.
+static const struct gdbs_register registers[] =
+{
+    { 0, 0, 4, 0 },
+    { 1, 4, 2, 0 },
+};
+static unsigned char register_frame[6];
+static unsigned char packet_buffer[GDBS_PACKET_BUFFER_LENGTH];
+
+/**
+ * Run a command handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    int        (*handler)(struct packet_tokenizer *),
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+
+    // Skip the command name, as the query dispatcher does.
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, ':', &token, &length);
+    return handler(&tokenizer);
+}
+
+/**
+ * Reset the environment, and define tracepoints.
+ *
+ * @return Boolean indicating that every definition succeeded.
+ */
+static int define
+(
+    const char *const   *commands,
+    size_t               count
+)
+{
+    char    reply[32];
+    size_t  i;
+    int     ok = 1;
+
+    memset(&env, 0, sizeof(env));
+    env.registers = registers;
+    env.register_count = sizeof(registers) / sizeof(registers[0]);
+    env.register_frame = register_frame;
+    env.register_frame_length = sizeof(register_frame);
+    env.pc_register = &registers[0];
+    env.general_frame = register_frame;
+    env.packet_buffer = packet_buffer;
+    inserted = 0;
+    cleared = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        ok = ok && run(proto_trace_define, commands[i], reply, sizeof(reply)) == 0 &&
+             strcmp(reply, "$OK#9A") == 0;
+    }
+    return ok;
+}
+
+/**
+ * Simulate a tracepoint breakpoint being hit.
+ */
+static void hit
+(
+    gdbs_address_t address
+)
+{
+    value_to_bytes(register_frame, address, 4, is_little_endian());
+    proto_trace_hit(address);
+}
+
+/**
+ * Reach a static tracepoint marker, as the target would while running.
+ */
+static void reach
+(
+    int          speed,
+    const char  *name
+)
+{
+    unsigned char *buffer = env.packet_buffer;
+
+    env.packet_buffer = NULL;
+    GDBS_TRACE_MARKER(motor_start, "speed=%d name=%s", speed, name);
+    env.packet_buffer = buffer;
+}
+
+/**
+ * Find a static tracepoint marker by name.
+ *
+ * @return Address of the marker, or zero if there is none.
+ */
+static gdbs_address_t marker_address
+(
+    const char *id
+)
+{
+    struct gdbs_marker *marker;
+
+    for (marker = MARKERS_START; marker < MARKERS_END; ++marker)
+    {
+        if (strcmp(marker->id, id) == 0)
+        {
+            return (gdbs_address_t) marker;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Record marker arguments with a given format.
+ *
+ * @return Length of the record.
+ */
+static unsigned int record
+(
+    unsigned char   *data,
+    unsigned int     limit,
+    const char      *format,
+    ...
+)
+{
+    unsigned int    length;
+    va_list         args;
+
+    va_start(args, format);
+    length = marker_record(format, &args, data, limit);
+    va_end(args);
+    return length;
+}
+
+// Assertion count: 3 + 3 + 3 + 2 = 11
+static void test_proto_trace_define(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+    define(NULL, 0);
+
+    // A tracepoint, then its actions split over two commands.
+    result = run(proto_trace_define, "$QTDP:1:10:E:0:0-#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Define: '%s'", reply);
+    TAP_OK(env.tracepoint_count == 1 && env.tracepoints[0].address == 0x10 &&
+           env.tracepoints[0].enabled && env.tracepoints[0].actions_length == 0,
+           "Tracepoint: %u", env.tracepoint_count);
+    run(proto_trace_define, "$QTDP:-1:10:R3M-1,20,4-#00", reply, sizeof(reply));
+    run(proto_trace_define, "$QTDP:-1:10:X6,222022040C27#00", reply, sizeof(reply));
+    TAP_OK(env.tracepoints[0].actions_length == 31 && env.trace_actions_used == 31,
+           "Actions: %u", env.tracepoints[0].actions_length);
+
+    // A disabled tracepoint with a pass count and a condition.
+    result = run(proto_trace_define, "$QTDP:2:20:D:0:3:X3,220027#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && env.tracepoint_count == 2, "Define: %d", result);
+    TAP_OK(!env.tracepoints[1].enabled && env.tracepoints[1].pass_count == 3 &&
+           env.tracepoints[1].actions_length == 6, "Condition: %u",
+           env.tracepoints[1].actions_length);
+
+    // While-stepping actions are ignored.
+    result = run(proto_trace_define, "$QTDP:-2:20:SM-1,0,4#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && env.tracepoints[1].stepping && env.trace_actions_used == 37,
+           "Stepping: %d", result);
+
+    // Malformed definitions leave the pool untouched.
+    result = run(proto_trace_define, "$QTDP:-1:10:R1#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Not the last tracepoint: %d", result);
+    result = run(proto_trace_define, "$QTDP:3:30:Q:0:0#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Bad enable: %d", result);
+    result = run(proto_trace_define, "$QTDP:3:30:E:0:0:X3,22#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID && env.tracepoint_count == 2 &&
+           env.trace_actions_used == 37, "Truncated condition: %d", result);
+
+    result = run(proto_trace_init, "$QTinit#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0, "Init: '%s'", reply);
+    TAP_OK(env.tracepoint_count == 0 && env.trace_actions_used == 0, "Cleared");
+}
+
+// Assertion count: 2 + 3 + 3 + 3 = 11
+static void test_proto_trace_collect(void)
+{
+    static const char *const commands[] =
+    {
+        "$QTDP:1:10:E:0:0-#00",
+        "$QTDP:-1:10:RfM-1,20,4X5,22400D0227#00",
+        "$QTDP:2:20:E:0:2:X3,220127-#00",
+        "$QTDP:-2:20:R1#00",
+        "$QTDP:3:10:E:0:0:X3,220027-#00",
+        "$QTDP:-3:10:R1#00",
+    };
+    char    reply[128];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+    define(commands, sizeof(commands) / sizeof(commands[0]));
+
+    result = run(proto_trace_status, "$qTStatus#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$T0;tnotrun:0;tframes:0;tcreated:0;tfree:1000;"
+                                        "tsize:1000;circular:0;disconn:0#09") == 0,
+           "Not run: '%s'", reply);
+    result = run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && env.tracing && inserted == 3, "Start: %d", result);
+
+    // The condition of tracepoint 3 is false, so only one frame is collected.
+    hit(0x10);
+    hit(0x30);
+    TAP_OK(env.trace_frame_count == 1 && env.trace_used == 41, "Frame: %u", env.trace_used);
+
+    // A hit which preempts the recording of a marker is dropped, rather than corrupting its frame.
+    env.trace_marker_busy = 1;
+    hit(0x10);
+    TAP_OK(env.trace_frame_count == 1 && env.trace_used == 41 && env.trace_marker_busy == 1,
+           "Dropped while busy: %u", env.trace_frame_count);
+    env.trace_marker_busy = 0;
+
+    result = run(proto_trace_status, "$qTStatus#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$T1;tframes:1;tcreated:1;tfree:FD7;tsize:1000;"
+                                        "circular:0;disconn:0#4D") == 0,
+           "Running: '%s'", reply);
+
+    // Tracing stops when tracepoint 2 reaches its pass count.
+    hit(0x20);
+    TAP_OK(env.tracing, "Still tracing");
+    hit(0x20);
+    result = run(proto_trace_status, "$qTStatus#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$T0;tpasscount:2;tframes:3;tcreated:3;tfree:FBD;"
+                                        "tsize:1000;circular:0;disconn:0#56") == 0,
+           "Pass count: '%s'", reply);
+    TAP_OK(!env.tracing && cleared == 2, "Breakpoints cleared: %d", cleared);
+
+    // The raw buffer starts with the tracepoint number.
+    result = run(proto_trace_read_buffer, "$qTBuffer:0,2#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, (is_little_endian() ? "$0100#C1" : "$0001#C1")) == 0,
+           "Buffer: '%s'", reply);
+    result = run(proto_trace_read_buffer, "$qTBuffer:43,10#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$l#6C") == 0, "End of buffer: '%s'", reply);
+    result = run(proto_trace_read_buffer, "$qTBuffer:0#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed: %d", result);
+}
+
+// Assertion count: 3 + 4 + 4 + 3 = 14
+static void test_proto_trace_frame(void)
+{
+    unsigned char   data[8];
+    char            reply[32];
+    int             result;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Frames collected by test_proto_trace_collect(), at 0x10, 0x20, and 0x20.
+    result = run(proto_trace_select_frame, "$QTFrame:0#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$F0T1#FB") == 0, "Frame 0: '%s'", reply);
+    TAP_OK(env.trace_selected && env.general_frame == env.trace_registers &&
+           bytes_to_value(env.trace_registers, 4, is_little_endian()) == 0x10, "Registers loaded");
+    TAP_OK(proto_trace_read_memory(0x20, data, 4) == 4 && memcmp(data, &target[0x20], 4) == 0,
+           "Memory block");
+
+    // Reads stop short at the end of what the frame holds.
+    TAP_OK(proto_trace_read_memory(0x22, data, 4) == 2, "Partial read");
+    TAP_OK(proto_trace_read_memory(0x40, data, 2) == 2 && memcmp(data, &target[0x40], 2) == 0,
+           "Collected by expression");
+    TAP_OK(proto_trace_read_memory(0x50, data, 1) == -GDBS_ERROR_NOT_FOUND, "Not collected");
+    run(proto_trace_select_frame, "$QTFrame:1#00", reply, sizeof(reply));
+    TAP_OK(proto_trace_read_memory(0x20, data, 4) == -GDBS_ERROR_NOT_FOUND, "Registers only");
+
+    // Searches carry on from the selected frame.
+    run(proto_trace_select_frame, "$QTFrame:tdp:2#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F2T2#FE") == 0, "Next of tracepoint 2: '%s'", reply);
+    run(proto_trace_select_frame, "$QTFrame:tdp:2#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F-1#A4") == 0 && !env.trace_selected &&
+           env.general_frame == register_frame, "No more: '%s'", reply);
+    run(proto_trace_select_frame, "$QTFrame:pc:20#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F1T2#FD") == 0, "By address: '%s'", reply);
+    run(proto_trace_select_frame, "$QTFrame:outside:18:30#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F-1#A4") == 0, "Outside: '%s'", reply);
+
+    run(proto_trace_select_frame, "$QTFrame:range:0:18#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F0T1#FB") == 0, "Range: '%s'", reply);
+    run(proto_trace_select_frame, "$QTFrame:ffffffff#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$F-1#A4") == 0, "Out of range: '%s'", reply);
+    result = run(proto_trace_select_frame, "$QTFrame:xyz:1#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Malformed: %d", result);
+}
+
+// Assertion count: 3 + 4 + 2 = 9
+static void test_proto_trace_buffer(void)
+{
+    static const char *const commands[] =
+    {
+        "$QTDP:1:10:E:0:0-#00",
+        "$QTDP:-1:10:M-1,0,ff#00",
+    };
+    static const char *const faulting[] =
+    {
+        "$QTDP:1:10:E:0:0-#00",
+        "$QTDP:-1:10:M-1,f0,20R1#00",
+    };
+    unsigned char   data[255];
+    char            reply[32];
+    char            command[32];
+    size_t          i;
+    int             result;
+    int             ok = 1;
+
+    TAP_DIAG("In %s", __func__);
+    for (i = 0; i < sizeof(target); ++i)
+    {
+        target[i] = (unsigned char) i;
+    }
+
+    // Each frame takes 272 bytes, so the 16th does not fit.
+    define(commands, sizeof(commands) / sizeof(commands[0]));
+    run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    for (i = 0; i < 16; ++i)
+    {
+        hit(0x10);
+    }
+    TAP_OK(!env.tracing && env.trace_stop_reason == TS_FULL && env.trace_frame_count == 15,
+           "Full: %u", env.trace_frame_count);
+    result = run(proto_trace_set_buffer, "$QTBuffer:size:1000#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Size unsupported: '%s'", reply);
+    result = run(proto_trace_set_buffer, "$QTBuffer:circular:1#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$OK#9A") == 0 && env.trace_circular,
+           "Circular: '%s'", reply);
+
+    // In circular mode the oldest frames make way, including frames which wrap around the end.
+    run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    for (i = 0; i < 20; ++i)
+    {
+        target[0] = (unsigned char) i;
+        hit(0x10);
+    }
+    TAP_OK(env.tracing && env.trace_frame_count == 15 && env.trace_frames_created == 20,
+           "Wrapped: %u", env.trace_frames_created);
+    for (i = 0; i < 15; ++i)
+    {
+        sprintf(command, "$QTFrame:%x#00", (unsigned int) i);
+        run(proto_trace_select_frame, command, reply, sizeof(reply));
+        ok = ok && proto_trace_read_memory(0, data, sizeof(data)) == (int) sizeof(data) &&
+             data[0] == i + 5 && memcmp(&data[1], &target[1], sizeof(data) - 1) == 0;
+    }
+    TAP_OK(ok, "Frames intact");
+
+    // The selection moves down as frames are discarded.
+    run(proto_trace_select_frame, "$QTFrame:3#00", reply, sizeof(reply));
+    hit(0x10);
+    TAP_OK(env.trace_selected && env.trace_selected_frame == 2, "Selection moved");
+    run(proto_trace_select_frame, "$QTFrame:0#00", reply, sizeof(reply));
+    hit(0x10);
+    TAP_OK(!env.trace_selected, "Selection discarded");
+
+    // Memory which cannot be read is left out of the frame.
+    result = define(faulting, sizeof(faulting) / sizeof(faulting[0]));
+    run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    hit(0x10);
+    TAP_OK(result && env.trace_frame_count == 1 && env.trace_used == 13, "Fault skipped: %u",
+           env.trace_used);
+    TAP_OK(env.tracing, "Still tracing");
+}
+
+// Assertion count: 4 + 4 + 2 + 2 = 12
+static void test_proto_trace_marker(void)
+{
+    struct gdbs_marker  *marker = (struct gdbs_marker *) marker_address("motor_start");
+    unsigned char        data[16];
+    char                 reply[128];
+    char                 command[64];
+    int                  speed = 42;
+    int                  result;
+
+    TAP_DIAG("In %s", __func__);
+    define(NULL, 0);
+
+    // Markers are listed with their names and formats hex encoded.
+    result = run(proto_trace_marker_list_first, "$qTfSTM#00", reply, sizeof(reply));
+    sprintf(command, "m%lX:6D6F746F725F7374617274:", (unsigned long) (gdbs_address_t) marker);
+    TAP_OK(result == 0 && marker != NULL && strncmp(&reply[1], command, strlen(command)) == 0,
+           "List: '%s'", reply);
+    result = run(proto_trace_marker_list_next, "$qTsSTM#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$l#6C") == 0, "End of list: '%s'", reply);
+    sprintf(command, "$qTSTMat:%lx#00", (unsigned long) (gdbs_address_t) marker);
+    result = run(proto_trace_marker_at, command, reply, sizeof(reply));
+    TAP_OK(result == 0 && reply[1] == 'm', "Marker at address: '%s'", reply);
+    result = run(proto_trace_marker_at, "$qTSTMat:1#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$l#6C") == 0, "No marker: '%s'", reply);
+
+    // Tracing enables the marker instead of inserting a breakpoint.
+    reach(speed, "ab");
+    TAP_OK(!marker->enabled && env.trace_frame_count == 0, "Disabled");
+    sprintf(command, "$QTDP:1:%lx:E:0:0:S#00", (unsigned long) (gdbs_address_t) marker);
+    run(proto_trace_define, command, reply, sizeof(reply));
+    result = run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && marker->enabled && inserted == 0, "Enabled: %d", result);
+    reach(speed, "ab");
+    TAP_OK(env.trace_frame_count == 1 && env.trace_used == 16, "Recorded: %u", env.trace_used);
+    gdbs_trace_marker(marker, "speed=%d name=%s", speed, "ab");
+    TAP_OK(env.trace_frame_count == 1, "Dropped while the stub is active");
+
+    // The record holds the arguments, and is read back as static trace data.
+    run(proto_trace_select_frame, "$QTFrame:0#00", reply, sizeof(reply));
+    result = proto_xfer_static_trace(NULL, 0, 0, data, sizeof(data));
+    TAP_OK(result == 7 && memcmp(data, &speed, 4) == 0 && memcmp(&data[4], "ab", 3) == 0,
+           "Static trace data: %d", result);
+    result = proto_xfer_static_trace(NULL, 0, 5, data, sizeof(data));
+    TAP_OK(result == 2 && memcmp(data, "b", 2) == 0, "Window: %d", result);
+
+    // Stopping disables the marker, and a static tracepoint needs a marker.
+    run(proto_trace_stop, "$QTStop#00", reply, sizeof(reply));
+    TAP_OK(!marker->enabled, "Stopped");
+    run(proto_trace_define, "$QTDP:2:1:E:0:0:S#00", reply, sizeof(reply));
+    result = run(proto_trace_start, "$QTStart#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND && !marker->enabled && !env.tracing,
+           "Missing marker: %d", result);
+}
+
+// Assertion count: 3
+static void test_proto_marker_record(void)
+{
+    unsigned char   data[64];
+    unsigned int    length;
+
+    TAP_DIAG("In %s", __func__);
+
+    length = record(data, sizeof(data), "%hhx %-4hd %ld %p %5.2f %%", 1, 2, 3L, (void *) data,
+                    1.5);
+    TAP_OK(length == 1 + sizeof(short) + sizeof(long) + sizeof(void *) + sizeof(double) &&
+           data[0] == 1, "Sizes: %u", length);
+    length = record(data, 4, "%s", "abcdef");
+    TAP_OK(length == 4 && memcmp(data, "abc", 4) == 0, "String cut short: %u", length);
+    length = record(data, sizeof(data), "%d %n %d", 1, (int *) NULL, 2);
+    TAP_OK(length == sizeof(int), "Unknown conversion: %u", length);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_trace_define();
+    test_proto_trace_collect();
+    test_proto_trace_frame();
+    test_proto_trace_buffer();
+    test_proto_trace_marker();
+    test_proto_marker_record();
+
+    TAP_END_PLAN();
+}
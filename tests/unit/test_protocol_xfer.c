@@ -0,0 +1,263 @@
+/**
+ *  @file       test_protocol_xfer.c
+ *  @copyright  2022 Andrew MacIsaac
+ *
+ *  @remark
+ *      SPDX-License-Identifier: MPL-2.0
+ *
+ *  @brief      Unit test cases for protocol object transfers.
+ */
+#include "protocol/xfer.c"
+
+#include "stdc/assert.h"
+
+/*********************************** Begin Test Implementation ************************************/
+#include "tap.h"
+
+//                                      TPXR TPXU
+static const unsigned long TEST_COUNT =    4 +  8;
+
+static struct environment env;
+
+struct environment *core_get_environment(void)
+{
+    return &env;
+}
+
+struct testbuf
+{
+    size_t           i;
+    size_t           length;
+    unsigned char   *data;
+};
+
+int gdbs_send
+(
+    void *comm,
+    int   c
+)
+{
+    struct testbuf *buf = comm;
+
+    assert(buf->i < buf->length - 1);
+    buf->data[buf->i]   = (unsigned char) c;
+    buf->data[++buf->i] = '\0';
+
+    return 0;
+}
+
+int gdbs_receive
+(
+    void *comm
+)
+{
+    (void) comm;
+    return 0;
+}
+
+/// Length of the test object, which covers every byte value several times over.
+#define OBJECT_LENGTH 2000
+
+/// Annex passed to the last read.
+static char annex_seen[ANNEX_LENGTH + 1];
+
+int proto_xfer_threads
+(
+    const unsigned char *annex,
+    size_t               annex_length,
+    gdbs_address_t       offset,
+    unsigned char       *data,
+    size_t               length
+)
+{
+    size_t i;
+
+    memcpy(annex_seen, annex, annex_length);
+    annex_seen[annex_length] = '\0';
+    for (i = 0; i < length && offset + i < OBJECT_LENGTH; ++i)
+    {
+        data[i] = (unsigned char) ((offset + i) * 7);
+    }
+    return (int) i;
+}
+
+int proto_xfer_features
+(
+    const unsigned char *annex,
+    size_t               annex_length,
+    gdbs_address_t       offset,
+    unsigned char       *data,
+    size_t               length
+)
+{
+    (void) annex;
+    (void) annex_length;
+    (void) offset;
+    (void) data;
+    (void) length;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+int proto_xfer_memory_map
+(
+    const unsigned char *annex,
+    size_t               annex_length,
+    gdbs_address_t       offset,
+    unsigned char       *data,
+    size_t               length
+)
+{
+    (void) annex;
+    (void) annex_length;
+    (void) offset;
+    (void) data;
+    (void) length;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+int proto_xfer_static_trace
+(
+    const unsigned char *annex,
+    size_t               annex_length,
+    gdbs_address_t       offset,
+    unsigned char       *data,
+    size_t               length
+)
+{
+    (void) annex;
+    (void) annex_length;
+    (void) offset;
+    (void) data;
+    (void) length;
+    return -GDBS_ERROR_NOT_FOUND;
+}
+
+/**
+ * Run the transfer handler against a command string, capturing the reply.
+ *
+ * @return Handler result.
+ */
+static int run
+(
+    const char  *command,
+    char        *reply,
+    size_t       reply_length
+)
+{
+    static unsigned char     buffer[GDBS_PACKET_BUFFER_LENGTH];
+    const unsigned char     *token;
+    size_t                   length;
+    struct packet_tokenizer  tokenizer;
+    struct testbuf           buf = { 0, reply_length, (unsigned char *) reply };
+
+    reply[0] = '\0';
+    env.comm = &buf;
+    env.packet_buffer = buffer;
+
+    packet_tokenizer_init(&tokenizer, (const unsigned char *) command, strlen(command));
+    packet_tokenizer_advance(&tokenizer, TOKEN_SINGLE_CHAR, &token, &length);
+    packet_tokenizer_advance(&tokenizer, ':', &token, &length);
+    return proto_xfer(&tokenizer);
+}
+
+/**
+ * Decode the binary encoded payload of a reply, after its 'm' or 'l' prefix.
+ *
+ * @return Number of bytes decoded.
+ */
+static size_t decode
+(
+    const char      *reply,
+    unsigned char   *data
+)
+{
+    size_t  count = 0;
+    size_t  i;
+
+    for (i = 2; reply[i] != '#'; ++i)
+    {
+        data[count++] = (unsigned char) (reply[i] == '}' ? reply[++i] ^ 0x20 : reply[i]);
+    }
+    return count;
+}
+
+// Assertion count: 1 + 1 + 1 + 1 = 4
+static void test_proto_xfer_read(void)
+{
+    static char              reply[GDBS_PACKET_BUFFER_LENGTH + 8];
+    static unsigned char     object[OBJECT_LENGTH + GDBS_PACKET_BUFFER_LENGTH];
+    char                     command[64];
+    size_t                   offset = 0;
+    size_t                   i;
+    int                      result;
+    int                      sized = 1;
+    int                      matched = 1;
+
+    TAP_DIAG("In %s", __func__);
+
+    // Read the whole object in windows larger than a packet can carry.
+    do
+    {
+        sprintf(command, "$qXfer:threads:read::%lx,1000#00", (unsigned long) offset);
+        result = run(command, reply, sizeof(reply));
+        sized &= (strlen(reply) - 4 <= REPLY_LIMIT);
+        offset += decode(reply, &object[offset]);
+    } while (result == 0 && reply[1] == 'm');
+
+    for (i = 0; i < OBJECT_LENGTH; ++i)
+    {
+        matched &= (object[i] == (unsigned char) (i * 7));
+    }
+    TAP_OK(result == 0 && reply[1] == 'l', "Ended: '%.8s'", reply);
+    TAP_OK(offset == OBJECT_LENGTH && matched, "Object read: %lu", (unsigned long) offset);
+    TAP_OK(sized, "Replies within packet size");
+
+    // A short window ends early without reaching the end of the object.
+    run("$qXfer:threads:read:annex:7c6,2#00", reply, sizeof(reply));
+    TAP_OK(strcmp(reply, "$mjq#48") == 0 && strcmp(annex_seen, "annex") == 0,
+           "Window: '%s' '%s'", reply, annex_seen);
+}
+
+// Assertion count: 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 = 8
+static void test_proto_xfer_unsupported(void)
+{
+    char    reply[32];
+    int     result;
+
+    TAP_DIAG("In %s", __func__);
+
+    result = run("$qXfer:libraries:read::0,10#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Unknown object: '%s'", reply);
+
+    result = run("$qXfer:threads:write::0:00#00", reply, sizeof(reply));
+    TAP_OK(result == 0 && strcmp(reply, "$#00") == 0, "Unknown operation: '%s'", reply);
+
+    result = run("$qXfer:threads:read::zz,10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Bad offset: %d", result);
+
+    result = run("$qXfer:threads#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_INVALID, "Truncated: %d", result);
+
+    result = run("$qXfer:threads:read:0123456789abcdef0123456789abcdef0:0,10#00",
+                 reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "Long annex: %d", result);
+
+    result = run("$qXfer:statictrace:read::0,10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No trace frame: %d", result);
+
+    result = run("$qXfer:memory-map:read::0,10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No memory map: %d", result);
+
+    result = run("$qXfer:features:read:target.xml:0,10#00", reply, sizeof(reply));
+    TAP_OK(result == -GDBS_ERROR_NOT_FOUND, "No target description: %d", result);
+}
+
+int main(void)
+{
+    TAP_PLAN(TEST_COUNT);
+
+    test_proto_xfer_read();
+    test_proto_xfer_unsupported();
+
+    TAP_END_PLAN();
+}